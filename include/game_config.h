@@ -1,6 +1,6 @@
 #pragma once
 
-#include <Arduino.h>
+#include <stdint.h>
 
 
 #define API_DEBUG_LOGGING 1
@@ -44,6 +44,41 @@ constexpr uint32_t IR_CONFIRM_WINDOW_MS = 5000;       // 5s window to receive IR
 constexpr uint8_t DEFUSE_CODE_LENGTH = 4;             // Number of digits in the defuse code
 constexpr uint8_t MAX_WIFI_RETRIES = 10;              // WiFi connection attempts before failing
 constexpr uint32_t DEFAULT_BOMB_DURATION_MS = 40000;  // Default bomb countdown time (e.g., 40s)
+constexpr uint32_t SCHEDULER_STATS_DUMP_INTERVAL_MS = 10000;  // Debug serial dump of per-task timing
+constexpr uint32_t GAME_TICK_BUDGET_US = 200;  // Ceiling for one game_tick() under any game mode
+// Debug command 's' soaks the game logic on-device in short slices between loop() passes.
+constexpr uint32_t SOAK_DEBUG_MATCHES = 20;
+constexpr uint32_t SOAK_TICKS_PER_SLICE = 500;  // ~1 ms of CPU per slice
+constexpr uint32_t SOAK_SLICE_GAP_MS = 20;
+// Debug console (serial commands) is polled from loop(); 'r'/'R' stream the replay log
+// in slices so the dump never holds up the game tick.
+constexpr uint32_t DEBUG_CONSOLE_INTERVAL_MS = 50;
+constexpr uint32_t REPLAY_DUMP_BYTES_PER_SLICE = 256;
+constexpr uint32_t REPLAY_DUMP_SLICE_GAP_MS = 10;
+// When true, new input runs inputs -> state -> effects/UI back-to-back in one scheduler
+// pass. When false the stages keep their own cadence and the pipeline edges only
+// measure input-to-output latency (reported in the scheduler stats dump).
+constexpr bool PIPELINE_IMMEDIATE_DISPATCH = true;
+// Load governor: when the game tick starts late, UI and LED frame intervals are doubled
+// per level (up to the max level) and restored one level at a time once it is on time again.
+constexpr uint32_t GOVERNOR_SAMPLE_INTERVAL_MS = 250;  // Window over which state-tick lateness is sampled
+constexpr uint32_t GOVERNOR_SHED_LATENESS_US = 4000;   // Peak lateness that sheds one level
+constexpr uint32_t GOVERNOR_RESTORE_LATENESS_US = 2000;  // Peak lateness considered calm
+constexpr uint8_t GOVERNOR_RESTORE_WINDOWS = 8;        // Calm windows in a row before restoring a level
+constexpr uint8_t GOVERNOR_MAX_LEVEL = 2;              // 2 => frame intervals up to 4x nominal
+// Replay log: game tick inputs and outputs are buffered in RAM and flushed to LittleFS
+// so field sessions can be re-executed on the host (see core/game_recorder.h).
+constexpr bool REPLAY_LOG_ENABLED = true;
+constexpr uint32_t REPLAY_LOG_FLUSH_INTERVAL_MS = 5000;   // RAM ring holds ~20 s of typical play
+// The session log is split into segments. Past REPLAY_LOG_SEGMENT_BYTES the current one
+// is closed between rounds and a new one started; the newest REPLAY_LOG_SEGMENTS are
+// kept, so the latest play always survives a long session.
+constexpr uint32_t REPLAY_LOG_SEGMENT_BYTES = 128 * 1024;  // Roughly 8 minutes of play
+constexpr uint8_t REPLAY_LOG_SEGMENTS = 4;
+static constexpr const char *REPLAY_LOG_PATH = "/replay.bin";              // Current segment
+static constexpr const char *REPLAY_LOG_OLDER_PATH_FORMAT = "/replay.%u.bin";  // 1 = the one before it
+static constexpr const char *REPLAY_LOG_PREVIOUS_PATH = "/replay.prev.bin";  // Last segment of the previous boot
+static_assert(REPLAY_LOG_SEGMENTS >= 1 && REPLAY_LOG_SEGMENTS <= 9, "Replay log segment count out of range");
 
 // Placeholder default defuse code used until Preferences or web UI override it.
 static constexpr const char *DEFAULT_DEFUSE_CODE = "1234";
@@ -62,6 +97,28 @@ static constexpr const char *DEFAULT_API_ENDPOINT = "http://192.168.0.2:9055/pro
 static constexpr const char *SOFTAP_SSID_PREFIX = "DigitalFlame-";
 static constexpr const char *SOFTAP_PASSWORD = "digitalflame";
 constexpr uint32_t WIFI_CONNECT_TIMEOUT_MS = 5000;  // Timeout for each WiFi connection attempt
+constexpr uint32_t WIFI_STATUS_POLL_MS = 200;       // WiFi link check cadence while connecting/connected
+constexpr uint32_t CONFIG_PORTAL_RECONNECT_DELAY_MS = 500;  // Lets the "saved" page reach the browser
+constexpr uint32_t API_CONNECT_TIMEOUT_MS = 2000;  // TCP connect to the backend (kept open between polls)
+constexpr uint16_t API_HTTP_TIMEOUT_MS = 2000;     // Waiting for the backend's response
+// Heartbeat cadence by game state (state transitions are reported at once regardless);
+// ARMING, ARMED and ERROR_STATE keep API_POST_INTERVAL_MS (see core/report_cadence.h).
+// Failed reports back off exponentially, with jitter, from API_BACKOFF_BASE_MS. A
+// "poll_interval_ms" field in the response replaces the per-state interval. Every
+// interval is capped at API_MAX_POST_INTERVAL_MS so a few reports always fit inside
+// API_TIMEOUT_MS before the offline watchdog fires.
+constexpr uint32_t API_MAX_POST_INTERVAL_MS = API_TIMEOUT_MS / 4;
+constexpr uint32_t API_MIN_POST_INTERVAL_MS = 200;         // Floor for server-suggested intervals
+constexpr uint32_t API_IDLE_POST_INTERVAL_MS = 2000;       // ON, READY: waiting for the match
+constexpr uint32_t API_ACTIVE_POST_INTERVAL_MS = 1000;     // ACTIVE, DEFUSED, DETONATED
+constexpr uint32_t API_FINAL_COUNTDOWN_MS = 10000;         // ARMED with this little left...
+constexpr uint32_t API_FINAL_POST_INTERVAL_MS = 250;       // ...reports this often
+constexpr uint32_t API_BACKOFF_BASE_MS = 1000;             // First retry delay after a failure
+static_assert(API_IDLE_POST_INTERVAL_MS <= API_MAX_POST_INTERVAL_MS &&
+                  API_ACTIVE_POST_INTERVAL_MS <= API_MAX_POST_INTERVAL_MS &&
+                  API_POST_INTERVAL_MS <= API_MAX_POST_INTERVAL_MS,
+              "Report intervals must leave room for several reports per API_TIMEOUT_MS");
+static_assert(API_MIN_POST_INTERVAL_MS <= API_FINAL_POST_INTERVAL_MS, "Final countdown below the interval floor");
 
 // Controls how the device interacts with the backend API. Additional configurability
 // will be added later; for now the mode is fixed to TestSendOnly.
@@ -145,6 +202,8 @@ constexpr uint16_t IR_CONFIRM_PROMPT_BEEP_FREQ = 1500;
 constexpr uint16_t WRONG_CODE_TONE_MS = 220;
 constexpr uint16_t WRONG_CODE_TONE_FREQ_HZ = 90;
 constexpr uint16_t WRONG_CODE_GAP_MS = 140;
+// The keypad stays locked for the whole wrong-code double beep.
+constexpr uint16_t WRONG_CODE_LOCKOUT_MS = (WRONG_CODE_TONE_MS * 2) + WRONG_CODE_GAP_MS;
 
 // Effect durations
 #ifdef APP_DEBUG
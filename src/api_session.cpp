@@ -0,0 +1,274 @@
+#include "api_session.h"
+
+#include <HTTPClient.h>
+#include <WiFi.h>
+
+#include <atomic>
+#include <cstring>
+
+#include "core/async_http.h"
+#include "core/clock.h"
+#include "core/config_store.h"
+#include "game_config.h"
+
+namespace api_session {
+namespace {
+struct Endpoint {
+  bool secure = false;
+  char host[ConfigSnapshot::kMaxEndpointLength + 1] = {0};
+  uint16_t port = 80;
+  char path[ConfigSnapshot::kMaxEndpointLength + 1] = {0};
+};
+
+AsyncHttpClient client;
+
+uint32_t endpointVersion = 0;  // Config version the endpoint was parsed from; 0 = none yet.
+bool endpointValid = false;
+Endpoint endpoint;
+IPAddress address;
+bool addressValid = false;
+
+bool awaiting = false;      // A submitted report has not been reported complete yet.
+bool oneShotDone = false;   // Completed inside submit(): https fallback or failed lookup.
+int lastStatus = 0;
+uint32_t requestStartMs = 0;
+uint32_t seenConnects = 0;  // client.connectCount() already added to connectCount.
+char oneShotBody[AsyncHttpClient::kResponseCapacity + 1] = {0};
+size_t oneShotLength = 0;
+bool bodyFromOneShot = false;
+
+// Written by the networking task, read by the debug dump.
+std::atomic<uint32_t> requestCount{0};
+std::atomic<uint32_t> reusedCount{0};
+std::atomic<uint32_t> connectCount{0};
+std::atomic<uint32_t> dnsLookupCount{0};
+std::atomic<uint32_t> failureCount{0};
+std::atomic<uint32_t> timeoutCount{0};
+std::atomic<uint32_t> supersededCount{0};
+std::atomic<uint32_t> answeredCount{0};
+std::atomic<uint32_t> totalRttMs{0};
+std::atomic<uint32_t> maxRttMs{0};
+
+void bump(std::atomic<uint32_t> &counter, uint32_t amount = 1) {
+  counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+// "http[s]://host[:port][/path]"
+bool parseEndpoint(const char *url, Endpoint &out) {
+  out = Endpoint();
+  if (std::strncmp(url, "http://", 7) == 0) {
+    url += 7;
+  } else if (std::strncmp(url, "https://", 8) == 0) {
+    url += 8;
+    out.secure = true;
+    out.port = 443;
+  } else {
+    return false;
+  }
+
+  const size_t hostLength = std::strcspn(url, ":/");
+  if (hostLength == 0) {
+    return false;
+  }
+  std::memcpy(out.host, url, hostLength);
+  out.host[hostLength] = '\0';
+  url += hostLength;
+
+  if (*url == ':') {
+    ++url;
+    uint32_t port = 0;
+    while (*url >= '0' && *url <= '9' && port <= 65535) {
+      port = port * 10 + static_cast<uint32_t>(*url++ - '0');
+    }
+    if (port == 0 || port > 65535 || (*url != '\0' && *url != '/')) {
+      return false;
+    }
+    out.port = static_cast<uint16_t>(port);
+  }
+
+  strlcpy(out.path, *url == '\0' ? "/" : url, sizeof(out.path));
+  return true;
+}
+
+void refreshEndpoint() {
+  const ConfigSnapshot &config = config_store::current();
+  if (config.version == endpointVersion && endpointVersion != 0) {
+    return;
+  }
+  reset();
+  endpointVersion = config.version;
+  endpointValid = parseEndpoint(config.apiEndpoint, endpoint);
+  // A literal address needs no lookup.
+  addressValid = endpointValid && address.fromString(endpoint.host);
+}
+
+void syncConnects() {
+  bump(connectCount, client.connectCount() - seenConnects);
+  seenConnects = client.connectCount();
+}
+
+void noteAnswered() {
+  const uint32_t rttMs = sys_clock::nowMs() - requestStartMs;
+  bump(answeredCount);
+  bump(totalRttMs, rttMs);
+  if (rttMs > maxRttMs.load(std::memory_order_relaxed)) {
+    maxRttMs.store(rttMs, std::memory_order_relaxed);
+  }
+}
+
+// The previous, blocking behaviour, kept for https:// and unparsable endpoints.
+void postOneShot(const char *url, const char *payload) {
+  HTTPClient oneShot;
+  oneShotLength = 0;
+  oneShotBody[0] = '\0';
+  bodyFromOneShot = true;
+  oneShotDone = true;
+  if (!oneShot.begin(url)) {
+    lastStatus = HTTPC_ERROR_CONNECTION_REFUSED;
+    return;
+  }
+  bump(connectCount);
+  oneShot.setTimeout(API_HTTP_TIMEOUT_MS);
+  oneShot.addHeader("Content-Type", "application/json");
+  lastStatus = oneShot.POST(String(payload));
+  if (lastStatus == HTTP_CODE_OK) {
+    oneShotLength = strlcpy(oneShotBody, oneShot.getString().c_str(), sizeof(oneShotBody));
+    if (oneShotLength >= sizeof(oneShotBody)) {
+      oneShotLength = sizeof(oneShotBody) - 1;
+    }
+  }
+  oneShot.end();
+}
+}  // namespace
+
+void submit(const char *payload, size_t length, uint32_t nowMs) {
+  refreshEndpoint();
+  if (client.inFlight()) {
+    bump(supersededCount);
+  }
+  bump(requestCount);
+  requestStartMs = sys_clock::nowMs();
+  awaiting = true;
+  oneShotDone = false;
+  bodyFromOneShot = false;
+
+  if (!endpointValid || endpoint.secure) {
+    client.cancel();
+    postOneShot(config_store::current().apiEndpoint, payload);
+    return;
+  }
+  if (!addressValid) {
+    bump(dnsLookupCount);
+    if (WiFi.hostByName(endpoint.host, address) != 1) {
+      client.cancel();
+      oneShotDone = true;
+      lastStatus = HTTPC_ERROR_CONNECTION_REFUSED;
+      return;
+    }
+    addressValid = true;
+  }
+
+  AsyncHttpClient::Target target;
+  target.address = static_cast<uint32_t>(address);
+  target.port = endpoint.port;
+  target.host = endpoint.host;
+  target.path = endpoint.path;
+  client.startPost(target, payload, length, nowMs, API_HTTP_TIMEOUT_MS);
+  syncConnects();
+  if (client.reusedConnection()) {
+    bump(reusedCount);
+  }
+}
+
+bool inFlight() { return awaiting; }
+
+Result poll(uint32_t nowMs) {
+  if (!awaiting) {
+    return Result::Idle;
+  }
+  if (oneShotDone) {
+    awaiting = false;
+    if (lastStatus < 0) {
+      bump(failureCount);
+      return Result::Failed;
+    }
+    noteAnswered();
+    return Result::Answered;
+  }
+
+  const AsyncHttpClient::Phase phase = client.inFlight() ? client.poll(nowMs) : client.phase();
+  syncConnects();
+  if (phase == AsyncHttpClient::Phase::Done) {
+    awaiting = false;
+    lastStatus = client.status();
+    noteAnswered();
+    return Result::Answered;
+  }
+  if (phase == AsyncHttpClient::Phase::Failed) {
+    awaiting = false;
+    const AsyncHttpClient::Error error = client.error();
+    lastStatus = -static_cast<int>(error);
+    bump(failureCount);
+    if (error == AsyncHttpClient::Error::Timeout) {
+      bump(timeoutCount);
+    } else if (error == AsyncHttpClient::Error::Connect) {
+      // Look the host up again next time in case it moved.
+      addressValid = address.fromString(endpoint.host);
+    }
+    return Result::Failed;
+  }
+  return Result::Pending;
+}
+
+bool waitForActivity(uint32_t maxMs) { return client.waitForActivity(maxMs); }
+
+int statusCode() { return lastStatus; }
+
+const char *responseBody() {
+  if (bodyFromOneShot) {
+    return oneShotBody;
+  }
+  return lastStatus == HTTP_CODE_OK ? client.body() : "";
+}
+
+size_t responseLength() {
+  if (bodyFromOneShot) {
+    return oneShotLength;
+  }
+  return lastStatus == HTTP_CODE_OK ? client.bodyLength() : 0;
+}
+
+void reset() {
+  client.disconnect();
+  awaiting = false;
+  addressValid = false;
+}
+
+Stats getStats() {
+  Stats stats;
+  stats.requests = requestCount.load(std::memory_order_relaxed);
+  stats.reused = reusedCount.load(std::memory_order_relaxed);
+  stats.connects = connectCount.load(std::memory_order_relaxed);
+  stats.dnsLookups = dnsLookupCount.load(std::memory_order_relaxed);
+  stats.failures = failureCount.load(std::memory_order_relaxed);
+  stats.timeouts = timeoutCount.load(std::memory_order_relaxed);
+  stats.superseded = supersededCount.load(std::memory_order_relaxed);
+  const uint32_t answered = answeredCount.load(std::memory_order_relaxed);
+  stats.avgRttMs = answered ? totalRttMs.load(std::memory_order_relaxed) / answered : 0;
+  stats.maxRttMs = maxRttMs.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void dumpStats() {
+#ifdef APP_DEBUG
+  const Stats stats = getStats();
+  Serial.printf(
+      "[API] requests=%lu reused=%lu connects=%lu dns=%lu failures=%lu timeouts=%lu superseded=%lu rtt=%lu/%lums\n",
+      static_cast<unsigned long>(stats.requests), static_cast<unsigned long>(stats.reused),
+      static_cast<unsigned long>(stats.connects), static_cast<unsigned long>(stats.dnsLookups),
+      static_cast<unsigned long>(stats.failures), static_cast<unsigned long>(stats.timeouts),
+      static_cast<unsigned long>(stats.superseded), static_cast<unsigned long>(stats.avgRttMs),
+      static_cast<unsigned long>(stats.maxRttMs));
+#endif
+}
+}  // namespace api_session
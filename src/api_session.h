@@ -0,0 +1,58 @@
+#pragma once
+
+#include <Arduino.h>
+
+// HTTP session for the backend reports, on the non-blocking AsyncHttpClient. The
+// endpoint URL is parsed and its host resolved once per configuration version. The
+// TCP connection is kept open across polls (HTTP keep-alive) and re-established when
+// the server or the link drops it.
+//
+// One report is in flight at a time and the latest one wins: submitting cancels a
+// report still pending. Each report has its own deadline (API_HTTP_TIMEOUT_MS).
+// Nothing blocks except the host name lookup, which runs once per endpoint.
+// https:// endpoints are the exception: they fall back to a blocking one-shot
+// HTTPClient request inside submit().
+//
+// Used from the networking task only; getStats()/dumpStats() may be called from any task.
+namespace api_session {
+struct Stats {
+  uint32_t requests = 0;
+  uint32_t reused = 0;      // Sent on a connection left open by an earlier request.
+  uint32_t connects = 0;    // New TCP connections (including one-shot requests).
+  uint32_t dnsLookups = 0;  // Host name resolutions; literal IP endpoints need none.
+  uint32_t failures = 0;    // Requests that got no HTTP response at all.
+  uint32_t timeouts = 0;    // Failures that hit the request deadline.
+  uint32_t superseded = 0;  // Cancelled by a newer report.
+  uint32_t avgRttMs = 0;    // Request to response, over answered requests.
+  uint32_t maxRttMs = 0;
+};
+
+enum class Result : uint8_t { Idle, Pending, Answered, Failed };
+
+// Starts POSTing the JSON `payload`, cancelling a report still in flight.
+void submit(const char *payload, size_t length, uint32_t nowMs);
+
+bool inFlight();
+
+// Advances the report in flight without blocking. Returns Answered or Failed once, from
+// the call that completes it; then Idle until the next submit().
+Result poll(uint32_t nowMs);
+
+// Sleeps up to `maxMs` until the report in flight can make progress. Returns false at
+// once when nothing is in flight.
+bool waitForActivity(uint32_t maxMs);
+
+// Of the report that last completed: the HTTP status code (negative when there was no
+// response) and, on HTTP 200, the NUL-terminated body.
+int statusCode();
+const char *responseBody();
+size_t responseLength();
+
+// Cancels the report in flight, closes the connection and forgets the resolved address.
+void reset();
+
+Stats getStats();
+
+// Prints the counters above to Serial (APP_DEBUG only).
+void dumpStats();
+}  // namespace api_session
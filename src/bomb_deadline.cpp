@@ -0,0 +1,166 @@
+#include "bomb_deadline.h"
+
+#include <esp_timer.h>
+
+#include <atomic>
+
+#include "core/clock.h"
+
+namespace bomb_deadline {
+namespace {
+enum Phase : uint8_t { Idle, Armed, Expired };
+
+constexpr uint8_t kAllMarks = (1u << static_cast<uint8_t>(Stage::Count)) - 1;
+
+// Written by the one task that reaches the stage, read by the debug dump.
+struct StageTotals {
+  std::atomic<uint32_t> samples;
+  std::atomic<uint32_t> totalUs;
+  std::atomic<uint32_t> maxUs;
+};
+
+esp_timer_handle_t timer = nullptr;
+Notifier notifier = nullptr;
+std::atomic<uint8_t> phase{Idle};
+
+// Stages still to be measured for the current deadline. Each stage is claimed once, by
+// the one task that reaches it (game tick, effects, API task or the timer callback).
+std::atomic<uint8_t> pendingMarks{0};
+std::atomic<uint32_t> deadlineUs{0};  // Low 32 bits of sys_clock::nowUs(); latencies are differences.
+
+StageTotals totals[static_cast<size_t>(Stage::Count)] = {};
+std::atomic<uint32_t> armedCount{0};
+std::atomic<uint32_t> cancelledCount{0};
+std::atomic<uint32_t> fallbackCount{0};
+
+uint32_t nowUs() { return static_cast<uint32_t>(sys_clock::nowUs()); }
+
+void bump(std::atomic<uint32_t> &counter, uint32_t amount = 1) {
+  counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+void mark(Stage stage, uint32_t atUs) {
+  const uint8_t bit = static_cast<uint8_t>(1u << static_cast<uint8_t>(stage));
+  if ((pendingMarks.fetch_and(static_cast<uint8_t>(~bit), std::memory_order_acquire) & bit) == 0) {
+    return;
+  }
+  // The tick countdown can beat the timer by a fraction of a millisecond.
+  const int32_t lateUs = static_cast<int32_t>(atUs - deadlineUs.load(std::memory_order_relaxed));
+  const uint32_t latencyUs = lateUs > 0 ? static_cast<uint32_t>(lateUs) : 0;
+  StageTotals &entry = totals[static_cast<size_t>(stage)];
+  bump(entry.samples);
+  bump(entry.totalUs, latencyUs);
+  if (latencyUs > entry.maxUs.load(std::memory_order_relaxed)) {
+    entry.maxUs.store(latencyUs, std::memory_order_relaxed);
+  }
+}
+
+void onTimer(void *) {
+  const uint32_t firedUs = nowUs();
+  uint8_t expected = Armed;
+  if (!phase.compare_exchange_strong(expected, Expired, std::memory_order_acq_rel)) {
+    return;  // Cancelled while the callback was being dispatched.
+  }
+  mark(Stage::Dispatch, firedUs);
+  if (notifier) {
+    notifier();
+  }
+}
+}  // namespace
+
+bool begin(Notifier onExpired) {
+  notifier = onExpired;
+  if (timer) {
+    return true;
+  }
+  esp_timer_create_args_t args = {};
+  args.callback = onTimer;
+  args.dispatch_method = ESP_TIMER_TASK;
+  args.name = "bomb";
+  if (esp_timer_create(&args, &timer) != ESP_OK) {
+    timer = nullptr;
+#ifdef APP_DEBUG
+    Serial.println("[BOMB] esp_timer_create failed; detonation falls back to the tick countdown.");
+#endif
+    return false;
+  }
+  return true;
+}
+
+void arm(uint32_t durationMs) {
+  if (!timer) {
+    return;
+  }
+  cancel();
+  const uint64_t durationUs = static_cast<uint64_t>(durationMs) * 1000;
+  deadlineUs.store(nowUs() + static_cast<uint32_t>(durationUs), std::memory_order_relaxed);
+  pendingMarks.store(kAllMarks, std::memory_order_release);
+  phase.store(Armed, std::memory_order_release);
+  esp_timer_start_once(timer, durationUs);
+  bump(armedCount);
+}
+
+void cancel() {
+  const uint8_t previous = phase.exchange(Idle, std::memory_order_acq_rel);
+  if (previous == Armed) {
+    esp_timer_stop(timer);
+  }
+  if (previous != Idle) {
+    pendingMarks.store(0, std::memory_order_relaxed);
+    bump(cancelledCount);
+  }
+}
+
+bool takeExpired() {
+  uint8_t expected = Expired;
+  return phase.compare_exchange_strong(expected, Idle, std::memory_order_acq_rel);
+}
+
+void noteDetonation() {
+  if (phase.exchange(Idle, std::memory_order_acq_rel) == Armed) {
+    esp_timer_stop(timer);
+    bump(fallbackCount);
+  }
+  mark(Stage::Tick, nowUs());
+}
+
+void noteEffectFrame() {
+  if (pendingMarks.load(std::memory_order_relaxed) != 0) {
+    mark(Stage::Frame, nowUs());
+  }
+}
+
+void noteReportSent() {
+  if (pendingMarks.load(std::memory_order_relaxed) != 0) {
+    mark(Stage::Report, nowUs());
+  }
+}
+
+Stats getStats() {
+  Stats stats;
+  for (size_t i = 0; i < static_cast<size_t>(Stage::Count); ++i) {
+    const uint32_t samples = totals[i].samples.load(std::memory_order_relaxed);
+    stats.stages[i].samples = samples;
+    stats.stages[i].avgUs = samples ? totals[i].totalUs.load(std::memory_order_relaxed) / samples : 0;
+    stats.stages[i].maxUs = totals[i].maxUs.load(std::memory_order_relaxed);
+  }
+  stats.armed = armedCount.load(std::memory_order_relaxed);
+  stats.cancelled = cancelledCount.load(std::memory_order_relaxed);
+  stats.countdownFallbacks = fallbackCount.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void dumpStats() {
+#ifdef APP_DEBUG
+  static const char *const kStageNames[] = {"dispatch", "tick", "frame", "report"};
+  const Stats stats = getStats();
+  Serial.printf("[BOMB] armed=%lu cancelled=%lu fallbacks=%lu", static_cast<unsigned long>(stats.armed),
+                static_cast<unsigned long>(stats.cancelled), static_cast<unsigned long>(stats.countdownFallbacks));
+  for (size_t i = 0; i < static_cast<size_t>(Stage::Count); ++i) {
+    Serial.printf(" %s=%lu/%lu/%luus", kStageNames[i], static_cast<unsigned long>(stats.stages[i].samples),
+                  static_cast<unsigned long>(stats.stages[i].avgUs), static_cast<unsigned long>(stats.stages[i].maxUs));
+  }
+  Serial.printf("\n");
+#endif
+}
+}  // namespace bomb_deadline
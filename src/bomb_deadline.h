@@ -0,0 +1,54 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Hardware deadline for the ARMED countdown. Entering ARMED starts a one-shot esp_timer
+// at the bomb duration; when it fires, the notifier passed to begin() wakes the game
+// tick, which detonates right away instead of on its next 10 ms slot. The engine's own
+// millisecond countdown stays as the fallback and keeps the displayed time.
+//
+// Each detonation is timed against the deadline at four points: the timer callback,
+// the game tick applying DETONATED (which triggers the effect), the first LED frame
+// showing it and the outbound API report carrying it.
+namespace bomb_deadline {
+using Notifier = void (*)();
+
+enum class Stage : uint8_t { Dispatch, Tick, Frame, Report, Count };
+
+struct LatencyStats {
+  uint32_t samples = 0;
+  uint32_t avgUs = 0;
+  uint32_t maxUs = 0;
+};
+
+struct Stats {
+  LatencyStats stages[static_cast<size_t>(Stage::Count)];
+  uint32_t armed = 0;
+  uint32_t cancelled = 0;          // Left ARMED before the deadline (defused, reset, error).
+  uint32_t countdownFallbacks = 0;  // Detonated by the tick countdown before the timer fired.
+};
+
+// Creates the timer. `onExpired` runs in the esp_timer task and must only wake the game
+// side (scheduler::post(), rtos_stage::wake()).
+bool begin(Notifier onExpired);
+
+// Starts the deadline `durationMs` from now, replacing any pending one.
+void arm(uint32_t durationMs);
+
+// Drops a pending deadline. A deadline that fired but was not yet taken is dropped too,
+// so a defuse applied by the game tick always wins over a late callback.
+void cancel();
+
+// True once per fired deadline; the game tick feeds it to the engine.
+bool takeExpired();
+
+// Measurement points. noteDetonation() also retires the deadline.
+void noteDetonation();
+void noteEffectFrame();
+void noteReportSent();
+
+Stats getStats();
+
+// Prints the counters above to Serial (APP_DEBUG only).
+void dumpStats();
+}  // namespace bomb_deadline
@@ -0,0 +1,391 @@
+#include "core/async_http.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <strings.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "core/clock.h"
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0  // lwIP never raises SIGPIPE.
+#endif
+
+namespace {
+bool wouldBlock() { return errno == EAGAIN || errno == EWOULDBLOCK; }
+
+bool nameIs(const char *begin, const char *end, const char *name) {
+  const size_t length = std::strlen(name);
+  return static_cast<size_t>(end - begin) == length && strncasecmp(begin, name, length) == 0;
+}
+
+bool containsWord(const char *begin, const char *end, const char *word) {
+  const size_t length = std::strlen(word);
+  for (const char *p = begin; p + length <= end; ++p) {
+    if (strncasecmp(p, word, length) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+}  // namespace
+
+AsyncHttpClient::~AsyncHttpClient() { closeSocket(); }
+
+bool AsyncHttpClient::inFlight() const {
+  return currentPhase == Phase::Connecting || currentPhase == Phase::Sending || currentPhase == Phase::Receiving;
+}
+
+bool AsyncHttpClient::startPost(const Target &target, const char *body, size_t length, uint32_t nowMs,
+                                uint32_t timeoutMs) {
+  cancel();
+  lastError = Error::None;
+  deadlineMs = nowMs + timeoutMs;
+  reused = false;
+  retried = false;
+  sentBytes = 0;
+  receivedBytes = 0;
+  response[0] = '\0';
+  headersParsed = false;
+  framing = Framing::Unknown;
+  statusCode = 0;
+  bodyStart = 0;
+  contentLength = 0;
+  bodyBytes = 0;
+
+  char portSuffix[8] = {0};
+  if (target.port != 80) {
+    snprintf(portSuffix, sizeof(portSuffix), ":%u", static_cast<unsigned>(target.port));
+  }
+  const int headerLength = snprintf(request, sizeof(request),
+                                    "POST %s HTTP/1.1\r\nHost: %s%s\r\nContent-Type: application/json\r\n"
+                                    "Content-Length: %u\r\nConnection: keep-alive\r\n\r\n",
+                                    target.path, target.host, portSuffix, static_cast<unsigned>(length));
+  if (headerLength < 0 || static_cast<size_t>(headerLength) + length > sizeof(request)) {
+    fail(Error::TooLarge);
+    return false;
+  }
+  std::memcpy(request + headerLength, body, length);
+  requestLength = static_cast<size_t>(headerLength) + length;
+
+  if (socketFd >= 0 && keepAlive && target.address == targetAddress && target.port == targetPort && socketAlive()) {
+    reused = true;
+    currentPhase = Phase::Sending;
+    return true;
+  }
+  closeSocket();
+  targetAddress = target.address;
+  targetPort = target.port;
+  return openSocket();
+}
+
+AsyncHttpClient::Phase AsyncHttpClient::poll(uint32_t nowMs) {
+  for (;;) {
+    switch (currentPhase) {
+      case Phase::Connecting: {
+        fd_set writable;
+        FD_ZERO(&writable);
+        FD_SET(socketFd, &writable);
+        timeval immediately = {0, 0};
+        const int ready = select(socketFd + 1, nullptr, &writable, nullptr, &immediately);
+        if (ready == 0) {
+          break;
+        }
+        int socketError = 0;
+        socklen_t errorLength = sizeof(socketError);
+        if (ready < 0 || getsockopt(socketFd, SOL_SOCKET, SO_ERROR, &socketError, &errorLength) != 0 ||
+            socketError != 0) {
+          fail(Error::Connect);
+          continue;
+        }
+        currentPhase = Phase::Sending;
+        continue;
+      }
+
+      case Phase::Sending: {
+        const ssize_t sent =
+            send(socketFd, request + sentBytes, requestLength - sentBytes, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (sent > 0) {
+          sentBytes += static_cast<size_t>(sent);
+          if (sentBytes == requestLength) {
+            currentPhase = Phase::Receiving;
+          }
+          continue;
+        }
+        if (sent < 0 && wouldBlock()) {
+          break;
+        }
+        failOrRetry(Error::Send);
+        continue;
+      }
+
+      case Phase::Receiving: {
+        if (receivedBytes == kResponseCapacity) {
+          fail(Error::TooLarge);
+          continue;
+        }
+        const ssize_t received =
+            recv(socketFd, response + receivedBytes, kResponseCapacity - receivedBytes, MSG_DONTWAIT);
+        if (received > 0) {
+          receivedBytes += static_cast<size_t>(received);
+          response[receivedBytes] = '\0';
+          if (!headersParsed && !parseHeaders()) {
+            fail(Error::Protocol);
+            continue;
+          }
+          if (!headersParsed) {
+            continue;
+          }
+          if (framing == Framing::Length && bodyStart + contentLength > kResponseCapacity) {
+            fail(Error::TooLarge);
+            continue;
+          }
+          const Progress progress = bodyProgress();
+          if (progress == Progress::Invalid) {
+            fail(Error::Protocol);
+          } else if (progress == Progress::Complete) {
+            finish();
+          }
+          continue;
+        }
+        if (received == 0) {
+          // Peer closed: the end of a close-delimited body, otherwise a cut-off response.
+          if (headersParsed && framing == Framing::Close) {
+            bodyBytes = receivedBytes - bodyStart;
+            finish();
+          } else {
+            failOrRetry(Error::Closed);
+          }
+          continue;
+        }
+        if (wouldBlock()) {
+          break;
+        }
+        failOrRetry(Error::Receive);
+        continue;
+      }
+
+      default:
+        return currentPhase;
+    }
+
+    // The socket has nothing more for now.
+    if (sys_clock::reached(nowMs, deadlineMs)) {
+      fail(Error::Timeout);
+    }
+    return currentPhase;
+  }
+}
+
+bool AsyncHttpClient::waitForActivity(uint32_t maxMs) {
+  if (!inFlight()) {
+    return false;
+  }
+  fd_set readable;
+  fd_set writable;
+  FD_ZERO(&readable);
+  FD_ZERO(&writable);
+  FD_SET(socketFd, currentPhase == Phase::Receiving ? &readable : &writable);
+  timeval timeout = {static_cast<time_t>(maxMs / 1000), static_cast<suseconds_t>((maxMs % 1000) * 1000)};
+  select(socketFd + 1, &readable, &writable, nullptr, &timeout);
+  return true;
+}
+
+void AsyncHttpClient::cancel() {
+  if (inFlight()) {
+    fail(Error::Cancelled);
+  }
+}
+
+void AsyncHttpClient::disconnect() {
+  cancel();
+  closeSocket();
+}
+
+bool AsyncHttpClient::openSocket() {
+  socketFd = socket(AF_INET, SOCK_STREAM, 0);
+  if (socketFd < 0) {
+    fail(Error::Connect);
+    return false;
+  }
+  fcntl(socketFd, F_SETFL, fcntl(socketFd, F_GETFL, 0) | O_NONBLOCK);
+  int noDelay = 1;
+  setsockopt(socketFd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+  sockaddr_in address;
+  std::memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_port = htons(targetPort);
+  address.sin_addr.s_addr = targetAddress;
+  ++connects;
+  keepAlive = true;
+  if (connect(socketFd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) == 0) {
+    currentPhase = Phase::Sending;
+    return true;
+  }
+  if (errno == EINPROGRESS) {
+    currentPhase = Phase::Connecting;
+    return true;
+  }
+  fail(Error::Connect);
+  return false;
+}
+
+void AsyncHttpClient::closeSocket() {
+  if (socketFd >= 0) {
+    close(socketFd);
+    socketFd = -1;
+  }
+  keepAlive = false;
+}
+
+bool AsyncHttpClient::socketAlive() const {
+  // An idle kept-alive connection has nothing to read; EOF or stray bytes mean it is done.
+  char peek;
+  return recv(socketFd, &peek, 1, MSG_PEEK | MSG_DONTWAIT) < 0 && wouldBlock();
+}
+
+void AsyncHttpClient::fail(Error error) {
+  closeSocket();
+  lastError = error;
+  currentPhase = Phase::Failed;
+}
+
+void AsyncHttpClient::failOrRetry(Error error) {
+  if (reused && !retried && receivedBytes == 0) {
+    retried = true;
+    reused = false;
+    sentBytes = 0;
+    closeSocket();
+    openSocket();
+    return;
+  }
+  fail(error);
+}
+
+void AsyncHttpClient::finish() {
+  response[bodyStart + bodyBytes] = '\0';
+  currentPhase = Phase::Done;
+  if (!keepAlive) {
+    closeSocket();
+  }
+}
+
+bool AsyncHttpClient::parseHeaders() {
+  const char *headerEnd = std::strstr(response, "\r\n\r\n");
+  if (!headerEnd) {
+    return true;  // A header block that never ends fills the buffer and fails as TooLarge.
+  }
+  if (std::strncmp(response, "HTTP/1.", 7) != 0 || response[8] != ' ' || response[9] < '1' || response[9] > '5') {
+    return false;
+  }
+  statusCode = static_cast<int>(std::strtol(response + 9, nullptr, 10));
+  bool closeRequested = response[7] == '0';  // HTTP/1.0 closes unless told otherwise.
+  bool chunked = false;
+  bool lengthGiven = false;
+
+  for (const char *line = std::strstr(response, "\r\n") + 2; line < headerEnd;) {
+    const char *lineEnd = std::strstr(line, "\r\n");
+    const char *colon = static_cast<const char *>(std::memchr(line, ':', static_cast<size_t>(lineEnd - line)));
+    if (colon) {
+      const char *value = colon + 1;
+      while (value < lineEnd && *value == ' ') {
+        ++value;
+      }
+      if (nameIs(line, colon, "Content-Length")) {
+        contentLength = std::strtoul(value, nullptr, 10);
+        lengthGiven = true;
+      } else if (nameIs(line, colon, "Transfer-Encoding")) {
+        chunked = containsWord(value, lineEnd, "chunked");
+      } else if (nameIs(line, colon, "Connection")) {
+        if (containsWord(value, lineEnd, "close")) {
+          closeRequested = true;
+        } else if (containsWord(value, lineEnd, "keep-alive")) {
+          closeRequested = false;
+        }
+      }
+    }
+    line = lineEnd + 2;
+  }
+
+  bodyStart = static_cast<size_t>(headerEnd + 4 - response);
+  keepAlive = !closeRequested;
+  if (statusCode == 204 || statusCode == 304) {
+    framing = Framing::Length;
+    contentLength = 0;
+  } else if (chunked) {
+    framing = Framing::Chunked;
+  } else if (lengthGiven) {
+    framing = Framing::Length;
+  } else {
+    framing = Framing::Close;
+    keepAlive = false;
+  }
+  headersParsed = true;
+  return true;
+}
+
+AsyncHttpClient::Progress AsyncHttpClient::bodyProgress() {
+  switch (framing) {
+    case Framing::Length:
+      if (receivedBytes - bodyStart < contentLength) {
+        return Progress::Incomplete;
+      }
+      bodyBytes = contentLength;
+      if (receivedBytes - bodyStart > contentLength) {
+        keepAlive = false;  // Unexpected extra bytes; do not read the next response after them.
+      }
+      return Progress::Complete;
+    case Framing::Chunked: {
+      const Progress progress = decodeChunks(false);
+      return progress == Progress::Complete ? decodeChunks(true) : progress;
+    }
+    default:
+      return Progress::Incomplete;
+  }
+}
+
+AsyncHttpClient::Progress AsyncHttpClient::decodeChunks(bool compact) {
+  size_t readAt = bodyStart;
+  size_t writeAt = bodyStart;
+  for (;;) {
+    const char *sizeEnd = std::strstr(response + readAt, "\r\n");
+    if (!sizeEnd) {
+      return Progress::Incomplete;
+    }
+    char *digitsEnd = nullptr;
+    const unsigned long size = std::strtoul(response + readAt, &digitsEnd, 16);
+    if (digitsEnd == response + readAt || size > kResponseCapacity) {
+      return Progress::Invalid;
+    }
+    readAt = static_cast<size_t>(sizeEnd + 2 - response);
+
+    if (size == 0) {
+      // Last chunk; any trailers end with an empty line.
+      if (!std::strstr(response + readAt - 2, "\r\n\r\n")) {
+        return Progress::Incomplete;
+      }
+      bodyBytes = writeAt - bodyStart;
+      return Progress::Complete;
+    }
+    if (readAt + size + 2 > receivedBytes) {
+      return Progress::Incomplete;
+    }
+    if (response[readAt + size] != '\r' || response[readAt + size + 1] != '\n') {
+      return Progress::Invalid;
+    }
+    if (compact) {
+      std::memmove(response + writeAt, response + readAt, size);
+    }
+    writeAt += size;
+    readAt += size + 2;
+  }
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Non-blocking HTTP/1.1 POST client over one BSD socket (lwIP on the ESP32), driven by
+// poll() from the task that owns it. Nothing waits: connecting, sending and receiving
+// each do what the socket allows right now and return. There is a single in-flight
+// slot and the latest request wins: starting a POST cancels the one still pending.
+//
+// The connection is kept open between exchanges when the server allows it. A reused
+// connection that turns out to be dead before any response byte arrives is replaced
+// once, transparently. Responses may use Content-Length, chunked encoding or end at
+// connection close.
+//
+// Request and response live in fixed buffers. A request or response that does not fit
+// fails with Error::TooLarge.
+class AsyncHttpClient {
+ public:
+  static constexpr size_t kRequestCapacity = 768;
+  static constexpr size_t kResponseCapacity = 1024;
+
+  enum class Phase : uint8_t { Idle, Connecting, Sending, Receiving, Done, Failed };
+  enum class Error : uint8_t { None, Connect, Send, Receive, Closed, Timeout, Protocol, TooLarge, Cancelled };
+
+  struct Target {
+    uint32_t address = 0;  // IPv4, network byte order (as IPAddress stores it).
+    uint16_t port = 80;
+    const char *host = "";  // For the Host header.
+    const char *path = "/";
+  };
+
+  AsyncHttpClient() = default;
+  ~AsyncHttpClient();
+  AsyncHttpClient(const AsyncHttpClient &) = delete;
+  AsyncHttpClient &operator=(const AsyncHttpClient &) = delete;
+
+  // Starts POSTing the JSON `body` to `target`, cancelling an exchange still in flight.
+  // The exchange fails with Error::Timeout unless it completes within `timeoutMs`.
+  // Returns false when it could not be started; phase() is then Failed.
+  bool startPost(const Target &target, const char *body, size_t length, uint32_t nowMs, uint32_t timeoutMs);
+
+  // Advances the exchange as far as the socket allows without waiting.
+  Phase poll(uint32_t nowMs);
+
+  // Sleeps up to `maxMs` until the socket can make progress for the exchange in flight.
+  // Returns false at once when nothing is in flight.
+  bool waitForActivity(uint32_t maxMs);
+
+  // Abandons the exchange in flight. Its connection is dropped as well, since a
+  // half-sent request or half-read response leaves it unusable.
+  void cancel();
+
+  // Closes the kept-alive connection, if any.
+  void disconnect();
+
+  Phase phase() const { return currentPhase; }
+  Error error() const { return lastError; }
+  bool inFlight() const;
+  int status() const { return statusCode; }  // HTTP status once Done.
+  const char *body() const { return response + bodyStart; }  // NUL-terminated once Done.
+  size_t bodyLength() const { return bodyBytes; }
+  bool reusedConnection() const { return reused; }  // Sent on a kept-alive connection.
+  uint32_t connectCount() const { return connects; }
+
+ private:
+  enum class Framing : uint8_t { Unknown, Length, Chunked, Close };
+  enum class Progress : uint8_t { Incomplete, Complete, Invalid };
+
+  bool openSocket();
+  void closeSocket();
+  bool socketAlive() const;
+  void fail(Error error);
+  // Reopens the connection when a reused one died before answering; otherwise fails.
+  void failOrRetry(Error error);
+  void finish();
+  // False on a malformed status line; sets headersParsed once the header block is in.
+  bool parseHeaders();
+  // Sets bodyBytes once the whole body is in.
+  Progress bodyProgress();
+  // Walks the chunks received so far; `compact` also moves their data together.
+  Progress decodeChunks(bool compact);
+
+  int socketFd = -1;
+  uint32_t targetAddress = 0;
+  uint16_t targetPort = 0;
+  bool keepAlive = false;
+  uint32_t connects = 0;
+
+  Phase currentPhase = Phase::Idle;
+  Error lastError = Error::None;
+  uint32_t deadlineMs = 0;
+  bool reused = false;
+  bool retried = false;
+
+  char request[kRequestCapacity];
+  size_t requestLength = 0;
+  size_t sentBytes = 0;
+
+  char response[kResponseCapacity + 1] = {0};
+  size_t receivedBytes = 0;
+  bool headersParsed = false;
+  Framing framing = Framing::Unknown;
+  int statusCode = 0;
+  size_t bodyStart = 0;
+  size_t contentLength = 0;
+  size_t bodyBytes = 0;
+};
@@ -0,0 +1,37 @@
+#include "core/clock.h"
+
+#ifdef ESP_PLATFORM
+#include <esp_attr.h>
+#include <esp_timer.h>
+#else
+#include <chrono>
+#endif
+
+namespace sys_clock {
+namespace {
+thread_local uint64_t frameStartUs = 0;
+#ifndef ESP_PLATFORM
+HostTimeSource hostSource = nullptr;
+#endif
+}  // namespace
+
+#ifdef ESP_PLATFORM
+// In IRAM because scheduler::postFromIsr() timestamps events with it.
+uint64_t IRAM_ATTR nowUs() { return static_cast<uint64_t>(esp_timer_get_time()); }
+#else
+uint64_t nowUs() {
+  if (hostSource != nullptr) {
+    return hostSource();
+  }
+  static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+void setHostTimeSource(HostTimeSource source) { hostSource = source; }
+#endif
+
+void beginFrame() { frameStartUs = nowUs(); }
+
+uint64_t frameUs() { return frameStartUs; }
+}  // namespace sys_clock
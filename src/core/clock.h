@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdint.h>
+
+// Single time base for every module. The source is the 64-bit esp_timer counter:
+// microseconds since boot, monotonic, and it never wraps in practice.
+//
+// Millisecond timestamps handed between modules (deadlines, GameInputs, task `now`
+// arguments) are the low 32 bits of that clock in ms. They wrap after ~49.7 days, so
+// they are only ever subtracted or compared with reached(), never with `<`.
+//
+// The frame time is sampled once by beginFrame() at the start of each scheduler pass,
+// RTOS stage run and network loop iteration, and reused by everything that runs in it,
+// so one game tick sees one time. It is cached per FreeRTOS task. Code that needs the
+// wall time mid-frame (profiling, timestamps around a blocking call) uses now*().
+namespace sys_clock {
+uint64_t nowUs();
+inline uint32_t nowMs() { return static_cast<uint32_t>(nowUs() / 1000); }
+
+void beginFrame();
+uint64_t frameUs();
+inline uint32_t frameMs() { return static_cast<uint32_t>(frameUs() / 1000); }
+
+constexpr uint32_t usToMs(uint64_t us) { return static_cast<uint32_t>(us / 1000); }
+constexpr uint64_t msToUs(uint32_t ms) { return static_cast<uint64_t>(ms) * 1000; }
+
+// True once `nowMs` is at or past `deadlineMs`; valid across the 32-bit wrap for
+// deadlines less than ~24.8 days away.
+constexpr bool reached(uint32_t nowMs, uint32_t deadlineMs) { return static_cast<int32_t>(nowMs - deadlineMs) >= 0; }
+
+#ifndef ESP_PLATFORM
+// Host builds (native tests and tools) count from the first call on the monotonic
+// clock; tests install a virtual clock here instead. nullptr restores the default.
+using HostTimeSource = uint64_t (*)();
+void setHostTimeSource(HostTimeSource source);
+#endif
+}  // namespace sys_clock
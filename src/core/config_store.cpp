@@ -0,0 +1,23 @@
+#include "core/config_store.h"
+
+#include <atomic>
+
+namespace config_store {
+namespace {
+ConfigSnapshot slots[kSlots];
+std::atomic<const ConfigSnapshot *> active{&slots[0]};
+size_t activeIndex = 0;  // Writer-side only.
+}  // namespace
+
+const ConfigSnapshot &current() { return *active.load(std::memory_order_acquire); }
+
+const ConfigSnapshot &publish(const ConfigSnapshot &next) {
+  const size_t index = (activeIndex + 1) % kSlots;
+  ConfigSnapshot &slot = slots[index];
+  slot = next;
+  slot.version = slots[activeIndex].version + 1;
+  active.store(&slot, std::memory_order_release);
+  activeIndex = index;
+  return slot;
+}
+}  // namespace config_store
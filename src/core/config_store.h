@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "core/game_mode.h"
+
+// Device configuration as set through the portal and persisted in NVS, published as
+// immutable snapshots. Readers get a reference to the snapshot in effect and never
+// copy or allocate; the writer fills a spare slot and swaps it in with one atomic
+// pointer store, so a reader sees either the old or the new configuration whole.
+//
+// Slots are recycled: a reference stays valid until two further publish() calls.
+// Readers take one per tick or request and drop it at the end; publishes come from
+// the portal, seconds apart at the very least.
+struct ConfigSnapshot {
+  static constexpr size_t kMaxSsidLength = 32;
+  static constexpr size_t kMaxPasswordLength = 64;
+  static constexpr size_t kMaxDefuseCodeLength = 32;
+  static constexpr size_t kMaxEndpointLength = 160;
+
+  uint32_t version = 0;  // Bumped by every publish(); 0 until the first one.
+  char wifiSsid[kMaxSsidLength + 1] = {0};
+  char wifiPass[kMaxPasswordLength + 1] = {0};
+  char defuseCode[kMaxDefuseCodeLength + 1] = {0};
+  char apiEndpoint[kMaxEndpointLength + 1] = {0};
+  uint32_t bombDurationMs = 0;
+  game_mode::GameMode gameMode;  // Compiled from its rules string before publishing.
+};
+
+namespace config_store {
+constexpr size_t kSlots = 3;
+
+const ConfigSnapshot &current();
+
+// Copies `next` into a spare slot, stamps the next version and makes it current.
+// Single writer: call from one task only (the loop task).
+const ConfigSnapshot &publish(const ConfigSnapshot &next);
+
+// Copies `value` into a snapshot field. Returns false, leaving the field untouched,
+// when it does not fit.
+template <size_t N>
+bool assign(char (&field)[N], const char *value) {
+  const size_t length = strlen(value);
+  if (length >= N) {
+    return false;
+  }
+  memcpy(field, value, length + 1);
+  return true;
+}
+}  // namespace config_store
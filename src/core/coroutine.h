@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Stackless, protothread-style coroutines for multi-step sequences. A coroutine is a
+// function `CoStatus body(Frame &co, uint32_t nowMs)` where Frame derives from
+// Coroutine; the body is written linearly between CO_BEGIN and CO_END and suspends
+// with CO_SLEEP_MS. The frame struct is the coroutine's entire state: ordinary locals
+// do not survive a suspension, so anything needed afterwards must be a frame member.
+// That keeps frames static, allocation-free and bounded by kMaxCoroutineFrameBytes.
+//
+// The host decides how a sleep is honoured: scheduler::addCoroutine() turns it into
+// the task's next deadline, and a TimerWheel host re-arms a one-shot timer.
+//
+// Restrictions of the switch-based expansion: at most one CO_SLEEP_MS per source line,
+// and the body must not contain its own switch statement spanning a suspension.
+
+enum class CoStatus : uint8_t {
+  Sleeping,  // Suspended; resume after `sleepMs`.
+  Done,      // Reached CO_END; the next resume starts from the top.
+};
+
+struct Coroutine {
+  uint16_t resumeLine = 0;
+  uint32_t sleepMs = 0;
+
+  void restart() { resumeLine = 0; }
+};
+
+constexpr size_t kMaxCoroutineFrameBytes = 32;
+
+#define CO_BEGIN(co)           \
+  switch ((co).resumeLine) {   \
+    case 0:
+
+#define CO_SLEEP_MS(co, ms)             \
+  do {                                  \
+    (co).sleepMs = (ms);                \
+    (co).resumeLine = __LINE__;         \
+    return CoStatus::Sleeping;          \
+    case __LINE__:;                     \
+  } while (0)
+
+// Ends the sequence early from anywhere inside the body.
+#define CO_EXIT(co)            \
+  do {                         \
+    (co).resumeLine = 0;       \
+    return CoStatus::Done;     \
+  } while (0)
+
+#define CO_END(co)             \
+  }                            \
+  (co).resumeLine = 0;         \
+  return CoStatus::Done
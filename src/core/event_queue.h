@@ -0,0 +1,86 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+// Bounded lock-free multi-producer queue (Vyukov-style sequenced ring). Each cell
+// carries a sequence number that tells producers and the consumer whose turn it is,
+// so push() never blocks and is safe from ISRs and from tasks on either core. A
+// producer interrupted mid-push only delays that one cell; other producers claim the
+// next cells and the consumer stops at the unfinished one until it is published.
+template <typename T, size_t Capacity>
+class EventQueue {
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "EventQueue capacity must be a power of two");
+
+ public:
+  EventQueue() {
+    for (size_t i = 0; i < Capacity; ++i) {
+      cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  EventQueue(const EventQueue &) = delete;
+  EventQueue &operator=(const EventQueue &) = delete;
+
+  // Returns false when the queue is full; the caller decides whether that is an error.
+  // Always inlined so an IRAM_ATTR caller keeps the whole push in IRAM.
+  __attribute__((always_inline)) bool push(const T &value) {
+    size_t pos = enqueuePos.load(std::memory_order_relaxed);
+    Cell *cell = nullptr;
+    for (;;) {
+      cell = &cells[pos & kMask];
+      const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+      const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = enqueuePos.load(std::memory_order_relaxed);
+      }
+    }
+
+    cell->value = value;
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Returns false when no completed element is available.
+  bool pop(T &out) {
+    size_t pos = dequeuePos.load(std::memory_order_relaxed);
+    Cell *cell = nullptr;
+    for (;;) {
+      cell = &cells[pos & kMask];
+      const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+      const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+      if (diff == 0) {
+        if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = dequeuePos.load(std::memory_order_relaxed);
+      }
+    }
+
+    out = cell->value;
+    cell->sequence.store(pos + Capacity, std::memory_order_release);
+    return true;
+  }
+
+ private:
+  static constexpr size_t kMask = Capacity - 1;
+
+  struct Cell {
+    std::atomic<size_t> sequence;
+    T value;
+  };
+
+  Cell cells[Capacity];
+  std::atomic<size_t> enqueuePos{0};
+  std::atomic<size_t> dequeuePos{0};
+};
@@ -0,0 +1,183 @@
+#include "core/game_mode.h"
+
+#include <cstring>
+
+namespace game_mode {
+namespace {
+const GameMode builtInMode;
+
+// A [begin, end) slice of the rules string.
+struct Span {
+  const char *begin;
+  const char *end;
+
+  bool empty() const { return begin == end; }
+  bool is(const char *word) const {
+    const size_t length = std::strlen(word);
+    return static_cast<size_t>(end - begin) == length && std::memcmp(begin, word, length) == 0;
+  }
+};
+
+Span trim(Span span) {
+  while (span.begin < span.end && *span.begin == ' ') {
+    ++span.begin;
+  }
+  while (span.end > span.begin && span.end[-1] == ' ') {
+    --span.end;
+  }
+  return span;
+}
+
+// Splits off the text up to the next `separator` (or the end) and advances `rest` past it.
+Span next(Span &rest, char separator) {
+  const char *stop = rest.begin;
+  while (stop < rest.end && *stop != separator) {
+    ++stop;
+  }
+  const Span token = trim(Span{rest.begin, stop});
+  rest.begin = stop < rest.end ? stop + 1 : stop;
+  return token;
+}
+
+bool parseMs(Span digits, uint32_t &ms) {
+  if (digits.empty()) {
+    return false;
+  }
+  uint32_t value = 0;
+  for (const char *p = digits.begin; p < digits.end; ++p) {
+    if (*p < '0' || *p > '9') {
+      return false;
+    }
+    value = value * 10 + static_cast<uint32_t>(*p - '0');
+    if (value > kMaxStepMs) {
+      return false;
+    }
+  }
+  if (value == 0) {
+    return false;
+  }
+  ms = value;
+  return true;
+}
+
+// "name" or "name:ms"; `ms` is left as is when no duration is given.
+bool parseTimed(Span item, Span &name, uint32_t &ms) {
+  const char *colon = item.begin;
+  while (colon < item.end && *colon != ':') {
+    ++colon;
+  }
+  name = trim(Span{item.begin, colon});
+  return colon == item.end || parseMs(trim(Span{colon + 1, item.end}), ms);
+}
+
+uint32_t hashRules(const char *rules) {
+  uint32_t hash = 2166136261u;  // FNV-1a
+  for (const char *p = rules; *p != '\0'; ++p) {
+    hash = (hash ^ static_cast<uint8_t>(*p)) * 16777619u;
+  }
+  return hash == 0 ? 1 : hash;
+}
+
+const char *compileArm(Span value, GameMode &mode) {
+  mode.armStepCount = 0;
+  while (!value.empty()) {
+    if (mode.armStepCount == kMaxArmSteps) {
+      return "too many arming steps";
+    }
+    Step &step = mode.armSteps[mode.armStepCount];
+    Span name;
+    uint32_t ms = 0;
+    if (!parseTimed(next(value, ','), name, ms)) {
+      return "bad arming step duration";
+    }
+    if (name.is("hold")) {
+      step = Step{ArmStep::Hold, ms ? ms : BUTTON_HOLD_MS};
+    } else if (name.is("ir")) {
+      step = Step{ArmStep::IrConfirm, ms ? ms : IR_CONFIRM_WINDOW_MS};
+    } else {
+      return "unknown arming step";
+    }
+    ++mode.armStepCount;
+  }
+  if (mode.armStepCount == 0 || mode.armSteps[0].kind != ArmStep::Hold) {
+    return "arming must start with a hold";
+  }
+  return nullptr;
+}
+
+const char *compileDefuse(Span value, GameMode &mode) {
+  Span name;
+  uint32_t ms = 0;
+  if (!parseTimed(value, name, ms)) {
+    return "bad defuse hold duration";
+  }
+  if (name.is("code") && ms == 0) {
+    mode.defuse = DefuseMethod::Code;
+  } else if (name.is("hold")) {
+    mode.defuse = DefuseMethod::Hold;
+    mode.defuseHoldMs = ms ? ms : BUTTON_HOLD_MS;
+  } else {
+    return "unknown defuse method";
+  }
+  return nullptr;
+}
+
+const char *compileOutcome(Span value, GameMode &mode) {
+  if (value.is("defused")) {
+    mode.outcome = DefuseOutcome::Defused;
+  } else if (value.is("neutral")) {
+    mode.outcome = DefuseOutcome::Neutral;
+  } else {
+    return "unknown outcome";
+  }
+  return nullptr;
+}
+
+const char *compileInto(const char *rules, GameMode &mode) {
+  const size_t length = std::strlen(rules);
+  if (length > kMaxRulesLength) {
+    return "rules too long";
+  }
+  Span rest{rules, rules + length};
+  while (!rest.empty()) {
+    Span clause = next(rest, ';');
+    if (clause.empty()) {
+      continue;
+    }
+    const Span key = next(clause, '=');
+    const Span value = trim(clause);
+    const char *error = nullptr;
+    if (key.is("arm")) {
+      error = compileArm(value, mode);
+    } else if (key.is("defuse")) {
+      error = compileDefuse(value, mode);
+    } else if (key.is("outcome")) {
+      error = compileOutcome(value, mode);
+    } else {
+      error = "unknown rule";
+    }
+    if (error) {
+      return error;
+    }
+  }
+  std::memcpy(mode.rules, rules, length + 1);
+  mode.id = length == 0 ? 0 : hashRules(rules);
+  return nullptr;
+}
+}  // namespace
+
+const GameMode &builtIn() { return builtInMode; }
+
+bool compile(const char *rules, GameMode &mode, const char **error) {
+  GameMode compiled;
+  const char *problem = compileInto(rules, compiled);
+  if (problem) {
+    if (error) {
+      *error = problem;
+    }
+    return false;
+  }
+  mode = compiled;
+  return true;
+}
+}  // namespace game_mode
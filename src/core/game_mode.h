@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "game_config.h"
+
+// Game mode rules. A mode is written as a short rules string (kept in NVS and editable
+// in the config portal) and compiled once, when the configuration is published, into
+// a GameMode the engine executes without parsing anything per tick:
+//
+//   arm=<step>[,<step>...]   arming sequence, 1..kMaxArmSteps steps, starting with a hold
+//                              hold[:ms]  both buttons held (default BUTTON_HOLD_MS)
+//                              ir[:ms]    IR confirmation window (default IR_CONFIRM_WINDOW_MS)
+//   defuse=code | hold[:ms]  keypad code, or both buttons held while armed
+//   outcome=defused | neutral
+//                            what a defuse does: end the round (DEFUSED), or neutralise
+//                            the device back to ACTIVE so it can be captured again
+//
+// Clauses are separated by ';' and may come in any order; missing ones keep the
+// built-in search-and-destroy values. The empty string is the built-in mode:
+// "arm=hold,ir;defuse=code;outcome=defused". Examples:
+//   "defuse=hold:8000"                     hold-to-defuse
+//   "arm=hold,ir,hold:5000"                multi-stage arming
+//   "arm=hold:10000;defuse=hold:10000;outcome=neutral"
+//                                          domination-style capture point
+namespace game_mode {
+constexpr size_t kMaxRulesLength = 63;
+constexpr size_t kMaxArmSteps = 4;
+constexpr uint32_t kMaxStepMs = 600000;
+
+enum class ArmStep : uint8_t { Hold, IrConfirm };
+enum class DefuseMethod : uint8_t { Code, Hold };
+enum class DefuseOutcome : uint8_t { Defused, Neutral };
+
+struct Step {
+  ArmStep kind;
+  uint32_t durationMs;
+};
+
+struct GameMode {
+  uint32_t id = 0;  // Hash of `rules`; 0 for the built-in mode.
+  char rules[kMaxRulesLength + 1] = {0};
+
+  Step armSteps[kMaxArmSteps] = {{ArmStep::Hold, BUTTON_HOLD_MS}, {ArmStep::IrConfirm, IR_CONFIRM_WINDOW_MS}};
+  uint8_t armStepCount = 2;
+  DefuseMethod defuse = DefuseMethod::Code;
+  uint32_t defuseHoldMs = BUTTON_HOLD_MS;
+  DefuseOutcome outcome = DefuseOutcome::Defused;
+};
+
+const GameMode &builtIn();
+
+// Compiles `rules` into `mode`. On failure returns false, leaves `mode` untouched and
+// points `error` (when given) at a static description of the problem.
+bool compile(const char *rules, GameMode &mode, const char **error = nullptr);
+}  // namespace game_mode
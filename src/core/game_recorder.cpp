@@ -0,0 +1,534 @@
+#include "core/game_recorder.h"
+
+#include <cstring>
+
+namespace game_recorder {
+namespace {
+constexpr uint8_t kBoolsChanged = 0x01;
+constexpr uint8_t kApiMsChanged = 0x02;
+constexpr uint8_t kStatusChanged = 0x04;
+constexpr uint8_t kBombDurationChanged = 0x08;
+constexpr uint8_t kDefuseCodeChanged = 0x10;
+constexpr uint8_t kKeypadDigitChanged = 0x20;
+constexpr uint8_t kOutputsChanged = 0x40;
+constexpr uint8_t kAllTickFields = 0x7f;
+
+constexpr uint8_t kSetStateTag = 0x80;
+constexpr uint8_t kMatchStatusTag = 0x81;
+constexpr uint8_t kGapTag = 0x82;
+constexpr uint8_t kGameModeTag = 0x83;
+constexpr uint8_t kResumeTag = 0x84;
+
+constexpr char kMagic[4] = {'G', 'R', 'E', 'C'};
+
+static_assert((Recorder::kRingBytes & (Recorder::kRingBytes - 1)) == 0, "Recorder ring size must be a power of two");
+
+uint8_t packBools(const GameInputs &inputs) {
+  return static_cast<uint8_t>((inputs.wifiConnected ? 0x01 : 0) | (inputs.apiResponseReceived ? 0x02 : 0) |
+                              (inputs.bothButtonsPressed ? 0x04 : 0) | (inputs.keypadDigitAvailable ? 0x08 : 0) |
+                              (inputs.irConfirmationReceived ? 0x10 : 0) | (inputs.bombDeadlineElapsed ? 0x20 : 0));
+}
+
+void unpackBools(uint8_t bools, GameInputs &inputs) {
+  inputs.wifiConnected = (bools & 0x01) != 0;
+  inputs.apiResponseReceived = (bools & 0x02) != 0;
+  inputs.bothButtonsPressed = (bools & 0x04) != 0;
+  inputs.keypadDigitAvailable = (bools & 0x08) != 0;
+  inputs.irConfirmationReceived = (bools & 0x10) != 0;
+  inputs.bombDeadlineElapsed = (bools & 0x20) != 0;
+}
+
+void putVarint(uint8_t *&out, uint64_t value) {
+  while (value >= 0x80) {
+    *out++ = static_cast<uint8_t>(value | 0x80);
+    value >>= 7;
+  }
+  *out++ = static_cast<uint8_t>(value);
+}
+
+void putSignedVarint(uint8_t *&out, int64_t value) {
+  putVarint(out, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+// Bounds-checked cursor over a recorded stream; any overrun clears `ok`.
+struct Reader {
+  const uint8_t *data;
+  size_t length;
+  size_t position;
+  bool ok;
+
+  uint8_t u8() {
+    if (position >= length) {
+      ok = false;
+      return 0;
+    }
+    return data[position++];
+  }
+
+  uint64_t varint() {
+    uint64_t value = 0;
+    for (uint8_t shift = 0; shift < 64; shift += 7) {
+      const uint8_t byte = u8();
+      value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0) {
+        return value;
+      }
+    }
+    ok = false;
+    return 0;
+  }
+
+  int64_t signedVarint() {
+    const uint64_t value = varint();
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+  }
+};
+}  // namespace
+
+uint16_t packOutputs(const GameOutputs &outputs) {
+  return static_cast<uint16_t>((outputs.stateChanged ? 0x001 : 0) | (outputs.showArmingConfirmPrompt ? 0x002 : 0) |
+                               (outputs.armingConfirmNeededEffect ? 0x004 : 0) |
+                               (outputs.armingConfirmedEffect ? 0x008 : 0) | (outputs.wrongCodeEffect ? 0x010 : 0) |
+                               (outputs.keypadDigitEffect ? 0x020 : 0) | (outputs.clearIrConfirmation ? 0x040 : 0) |
+                               (outputs.gameOverSet ? 0x080 : 0) | (outputs.gameOver ? 0x100 : 0) |
+                               ((outputs.previousState & 0x7) << 9) | ((outputs.newState & 0x7) << 12));
+}
+
+void Recorder::start() {
+  head.store(0, std::memory_order_relaxed);
+  tail.store(0, std::memory_order_relaxed);
+  dropped.store(0, std::memory_order_relaxed);
+  segmentPending.store(false, std::memory_order_relaxed);
+  inGap = false;
+  resetLastRecorded();
+
+  uint8_t header[kHeaderBytes];
+  std::memcpy(header, kMagic, sizeof(kMagic));
+  header[4] = kStreamVersion;
+  appendRecord(header, sizeof(header));
+}
+
+// A new stream starts from a fresh engine, so its first tick is a keyframe.
+void Recorder::resetLastRecorded() {
+  keyframePending = true;
+  lastNowMs = 0;
+  lastApiMs = 0;
+  lastBools = 0;
+  lastStatus = 0;
+  lastBombDurationMs = 0;
+  lastDefuseCode[0] = '\0';
+  lastDefuseCodeLength = 0;
+  lastKeypadDigit = '\0';
+  lastOutputs = 0;
+  lastModeId = 0;
+}
+
+void Recorder::recordTick(const GameInputs &inputs, const GameOutputs &outputs) {
+  encodeModeIfChanged(inputs);
+  uint8_t record[kMaxRecordBytes];
+  appendRecord(record, encodeTick(inputs, outputs, record));
+}
+
+void Recorder::recordSetState(FlameState state, uint32_t nowMs) {
+  uint8_t record[kMaxRecordBytes];
+  uint8_t *cursor = record;
+  *cursor++ = kSetStateTag;
+  putSignedVarint(cursor, static_cast<int32_t>(nowMs - lastNowMs));
+  *cursor++ = static_cast<uint8_t>(state);
+  lastNowMs = nowMs;
+  appendRecord(record, static_cast<size_t>(cursor - record));
+}
+
+void Recorder::recordMatchStatus(MatchStatus status) {
+  const uint8_t record[2] = {kMatchStatusTag, static_cast<uint8_t>(status)};
+  appendRecord(record, sizeof(record));
+}
+
+void Recorder::recordResume(const ResumePoint &point, uint32_t nowMs) {
+  uint8_t record[kMaxRecordBytes];
+  appendRecord(record, encodeResume(point, nowMs, record));
+}
+
+bool Recorder::startSegment(const ResumePoint &point, uint32_t nowMs) {
+  if (segmentPending.load(std::memory_order_acquire)) {
+    return false;
+  }
+  uint8_t record[kHeaderBytes + kMaxRecordBytes];
+  std::memcpy(record, kMagic, sizeof(kMagic));
+  record[4] = kStreamVersion;
+  const uint32_t previousNowMs = lastNowMs;
+  lastNowMs = 0;
+  const size_t length = kHeaderBytes + encodeResume(point, nowMs, record + kHeaderBytes);
+
+  // Checked up front: a failed append would mark a gap at the segment boundary.
+  const size_t position = head.load(std::memory_order_relaxed);
+  if (kRingBytes - (position - tail.load(std::memory_order_acquire)) < length + 1) {
+    lastNowMs = previousNowMs;
+    return false;
+  }
+  // Published before the header, so a drain that sees the header also sees the boundary.
+  segmentStart.store(position, std::memory_order_relaxed);
+  segmentPending.store(true, std::memory_order_release);
+  appendRecord(record, length);
+  resetLastRecorded();
+  lastNowMs = nowMs;
+  return true;
+}
+
+bool Recorder::takeSegmentStart() {
+  if (!segmentPending.load(std::memory_order_acquire) ||
+      tail.load(std::memory_order_relaxed) != segmentStart.load(std::memory_order_relaxed)) {
+    return false;
+  }
+  segmentPending.store(false, std::memory_order_release);
+  return true;
+}
+
+size_t Recorder::encodeResume(const ResumePoint &point, uint32_t nowMs, uint8_t *out) {
+  uint8_t *cursor = out;
+  *cursor++ = kResumeTag;
+  putSignedVarint(cursor, static_cast<int32_t>(nowMs - lastNowMs));
+  *cursor++ = static_cast<uint8_t>(point.state);
+  *cursor++ = static_cast<uint8_t>(point.matchStatus);
+  putVarint(cursor, point.bombDurationMs);
+  putVarint(cursor, point.bombRemainingMs);
+  const uint8_t digits = point.enteredDigits > DEFUSE_CODE_LENGTH ? DEFUSE_CODE_LENGTH : point.enteredDigits;
+  *cursor++ = digits;
+  std::memcpy(cursor, point.defuseBuffer, digits);
+  cursor += digits;
+  lastNowMs = nowMs;
+  return static_cast<size_t>(cursor - out);
+}
+
+size_t Recorder::drain(Sink sink) {
+  size_t position = tail.load(std::memory_order_relaxed);
+  size_t end = head.load(std::memory_order_acquire);
+  if (segmentPending.load(std::memory_order_acquire)) {
+    end = segmentStart.load(std::memory_order_relaxed);
+  }
+  size_t total = 0;
+  while (position != end) {
+    const size_t offset = position & (kRingBytes - 1);
+    size_t chunk = end - position;
+    if (chunk > kRingBytes - offset) {
+      chunk = kRingBytes - offset;
+    }
+    const size_t accepted = sink(ring + offset, chunk);
+    position += accepted;
+    total += accepted;
+    tail.store(position, std::memory_order_release);
+    if (accepted < chunk) {
+      break;
+    }
+  }
+  return total;
+}
+
+size_t Recorder::pendingBytes() const {
+  return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+}
+
+// All-or-nothing: a record that does not fit is dropped. The first drop writes a gap
+// marker into the byte kept in reserve for it, and the next record that fits is
+// written as a keyframe.
+bool Recorder::appendRecord(const uint8_t *data, size_t length) {
+  size_t position = head.load(std::memory_order_relaxed);
+  const size_t freeBytes = kRingBytes - (position - tail.load(std::memory_order_acquire));
+  if (freeBytes < length + 1) {
+    dropped.fetch_add(1, std::memory_order_relaxed);
+    keyframePending = true;
+    if (!inGap && freeBytes > 0) {
+      ring[position++ & (kRingBytes - 1)] = kGapTag;
+      head.store(position, std::memory_order_release);
+      inGap = true;
+    }
+    return false;
+  }
+
+  for (size_t i = 0; i < length; ++i) {
+    ring[position++ & (kRingBytes - 1)] = data[i];
+  }
+  head.store(position, std::memory_order_release);
+  inGap = false;
+  return true;
+}
+
+// Written ahead of a keyframe too, so a stream resumed after a gap names its mode.
+void Recorder::encodeModeIfChanged(const GameInputs &inputs) {
+  const game_mode::GameMode &mode = inputs.gameMode ? *inputs.gameMode : game_mode::builtIn();
+  if (mode.id == lastModeId && !keyframePending) {
+    return;
+  }
+  uint8_t record[2 + game_mode::kMaxRulesLength];
+  const size_t rulesLength = std::strlen(mode.rules);
+  record[0] = kGameModeTag;
+  record[1] = static_cast<uint8_t>(rulesLength);
+  std::memcpy(record + 2, mode.rules, rulesLength);
+  appendRecord(record, 2 + rulesLength);
+  lastModeId = mode.id;
+}
+
+size_t Recorder::encodeTick(const GameInputs &inputs, const GameOutputs &outputs, uint8_t *out) {
+  const uint8_t bools = packBools(inputs);
+  const uint8_t status = static_cast<uint8_t>(inputs.remoteMatchStatus);
+  const char *code = inputs.configuredDefuseCode;
+  size_t codeLength = std::strlen(code);
+  if (codeLength > kMaxDefuseCodeBytes) {
+    codeLength = kMaxDefuseCodeBytes;
+  }
+  const uint16_t outputsWord = packOutputs(outputs);
+
+  uint8_t flags = keyframePending ? kAllTickFields : 0;
+  if (bools != lastBools) {
+    flags |= kBoolsChanged;
+  }
+  if (inputs.lastSuccessfulApiMs != lastApiMs) {
+    flags |= kApiMsChanged;
+  }
+  if (status != lastStatus) {
+    flags |= kStatusChanged;
+  }
+  if (inputs.configuredBombDurationMs != lastBombDurationMs) {
+    flags |= kBombDurationChanged;
+  }
+  if (codeLength != lastDefuseCodeLength || std::memcmp(code, lastDefuseCode, codeLength) != 0) {
+    flags |= kDefuseCodeChanged;
+  }
+  if (inputs.keypadDigit != lastKeypadDigit) {
+    flags |= kKeypadDigitChanged;
+  }
+  if (outputsWord != lastOutputs) {
+    flags |= kOutputsChanged;
+  }
+
+  uint8_t *cursor = out;
+  *cursor++ = flags;
+  putSignedVarint(cursor, static_cast<int32_t>(inputs.nowMs - lastNowMs));
+  if (flags & kBoolsChanged) {
+    *cursor++ = bools;
+  }
+  if (flags & kApiMsChanged) {
+    putSignedVarint(cursor, static_cast<int32_t>(inputs.lastSuccessfulApiMs - lastApiMs));
+  }
+  if (flags & kStatusChanged) {
+    *cursor++ = status;
+  }
+  if (flags & kBombDurationChanged) {
+    putVarint(cursor, inputs.configuredBombDurationMs);
+  }
+  if (flags & kDefuseCodeChanged) {
+    *cursor++ = static_cast<uint8_t>(codeLength);
+    std::memcpy(cursor, code, codeLength);
+    cursor += codeLength;
+  }
+  if (flags & kKeypadDigitChanged) {
+    *cursor++ = static_cast<uint8_t>(inputs.keypadDigit);
+  }
+  if (flags & kOutputsChanged) {
+    *cursor++ = static_cast<uint8_t>(outputsWord);
+    *cursor++ = static_cast<uint8_t>(outputsWord >> 8);
+  }
+
+  lastNowMs = inputs.nowMs;
+  lastApiMs = inputs.lastSuccessfulApiMs;
+  lastBools = bools;
+  lastStatus = status;
+  lastBombDurationMs = inputs.configuredBombDurationMs;
+  std::memcpy(lastDefuseCode, code, codeLength);
+  lastDefuseCode[codeLength] = '\0';
+  lastDefuseCodeLength = static_cast<uint8_t>(codeLength);
+  lastKeypadDigit = inputs.keypadDigit;
+  lastOutputs = outputsWord;
+  keyframePending = false;
+  return static_cast<size_t>(cursor - out);
+}
+
+ReplayResult replay(const uint8_t *data, size_t length, game_state::GameEngine &engine) {
+  ReplayResult result;
+  if (length < kHeaderBytes || std::memcmp(data, kMagic, sizeof(kMagic)) != 0 || data[4] == 0 || data[4] > kStreamVersion) {
+    result.end = ReplayEnd::BadHeader;
+    return result;
+  }
+
+  Reader reader{data, length, kHeaderBytes, true};
+  GameInputs inputs;
+  uint16_t expectedOutputs = 0;
+  char code[kMaxDefuseCodeBytes + 1] = {0};
+  game_mode::GameMode mode;
+
+  while (reader.position < length) {
+    const uint8_t tag = reader.u8();
+    if (tag == kGapTag) {
+      result.end = ReplayEnd::Gap;
+      return result;
+    }
+
+    if (tag == kSetStateTag) {
+      const int32_t dtMs = static_cast<int32_t>(reader.signedVarint());
+      const uint8_t state = reader.u8();
+      if (!reader.ok) {
+        break;
+      }
+      if (state > ERROR_STATE) {
+        result.end = ReplayEnd::Corrupt;
+        return result;
+      }
+      inputs.nowMs += static_cast<uint32_t>(dtMs);
+      engine.set_state(static_cast<FlameState>(state), inputs.nowMs);
+      ++result.overrides;
+      continue;
+    }
+
+    if (tag == kMatchStatusTag) {
+      const uint8_t status = reader.u8();
+      if (!reader.ok) {
+        break;
+      }
+      if (status > Cancelled) {
+        result.end = ReplayEnd::Corrupt;
+        return result;
+      }
+      engine.set_match_status(static_cast<MatchStatus>(status));
+      ++result.overrides;
+      continue;
+    }
+
+    if (tag == kGameModeTag) {
+      char rules[game_mode::kMaxRulesLength + 1] = {0};
+      const uint8_t rulesLength = reader.u8();
+      if (!reader.ok) {
+        break;
+      }
+      if (rulesLength > game_mode::kMaxRulesLength) {
+        result.end = ReplayEnd::Corrupt;
+        return result;
+      }
+      if (reader.position + rulesLength > length) {
+        reader.ok = false;
+        break;
+      }
+      std::memcpy(rules, data + reader.position, rulesLength);
+      reader.position += rulesLength;
+      if (!game_mode::compile(rules, mode)) {
+        result.end = ReplayEnd::Corrupt;
+        return result;
+      }
+      inputs.gameMode = &mode;
+      continue;
+    }
+
+    if (tag == kResumeTag) {
+      ResumePoint point;
+      const int32_t dtMs = static_cast<int32_t>(reader.signedVarint());
+      const uint8_t state = reader.u8();
+      const uint8_t status = reader.u8();
+      point.bombDurationMs = static_cast<uint32_t>(reader.varint());
+      point.bombRemainingMs = static_cast<uint32_t>(reader.varint());
+      point.enteredDigits = reader.u8();
+      if (!reader.ok) {
+        break;
+      }
+      if (state > ERROR_STATE || status > Cancelled || point.enteredDigits > DEFUSE_CODE_LENGTH) {
+        result.end = ReplayEnd::Corrupt;
+        return result;
+      }
+      if (reader.position + point.enteredDigits > length) {
+        reader.ok = false;
+        break;
+      }
+      std::memcpy(point.defuseBuffer, data + reader.position, point.enteredDigits);
+      reader.position += point.enteredDigits;
+      point.state = static_cast<FlameState>(state);
+      point.matchStatus = static_cast<MatchStatus>(status);
+      inputs.nowMs += static_cast<uint32_t>(dtMs);
+      engine.resume(point, inputs.nowMs);
+      ++result.overrides;
+      continue;
+    }
+
+    if ((tag & 0x80) != 0) {
+      result.end = ReplayEnd::Corrupt;
+      return result;
+    }
+
+    // Decode into temporaries first so a record cut short is not half applied.
+    const uint8_t flags = tag;
+    const int32_t dtMs = static_cast<int32_t>(reader.signedVarint());
+    const uint8_t bools = (flags & kBoolsChanged) ? reader.u8() : 0;
+    const int64_t apiDeltaMs = (flags & kApiMsChanged) ? reader.signedVarint() : 0;
+    const uint8_t status = (flags & kStatusChanged) ? reader.u8() : 0;
+    const uint32_t bombDurationMs = (flags & kBombDurationChanged) ? static_cast<uint32_t>(reader.varint()) : 0;
+    uint8_t codeLength = 0;
+    if (flags & kDefuseCodeChanged) {
+      codeLength = reader.u8();
+      if (codeLength > kMaxDefuseCodeBytes) {
+        result.end = ReplayEnd::Corrupt;
+        return result;
+      }
+      if (reader.position + codeLength > length) {
+        reader.ok = false;
+        break;
+      }
+      std::memcpy(code, data + reader.position, codeLength);
+      code[codeLength] = '\0';
+      reader.position += codeLength;
+    }
+    const char keypadDigit = (flags & kKeypadDigitChanged) ? static_cast<char>(reader.u8()) : '\0';
+    uint16_t outputsWord = 0;
+    if (flags & kOutputsChanged) {
+      outputsWord = reader.u8();
+      outputsWord |= static_cast<uint16_t>(reader.u8() << 8);
+    }
+    if (!reader.ok) {
+      break;
+    }
+    if (status > Cancelled) {
+      result.end = ReplayEnd::Corrupt;
+      return result;
+    }
+
+    inputs.nowMs += static_cast<uint32_t>(dtMs);
+    if (flags & kBoolsChanged) {
+      unpackBools(bools, inputs);
+    }
+    if (flags & kApiMsChanged) {
+      inputs.lastSuccessfulApiMs += static_cast<uint32_t>(apiDeltaMs);
+    }
+    if (flags & kStatusChanged) {
+      inputs.remoteMatchStatus = static_cast<MatchStatus>(status);
+    }
+    if (flags & kBombDurationChanged) {
+      inputs.configuredBombDurationMs = bombDurationMs;
+    }
+    if (flags & kDefuseCodeChanged) {
+      inputs.configuredDefuseCode = code;
+    }
+    if (flags & kKeypadDigitChanged) {
+      inputs.keypadDigit = keypadDigit;
+    }
+    if (flags & kOutputsChanged) {
+      expectedOutputs = outputsWord;
+    }
+
+    GameOutputs outputs;
+    engine.game_tick(inputs, outputs);
+    const uint16_t actualOutputs = packOutputs(outputs);
+    if (actualOutputs != expectedOutputs) {
+      if (result.mismatches == 0) {
+        result.firstMismatchTick = result.ticks;
+        result.firstMismatchNowMs = inputs.nowMs;
+        result.firstMismatchExpected = expectedOutputs;
+        result.firstMismatchActual = actualOutputs;
+      }
+      ++result.mismatches;
+    }
+    ++result.ticks;
+    result.lastNowMs = inputs.nowMs;
+  }
+
+  if (!reader.ok) {
+    result.end = ReplayEnd::Truncated;
+  }
+  return result;
+}
+}  // namespace game_recorder
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+#include "core/game_state.h"
+
+// Deterministic record/replay of everything that drives game_state. The recorder logs
+// one record per game tick, holding only the GameInputs fields that changed since the
+// previous tick plus the GameOutputs the tick produced, and one record per direct
+// state or match-status override. A log starts from a freshly constructed engine, so
+// feeding it to replay() re-executes the session through a new GameEngine and reports
+// every tick whose outputs differ from the recorded ones. Replay is pure computation
+// (a 30-minute match is ~180k ticks) and runs on the host or on the device alike.
+//
+// Stream layout, little-endian; varints are LEB128, signed ones zigzag-encoded:
+//   header:   "GREC" version:u8
+//   tick:     flags:u8 (bit 7 clear) dtMs:svarint, then per set flag in bit order:
+//               kBoolsChanged u8 | kApiMsChanged svarint delta | kStatusChanged u8 |
+//               kBombDurationChanged varint | kDefuseCodeChanged len:u8 bytes |
+//               kKeypadDigitChanged u8 | kOutputsChanged u16
+//   setState: 0x80 dtMs:svarint state:u8
+//   status:   0x81 status:u8
+//   gap:      0x82 (records were dropped; the engine state after it is unknown)
+//   mode:     0x83 len:u8 rules bytes (the game mode for the ticks that follow)
+//   resume:   0x84 dtMs:svarint state:u8 status:u8 bombDurationMs:varint
+//             bombRemainingMs:varint digits:u8 bytes (a round resumed after a warm reset)
+// dtMs is relative to the previous tick or setState record. The API game-timer sync
+// is not recorded: it arrives from the API task and never affects GameOutputs. A mode
+// record precedes the first tick and every tick whose game mode differs from the last
+// one recorded; streams without one replay in the built-in mode. A stream opened by
+// startSegment() carries on from an earlier one: its header is followed by a resume
+// record holding the engine state at the cut.
+namespace game_recorder {
+// 2: bombDeadlineElapsed input. 3: mode records. 4: resume records. Older streams still replay.
+constexpr uint8_t kStreamVersion = 4;
+constexpr size_t kHeaderBytes = 5;
+constexpr size_t kMaxDefuseCodeBytes = 32;  // Longer codes are cut; they can never match anyway.
+
+// Packs a GameOutputs into the 15-bit word stored in tick records.
+uint16_t packOutputs(const GameOutputs &outputs);
+
+// Write side. The record*() calls encode into a RAM ring and never block or allocate;
+// a record that does not fit is dropped and marked with a gap. drain() hands pending
+// bytes to a sink (flash file, serial). One task may record while another drains.
+class Recorder {
+ public:
+  // Returns how many bytes it consumed; a short count leaves the rest in the ring.
+  using Sink = size_t (*)(const uint8_t *data, size_t length);
+
+  static constexpr size_t kRingBytes = 4096;
+
+  Recorder() = default;
+  Recorder(const Recorder &) = delete;
+  Recorder &operator=(const Recorder &) = delete;
+
+  // Discards pending bytes and starts a new stream with its header. Call before the
+  // first record and only while nothing is draining.
+  void start();
+
+  void recordTick(const GameInputs &inputs, const GameOutputs &outputs);
+  void recordSetState(FlameState state, uint32_t nowMs);
+  void recordMatchStatus(MatchStatus status);
+  void recordResume(const ResumePoint &point, uint32_t nowMs);
+
+  // Ends the current stream and starts a new one after it, for a log kept as a series
+  // of files: a fresh header, a resume record carrying `point` (the engine after the
+  // last recorded tick) and a keyframe on the next tick, so the new stream replays on
+  // its own. Only exact between rounds, when `point` holds everything the engine would
+  // carry into the next tick. Returns false, recording nothing, while the previous
+  // segment start has not been taken or the ring lacks room; try again on a later tick.
+  bool startSegment(const ResumePoint &point, uint32_t nowMs);
+
+  // drain() stops in front of a new segment's header. Once everything before it is out,
+  // this returns true (once) and the sink should move to a new file.
+  bool takeSegmentStart();
+
+  size_t drain(Sink sink);
+
+  size_t pendingBytes() const;
+  uint32_t droppedRecords() const { return dropped.load(std::memory_order_relaxed); }
+
+ private:
+  static constexpr size_t kMaxRecordBytes = 64;
+
+  void resetLastRecorded();
+  size_t encodeResume(const ResumePoint &point, uint32_t nowMs, uint8_t *out);
+  bool appendRecord(const uint8_t *data, size_t length);
+  void encodeModeIfChanged(const GameInputs &inputs);
+  size_t encodeTick(const GameInputs &inputs, const GameOutputs &outputs, uint8_t *out);
+
+  uint8_t ring[kRingBytes];
+  std::atomic<size_t> head{0};  // Written by the recording task.
+  std::atomic<size_t> tail{0};  // Written by the draining task.
+  std::atomic<uint32_t> dropped{0};
+  std::atomic<size_t> segmentStart{0};       // Ring position of the pending segment header.
+  std::atomic<bool> segmentPending{false};  // Set by startSegment(), cleared by takeSegmentStart().
+  bool inGap = false;
+  bool keyframePending = true;
+
+  // Last recorded values the next tick record is diffed against.
+  uint32_t lastNowMs = 0;
+  uint32_t lastApiMs = 0;
+  uint8_t lastBools = 0;
+  uint8_t lastStatus = 0;
+  uint32_t lastBombDurationMs = 0;
+  char lastDefuseCode[kMaxDefuseCodeBytes + 1] = {0};
+  uint8_t lastDefuseCodeLength = 0;
+  char lastKeypadDigit = '\0';
+  uint16_t lastOutputs = 0;
+  uint32_t lastModeId = 0;
+};
+
+enum class ReplayEnd : uint8_t {
+  Complete,   // Every record was replayed.
+  BadHeader,  // Not a stream, or an unknown version.
+  Truncated,  // The stream ends inside a record (e.g. power loss before a flush).
+  Corrupt,    // Unknown record tag or out-of-range value.
+  Gap,        // The recorder dropped records; nothing after the gap is replayable.
+};
+
+struct ReplayResult {
+  ReplayEnd end = ReplayEnd::Complete;
+  uint32_t ticks = 0;
+  uint32_t overrides = 0;  // setState, match-status and resume records.
+  uint32_t mismatches = 0;
+  uint32_t lastNowMs = 0;
+  // First tick whose outputs differ from the recording (valid when mismatches > 0).
+  uint32_t firstMismatchTick = 0;
+  uint32_t firstMismatchNowMs = 0;
+  uint16_t firstMismatchExpected = 0;
+  uint16_t firstMismatchActual = 0;
+};
+
+// Re-executes a recorded stream on `engine`, which must be freshly constructed.
+ReplayResult replay(const uint8_t *data, size_t length, game_state::GameEngine &engine);
+}  // namespace game_recorder
@@ -2,50 +2,25 @@
 
 #include <cstring>
 
-#include "effects.h"
+#ifdef APP_DEBUG
+#include <Arduino.h>
+#endif
+
+#include "core/clock.h"
 
 namespace game_state {
 namespace {
-FlameState currentState = ON;
-MatchStatus currentMatchStatus = WaitingOnStart;
-
-bool gameTimerValid = false;
-uint32_t gameTimerRemainingMs = 0;
-uint32_t gameTimerLastUpdateMs = 0;
-
-bool bombTimerActive = false;
-uint32_t bombTimerDurationMs = 0;
-uint32_t bombTimerRemainingMs = 0;
-uint32_t bombTimerLastUpdateMs = 0;
-
-uint32_t armingHoldStartMs = 0;
-bool armingHoldActive = false;
-bool armingHoldComplete = false;
-uint32_t irWindowStartMs = 0;
-bool irWindowActive = false;
-bool pendingClearIrConfirmation = false;
-bool clearDefuseAfterLock = false;
-
-char defuseBuffer[DEFUSE_CODE_LENGTH + 1] = {0};
-uint8_t defuseEnteredDigits = 0;
-uint32_t keypadLockedUntilMs = 0;
-
-uint32_t configuredBombDurationMs = DEFAULT_BOMB_DURATION_MS;
-
 bool isGameOverStatus(MatchStatus status) {
   return status == WaitingOnFinalData || status == Completed || status == Cancelled;
 }
 
-bool isGameTimerCountdownAllowed() {
-  return currentState == ACTIVE || currentState == ARMING || currentState == ARMED;
-}
-
 bool isGlobalTimeoutTriggered(const GameInputs &inputs) {
   if (!inputs.wifiConnected) {
     return false;
   }
 
-  if (inputs.nowMs < inputs.lastSuccessfulApiMs) {
+  // A response stamped after this tick's frame time is fresh, not 49 days old.
+  if (!sys_clock::reached(inputs.nowMs, inputs.lastSuccessfulApiMs)) {
     return false;
   }
 
@@ -57,36 +32,335 @@ void logErrorTransition(const char *reason, const GameInputs &inputs) {
   Serial.print("[ERROR] Entering ERROR_STATE due to: ");
   Serial.println(reason);
   Serial.printf("    wifiConnected=%s\n", inputs.wifiConnected ? "true" : "false");
-  const uint64_t apiDelta =
-      inputs.nowMs >= inputs.lastSuccessfulApiMs ? inputs.nowMs - inputs.lastSuccessfulApiMs : 0;
-  Serial.printf("    lastSuccessfulApiMs=%llu nowMs=%lu delta=%llu timeout=%lu\n",
-                static_cast<unsigned long long>(inputs.lastSuccessfulApiMs),
+  const uint32_t apiDelta =
+      sys_clock::reached(inputs.nowMs, inputs.lastSuccessfulApiMs) ? inputs.nowMs - inputs.lastSuccessfulApiMs : 0;
+  Serial.printf("    lastSuccessfulApiMs=%lu nowMs=%lu delta=%lu timeout=%lu\n",
+                static_cast<unsigned long>(inputs.lastSuccessfulApiMs),
                 static_cast<unsigned long>(inputs.nowMs),
-                static_cast<unsigned long long>(apiDelta), static_cast<unsigned long>(API_TIMEOUT_MS));
+                static_cast<unsigned long>(apiDelta), static_cast<unsigned long>(API_TIMEOUT_MS));
   Serial.println("    Check API availability, WiFi stability, or disable API watchdog while offline.");
 }
 #endif
+}  // namespace
+
+// ---------------------------------------------------------------------------------
+// Transition engine. Every state change made by game_tick() is a row lookup in
+// kTransitions: (current FlameState, event) -> rule, and the rule applies when the
+// current MatchStatus is in its status mask. Events are raised by game_tick() in a
+// fixed priority order (the column order); the first rule that applies wins and ends
+// the tick. Side effects tied to a state live in kStateBehaviors as entry/exit actions
+// and an optional in-state activity that can raise further events.
+//
+// The game mode (core/game_mode.h) does not change the table: it selects which
+// events game_tick() raises (a defuse hold, or a neutralising defuse) and drives the
+// ARMING activity, which steps through the mode's arming sequence.
+// ---------------------------------------------------------------------------------
+
+namespace {
+constexpr size_t kStateCount = ERROR_STATE + 1;
+constexpr size_t kMatchStatusCount = Cancelled + 1;
+constexpr size_t kEventCount = static_cast<size_t>(GameEvent::Count);
+
+struct ActionContext {
+  GameEngine &engine;
+  GameOutputs &outputs;
+  uint32_t nowMs;
+  FlameState from;
+  FlameState to;
+};
+
+using Action = void (*)(ActionContext &context);
+// Returns the event to raise, or GameEvent::Count for none.
+using Activity = GameEvent (*)(GameEngine &engine, const GameInputs &inputs, GameOutputs &outputs);
+
+struct Transition {
+  bool specified;      // Guards against rows left short; every cell must be written out.
+  uint8_t statusMask;  // MatchStatus values the rule applies in; 0 means the event is ignored.
+  FlameState target;
+  Action action;       // Runs before the exit and entry actions.
+};
+
+struct StateBehavior {
+  Action onEnter;
+  Action onExit;
+  Activity during;  // Runs when no earlier rule fired this tick.
+};
+
+constexpr uint8_t statusBit(MatchStatus status) { return static_cast<uint8_t>(1u << status); }
+
+constexpr uint8_t kAnyStatus = static_cast<uint8_t>((1u << kMatchStatusCount) - 1);
+constexpr uint8_t kPreMatchStatuses = statusBit(WaitingOnStart) | statusBit(Countdown);
+constexpr uint8_t kHaltedStatuses = kPreMatchStatuses | statusBit(WaitingOnFinalData);
+
+constexpr Transition stay() { return Transition{true, 0, ON, nullptr}; }
+
+constexpr Transition goTo(FlameState target, uint8_t statuses = kAnyStatus, Action action = nullptr) {
+  return Transition{true, statuses, target, action};
+}
+}  // namespace
+
+// Timer callbacks, transition actions and state activities. They are static so the
+// constexpr tables can point at them; timer contexts are the owning engine.
+struct EngineRules {
+  static void onArmingHoldElapsed(void *context) { static_cast<GameEngine *>(context)->armingHoldElapsed = true; }
+
+  static void onIrWindowExpired(void *context) { static_cast<GameEngine *>(context)->irWindowExpired = true; }
+
+  static void onKeypadLockExpired(void *context) {
+    GameEngine &engine = *static_cast<GameEngine *>(context);
+    engine.keypadLocked = false;
+    if (engine.clearDefuseAfterLock) {
+      engine.resetDefuseBuffer();
+    }
+  }
+
+  static void enterArmed(ActionContext &context) {
+    GameEngine &engine = context.engine;
+    engine.bombTimerActive = true;
+    engine.bombTimerDurationMs =
+        engine.configuredBombDurationMs == 0 ? DEFAULT_BOMB_DURATION_MS : engine.configuredBombDurationMs;
+    engine.bombTimerRemainingMs = engine.bombTimerDurationMs;
+    engine.bombTimerLastUpdateMs = context.nowMs;
+    // Whoever armed it may still be holding the buttons; that press must not defuse it.
+    if (engine.mode.defuse == game_mode::DefuseMethod::Hold) {
+      engine.clearButtonHold();
+      engine.holdNeedsRelease = true;
+    }
+  }
+
+  static void exitArmed(ActionContext &context) {
+    GameEngine &engine = context.engine;
+    engine.bombTimerActive = false;
+    if (context.to != DEFUSED) {
+      engine.bombTimerRemainingMs = 0;
+    }
+    engine.resetDefuseBuffer();
+    engine.unlockKeypad();
+  }
+
+  static void exitArming(ActionContext &context) { context.engine.stopButtonHoldInternal(context.outputs); }
+
+  static void abandonArming(ActionContext &context) {
+    if (context.engine.armingHoldActive) {
+      context.engine.stopButtonHoldInternal(context.outputs);
+    }
+  }
+
+  static void confirmArming(ActionContext &context) { context.outputs.armingConfirmedEffect = true; }
+
+  static void rejectArming(ActionContext &context) { context.outputs.wrongCodeEffect = true; }
+
+  static void releaseHold(ActionContext &context) { context.engine.clearButtonHold(); }
+
+  // The defusing hold must not carry over into capturing the device again.
+  static void neutralize(ActionContext &context) {
+    context.engine.clearButtonHold();
+    context.engine.holdNeedsRelease = true;
+  }
+
+  // Steps through the mode's arming sequence. The first step is the hold that entered
+  // ARMING; a later hold restarts the hold timer on the press that is still going, and
+  // an IR step opens the confirmation window. Each step completes at most once per
+  // tick, so a tick costs at most kMaxArmSteps iterations.
+  static GameEvent runArmingFlow(GameEngine &engine, const GameInputs &inputs, GameOutputs &outputs) {
+    if (!engine.armingHoldActive) {
+      engine.resetArmingFlow(outputs);
+      return GameEvent::Count;
+    }
+
+    const game_mode::GameMode &mode = engine.mode;
+    while (engine.armStep < mode.armStepCount) {
+      const game_mode::Step &step = mode.armSteps[engine.armStep];
+      if (step.kind == game_mode::ArmStep::Hold) {
+        if (!engine.armingHoldElapsed) {
+          return GameEvent::Count;
+        }
+      } else {
+        if (!engine.irWindowActive) {
+          engine.irWindowActive = true;
+          engine.irWindowExpired = false;
+          engine.timers.cancel(engine.irWindowTimer);
+          engine.irWindowTimer = engine.timers.schedule(inputs.nowMs + step.durationMs, onIrWindowExpired, &engine);
+          outputs.showArmingConfirmPrompt = true;
+          outputs.armingConfirmNeededEffect = true;
+        }
+        if (!inputs.irConfirmationReceived) {
+          return engine.irWindowExpired ? GameEvent::IrWindowExpired : GameEvent::Count;
+        }
+      }
+
+      if (++engine.armStep == mode.armStepCount) {
+        break;
+      }
+      if (step.kind == game_mode::ArmStep::IrConfirm) {
+        // The next IR step needs a confirmation of its own.
+        engine.irWindowActive = false;
+        engine.timers.cancel(engine.irWindowTimer);
+        outputs.clearIrConfirmation = true;
+      }
+      const game_mode::Step &nextStep = mode.armSteps[engine.armStep];
+      if (nextStep.kind == game_mode::ArmStep::Hold) {
+        engine.startButtonHold(inputs.nowMs, nextStep.durationMs);
+      }
+    }
+    return GameEvent::ArmingCompleted;
+  }
+};
+
+namespace {
+// Rows follow FlameState; columns follow GameEvent:
+//   ApiTimeout, MatchOver, BombExpired, DefuseCompleted, Neutralized, StatusUpdate,
+//   ApiOnline, HoldActive, HoldReleased, HoldCompleted, ArmingCompleted, IrWindowExpired
+constexpr Transition kTransitions[kStateCount][kEventCount] = {
+    // ON
+    {goTo(ERROR_STATE), stay(), stay(), stay(), stay(), stay(), goTo(READY), stay(), stay(), stay(), stay(), stay()},
+    // READY
+    {goTo(ERROR_STATE), stay(), stay(), stay(), stay(), goTo(ACTIVE, statusBit(Running)), stay(), stay(), stay(),
+     stay(), stay(), stay()},
+    // ACTIVE
+    {goTo(ERROR_STATE), goTo(READY), stay(), stay(), stay(), goTo(READY, kHaltedStatuses, EngineRules::abandonArming),
+     stay(), goTo(ARMING), stay(), stay(), stay(), stay()},
+    // ARMING
+    {goTo(ERROR_STATE), goTo(READY), stay(), stay(), stay(), goTo(READY, kHaltedStatuses), stay(), stay(),
+     goTo(ACTIVE), stay(), goTo(ARMED, kAnyStatus, EngineRules::confirmArming),
+     goTo(ACTIVE, kAnyStatus, EngineRules::rejectArming)},
+    // ARMED
+    {goTo(ERROR_STATE), goTo(READY), goTo(DETONATED), goTo(DEFUSED), goTo(ACTIVE, kAnyStatus, EngineRules::neutralize),
+     goTo(READY, kPreMatchStatuses), stay(), stay(), stay(), stay(), stay(), stay()},
+    // DEFUSED
+    {goTo(ERROR_STATE), stay(), stay(), stay(), stay(), goTo(READY, kPreMatchStatuses), stay(), stay(), stay(), stay(),
+     stay(), stay()},
+    // DETONATED
+    {goTo(ERROR_STATE), stay(), stay(), stay(), stay(), goTo(READY, kPreMatchStatuses), stay(), stay(), stay(), stay(),
+     stay(), stay()},
+    // ERROR_STATE
+    {stay(), stay(), stay(), stay(), stay(), stay(), stay(), stay(), stay(),
+     goTo(ON, kAnyStatus, EngineRules::releaseHold), stay(), stay()},
+};
+
+constexpr StateBehavior kStateBehaviors[kStateCount] = {
+    {nullptr, nullptr, nullptr},                                      // ON
+    {nullptr, nullptr, nullptr},                                      // READY
+    {nullptr, nullptr, nullptr},                                      // ACTIVE
+    {nullptr, EngineRules::exitArming, EngineRules::runArmingFlow},  // ARMING
+    {EngineRules::enterArmed, EngineRules::exitArmed, nullptr},      // ARMED
+    {nullptr, nullptr, nullptr},                                      // DEFUSED
+    {nullptr, nullptr, nullptr},                                      // DETONATED
+    {nullptr, nullptr, nullptr},                                      // ERROR_STATE
+};
+
+// Compile-time validation of the table (C++11 constexpr, hence the recursion).
+constexpr size_t kCellCount = kStateCount * kEventCount;
+
+constexpr const Transition &cellAt(size_t index) { return kTransitions[index / kEventCount][index % kEventCount]; }
+
+constexpr bool isRule(const Transition &cell) { return cell.statusMask != 0; }
+
+constexpr uint16_t stateBit(size_t state) { return static_cast<uint16_t>(1u << state); }
+
+constexpr bool allCellsSpecified(size_t index = 0) {
+  return index == kCellCount || (cellAt(index).specified && allCellsSpecified(index + 1));
+}
+
+constexpr bool isWellFormed(const Transition &cell, size_t fromState) {
+  return !isRule(cell) || ((cell.statusMask & ~kAnyStatus) == 0 && static_cast<size_t>(cell.target) < kStateCount &&
+                           static_cast<size_t>(cell.target) != fromState);
+}
+
+constexpr bool allRulesWellFormed(size_t index = 0) {
+  return index == kCellCount || (isWellFormed(cellAt(index), index / kEventCount) && allRulesWellFormed(index + 1));
+}
+
+constexpr uint16_t successors(uint16_t states, size_t index = 0) {
+  return index == kCellCount
+             ? 0
+             : static_cast<uint16_t>(((states & stateBit(index / kEventCount)) != 0 && isRule(cellAt(index))
+                                          ? stateBit(cellAt(index).target)
+                                          : 0) |
+                                     successors(states, index + 1));
+}
 
-void resetArmingFlow(GameOutputs &outputs) {
-  armingHoldComplete = false;
+constexpr uint16_t reachableFrom(uint16_t states) {
+  return static_cast<uint16_t>(states | successors(states)) == states
+             ? states
+             : reachableFrom(static_cast<uint16_t>(states | successors(states)));
+}
+
+constexpr bool hasExit(size_t state, size_t event = 0) {
+  return event < kEventCount && (isRule(kTransitions[state][event]) || hasExit(state, event + 1));
+}
+
+constexpr bool noDeadEnds(size_t state = 0) { return state == kStateCount || (hasExit(state) && noDeadEnds(state + 1)); }
+
+constexpr bool eventHandled(size_t event, size_t state = 0) {
+  return state < kStateCount && (isRule(kTransitions[state][event]) || eventHandled(event, state + 1));
+}
+
+constexpr bool allEventsHandled(size_t event = 0) {
+  return event == kEventCount || (eventHandled(event) && allEventsHandled(event + 1));
+}
+
+static_assert(allCellsSpecified(), "kTransitions: every (state, event) cell must be written out");
+static_assert(allRulesWellFormed(), "kTransitions: rule targets its own state or has an invalid status mask");
+static_assert(reachableFrom(stateBit(ON)) == stateBit(kStateCount) - 1, "kTransitions: a state is unreachable from ON");
+static_assert(noDeadEnds(), "kTransitions: a state has no way out");
+static_assert(allEventsHandled(), "kTransitions: an event is never handled");
+
+GameEngine defaultEngine;
+}  // namespace
+
+bool GameEngine::isGameTimerCountdownAllowed() const {
+  return currentState == ACTIVE || currentState == ARMING || currentState == ARMED;
+}
+
+void GameEngine::resetArmingFlow(GameOutputs &outputs) {
+  armStep = 0;
   irWindowActive = false;
-  irWindowStartMs = 0;
+  irWindowExpired = false;
+  timers.cancel(irWindowTimer);
   outputs.clearIrConfirmation = true;
 }
 
-void resetDefuseBuffer() {
+void GameEngine::resetDefuseBuffer() {
   std::memset(defuseBuffer, 0, sizeof(defuseBuffer));
   defuseEnteredDigits = 0;
   clearDefuseAfterLock = false;
 }
 
-void stopButtonHoldInternal(GameOutputs &outputs) {
+void GameEngine::unlockKeypad() {
+  timers.cancel(keypadLockTimer);
+  keypadLocked = false;
+}
+
+uint32_t GameEngine::holdDurationMs() const {
+  if (currentState == ARMED && mode.defuse == game_mode::DefuseMethod::Hold) {
+    return mode.defuseHoldMs;
+  }
+  return currentState == ERROR_STATE ? BUTTON_HOLD_MS : mode.armSteps[0].durationMs;
+}
+
+void GameEngine::startButtonHold(uint32_t nowMs, uint32_t durationMs) {
+  armingHoldActive = true;
+  armingHoldStartMs = nowMs;
+  armingHoldDurationMs = durationMs;
+  armingHoldElapsed = false;
+  timers.cancel(armingHoldTimer);
+  armingHoldTimer = timers.schedule(nowMs + durationMs, EngineRules::onArmingHoldElapsed, this);
+}
+
+void GameEngine::clearButtonHold() {
   armingHoldActive = false;
   armingHoldStartMs = 0;
+  armingHoldElapsed = false;
+  timers.cancel(armingHoldTimer);
+}
+
+void GameEngine::stopButtonHoldInternal(GameOutputs &outputs) {
+  clearButtonHold();
   resetArmingFlow(outputs);
 }
 
-void updateGameTimerCountdown(uint32_t nowMs) {
+void GameEngine::updateGameTimerCountdown(uint32_t nowMs) {
   if (!gameTimerValid) {
     return;
   }
@@ -110,52 +384,28 @@ void updateGameTimerCountdown(uint32_t nowMs) {
   }
 }
 
-void transitionTo(FlameState newState, GameOutputs &outputs, uint32_t nowMs) {
-  if (newState == currentState) {
-    return;
-  }
-
-  const FlameState oldState = currentState;
-  currentState = newState;
-
-  outputs.stateChanged = true;
-  outputs.previousState = oldState;
-  outputs.newState = newState;
-
-  if (oldState == ARMING && newState != ARMING) {
-    stopButtonHoldInternal(outputs);
-  }
-
-  if (newState == ARMED && oldState != ARMED) {
-    bombTimerActive = true;
-    bombTimerDurationMs = configuredBombDurationMs == 0 ? DEFAULT_BOMB_DURATION_MS : configuredBombDurationMs;
-    bombTimerRemainingMs = bombTimerDurationMs;
-    bombTimerLastUpdateMs = nowMs;
-  } else if (oldState == ARMED && newState != ARMED) {
-    bombTimerActive = false;
-    if (newState != DEFUSED) {
-      bombTimerRemainingMs = 0;
-    }
-    resetDefuseBuffer();
-    keypadLockedUntilMs = 0;
-  }
-}
-
-void updateBombTimerCountdown(uint32_t nowMs, GameOutputs &outputs) {
+// Returns true when the countdown reached zero on this tick, either by itself or
+// because the hardware deadline fired between ticks.
+bool GameEngine::updateBombTimerCountdown(uint32_t nowMs, bool deadlineElapsed) {
   if (!bombTimerActive) {
-    return;
+    return false;
   }
 
   if (currentState != ARMED) {
     bombTimerActive = false;
-    return;
+    return false;
   }
 
   const uint32_t delta = nowMs - bombTimerLastUpdateMs;
   bombTimerLastUpdateMs = nowMs;
 
+  if (deadlineElapsed && bombTimerRemainingMs != 0) {
+    bombTimerRemainingMs = 0;
+    return true;
+  }
+
   if (delta == 0 || bombTimerRemainingMs == 0) {
-    return;
+    return false;
   }
 
   if (delta >= bombTimerRemainingMs) {
@@ -164,107 +414,118 @@ void updateBombTimerCountdown(uint32_t nowMs, GameOutputs &outputs) {
     bombTimerRemainingMs -= delta;
   }
 
-  if (bombTimerRemainingMs == 0 && currentState == ARMED) {
-    bombTimerActive = false;
-    transitionTo(DETONATED, outputs, nowMs);
-  }
+  return bombTimerRemainingMs == 0;
 }
 
-void updateTimers(uint32_t nowMs, GameOutputs &outputs) {
-  updateGameTimerCountdown(nowMs);
-  updateBombTimerCountdown(nowMs, outputs);
-}
+void GameEngine::handleButtonHold(const GameInputs &inputs, GameOutputs &outputs) {
+  if (!inputs.bothButtonsPressed) {
+    holdNeedsRelease = false;
+  }
 
-void handleButtonHold(const GameInputs &inputs, GameOutputs &outputs) {
-  if (inputs.bothButtonsPressed && !armingHoldActive) {
-    armingHoldActive = true;
-    armingHoldStartMs = inputs.nowMs;
+  if (inputs.bothButtonsPressed && !armingHoldActive && !holdNeedsRelease) {
+    startButtonHold(inputs.nowMs, holdDurationMs());
   }
 
   if (!inputs.bothButtonsPressed && armingHoldActive) {
-    const bool holdCompleted = inputs.nowMs - armingHoldStartMs >= BUTTON_HOLD_MS;
-    if (!(currentState == ARMING && holdCompleted && irWindowActive)) {
+    if (!(currentState == ARMING && armingHoldElapsed && irWindowActive)) {
       stopButtonHoldInternal(outputs);
     }
   }
 }
 
-void handleArmingFlow(uint32_t nowMs, bool irConfirmationReceived, GameOutputs &outputs) {
-  if (!armingHoldActive) {
-    resetArmingFlow(outputs);
-    return;
+// Returns true when the mode's defuse condition is met: a complete, correct defuse
+// code, or a completed defuse hold.
+bool GameEngine::handleDefuseInput(const GameInputs &inputs, GameOutputs &outputs) {
+  if (currentState != ARMED) {
+    resetDefuseBuffer();
+    return false;
   }
 
-  if (!armingHoldComplete && (nowMs - armingHoldStartMs >= BUTTON_HOLD_MS)) {
-    armingHoldComplete = true;
-    irWindowActive = true;
-    irWindowStartMs = nowMs;
-    outputs.showArmingConfirmPrompt = true;
-    outputs.armingConfirmNeededEffect = true;
+  if (mode.defuse == game_mode::DefuseMethod::Hold) {
+    return armingHoldActive && armingHoldElapsed;
   }
 
-  if (!irWindowActive) {
-    return;
+  if (keypadLocked) {
+    return false;
   }
 
-  if (irConfirmationReceived) {
-    outputs.armingConfirmedEffect = true;
-    transitionTo(ARMED, outputs, nowMs);
-    resetArmingFlow(outputs);
-    return;
+  if (!inputs.keypadDigitAvailable || inputs.keypadDigit < '0' || inputs.keypadDigit > '9') {
+    return false;
   }
 
-  if (nowMs - irWindowStartMs >= IR_CONFIRM_WINDOW_MS) {
+  if (defuseEnteredDigits < DEFUSE_CODE_LENGTH) {
+    defuseBuffer[defuseEnteredDigits++] = inputs.keypadDigit;
+    defuseBuffer[defuseEnteredDigits] = '\0';
+    outputs.keypadDigitEffect = true;
+  }
+
+  if (defuseEnteredDigits >= DEFUSE_CODE_LENGTH) {
+    const bool matches = std::strlen(inputs.configuredDefuseCode) == DEFUSE_CODE_LENGTH &&
+                         std::strcmp(inputs.configuredDefuseCode, defuseBuffer) == 0;
+    if (matches) {
+      return true;
+    }
     outputs.wrongCodeEffect = true;
-    resetArmingFlow(outputs);
-    transitionTo(ACTIVE, outputs, nowMs);
+    keypadLocked = true;
+    clearDefuseAfterLock = true;
+    keypadLockTimer = timers.schedule(inputs.nowMs + WRONG_CODE_LOCKOUT_MS, EngineRules::onKeypadLockExpired, this);
   }
+  return false;
 }
 
-void handleDefuseInput(const GameInputs &inputs, GameOutputs &outputs) {
-  if (currentState != ARMED) {
-    resetDefuseBuffer();
-    return;
-  }
 
-  if (keypadLockedUntilMs != 0) {
-    if (inputs.nowMs >= keypadLockedUntilMs) {
-      keypadLockedUntilMs = 0;
-      if (clearDefuseAfterLock) {
-        resetDefuseBuffer();
-      }
-    } else {
-      return;
-    }
+// Mode changes take effect between rounds so a round in progress keeps its rules. A
+// resumed engine is mid-round from the start and takes the mode of its first tick.
+void GameEngine::adoptMode(const game_mode::GameMode *requested) {
+  const game_mode::GameMode &next = requested ? *requested : game_mode::builtIn();
+  if (next.id != mode.id &&
+      (!modeAdopted || currentState == ON || currentState == READY || currentState == ERROR_STATE)) {
+    mode = next;
   }
+  modeAdopted = true;
+}
 
-  if (!inputs.keypadDigitAvailable || inputs.keypadDigit < '0' || inputs.keypadDigit > '9') {
+void GameEngine::transitionTo(FlameState newState, GameOutputs &outputs, uint32_t nowMs) {
+  if (newState == currentState) {
     return;
   }
 
-  if (defuseEnteredDigits < DEFUSE_CODE_LENGTH) {
-    defuseBuffer[defuseEnteredDigits++] = inputs.keypadDigit;
-    defuseBuffer[defuseEnteredDigits] = '\0';
-    outputs.keypadDigitEffect = true;
+  const FlameState oldState = currentState;
+  currentState = newState;
+
+  outputs.stateChanged = true;
+  outputs.previousState = oldState;
+  outputs.newState = newState;
+
+  ActionContext context{*this, outputs, nowMs, oldState, newState};
+  if (kStateBehaviors[oldState].onExit != nullptr) {
+    kStateBehaviors[oldState].onExit(context);
   }
+  if (kStateBehaviors[newState].onEnter != nullptr) {
+    kStateBehaviors[newState].onEnter(context);
+  }
+}
 
-  if (defuseEnteredDigits >= DEFUSE_CODE_LENGTH) {
-    const bool matches = inputs.configuredDefuseCode.length() == DEFUSE_CODE_LENGTH &&
-                        inputs.configuredDefuseCode.equals(defuseBuffer);
-    if (matches) {
-      transitionTo(DEFUSED, outputs, inputs.nowMs);
-    } else {
-      outputs.wrongCodeEffect = true;
-      keypadLockedUntilMs = inputs.nowMs + effects::getWrongCodeBeepDurationMs();
-      clearDefuseAfterLock = true;
-    }
+// Applies the rule for `event` in the current state, if the match status allows it.
+bool GameEngine::fire(GameEvent event, GameOutputs &outputs, uint32_t nowMs) {
+  const Transition &rule = kTransitions[currentState][static_cast<size_t>(event)];
+  if ((rule.statusMask & statusBit(currentMatchStatus)) == 0) {
+    return false;
   }
+
+  if (rule.action != nullptr) {
+    ActionContext context{*this, outputs, nowMs, currentState, rule.target};
+    rule.action(context);
+  }
+  transitionTo(rule.target, outputs, nowMs);
+  return true;
 }
-}  // namespace
 
-void game_init() { currentState = ON; }
+void GameEngine::game_init() { currentState = ON; }
 
-void game_tick(const GameInputs &inputs, GameOutputs &outputs) {
+void GameEngine::game_tick(const GameInputs &inputs, GameOutputs &outputs) {
+  adoptMode(inputs.gameMode);
+  timers.advance(inputs.nowMs);
   configuredBombDurationMs = inputs.configuredBombDurationMs;
   handleButtonHold(inputs, outputs);
 
@@ -273,11 +534,10 @@ void game_tick(const GameInputs &inputs, GameOutputs &outputs) {
     pendingClearIrConfirmation = false;
   }
 
-  if (currentState != ERROR_STATE && isGlobalTimeoutTriggered(inputs)) {
+  if (isGlobalTimeoutTriggered(inputs) && fire(GameEvent::ApiTimeout, outputs, inputs.nowMs)) {
 #ifdef APP_DEBUG
     logErrorTransition("API timeout watchdog", inputs);
 #endif
-    transitionTo(ERROR_STATE, outputs, inputs.nowMs);
     return;
   }
 
@@ -295,10 +555,8 @@ void game_tick(const GameInputs &inputs, GameOutputs &outputs) {
     bombTimerActive = false;
     bombTimerRemainingMs = 0;
     resetArmingFlow(outputs);
-    armingHoldActive = false;
-    armingHoldStartMs = 0;
-    if (currentState == ARMED || currentState == ARMING || currentState == ACTIVE) {
-      transitionTo(READY, outputs, inputs.nowMs);
+    clearButtonHold();
+    if (fire(GameEvent::MatchOver, outputs, inputs.nowMs)) {
       return;
     }
   }
@@ -308,131 +566,133 @@ void game_tick(const GameInputs &inputs, GameOutputs &outputs) {
     resetDefuseBuffer();
   }
 
-  updateTimers(inputs.nowMs, outputs);
-  if (outputs.stateChanged) {
+  updateGameTimerCountdown(inputs.nowMs);
+  if (updateBombTimerCountdown(inputs.nowMs, inputs.bombDeadlineElapsed) && fire(GameEvent::BombExpired, outputs, inputs.nowMs)) {
     return;
   }
 
-  handleDefuseInput(inputs, outputs);
-  if (outputs.stateChanged) {
+  const GameEvent defuseEvent =
+      mode.outcome == game_mode::DefuseOutcome::Neutral ? GameEvent::Neutralized : GameEvent::DefuseCompleted;
+  if (handleDefuseInput(inputs, outputs) && fire(defuseEvent, outputs, inputs.nowMs)) {
     return;
   }
 
-  switch (currentState) {
-    case ON:
-      break;
-
-    case READY:
-      if (currentMatchStatus == Running) {
-        transitionTo(ACTIVE, outputs, inputs.nowMs);
-      }
-      break;
-
-    case ACTIVE:
-      if (armingHoldActive) {
-        transitionTo(ARMING, outputs, inputs.nowMs);
-      }
-      if (currentMatchStatus == WaitingOnStart || currentMatchStatus == Countdown || currentMatchStatus == WaitingOnFinalData) {
-        transitionTo(READY, outputs, inputs.nowMs);
-      }
-      break;
-
-    case ARMING:
-      if (currentMatchStatus == WaitingOnStart || currentMatchStatus == Countdown || currentMatchStatus == WaitingOnFinalData) {
-        resetArmingFlow(outputs);
-        armingHoldActive = false;
-        armingHoldStartMs = 0;
-        transitionTo(READY, outputs, inputs.nowMs);
-        break;
-      }
-
-      if (!armingHoldActive) {
-        resetArmingFlow(outputs);
-        transitionTo(ACTIVE, outputs, inputs.nowMs);
-        break;
-      }
-
-      handleArmingFlow(inputs.nowMs, inputs.irConfirmationReceived, outputs);
-      break;
-
-    case ARMED:
-      if (currentMatchStatus == WaitingOnStart || currentMatchStatus == Countdown) {
-        transitionTo(READY, outputs, inputs.nowMs);
-      }
-      break;
+  if (fire(GameEvent::StatusUpdate, outputs, inputs.nowMs)) {
+    return;
+  }
 
-    case DEFUSED:
-      if (currentMatchStatus == WaitingOnStart || currentMatchStatus == Countdown) {
-        transitionTo(READY, outputs, inputs.nowMs);
-      }
-      break;
+  if (inputs.apiResponseReceived && fire(GameEvent::ApiOnline, outputs, inputs.nowMs)) {
+    return;
+  }
 
-    case DETONATED:
-      if (currentMatchStatus == WaitingOnStart || currentMatchStatus == Countdown) {
-        transitionTo(READY, outputs, inputs.nowMs);
-      }
-      break;
+  if (armingHoldActive) {
+    if (fire(GameEvent::HoldActive, outputs, inputs.nowMs) ||
+        (armingHoldElapsed && fire(GameEvent::HoldCompleted, outputs, inputs.nowMs))) {
+      return;
+    }
+  } else if (fire(GameEvent::HoldReleased, outputs, inputs.nowMs)) {
+    return;
+  }
 
-    case ERROR_STATE:
-      if (armingHoldActive && (inputs.nowMs - armingHoldStartMs >= BUTTON_HOLD_MS)) {
-        armingHoldActive = false;
-        armingHoldStartMs = 0;
-        transitionTo(ON, outputs, inputs.nowMs);
-      }
-      break;
+  const Activity during = kStateBehaviors[currentState].during;
+  if (during != nullptr) {
+    const GameEvent event = during(*this, inputs, outputs);
+    if (event != GameEvent::Count) {
+      fire(event, outputs, inputs.nowMs);
+    }
   }
 }
 
-FlameState get_state() { return currentState; }
-
-void set_state(FlameState newState, GameOutputs *outputs) {
+void GameEngine::set_state(FlameState newState, uint32_t nowMs, GameOutputs *outputs) {
   if (outputs) {
-    transitionTo(newState, *outputs, millis());
+    transitionTo(newState, *outputs, nowMs);
   } else {
     GameOutputs localOutputs;
-    transitionTo(newState, localOutputs, millis());
+    transitionTo(newState, localOutputs, nowMs);
   }
 }
 
-void set_match_status(MatchStatus status) { currentMatchStatus = status; }
-
-MatchStatus get_match_status() { return currentMatchStatus; }
-
-void update_game_timer_from_api(uint32_t remainingMs, uint32_t nowMs) {
+void GameEngine::update_game_timer_from_api(uint32_t remainingMs, uint32_t nowMs) {
   gameTimerValid = true;
   gameTimerRemainingMs = remainingMs;
   gameTimerLastUpdateMs = nowMs;
 }
 
-bool is_game_timer_valid() { return gameTimerValid; }
+float GameEngine::get_arming_progress(uint32_t nowMs) const {
+  if (!armingHoldActive || armingHoldStartMs == 0) {
+    return 0.0f;
+  }
+  const uint32_t elapsed = nowMs - armingHoldStartMs;
+  const float progress = static_cast<float>(elapsed) / static_cast<float>(armingHoldDurationMs);
+  return progress > 1.0f ? 1.0f : progress;
+}
 
-uint32_t get_game_timer_remaining_ms() { return gameTimerRemainingMs; }
+ResumePoint GameEngine::get_resume_point() const {
+  ResumePoint point;
+  point.state = currentState;
+  point.matchStatus = currentMatchStatus;
+  point.bombDurationMs = bombTimerDurationMs;
+  point.bombRemainingMs = bombTimerRemainingMs;
+  point.enteredDigits = defuseEnteredDigits;
+  std::memcpy(point.defuseBuffer, defuseBuffer, sizeof(point.defuseBuffer));
+  return point;
+}
 
-bool is_bomb_timer_active() { return bombTimerActive; }
+void GameEngine::resume(const ResumePoint &point, uint32_t nowMs) {
+  currentState = point.state;
+  currentMatchStatus = point.matchStatus;
+  bombTimerActive = point.state == ARMED;
+  bombTimerDurationMs = point.bombDurationMs;
+  bombTimerRemainingMs = point.bombRemainingMs;
+  bombTimerLastUpdateMs = nowMs;
+  resetDefuseBuffer();
+  // A complete code was being checked (or locked out) when the reset hit; start it over.
+  if (point.state == ARMED && point.enteredDigits < DEFUSE_CODE_LENGTH) {
+    defuseEnteredDigits = point.enteredDigits;
+    std::memcpy(defuseBuffer, point.defuseBuffer, defuseEnteredDigits);
+  }
+}
 
-uint32_t get_bomb_timer_remaining_ms() { return bombTimerRemainingMs; }
+GameEngine &default_engine() { return defaultEngine; }
 
-uint32_t get_bomb_timer_duration_ms() { return bombTimerDurationMs; }
+void game_init() { defaultEngine.game_init(); }
 
-bool is_button_hold_active() { return armingHoldActive; }
+void game_tick(const GameInputs &inputs, GameOutputs &outputs) { defaultEngine.game_tick(inputs, outputs); }
 
-uint32_t get_button_hold_start_ms() { return armingHoldStartMs; }
+FlameState get_state() { return defaultEngine.get_state(); }
 
-bool is_ir_confirmation_window_active() { return irWindowActive; }
+void set_state(FlameState newState, GameOutputs *outputs) { defaultEngine.set_state(newState, sys_clock::frameMs(), outputs); }
 
-uint8_t get_defuse_entered_digits() { return defuseEnteredDigits; }
+void set_match_status(MatchStatus status) { defaultEngine.set_match_status(status); }
 
-const char *get_defuse_buffer() { return defuseBuffer; }
+MatchStatus get_match_status() { return defaultEngine.get_match_status(); }
 
-float get_arming_progress(uint32_t nowMs) {
-  if (!armingHoldActive || armingHoldStartMs == 0) {
-    return 0.0f;
-  }
-  const uint32_t elapsed = nowMs - armingHoldStartMs;
-  const float progress = static_cast<float>(elapsed) / static_cast<float>(BUTTON_HOLD_MS);
-  return progress > 1.0f ? 1.0f : progress;
+void update_game_timer_from_api(uint32_t remainingMs, uint32_t nowMs) {
+  defaultEngine.update_game_timer_from_api(remainingMs, nowMs);
 }
 
+bool is_game_timer_valid() { return defaultEngine.is_game_timer_valid(); }
+
+uint32_t get_game_timer_remaining_ms() { return defaultEngine.get_game_timer_remaining_ms(); }
+
+bool is_bomb_timer_active() { return defaultEngine.is_bomb_timer_active(); }
+
+uint32_t get_bomb_timer_remaining_ms() { return defaultEngine.get_bomb_timer_remaining_ms(); }
+
+uint32_t get_bomb_timer_duration_ms() { return defaultEngine.get_bomb_timer_duration_ms(); }
+
+bool is_button_hold_active() { return defaultEngine.is_button_hold_active(); }
+
+uint32_t get_button_hold_start_ms() { return defaultEngine.get_button_hold_start_ms(); }
+
+bool is_ir_confirmation_window_active() { return defaultEngine.is_ir_confirmation_window_active(); }
+
+uint8_t get_defuse_entered_digits() { return defaultEngine.get_defuse_entered_digits(); }
+
+const char *get_defuse_buffer() { return defaultEngine.get_defuse_buffer(); }
+
+float get_arming_progress(uint32_t nowMs) { return defaultEngine.get_arming_progress(nowMs); }
+
 const char *flame_state_to_string(FlameState state) {
   switch (state) {
     case ON:
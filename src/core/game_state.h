@@ -1,7 +1,10 @@
 #pragma once
 
-#include <Arduino.h>
+#include <stddef.h>
+#include <stdint.h>
 
+#include "core/game_mode.h"
+#include "core/timer_wheel.h"
 #include "game_config.h"
 
 // Flame state definitions follow agents.md strictly.
@@ -26,18 +29,23 @@ enum MatchStatus {
   Cancelled
 };
 
+// Times are sys_clock millisecond stamps (see core/clock.h).
 struct GameInputs {
   uint32_t nowMs = 0;
   bool wifiConnected = false;
-  uint64_t lastSuccessfulApiMs = 0;
+  uint32_t lastSuccessfulApiMs = 0;
   bool apiResponseReceived = false;
   MatchStatus remoteMatchStatus = WaitingOnStart;
   uint32_t configuredBombDurationMs = DEFAULT_BOMB_DURATION_MS;
-  String configuredDefuseCode;
+  const char *configuredDefuseCode = "";  // Owned by the caller (config snapshot); valid for the tick.
   bool bothButtonsPressed = false;
   bool keypadDigitAvailable = false;
   char keypadDigit = '\0';
   bool irConfirmationReceived = false;
+  bool bombDeadlineElapsed = false;  // The hardware bomb deadline fired; detonate now.
+  // Owned by the caller (config snapshot); nullptr for the built-in mode. The engine
+  // switches to a new mode between rounds only (ON, READY or ERROR_STATE).
+  const game_mode::GameMode *gameMode = nullptr;
 };
 
 struct GameOutputs {
@@ -57,8 +65,141 @@ struct GameOutputs {
   bool gameOver = false;
 };
 
+// The part of a round that carries over a warm reset (see resume_snapshot.h).
+struct ResumePoint {
+  FlameState state = ON;
+  MatchStatus matchStatus = WaitingOnStart;
+  uint32_t bombDurationMs = 0;
+  uint32_t bombRemainingMs = 0;
+  uint8_t enteredDigits = 0;
+  char defuseBuffer[DEFUSE_CODE_LENGTH + 1] = {0};
+};
+
 namespace game_state {
 
+// Events game_tick() raises, in priority order; see kTransitions in game_state.cpp.
+enum class GameEvent : uint8_t {
+  ApiTimeout,       // No API success for API_TIMEOUT_MS while WiFi is up.
+  MatchOver,        // Backend reports the match as over.
+  BombExpired,      // Bomb countdown reached zero.
+  DefuseCompleted,  // Correct defuse code entered, or the defuse hold completed.
+  Neutralized,      // As DefuseCompleted, in modes where a defuse returns the device to ACTIVE.
+  StatusUpdate,     // Raised every tick; rules key on the match status alone.
+  ApiOnline,        // A backend response has been received.
+  HoldActive,       // Both buttons are held.
+  HoldReleased,     // No button hold.
+  HoldCompleted,    // Button hold has lasted its duration (BUTTON_HOLD_MS outside ARMING).
+  ArmingCompleted,  // The last step of the mode's arming sequence completed.
+  IrWindowExpired,  // An arming confirmation window closed without IR confirmation.
+  Count
+};
+
+struct EngineRules;
+
+// One prop's complete game state. The firmware drives a single default instance
+// through the free functions below; host builds can create any number of independent
+// engines, e.g. to simulate many props against the backend in one process. Engines are
+// not thread-safe individually but share nothing, so separate engines can tick on
+// separate threads. Pending timers point back at the engine, hence no copies.
+class GameEngine {
+ public:
+  GameEngine() = default;
+  GameEngine(const GameEngine &) = delete;
+  GameEngine &operator=(const GameEngine &) = delete;
+
+  void game_init();
+  void game_tick(const GameInputs &inputs, GameOutputs &outputs);
+
+  FlameState get_state() const { return currentState; }
+  void set_state(FlameState newState, uint32_t nowMs, GameOutputs *outputs = nullptr);
+
+  void set_match_status(MatchStatus status) { currentMatchStatus = status; }
+  MatchStatus get_match_status() const { return currentMatchStatus; }
+
+  void update_game_timer_from_api(uint32_t remainingMs, uint32_t nowMs);
+  bool is_game_timer_valid() const { return gameTimerValid; }
+  uint32_t get_game_timer_remaining_ms() const { return gameTimerRemainingMs; }
+
+  bool is_bomb_timer_active() const { return bombTimerActive; }
+  uint32_t get_bomb_timer_remaining_ms() const { return bombTimerRemainingMs; }
+  uint32_t get_bomb_timer_duration_ms() const { return bombTimerDurationMs; }
+
+  bool is_button_hold_active() const { return armingHoldActive; }
+  uint32_t get_button_hold_start_ms() const { return armingHoldStartMs; }
+  bool is_ir_confirmation_window_active() const { return irWindowActive; }
+
+  uint8_t get_defuse_entered_digits() const { return defuseEnteredDigits; }
+  const char *get_defuse_buffer() const { return defuseBuffer; }
+
+  float get_arming_progress(uint32_t nowMs) const;
+
+  ResumePoint get_resume_point() const;
+  // Puts a freshly constructed engine straight into `point.state` without running entry
+  // actions; an ARMED countdown continues from `point.bombRemainingMs` at `nowMs`.
+  void resume(const ResumePoint &point, uint32_t nowMs);
+
+ private:
+  friend struct EngineRules;  // Table actions and timer callbacks (game_state.cpp).
+
+  bool isGameTimerCountdownAllowed() const;
+  void resetArmingFlow(GameOutputs &outputs);
+  void resetDefuseBuffer();
+  void unlockKeypad();
+  uint32_t holdDurationMs() const;
+  void startButtonHold(uint32_t nowMs, uint32_t durationMs);
+  void clearButtonHold();
+  void stopButtonHoldInternal(GameOutputs &outputs);
+  void updateGameTimerCountdown(uint32_t nowMs);
+  bool updateBombTimerCountdown(uint32_t nowMs, bool deadlineElapsed);
+  void handleButtonHold(const GameInputs &inputs, GameOutputs &outputs);
+  bool handleDefuseInput(const GameInputs &inputs, GameOutputs &outputs);
+  void adoptMode(const game_mode::GameMode *requested);
+  void transitionTo(FlameState newState, GameOutputs &outputs, uint32_t nowMs);
+  bool fire(GameEvent event, GameOutputs &outputs, uint32_t nowMs);
+
+  FlameState currentState = ON;
+  MatchStatus currentMatchStatus = WaitingOnStart;
+  game_mode::GameMode mode;
+
+  bool gameTimerValid = false;
+  uint32_t gameTimerRemainingMs = 0;
+  uint32_t gameTimerLastUpdateMs = 0;
+
+  bool bombTimerActive = false;
+  uint32_t bombTimerDurationMs = 0;
+  uint32_t bombTimerRemainingMs = 0;
+  uint32_t bombTimerLastUpdateMs = 0;
+
+  // One-shot game timeouts. Each timer fires exactly once from the wheel advanced at
+  // the top of game_tick(); the hold and IR timers latch a flag that the state logic
+  // consumes at its usual point in the tick so evaluation order stays as before.
+  TimerWheel timers;
+  TimerHandle armingHoldTimer;
+  TimerHandle irWindowTimer;
+  TimerHandle keypadLockTimer;
+
+  uint32_t armingHoldStartMs = 0;
+  uint32_t armingHoldDurationMs = BUTTON_HOLD_MS;
+  bool armingHoldActive = false;
+  bool armingHoldElapsed = false;
+  bool holdNeedsRelease = false;  // A new hold starts only once the buttons are let go.
+  bool modeAdopted = false;       // The first tick takes its mode whatever the state.
+  uint8_t armStep = 0;            // Index into mode.armSteps while ARMING.
+  bool irWindowActive = false;
+  bool irWindowExpired = false;
+  bool pendingClearIrConfirmation = false;
+  bool clearDefuseAfterLock = false;
+
+  char defuseBuffer[DEFUSE_CODE_LENGTH + 1] = {0};
+  uint8_t defuseEnteredDigits = 0;
+  bool keypadLocked = false;
+
+  uint32_t configuredBombDurationMs = DEFAULT_BOMB_DURATION_MS;
+};
+
+// The engine behind the free functions below.
+GameEngine &default_engine();
+
 void game_init();
 void game_tick(const GameInputs &inputs, GameOutputs &outputs);
 
@@ -89,4 +230,3 @@ const char *flame_state_to_string(FlameState state);
 const char *match_status_to_string(MatchStatus status);
 
 }  // namespace game_state
-
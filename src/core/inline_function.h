@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stddef.h>
+#include <new>
+#include <type_traits>
+
+// Fixed-capacity, heap-free replacement for std::function. The callable is copied
+// into inline storage and invoked through a single function pointer, so a table of
+// these is fully static and the thunk can inline the callable's body.
+template <typename Signature, size_t Capacity = 2 * sizeof(void *)>
+class InlineFunction;
+
+template <typename R, typename... Args, size_t Capacity>
+class InlineFunction<R(Args...), Capacity> {
+ public:
+  InlineFunction() = default;
+
+  template <typename F,
+            typename = typename std::enable_if<!std::is_same<typename std::decay<F>::type, InlineFunction>::value>::type>
+  InlineFunction(F callable) {
+    static_assert(sizeof(F) <= Capacity, "Callable capture exceeds InlineFunction capacity");
+    static_assert(alignof(F) <= alignof(Storage), "Callable alignment exceeds InlineFunction storage alignment");
+    static_assert(std::is_trivially_copyable<F>::value, "InlineFunction only stores trivially copyable callables");
+    ::new (static_cast<void *>(&storage)) F(callable);
+    invoker = &invoke<F>;
+  }
+
+  explicit operator bool() const { return invoker != nullptr; }
+
+  R operator()(Args... args) const { return invoker(&storage, args...); }
+
+ private:
+  using Storage = typename std::aligned_storage<Capacity, alignof(void *)>::type;
+
+  template <typename F>
+  static R invoke(void *target, Args... args) {
+    return (*static_cast<F *>(target))(args...);
+  }
+
+  mutable Storage storage{};
+  R (*invoker)(void *, Args...) = nullptr;
+};
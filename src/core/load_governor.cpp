@@ -0,0 +1,104 @@
+#include "core/load_governor.h"
+
+#include "game_config.h"
+
+namespace {
+constexpr size_t kMaxSheddables = 4;
+
+struct Sheddable {
+  uint32_t nominalIntervalMs;
+  load_governor::FrameIntervalSetter setter;
+};
+
+Sheddable sheddables[kMaxSheddables];
+size_t sheddableCount = 0;
+scheduler::TaskId watchedTask = scheduler::kInvalidTask;
+load_governor::Stats stats;
+uint8_t calmWindows = 0;
+bool sampled = false;
+uint32_t lastSampleMs = 0;
+
+void applyLevel(uint8_t level) {
+  for (size_t i = 0; i < sheddableCount; ++i) {
+    sheddables[i].setter(sheddables[i].nominalIntervalMs << level);
+  }
+}
+
+void setLevel(uint8_t level, uint32_t latenessUs) {
+  stats.level = level;
+  applyLevel(level);
+#ifdef APP_DEBUG
+  Serial.printf("[GOV] level %u (state tick late by %luus)\n", static_cast<unsigned>(level),
+                static_cast<unsigned long>(latenessUs));
+#else
+  (void)latenessUs;
+#endif
+}
+}  // namespace
+
+namespace load_governor {
+
+void watch(scheduler::TaskId task) { watchedTask = task; }
+
+bool addSheddable(uint32_t nominalIntervalMs, FrameIntervalSetter setter) {
+  if (setter == nullptr || nominalIntervalMs == 0 || sheddableCount >= kMaxSheddables) {
+    return false;
+  }
+  sheddables[sheddableCount++] = {nominalIntervalMs, setter};
+  setter(nominalIntervalMs << stats.level);
+  return true;
+}
+
+void update(uint32_t nowMs) {
+  if (sampled && stats.level > 0) {
+    stats.degradedMs += nowMs - lastSampleMs;
+  }
+  sampled = true;
+  lastSampleMs = nowMs;
+
+  const uint32_t latenessUs = scheduler::takePeakLatenessUs(watchedTask);
+  if (latenessUs > stats.peakLatenessUs) {
+    stats.peakLatenessUs = latenessUs;
+  }
+
+  if (latenessUs >= GOVERNOR_SHED_LATENESS_US) {
+    calmWindows = 0;
+    if (stats.level < GOVERNOR_MAX_LEVEL) {
+      ++stats.escalations;
+      stats.lastEscalationMs = nowMs;
+      setLevel(stats.level + 1, latenessUs);
+      if (stats.level > stats.peakLevel) {
+        stats.peakLevel = stats.level;
+      }
+    }
+    return;
+  }
+
+  if (stats.level == 0 || latenessUs >= GOVERNOR_RESTORE_LATENESS_US) {
+    calmWindows = 0;
+    return;
+  }
+
+  if (++calmWindows >= GOVERNOR_RESTORE_WINDOWS) {
+    calmWindows = 0;
+    ++stats.restorations;
+    setLevel(stats.level - 1, latenessUs);
+  }
+}
+
+uint8_t getLevel() { return stats.level; }
+
+Stats getStats() { return stats; }
+
+void dumpStats() {
+#ifdef APP_DEBUG
+  Serial.printf("[GOV] level=%u peak=%u escalations=%lu restorations=%lu degradedMs=%lu lastEscalationMs=%lu "
+                "peakLatenessUs=%lu\n",
+                static_cast<unsigned>(stats.level), static_cast<unsigned>(stats.peakLevel),
+                static_cast<unsigned long>(stats.escalations), static_cast<unsigned long>(stats.restorations),
+                static_cast<unsigned long>(stats.degradedMs), static_cast<unsigned long>(stats.lastEscalationMs),
+                static_cast<unsigned long>(stats.peakLatenessUs));
+#endif
+}
+
+}  // namespace load_governor
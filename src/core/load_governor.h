@@ -0,0 +1,38 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "core/scheduler.h"
+
+// Protects the game tick from render stalls. The governor samples how late the watched
+// task (the state tick) starts; when it slips, every registered sheddable stage has its
+// frame interval doubled, one level per sample window, and levels are handed back one
+// at a time after a run of calm windows.
+namespace load_governor {
+using FrameIntervalSetter = void (*)(uint32_t intervalMs);
+
+// Counters for spotting degradation after the fact (e.g. at the end of a match).
+struct Stats {
+  uint8_t level = 0;
+  uint8_t peakLevel = 0;
+  uint32_t escalations = 0;       // Times a level was shed.
+  uint32_t restorations = 0;      // Times a level was restored.
+  uint32_t degradedMs = 0;        // Total time spent above level 0.
+  uint32_t lastEscalationMs = 0;  // sys_clock ms stamp of the most recent escalation.
+  uint32_t peakLatenessUs = 0;    // Worst watched-task lateness seen.
+};
+
+void watch(scheduler::TaskId task);
+
+// Registers a stage whose frame interval is `nominalIntervalMs << level`.
+bool addSheddable(uint32_t nominalIntervalMs, FrameIntervalSetter setter);
+
+// Closes the current sample window; run it every GOVERNOR_SAMPLE_INTERVAL_MS.
+void update(uint32_t nowMs);
+
+uint8_t getLevel();
+Stats getStats();
+
+// Prints the counters above to Serial (APP_DEBUG only).
+void dumpStats();
+}  // namespace load_governor
@@ -0,0 +1,42 @@
+#include "core/report_cadence.h"
+
+namespace report_cadence {
+namespace {
+uint32_t stateIntervalMs(FlameState state) {
+  switch (state) {
+    case ON:
+    case READY:
+      return API_IDLE_POST_INTERVAL_MS;
+    case ACTIVE:
+    case DEFUSED:
+    case DETONATED:
+      return API_ACTIVE_POST_INTERVAL_MS;
+    default:
+      return API_POST_INTERVAL_MS;
+  }
+}
+}  // namespace
+
+uint32_t nextIntervalMs(FlameState state, uint32_t timerMs, uint8_t consecutiveFailures, uint32_t serverIntervalMs,
+                        uint32_t random) {
+  if (consecutiveFailures > 0) {
+    // The delay doubles per failure. Jitter over the upper half of the window keeps props
+    // that lost the backend together from retrying in lockstep.
+    const uint8_t shift = consecutiveFailures - 1 < 8 ? consecutiveFailures - 1 : 8;
+    uint32_t backoffMs = API_BACKOFF_BASE_MS << shift;
+    if (backoffMs > API_MAX_POST_INTERVAL_MS) {
+      backoffMs = API_MAX_POST_INTERVAL_MS;
+    }
+    return backoffMs / 2 + random % (backoffMs / 2 + 1);
+  }
+
+  uint32_t intervalMs = stateIntervalMs(state);
+  if (serverIntervalMs != 0) {
+    intervalMs = serverIntervalMs < API_MIN_POST_INTERVAL_MS ? API_MIN_POST_INTERVAL_MS : serverIntervalMs;
+  }
+  if (state == ARMED && timerMs <= API_FINAL_COUNTDOWN_MS && intervalMs > API_FINAL_POST_INTERVAL_MS) {
+    intervalMs = API_FINAL_POST_INTERVAL_MS;
+  }
+  return intervalMs < API_MAX_POST_INTERVAL_MS ? intervalMs : API_MAX_POST_INTERVAL_MS;
+}
+}  // namespace report_cadence
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "core/game_state.h"
+#include "game_config.h"
+
+// Heartbeat cadence for the backend reports (state transitions are sent at once
+// regardless). Idle phases report rarely and the end of a countdown often; the backend
+// may override the per-state choice; failed reports back off exponentially with jitter.
+// Every interval is capped at API_MAX_POST_INTERVAL_MS, so the offline watchdog
+// (API_TIMEOUT_MS) still sees several attempts. The intervals are set in game_config.h.
+namespace report_cadence {
+// Interval until the next heartbeat after a report of `state` carrying `timerMs`.
+// `consecutiveFailures` counts reports without an HTTP 200 since the last one with it;
+// `serverIntervalMs` is the backend's latest suggestion (0 for none); `random` is any
+// 32-bit random value and only spreads the backoff.
+uint32_t nextIntervalMs(FlameState state, uint32_t timerMs, uint8_t consecutiveFailures, uint32_t serverIntervalMs,
+                        uint32_t random);
+}  // namespace report_cadence
@@ -0,0 +1,62 @@
+#include "core/report_selection.h"
+
+#include <atomic>
+
+#include "game_config.h"
+
+namespace report_selection {
+namespace {
+uint32_t reportedTransitions = 0;  // Pass::transitions as of the last transition report.
+uint32_t lastSentMs = 0;
+uint32_t intervalMs = API_POST_INTERVAL_MS;
+
+std::atomic<uint32_t> transitionReports{0};
+std::atomic<uint32_t> coalescedCount{0};
+std::atomic<uint32_t> heartbeatCount{0};
+
+void bump(std::atomic<uint32_t> &counter, uint32_t amount = 1) {
+  counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+}  // namespace
+
+Report select(const Pass &pass) {
+  const bool transitionPending = pass.transitions != reportedTransitions;
+  const bool urgent = transitionPending || pass.requested;
+  if (pass.inFlight && !urgent) {
+    return Report::None;
+  }
+  if (!urgent && pass.nowMs - lastSentMs < intervalMs) {
+    return Report::None;
+  }
+  if (!pass.linkUp) {
+    return Report::None;
+  }
+
+  lastSentMs = pass.nowMs;
+  if (!transitionPending) {
+    bump(heartbeatCount);
+    return Report::Heartbeat;
+  }
+  bump(transitionReports);
+  bump(coalescedCount, pass.transitions - reportedTransitions - 1);
+  reportedTransitions = pass.transitions;
+  return Report::Transition;
+}
+
+void setIntervalMs(uint32_t newIntervalMs) { intervalMs = newIntervalMs; }
+
+uint32_t getIntervalMs() { return intervalMs; }
+
+uint32_t msUntilHeartbeat(uint32_t nowMs) {
+  const uint32_t sinceLastMs = nowMs - lastSentMs;
+  return sinceLastMs < intervalMs ? intervalMs - sinceLastMs : 0;
+}
+
+Stats getStats() {
+  Stats stats;
+  stats.transitions = transitionReports.load(std::memory_order_relaxed);
+  stats.coalesced = coalescedCount.load(std::memory_order_relaxed);
+  stats.heartbeats = heartbeatCount.load(std::memory_order_relaxed);
+  return stats;
+}
+}  // namespace report_selection
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdint.h>
+
+// Picks what the ApiTask sends on each pass: the latest state transition, a heartbeat
+// once the cadence interval (core/report_cadence.h) has run out, or nothing.
+// Transitions queued since the previous report go out as one, carrying the newest of
+// them. A transition or an explicit request is urgent: it takes the slot from a report
+// still in flight rather than waiting for its response. Nothing is sent while the link
+// is down, so an urgent report stays pending until it returns. select() runs on the
+// ApiTask only; the counters may be read from any task.
+namespace report_selection {
+enum class Report : uint8_t { None, Transition, Heartbeat };
+
+// What the ApiTask sees at the start of a pass.
+struct Pass {
+  uint32_t nowMs = 0;
+  uint32_t transitions = 0;  // Running count of transitions queued by the game.
+  bool requested = false;    // A report was asked for without a new transition.
+  bool inFlight = false;     // The previous report still awaits its response.
+  bool linkUp = false;
+};
+
+struct Stats {
+  uint32_t transitions = 0;  // Transition reports sent.
+  uint32_t coalesced = 0;    // Transitions superseded by a newer one before they were sent.
+  uint32_t heartbeats = 0;
+};
+
+// Decides this pass's report. A Transition or Heartbeat counts as sent at pass.nowMs,
+// and the next heartbeat is due an interval later.
+Report select(const Pass &pass);
+
+// Sets the heartbeat interval, counted from the last report sent.
+void setIntervalMs(uint32_t intervalMs);
+uint32_t getIntervalMs();
+
+// Time until a heartbeat is due at `nowMs`; 0 when it already is.
+uint32_t msUntilHeartbeat(uint32_t nowMs);
+
+Stats getStats();
+}  // namespace report_selection
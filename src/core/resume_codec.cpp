@@ -0,0 +1,73 @@
+#include "core/resume_codec.h"
+
+#include <stddef.h>
+
+#include <cstring>
+
+namespace resume_codec {
+namespace {
+constexpr uint32_t kMagic = 0x44465253;  // "SRFD"
+
+uint32_t checksumOf(const Snapshot &value) {
+  const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&value);
+  uint32_t hash = 2166136261u;  // FNV-1a over everything before the checksum.
+  for (size_t i = 0; i < offsetof(Snapshot, checksum); ++i) {
+    hash = (hash ^ bytes[i]) * 16777619u;
+  }
+  return hash;
+}
+}  // namespace
+
+bool isWarmReset(ResetReason reason) {
+  return reason == ResetReason::Brownout || reason == ResetReason::Panic ||
+         reason == ResetReason::InterruptWatchdog || reason == ResetReason::TaskWatchdog ||
+         reason == ResetReason::OtherWatchdog;
+}
+
+Snapshot encode(const ResumePoint &point, uint64_t nowRtcUs) {
+  Snapshot next;
+  std::memset(&next, 0, sizeof(next));
+  next.magic = kMagic;
+  next.state = static_cast<uint8_t>(point.state);
+  next.matchStatus = static_cast<uint8_t>(point.matchStatus);
+  next.enteredDigits = point.enteredDigits;
+  std::memcpy(next.defuseBuffer, point.defuseBuffer, sizeof(next.defuseBuffer));
+  next.bombDurationMs = point.bombDurationMs;
+  next.bombRemainingMs = point.bombRemainingMs;
+  if (point.state == ARMED) {
+    next.deadlineRtcUs = nowRtcUs + static_cast<uint64_t>(point.bombRemainingMs) * 1000;
+  }
+  next.checksum = checksumOf(next);
+  return next;
+}
+
+bool decode(const Snapshot &saved, ResetReason reason, uint64_t nowRtcUs, ResumePoint &point) {
+  if (!isWarmReset(reason) || saved.magic != kMagic || saved.checksum != checksumOf(saved) ||
+      saved.matchStatus > Cancelled) {
+    return false;
+  }
+
+  const FlameState state = static_cast<FlameState>(saved.state);
+  if (state != ARMED && state != DEFUSED && state != DETONATED) {
+    return false;
+  }
+
+  point = ResumePoint();
+  point.state = state;
+  point.matchStatus = static_cast<MatchStatus>(saved.matchStatus);
+  point.bombDurationMs = saved.bombDurationMs;
+  point.bombRemainingMs = saved.bombRemainingMs;
+  if (state == ARMED) {
+    point.bombRemainingMs =
+        saved.deadlineRtcUs > nowRtcUs ? static_cast<uint32_t>((saved.deadlineRtcUs - nowRtcUs + 999) / 1000) : 0;
+    if (point.bombRemainingMs == 0) {
+      point.state = DETONATED;
+    } else {
+      point.enteredDigits = saved.enteredDigits;
+      std::memcpy(point.defuseBuffer, saved.defuseBuffer, sizeof(point.defuseBuffer));
+      point.defuseBuffer[DEFUSE_CODE_LENGTH] = '\0';
+    }
+  }
+  return true;
+}
+}  // namespace resume_codec
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "core/game_state.h"
+
+// Encoding of the warm-reset snapshot (see resume_snapshot.h). The firmware keeps a
+// Snapshot in RTC slow memory and supplies the RTC time and the reset reason; the rest
+// is decided here, so it runs on a host as well.
+namespace resume_codec {
+// Why the chip last reset, as far as resuming cares (esp_reset_reason_t on the prop).
+enum class ResetReason : uint8_t {
+  PowerOn,
+  External,  // Reset button.
+  Software,
+  DeepSleep,
+  Brownout,
+  Panic,
+  InterruptWatchdog,
+  TaskWatchdog,
+  OtherWatchdog,
+  Unknown,
+};
+
+struct Snapshot {
+  uint32_t magic;
+  uint8_t state;
+  uint8_t matchStatus;
+  uint8_t enteredDigits;
+  char defuseBuffer[DEFUSE_CODE_LENGTH + 1];
+  uint32_t bombDurationMs;
+  uint32_t bombRemainingMs;  // Frozen value for DEFUSED.
+  uint64_t deadlineRtcUs;    // ARMED: when the bomb goes off, on the RTC timer.
+  uint32_t checksum;
+};
+
+// Brownout, panic and the watchdogs; a power-on or reset-button boot starts afresh.
+bool isWarmReset(ResetReason reason);
+
+// Snapshot of `point` taken at `nowRtcUs`; for ARMED, the deadline is then plus
+// `point.bombRemainingMs`.
+Snapshot encode(const ResumePoint &point, uint64_t nowRtcUs);
+
+// Fills `point` from `saved` after a reset for `reason`, at `nowRtcUs`. An ARMED round
+// whose deadline passed during the reset comes back as DETONATED; the time left is
+// rounded up to whole ms. Returns false, leaving `point` alone, when there is nothing
+// to resume.
+bool decode(const Snapshot &saved, ResetReason reason, uint64_t nowRtcUs, ResumePoint &point);
+}  // namespace resume_codec
@@ -0,0 +1,41 @@
+#include "core/rtos_stage.h"
+
+#include "core/clock.h"
+
+namespace {
+void stageEntry(void *pvParameters) {
+  rtos_stage::Stage &stage = *static_cast<rtos_stage::Stage *>(pvParameters);
+  const TickType_t periodTicks = pdMS_TO_TICKS(stage.config.intervalMs) > 0 ? pdMS_TO_TICKS(stage.config.intervalMs) : 1;
+  TickType_t nextWakeTick = xTaskGetTickCount();
+  bool woken = false;
+  for (;;) {
+    sys_clock::beginFrame();
+    stage.body(sys_clock::frameMs(), woken);
+
+    const TickType_t nowTick = xTaskGetTickCount();
+    if (static_cast<int32_t>(nowTick - nextWakeTick) >= 0) {
+      // Stay on the grid but drop the slots this run overran.
+      nextWakeTick += ((nowTick - nextWakeTick) / periodTicks + 1) * periodTicks;
+    }
+    woken = ulTaskNotifyTake(pdTRUE, nextWakeTick - nowTick) != 0;
+  }
+}
+}  // namespace
+
+namespace rtos_stage {
+
+bool start(Stage &stage) {
+  if (stage.body == nullptr || stage.handle != nullptr) {
+    return false;
+  }
+  return xTaskCreatePinnedToCore(stageEntry, stage.config.name, stage.config.stackBytes, &stage,
+                                 stage.config.priority, &stage.handle, stage.config.core) == pdPASS;
+}
+
+void wake(Stage &stage) {
+  if (stage.handle != nullptr) {
+    xTaskNotifyGive(stage.handle);
+  }
+}
+
+}  // namespace rtos_stage
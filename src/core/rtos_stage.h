@@ -0,0 +1,35 @@
+#pragma once
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// A periodic pipeline stage running in its own FreeRTOS task. Used by the optional
+// threaded execution mode, where the game tick must preempt rendering instead of
+// queueing behind it in the cooperative scheduler.
+namespace rtos_stage {
+struct Config {
+  const char *name;
+  uint32_t intervalMs;
+  UBaseType_t priority;
+  BaseType_t core;
+  uint32_t stackBytes;
+};
+
+// `woken` is true when the run was started early by wake() rather than the period.
+using StageFn = void (*)(uint32_t nowMs, bool woken);
+
+struct Stage {
+  Config config;
+  StageFn body;
+  TaskHandle_t handle;
+};
+
+// Creates the task, pinned to `stage.config.core`. The deadline grid is phase-locked to
+// the start time, like scheduler tasks; a run that overruns its slot starts the next
+// one immediately without bursting through the missed ones. `stage` must outlive the task.
+bool start(Stage &stage);
+
+// Runs the stage as soon as its priority allows; safe to call from any task.
+void wake(Stage &stage);
+}  // namespace rtos_stage
@@ -1,37 +1,502 @@
 #include "core/scheduler.h"
 
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "core/clock.h"
+#include "core/event_queue.h"
+
 namespace {
 constexpr size_t kMaxTasks = 16;
+constexpr size_t kEventQueueCapacity = 32;
+constexpr size_t kHistogramBuckets = 40;  // Half-octave buckets up to ~1 s.
+
+struct TaskProfile {
+  uint32_t runs;
+  uint32_t minExecUs;
+  uint32_t maxExecUs;
+  uint64_t totalExecUs;
+  uint32_t jitterSamples;
+  uint32_t maxJitterUs;
+  uint32_t windowMaxJitterUs;
+  uint64_t totalJitterUs;
+  uint32_t missedDeadlines;
+  uint32_t overruns;
+  uint32_t skipped;
+  uint32_t triggeredRuns;
+  uint32_t latencySamples;
+  uint32_t maxLatencyUs;
+  uint64_t totalLatencyUs;
+  uint32_t histogram[kHistogramBuckets];
+};
+
 scheduler::Task tasks[kMaxTasks];
+TaskProfile profiles[kMaxTasks];
 size_t taskCount = 0;
+bool epochSet = false;
+uint32_t epochMs = 0;
+scheduler::IdleStats idleStats;
+
+// Pipeline bookkeeping: which tasks have unconsumed upstream output, and when the
+// chain that produced it started.
+uint16_t pendingMask = 0;
+uint64_t pendingOriginUs[kMaxTasks] = {0};
+bool publishedThisRun = false;
+bool triggeredThisRun = false;
+// The task whose callback is running, for sleepFor()/park().
+int8_t runningTask = -1;
+uint32_t runningNowMs = 0;
+
+struct Event {
+  scheduler::EventType type;
+  uint64_t postedUs;
+};
+
+EventQueue<Event, kEventQueueCapacity> eventQueue;
+std::atomic<uint32_t> droppedEvents{0};
+// The FreeRTOS task blocked in run(); producers notify it after queueing an event.
+std::atomic<TaskHandle_t> schedulerTask{nullptr};
+
+// Reached from postFromIsr(), so it and everything it calls (nowUs(), the inlined
+// EventQueue::push) stay in IRAM and keep working while the flash cache is disabled.
+bool IRAM_ATTR enqueueEvent(scheduler::EventType type) {
+  const Event event = {type, sys_clock::nowUs()};
+  if (!eventQueue.push(event)) {
+    droppedEvents.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+// Two buckets per power of two: the leading bit selects the octave and the bit after
+// it selects the half, which keeps p99 within ~25% without per-sample storage.
+size_t bucketForUs(uint32_t us) {
+  if (us < 2) {
+    return us;
+  }
+  const uint32_t msb = 31 - __builtin_clz(us);
+  const size_t index = 2 * msb + ((us >> (msb - 1)) & 1u);
+  return index < kHistogramBuckets ? index : kHistogramBuckets - 1;
+}
+
+uint32_t bucketUpperBoundUs(size_t index) {
+  if (index < 2) {
+    return static_cast<uint32_t>(index);
+  }
+  const uint32_t msb = static_cast<uint32_t>(index / 2);
+  const uint32_t lower = (1u << msb) | (static_cast<uint32_t>(index % 2) << (msb - 1));
+  return lower + (1u << (msb - 1)) - 1;
+}
+
+bool isDue(const scheduler::Task &task, uint32_t nowMs) {
+  return sys_clock::reached(nowMs, task.nextRunMs);
+}
+
+// Moves the deadline to the first grid slot strictly after `nowMs`.
+void realignPastNow(scheduler::Task &task, uint32_t nowMs) {
+  if (!isDue(task, nowMs)) {
+    return;
+  }
+  const uint32_t missedSlots = (nowMs - task.nextRunMs) / task.intervalMs + 1;
+  task.nextRunMs += missedSlots * task.intervalMs;
+}
+
+void recordExec(TaskProfile &profile, uint32_t intervalMs, uint32_t execUs) {
+  if (profile.runs == 0 || execUs < profile.minExecUs) {
+    profile.minExecUs = execUs;
+  }
+  if (execUs > profile.maxExecUs) {
+    profile.maxExecUs = execUs;
+  }
+  ++profile.runs;
+  profile.totalExecUs += execUs;
+  ++profile.histogram[bucketForUs(execUs)];
+
+  if (intervalMs != 0 && execUs > intervalMs * 1000) {
+    ++profile.overruns;
+  }
+}
+
+void recordLateness(TaskProfile &profile, uint32_t intervalMs, uint32_t latenessUs) {
+  const uint32_t intervalUs = intervalMs * 1000;
+  ++profile.jitterSamples;
+  profile.totalJitterUs += latenessUs;
+  if (latenessUs > profile.maxJitterUs) {
+    profile.maxJitterUs = latenessUs;
+  }
+  if (latenessUs > profile.windowMaxJitterUs) {
+    profile.windowMaxJitterUs = latenessUs;
+  }
+  if (intervalUs != 0 && latenessUs >= intervalUs) {
+    ++profile.missedDeadlines;
+  }
+}
+
+void recordLatency(TaskProfile &profile, uint32_t latencyUs) {
+  ++profile.latencySamples;
+  profile.totalLatencyUs += latencyUs;
+  if (latencyUs > profile.maxLatencyUs) {
+    profile.maxLatencyUs = latencyUs;
+  }
+}
+
+void markPending(uint16_t listeners, uint64_t originUs) {
+  for (size_t i = 0; i < taskCount; ++i) {
+    const uint16_t bit = static_cast<uint16_t>(1u << i);
+    if ((listeners & bit) != 0 && (pendingMask & bit) == 0) {
+      pendingOriginUs[i] = originUs;
+      pendingMask |= bit;
+    }
+  }
+}
+
+// Drains posted events and returns the set of subscribed tasks to run this pass.
+uint16_t collectEventSubscribers() {
+  uint16_t woken = 0;
+  Event event;
+  while (eventQueue.pop(event)) {
+    const uint32_t typeBit = 1u << static_cast<uint8_t>(event.type);
+    uint16_t subscribers = 0;
+    for (size_t i = 0; i < taskCount; ++i) {
+      if ((tasks[i].events & typeBit) != 0) {
+        subscribers |= static_cast<uint16_t>(1u << i);
+      }
+    }
+    markPending(subscribers, event.postedUs);
+    woken |= subscribers;
+  }
+  return woken;
+}
+
+uint32_t percentileUs(const TaskProfile &profile, uint32_t percent) {
+  if (profile.runs == 0) {
+    return 0;
+  }
+  const uint64_t target = (static_cast<uint64_t>(profile.runs) * percent + 99) / 100;
+  uint64_t seen = 0;
+  for (size_t i = 0; i < kHistogramBuckets; ++i) {
+    seen += profile.histogram[i];
+    if (seen >= target) {
+      const uint32_t bound = bucketUpperBoundUs(i);
+      return bound < profile.maxExecUs ? bound : profile.maxExecUs;
+    }
+  }
+  return profile.maxExecUs;
+}
 }  // namespace
 
 namespace scheduler {
 
-bool addTask(const TaskCallback &callback, uint32_t intervalMs) {
+TaskId addTask(const char *name, const TaskCallback &callback, uint32_t intervalMs, uint32_t phaseMs,
+               CatchUpPolicy catchUp) {
   if (!callback || intervalMs == 0 || taskCount >= kMaxTasks) {
+    return kInvalidTask;
+  }
+
+  if (!epochSet) {
+    epochMs = sys_clock::nowMs();
+    epochSet = true;
+  }
+
+  tasks[taskCount] = {name, callback, intervalMs, epochMs + phaseMs, catchUp, 0, 0, 0, nullptr, 0, false};
+  profiles[taskCount] = TaskProfile{};
+  return static_cast<TaskId>(taskCount++);
+}
+
+TaskId addCoroutineTask(const char *name, const TaskCallback &resume, Coroutine &frame, uint16_t frameBytes) {
+  const TaskId task = addTask(name, resume, 1);
+  if (task == kInvalidTask) {
+    return kInvalidTask;
+  }
+  // A coroutine has no cadence of its own: the interval only scales the missed-deadline
+  // and overrun stats, and stays 0 (not counted) until sleepFor() sets it to the length
+  // of the latest sleep.
+  tasks[task].intervalMs = 0;
+  tasks[task].coroutine = &frame;
+  tasks[task].frameBytes = frameBytes;
+  tasks[task].parked = true;
+  return task;
+}
+
+void sleepFor(uint32_t delayMs) {
+  if (runningTask < 0) {
+    return;
+  }
+  Task &task = tasks[runningTask];
+  task.nextRunMs = runningNowMs + delayMs;
+  task.intervalMs = delayMs > 0 ? delayMs : 1;
+}
+
+void park() {
+  if (runningTask >= 0) {
+    tasks[runningTask].parked = true;
+  }
+}
+
+bool startCoroutine(TaskId task) {
+  if (task < 0 || static_cast<size_t>(task) >= taskCount || tasks[task].coroutine == nullptr) {
+    return false;
+  }
+  Task &target = tasks[task];
+  target.coroutine->restart();
+  target.parked = false;
+  target.intervalMs = 0;
+  target.nextRunMs = sys_clock::nowMs();
+  return true;
+}
+
+bool addDependency(TaskId stage, TaskId upstream, bool runImmediately) {
+  // Dependents must come later in the table so one in-order pass resolves the chain.
+  if (upstream < 0 || stage <= upstream || static_cast<size_t>(stage) >= taskCount) {
     return false;
   }
 
-  tasks[taskCount] = {callback, intervalMs, 0};
-  ++taskCount;
+  const uint16_t bit = static_cast<uint16_t>(1u << stage);
+  Task &source = tasks[upstream];
+  if (runImmediately) {
+    source.triggers |= bit;
+    source.tracks &= static_cast<uint16_t>(~bit);
+  } else {
+    source.tracks |= bit;
+    source.triggers &= static_cast<uint16_t>(~bit);
+  }
   return true;
 }
 
-void run() {
-  const uint32_t now = millis();
+void publish() { publishedThisRun = true; }
+
+bool isTriggeredRun() { return triggeredThisRun; }
+
+bool subscribe(TaskId task, EventType type) {
+  if (task < 0 || static_cast<size_t>(task) >= taskCount || type >= EventType::Count) {
+    return false;
+  }
+  tasks[task].events |= 1u << static_cast<uint8_t>(type);
+  return true;
+}
+
+uint32_t takePeakLatenessUs(TaskId task) {
+  if (task < 0 || static_cast<size_t>(task) >= taskCount) {
+    return 0;
+  }
+  TaskProfile &profile = profiles[task];
+  const uint32_t peak = profile.windowMaxJitterUs;
+  profile.windowMaxJitterUs = 0;
+  return peak;
+}
+
+void post(EventType type) {
+  if (!enqueueEvent(type)) {
+    return;
+  }
+  TaskHandle_t waiter = schedulerTask.load(std::memory_order_acquire);
+  if (waiter != nullptr) {
+    xTaskNotifyGive(waiter);
+  }
+}
+
+void IRAM_ATTR postFromIsr(EventType type) {
+  if (!enqueueEvent(type)) {
+    return;
+  }
+  TaskHandle_t waiter = schedulerTask.load(std::memory_order_acquire);
+  if (waiter == nullptr) {
+    return;
+  }
+  BaseType_t higherPriorityWoken = pdFALSE;
+  vTaskNotifyGiveFromISR(waiter, &higherPriorityWoken);
+  if (higherPriorityWoken == pdTRUE) {
+    portYIELD_FROM_ISR();
+  }
+}
+
+void dispatchDue(uint32_t nowMs) {
+  ++idleStats.passes;
+  const uint64_t passStartUs = sys_clock::nowUs();
+  uint16_t triggered = collectEventSubscribers();
   for (size_t i = 0; i < taskCount; ++i) {
     Task &task = tasks[i];
-    if (!task.callback) {
+    if (!task.callback || task.parked) {
       continue;
     }
 
-    if (now - task.lastRunMs >= task.intervalMs) {
-      task.lastRunMs = now;
-      task.callback(now);
+    const uint16_t bit = static_cast<uint16_t>(1u << i);
+    bool due = isDue(task, nowMs);
+    const bool triggeredRun = (triggered & bit) != 0;
+    if (!due && !triggeredRun) {
+      continue;
+    }
+
+    TaskProfile &profile = profiles[i];
+    const uint32_t lateMs = nowMs - task.nextRunMs;
+    if (due && task.catchUp == CatchUpPolicy::Skip && lateMs >= task.intervalMs) {
+      ++profile.skipped;
+      ++profile.missedDeadlines;
+      realignPastNow(task, nowMs);
+      due = false;
+      if (!triggeredRun) {
+        continue;
+      }
+    }
+
+    const uint64_t startUs = sys_clock::nowUs();
+    if (due) {
+      // Lateness is the ms-resolution slip against the deadline plus whatever earlier
+      // tasks in this pass consumed before this one started.
+      recordLateness(profile, task.intervalMs, lateMs * 1000 + static_cast<uint32_t>(startUs - passStartUs));
+
+      // Phase-locked: the next deadline derives from the previous one, not from
+      // `nowMs`, so late dispatches do not push the period later. Coroutines set their
+      // next deadline themselves through sleepFor() or park().
+      if (task.coroutine == nullptr) {
+        task.nextRunMs += task.intervalMs;
+        if (task.catchUp != CatchUpPolicy::Burst) {
+          realignPastNow(task, nowMs);
+        }
+      }
+    } else {
+      ++profile.triggeredRuns;
+    }
+
+    publishedThisRun = false;
+    triggeredThisRun = !due;
+    runningTask = static_cast<int8_t>(i);
+    runningNowMs = nowMs;
+    task.callback(nowMs);
+    runningTask = -1;
+    triggeredThisRun = false;
+
+    const uint64_t endUs = sys_clock::nowUs();
+    recordExec(profile, task.intervalMs, static_cast<uint32_t>(endUs - startUs));
+
+    uint64_t originUs = startUs;
+    if ((pendingMask & bit) != 0) {
+      originUs = pendingOriginUs[i];
+      pendingMask &= static_cast<uint16_t>(~bit);
+      recordLatency(profile, static_cast<uint32_t>(endUs - originUs));
+    }
+
+    if (publishedThisRun) {
+      triggered |= task.triggers;
+      markPending(task.triggers | task.tracks, originUs);
     }
   }
 }
 
-}  // namespace scheduler
+uint32_t msUntilNextDeadline(uint32_t nowMs) {
+  uint32_t waitMs = kNoDeadline;
+  for (size_t i = 0; i < taskCount; ++i) {
+    const Task &task = tasks[i];
+    if (!task.callback || task.parked) {
+      continue;
+    }
+
+    if (isDue(task, nowMs)) {
+      return 0;
+    }
+
+    const uint32_t remaining = task.nextRunMs - nowMs;
+    if (remaining < waitMs) {
+      waitMs = remaining;
+    }
+  }
+  return waitMs;
+}
+
+void run() {
+  if (schedulerTask.load(std::memory_order_relaxed) == nullptr) {
+    schedulerTask.store(xTaskGetCurrentTaskHandle(), std::memory_order_release);
+  }
+
+  // Every task in this pass sees the same frame time.
+  sys_clock::beginFrame();
+  dispatchDue(sys_clock::frameMs());
+
+  // Re-sample the clock: the callbacks above may have consumed part of the next slot.
+  const uint32_t sleepStartMs = sys_clock::nowMs();
+  const uint32_t waitMs = msUntilNextDeadline(sleepStartMs);
+  if (waitMs == 0) {
+    return;
+  }
 
+  // Events posted since the drain above have already bumped the notification count,
+  // so this returns immediately for them instead of losing the wakeup.
+  ++idleStats.sleeps;
+  const TickType_t waitTicks = waitMs == kNoDeadline ? portMAX_DELAY : pdMS_TO_TICKS(waitMs);
+  if (ulTaskNotifyTake(pdTRUE, waitTicks) != 0) {
+    ++idleStats.eventWakeups;
+  }
+  idleStats.sleptMs += sys_clock::nowMs() - sleepStartMs;
+}
+
+IdleStats getIdleStats() {
+  IdleStats stats = idleStats;
+  stats.droppedEvents = droppedEvents.load(std::memory_order_relaxed);
+  return stats;
+}
+
+size_t getTaskCount() { return taskCount; }
+
+bool getTaskStats(size_t index, TaskStats &out) {
+  if (index >= taskCount) {
+    return false;
+  }
+
+  const Task &task = tasks[index];
+  const TaskProfile &profile = profiles[index];
+  out = TaskStats{};
+  out.name = task.name;
+  out.intervalMs = task.intervalMs;
+  out.runs = profile.runs;
+  out.minExecUs = profile.minExecUs;
+  out.maxExecUs = profile.maxExecUs;
+  out.avgExecUs = profile.runs == 0 ? 0 : static_cast<uint32_t>(profile.totalExecUs / profile.runs);
+  out.p99ExecUs = percentileUs(profile, 99);
+  out.avgJitterUs =
+      profile.jitterSamples == 0 ? 0 : static_cast<uint32_t>(profile.totalJitterUs / profile.jitterSamples);
+  out.maxJitterUs = profile.maxJitterUs;
+  out.missedDeadlines = profile.missedDeadlines;
+  out.overruns = profile.overruns;
+  out.skipped = profile.skipped;
+  out.triggeredRuns = profile.triggeredRuns;
+  out.avgLatencyUs =
+      profile.latencySamples == 0 ? 0 : static_cast<uint32_t>(profile.totalLatencyUs / profile.latencySamples);
+  out.maxLatencyUs = profile.maxLatencyUs;
+  out.frameBytes = task.frameBytes;
+  out.parked = task.parked;
+  return true;
+}
+
+void resetTaskStats() {
+  for (size_t i = 0; i < taskCount; ++i) {
+    profiles[i] = TaskProfile{};
+  }
+}
+
+void dumpTaskStats() {
+#ifdef APP_DEBUG
+  const IdleStats idle = getIdleStats();
+  Serial.printf("[SCHED] passes=%lu sleeps=%lu sleptMs=%lu eventWakeups=%lu droppedEvents=%lu\n",
+                static_cast<unsigned long>(idle.passes), static_cast<unsigned long>(idle.sleeps),
+                static_cast<unsigned long>(idle.sleptMs), static_cast<unsigned long>(idle.eventWakeups),
+                static_cast<unsigned long>(idle.droppedEvents));
+  for (size_t i = 0; i < taskCount; ++i) {
+    TaskStats stats;
+    getTaskStats(i, stats);
+    Serial.printf("[SCHED] %-10s %4lums runs=%lu exec us min/avg/max/p99=%lu/%lu/%lu/%lu jitter us avg/max=%lu/%lu "
+                  "missed=%lu overruns=%lu skipped=%lu triggered=%lu latency us avg/max=%lu/%lu frame=%uB%s\n",
+                  stats.name ? stats.name : "?", static_cast<unsigned long>(stats.intervalMs),
+                  static_cast<unsigned long>(stats.runs), static_cast<unsigned long>(stats.minExecUs),
+                  static_cast<unsigned long>(stats.avgExecUs), static_cast<unsigned long>(stats.maxExecUs),
+                  static_cast<unsigned long>(stats.p99ExecUs), static_cast<unsigned long>(stats.avgJitterUs),
+                  static_cast<unsigned long>(stats.maxJitterUs), static_cast<unsigned long>(stats.missedDeadlines),
+                  static_cast<unsigned long>(stats.overruns), static_cast<unsigned long>(stats.skipped),
+                  static_cast<unsigned long>(stats.triggeredRuns), static_cast<unsigned long>(stats.avgLatencyUs),
+                  static_cast<unsigned long>(stats.maxLatencyUs), static_cast<unsigned>(stats.frameBytes),
+                  stats.parked ? " parked" : "");
+  }
+#endif
+}
+
+}  // namespace scheduler
@@ -1,18 +1,175 @@
 #pragma once
 
 #include <Arduino.h>
-#include <functional>
+
+#include "core/coroutine.h"
+#include "core/inline_function.h"
 
 namespace scheduler {
-using TaskCallback = std::function<void(uint32_t)>;
+// Task callbacks live inline in the static task table; captures larger than two
+// pointers are rejected at compile time.
+using TaskCallback = InlineFunction<void(uint32_t)>;
+
+// Asynchronous wakeup sources. Producers on core 0, in ISRs or in drivers post these;
+// subscribed tasks run in the very next pass instead of waiting for their period,
+// which then only serves as a polling fallback.
+enum class EventType : uint8_t {
+  ApiResponse,   // ApiTask parsed a backend response.
+  IrFrame,       // IR receiver completed a frame (posted from the IRremote ISR).
+  BombDeadline,  // The ARMED countdown's hardware timer fired (posted from the esp_timer task).
+  Count
+};
+
+// Index of a registered task; returned by addTask() and used to wire dependencies.
+using TaskId = int8_t;
+constexpr TaskId kInvalidTask = -1;
+
+// What a periodic task does when a dispatch comes in a full interval or more late.
+// Deadlines always stay on the task's phase grid (next = previous + interval).
+enum class CatchUpPolicy : uint8_t {
+  Skip,     // Drop the stale run entirely and resume on the next grid slot.
+  RunOnce,  // Run once now; the missed slots collapse into this single run.
+  Burst,    // Run once per missed slot, back-to-back, until caught up.
+};
 
 struct Task {
+  const char *name;
   TaskCallback callback;
   uint32_t intervalMs;
-  uint32_t lastRunMs;
+  uint32_t nextRunMs;
+  CatchUpPolicy catchUp;
+  uint16_t triggers;  // Bitmask of dependent tasks run in the same pass when this one publishes.
+  uint16_t tracks;    // Bitmask of dependent tasks that only record latency from this one.
+  uint32_t events;    // Bitmask of EventType values this task is woken by.
+  Coroutine *coroutine;  // Frame of a coroutine task, nullptr for plain periodic tasks.
+  uint16_t frameBytes;
+  bool parked;        // Not dispatched and not waited for until started again.
 };
 
-bool addTask(const TaskCallback &callback, uint32_t intervalMs);
-void run();
+// Idle accounting for the tickless loop: how many times run() blocked instead of
+// re-polling the task table, how long it spent blocked in total, and how often an
+// event cut the sleep short.
+struct IdleStats {
+  uint32_t passes = 0;
+  uint32_t sleeps = 0;
+  uint32_t sleptMs = 0;
+  uint32_t eventWakeups = 0;
+  uint32_t droppedEvents = 0;  // Posts rejected because the event queue was full.
+};
+
+// Per-task execution profile. Execution times are measured with esp_timer around the
+// callback; start jitter is how far the dispatch started after the task's intended
+// deadline. p99 is resolved to half-octave histogram buckets (upper bucket bound).
+struct TaskStats {
+  const char *name = nullptr;
+  uint32_t intervalMs = 0;
+  uint32_t runs = 0;
+  uint32_t minExecUs = 0;
+  uint32_t avgExecUs = 0;
+  uint32_t maxExecUs = 0;
+  uint32_t p99ExecUs = 0;
+  uint32_t avgJitterUs = 0;
+  uint32_t maxJitterUs = 0;
+  uint32_t missedDeadlines = 0;  // Started a full interval or more past its deadline.
+  uint32_t overruns = 0;         // Callback ran longer than its own interval.
+  uint32_t skipped = 0;          // Stale runs dropped by CatchUpPolicy::Skip.
+  uint32_t triggeredRuns = 0;    // Extra runs caused by an upstream publish() or event.
+  uint32_t avgLatencyUs = 0;     // Upstream publish/event origin -> end of this task's run.
+  uint32_t maxLatencyUs = 0;
+  uint16_t frameBytes = 0;       // Coroutine frame size; 0 for plain tasks.
+  bool parked = false;
+};
+
+// Registers a periodic task whose first deadline is `phaseMs` after the scheduler epoch
+// (the time the first task was added). Giving tasks with the same interval different
+// phases spreads their cost across the period instead of stacking it in one pass.
+TaskId addTask(const char *name, const TaskCallback &callback, uint32_t intervalMs, uint32_t phaseMs = 0,
+               CatchUpPolicy catchUp = CatchUpPolicy::RunOnce);
+
+// Registers a parked coroutine task; use addCoroutine() instead.
+TaskId addCoroutineTask(const char *name, const TaskCallback &resume, Coroutine &frame, uint16_t frameBytes);
+
+// Called from inside a coroutine task's callback: its next run is `delayMs` from now.
+void sleepFor(uint32_t delayMs);
+
+// Called from inside a task callback: the task stops running until startCoroutine().
+void park();
+
+// Restarts a coroutine task from CO_BEGIN; it runs in the next pass. Restarting one
+// that is mid-sequence abandons the old run.
+bool startCoroutine(TaskId task);
+
+// Registers `body` as a coroutine task that is resumed only when its CO_SLEEP_MS
+// expires, so the tickless loop sleeps through the gaps. It starts parked; call
+// startCoroutine() to run it. Its stats interval is the latest sleep's length, and 0
+// (no missed deadlines or overruns counted) from a start until its first sleep.
+template <typename Frame>
+TaskId addCoroutine(const char *name, Frame &frame, CoStatus (*body)(Frame &, uint32_t)) {
+  static_assert(sizeof(Frame) <= kMaxCoroutineFrameBytes, "Coroutine frame exceeds kMaxCoroutineFrameBytes");
+  Frame *target = &frame;
+  return addCoroutineTask(
+      name,
+      [target, body](uint32_t nowMs) {
+        if (body(*target, nowMs) == CoStatus::Sleeping) {
+          sleepFor(target->sleepMs);
+        } else {
+          park();
+        }
+      },
+      frame, static_cast<uint16_t>(sizeof(Frame)));
 }
 
+// Declares that `stage` consumes `upstream`'s output. When upstream calls publish()
+// during its run, `stage` runs later in the same pass (in addition to its own period),
+// so a chain like inputs -> state -> UI completes back-to-back. With
+// `runImmediately` false the edge only measures latency and the stage keeps its own
+// cadence. Upstream must have been registered before the stage.
+bool addDependency(TaskId stage, TaskId upstream, bool runImmediately = true);
+
+// Called from inside a task callback to mark that it produced new output for its
+// dependents. The latency origin is carried along the chain, so downstream stages
+// report end-to-end latency from the first publishing stage.
+void publish();
+
+// True while the running callback was dispatched because of an upstream publish()
+// or a subscribed event rather than its own deadline.
+bool isTriggeredRun();
+
+// Wakes `task` whenever an event of `type` is posted.
+bool subscribe(TaskId task, EventType type);
+
+// Largest start lateness of `task`'s deadline runs since the previous call, then
+// starts a new window. Lets a monitor react to recent slips rather than lifetime stats.
+uint32_t takePeakLatenessUs(TaskId task);
+
+// Queue an event and wake the scheduler. post() is safe from any task on either core;
+// postFromIsr() is the ISR variant; its whole path lives in IRAM, so it is also safe
+// while the flash cache is off. Both are lock-free and never block.
+void post(EventType type);
+void postFromIsr(EventType type);
+
+// Dispatches every task whose deadline has been reached at `nowMs`. Takes the time as a
+// parameter so the table can be driven by a virtual clock.
+void dispatchDue(uint32_t nowMs);
+
+// Returned by msUntilNextDeadline() when no task is runnable.
+constexpr uint32_t kNoDeadline = UINT32_MAX;
+
+// Milliseconds from `nowMs` until the earliest task deadline: 0 when a task is due,
+// kNoDeadline when every task is parked or none is registered.
+uint32_t msUntilNextDeadline(uint32_t nowMs);
+
+// Runs due tasks, then blocks the calling FreeRTOS task until the next deadline so the
+// core idles instead of spinning through loop(). With nothing runnable it blocks until
+// an event is posted.
+void run();
+
+IdleStats getIdleStats();
+
+size_t getTaskCount();
+bool getTaskStats(size_t index, TaskStats &out);
+void resetTaskStats();
+
+// Prints one line per task with the profile above to Serial.
+void dumpTaskStats();
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+
+// Single-writer, multi-reader latest value (sequence lock). The writer bumps the
+// sequence to odd, stores the value and bumps it back to even; a reader retries when
+// the sequence was odd or moved while it copied. The writer never waits; readers only
+// spin for the length of one copy, and never return a mix of two writes.
+//
+// The value is kept as relaxed atomic words so the copy a reader later throws away is
+// still a well-defined read. Meant for small, trivially copyable structs.
+template <typename T>
+class Seqlock {
+  static_assert(std::is_trivially_copyable<T>::value, "Seqlock values are copied word by word");
+
+ public:
+  Seqlock() { write(T{}); }
+  Seqlock(const Seqlock &) = delete;
+  Seqlock &operator=(const Seqlock &) = delete;
+
+  void write(const T &value) {
+    uint32_t staged[kWords] = {0};
+    std::memcpy(staged, &value, sizeof(T));
+    const uint32_t sequence = sequenceNumber.load(std::memory_order_relaxed);
+    sequenceNumber.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < kWords; ++i) {
+      words[i].store(staged[i], std::memory_order_relaxed);
+    }
+    sequenceNumber.store(sequence + 2, std::memory_order_release);
+  }
+
+  T read() const {
+    uint32_t staged[kWords];
+    for (;;) {
+      const uint32_t before = sequenceNumber.load(std::memory_order_acquire);
+      if ((before & 1u) != 0) {
+        continue;
+      }
+      for (size_t i = 0; i < kWords; ++i) {
+        staged[i] = words[i].load(std::memory_order_relaxed);
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (sequenceNumber.load(std::memory_order_relaxed) == before) {
+        break;
+      }
+    }
+    T value;
+    std::memcpy(&value, staged, sizeof(T));
+    return value;
+  }
+
+  // Even; advances by 2 per write.
+  uint32_t sequence() const { return sequenceNumber.load(std::memory_order_acquire); }
+
+ private:
+  static constexpr size_t kWords = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+  std::atomic<uint32_t> sequenceNumber{0};
+  std::atomic<uint32_t> words[kWords];
+};
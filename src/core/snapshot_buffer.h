@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+
+// Single-writer, single-reader latest-value buffer (triple buffering). The writer fills
+// a private back slot and swaps it into the middle; the reader swaps the middle out
+// when it has changed. Neither side ever blocks or sees a half-written value, and the
+// reader always gets the most recent complete snapshot; intermediate ones are dropped.
+template <typename T>
+class SnapshotBuffer {
+ public:
+  SnapshotBuffer() = default;
+  SnapshotBuffer(const SnapshotBuffer &) = delete;
+  SnapshotBuffer &operator=(const SnapshotBuffer &) = delete;
+
+  void publish(const T &value) {
+    slots[backIndex] = value;
+    const uint8_t previous = middle.exchange(static_cast<uint8_t>(backIndex | kFreshBit), std::memory_order_acq_rel);
+    backIndex = previous & kIndexMask;
+  }
+
+  // Copies the latest snapshot into `out`. Returns false (leaving `out` untouched) when
+  // nothing new has been published since the previous read.
+  bool read(T &out) {
+    if ((middle.load(std::memory_order_relaxed) & kFreshBit) == 0) {
+      return false;
+    }
+    const uint8_t previous = middle.exchange(frontIndex, std::memory_order_acq_rel);
+    frontIndex = previous & kIndexMask;
+    out = slots[frontIndex];
+    return true;
+  }
+
+ private:
+  static constexpr uint8_t kFreshBit = 0x4;
+  static constexpr uint8_t kIndexMask = 0x3;
+
+  T slots[3]{};
+  std::atomic<uint8_t> middle{1};
+  uint8_t backIndex = 0;   // Owned by the writer.
+  uint8_t frontIndex = 2;  // Owned by the reader.
+};
@@ -0,0 +1,470 @@
+#include "core/soak_sim.h"
+
+#include <stdio.h>
+
+#include <new>
+
+#include "core/clock.h"
+
+namespace soak_sim {
+namespace {
+bool isPlayState(FlameState state) { return state == ACTIVE || state == ARMING || state == ARMED; }
+
+bool isMatchOver(MatchStatus status) {
+  return status == WaitingOnFinalData || status == Completed || status == Cancelled;
+}
+
+bool isWatchdogTripped(const GameInputs &inputs) {
+  return inputs.wifiConnected && sys_clock::reached(inputs.nowMs, inputs.lastSuccessfulApiMs) &&
+         inputs.nowMs - inputs.lastSuccessfulApiMs >= API_TIMEOUT_MS;
+}
+}  // namespace
+
+const char *invariantName(Invariant invariant) {
+  switch (invariant) {
+    case Invariant::BombTimerBounds:
+      return "BombTimerBounds";
+    case Invariant::BombTimerOutsideArmed:
+      return "BombTimerOutsideArmed";
+    case Invariant::BombTimerStalled:
+      return "BombTimerStalled";
+    case Invariant::EarlyDetonation:
+      return "EarlyDetonation";
+    case Invariant::ArmedExit:
+      return "ArmedExit";
+    case Invariant::DefuseWithoutCode:
+      return "DefuseWithoutCode";
+    case Invariant::ArmingPath:
+      return "ArmingPath";
+    case Invariant::ArmingStuck:
+      return "ArmingStuck";
+    case Invariant::PlayAfterMatchOver:
+      return "PlayAfterMatchOver";
+    case Invariant::OutputsMismatch:
+      return "OutputsMismatch";
+    case Invariant::GameTimerRewound:
+      return "GameTimerRewound";
+    default:
+      return "Unknown";
+  }
+}
+
+bool Simulator::reset(const Config &newConfig, const char **error) {
+  config = newConfig;
+  results = Report();
+  game_mode::GameMode compiled;
+  if (!game_mode::compile(config.rules, compiled, error)) {
+    config.matches = 0;
+    return false;
+  }
+  mode = compiled;
+
+  // The longest press that arming can need, and how long ARMING may last in all.
+  uint32_t stepsMs = 0;
+  armPressMaxMs = 0;
+  irWindowMs = IR_CONFIRM_WINDOW_MS;
+  for (uint8_t i = 0; i < mode.armStepCount; ++i) {
+    const game_mode::Step &step = mode.armSteps[i];
+    stepsMs += step.durationMs;
+    if (step.kind == game_mode::ArmStep::Hold) {
+      armPressMaxMs = stepsMs;
+    } else {
+      irWindowMs = step.durationMs;
+    }
+  }
+  armingMaxMs = stepsMs;
+
+  // A fresh engine per run, so a seed reproduces the run exactly.
+  engine.~GameEngine();
+  new (&engine) game_state::GameEngine();
+
+  rngState = config.seed != 0 ? config.seed : 1;
+  nowMs = config.startMs;
+  match = 0;
+  inputs = GameInputs();
+  wifiConnected = true;
+  linkRestoresMs = 0;
+  apiOutage = false;
+  apiResponseReceived = false;
+  nextApiMs = nowMs;
+  lastSuccessfulApiMs = nowMs;
+  holding = false;
+  irScheduled = false;
+  irLatched = false;
+  codePosition = 0;
+  gameTimerTracked = false;
+  inputs.gameMode = &mode;
+  startMatch();
+  return true;
+}
+
+bool Simulator::step(uint32_t maxTicks) {
+  for (uint32_t i = 0; i < maxTicks; ++i) {
+    if (results.matches >= config.matches) {
+      return false;
+    }
+    tick();
+  }
+  return results.matches < config.matches;
+}
+
+// xorshift32: deterministic on every platform, unlike the distributions in <random>.
+uint32_t Simulator::random() {
+  rngState ^= rngState << 13;
+  rngState ^= rngState >> 17;
+  rngState ^= rngState << 5;
+  return rngState;
+}
+
+uint32_t Simulator::randomBetween(uint32_t low, uint32_t high) { return low + random() % (high - low + 1); }
+
+bool Simulator::oneIn(uint32_t n) { return random() % n == 0; }
+
+void Simulator::startMatch() {
+  ++match;
+  phase = Phase::WaitingOnStart;
+  phaseEndsMs = nowMs + randomBetween(2000, 10000);
+  remoteStatus = WaitingOnStart;
+
+  const uint32_t ending = random() % 10;
+  finalStatus = ending == 0 ? Cancelled : (ending == 1 ? WaitingOnFinalData : Completed);
+
+  bombDurationMs = randomBetween(10, 60) * 1000;
+  for (uint8_t i = 0; i < DEFUSE_CODE_LENGTH; ++i) {
+    defuseCode[i] = static_cast<char>('0' + random() % 10);
+  }
+  defuseCode[DEFUSE_CODE_LENGTH] = '\0';
+  inputs.configuredBombDurationMs = bombDurationMs;
+  inputs.configuredDefuseCode = defuseCode;
+}
+
+void Simulator::advanceScript() {
+  if (static_cast<int32_t>(nowMs - phaseEndsMs) < 0) {
+    return;
+  }
+
+  switch (phase) {
+    case Phase::WaitingOnStart:
+      phase = Phase::Countdown;
+      remoteStatus = Countdown;
+      phaseEndsMs = nowMs + randomBetween(5000, 15000);
+      break;
+    case Phase::Countdown:
+      phase = Phase::Running;
+      remoteStatus = Running;
+      phaseEndsMs = nowMs + randomBetween(config.minRunningMs, config.maxRunningMs);
+      break;
+    case Phase::Running:
+      phase = finalStatus == WaitingOnFinalData ? Phase::FinalData : Phase::Over;
+      remoteStatus = finalStatus;
+      phaseEndsMs = nowMs + randomBetween(3000, 10000);
+      break;
+    case Phase::FinalData:
+      phase = Phase::Over;
+      remoteStatus = Completed;
+      phaseEndsMs = nowMs + randomBetween(3000, 10000);
+      break;
+    case Phase::Over:
+      ++results.matches;
+      if (results.matches < config.matches) {
+        startMatch();
+      }
+      break;
+  }
+}
+
+// Responses every API_POST_INTERVAL_MS, with occasional API outages (some long enough
+// to trip the watchdog) and WiFi drops (which suspend it).
+void Simulator::simulateApi() {
+  if ((apiOutage || !wifiConnected) && static_cast<int32_t>(nowMs - linkRestoresMs) >= 0) {
+    apiOutage = false;
+    wifiConnected = true;
+  } else if (!apiOutage && wifiConnected && oneIn(60000)) {
+    if (oneIn(2)) {
+      apiOutage = true;
+      linkRestoresMs = nowMs + randomBetween(2000, 25000);
+    } else {
+      wifiConnected = false;
+      linkRestoresMs = nowMs + randomBetween(1000, 30000);
+    }
+  }
+
+  if (wifiConnected && !apiOutage && static_cast<int32_t>(nowMs - nextApiMs) >= 0) {
+    lastSuccessfulApiMs = nowMs;
+    apiResponseReceived = true;
+    nextApiMs = nowMs + API_POST_INTERVAL_MS + random() % 50;
+    if (phase == Phase::Running) {
+      engine.update_game_timer_from_api(phaseEndsMs - nowMs, nowMs);
+      gameTimerTracked = false;
+    }
+  }
+
+  inputs.wifiConnected = wifiConnected;
+  inputs.lastSuccessfulApiMs = lastSuccessfulApiMs;
+  inputs.apiResponseReceived = apiResponseReceived;
+  inputs.remoteMatchStatus = remoteStatus;
+}
+
+void Simulator::simulatePlayers() {
+  const FlameState state = engine.get_state();
+  const bool wasHolding = holding;
+
+  if (holding && static_cast<int32_t>(nowMs - holdEndsMs) >= 0) {
+    holding = false;
+  }
+  if (!holding) {
+    const bool holdToDefuse = mode.defuse == game_mode::DefuseMethod::Hold;
+    if (state == ERROR_STATE && oneIn(200)) {
+      holding = true;
+      holdEndsMs = nowMs + randomBetween(BUTTON_HOLD_MS, BUTTON_HOLD_MS + 1000);
+    } else if (state == ARMED && holdToDefuse && oneIn(300)) {
+      holding = true;
+      holdEndsMs = nowMs + randomBetween(200, mode.defuseHoldMs + 2000);
+    } else if ((state == ACTIVE && oneIn(300)) || oneIn(5000)) {
+      holding = true;
+      holdEndsMs = nowMs + randomBetween(200, armPressMaxMs + 2000);
+    }
+  }
+  // A press that starts on the tick the last one ended is, to the engine, the same press.
+  if (holding && !wasHolding) {
+    holdStartedMs = nowMs;
+  }
+  inputs.bothButtonsPressed = holding;
+
+  // IR stays latched until the engine asks for it to be cleared, as on the prop.
+  if (engine.is_ir_confirmation_window_active()) {
+    if (!irScheduled) {
+      irScheduled = true;
+      irSendMs = nowMs + randomBetween(0, irWindowMs + 2000);
+    } else if (static_cast<int32_t>(nowMs - irSendMs) >= 0) {
+      irLatched = true;
+    }
+  } else {
+    irScheduled = false;
+    if (oneIn(20000)) {
+      irLatched = true;
+    }
+  }
+  inputs.irConfirmationReceived = irLatched;
+
+  inputs.keypadDigitAvailable = false;
+  inputs.keypadDigit = '\0';
+  if (state == ARMED && mode.defuse == game_mode::DefuseMethod::Code &&
+      static_cast<int32_t>(nowMs - nextKeyMs) >= 0) {
+    if (codePosition == 0) {
+      typingCorrectCode = !oneIn(3);
+    }
+    const char digit =
+        typingCorrectCode ? defuseCode[codePosition] : static_cast<char>('0' + random() % 10);
+    codePosition = static_cast<uint8_t>((codePosition + 1) % DEFUSE_CODE_LENGTH);
+    nextKeyMs = nowMs + (codePosition == 0 ? randomBetween(300, 25000) : randomBetween(150, 800));
+    inputs.keypadDigitAvailable = true;
+    inputs.keypadDigit = digit;
+  } else if (oneIn(5000)) {
+    inputs.keypadDigitAvailable = true;
+    inputs.keypadDigit = "0123456789*#"[random() % 12];
+  }
+
+  if (inputs.keypadDigitAvailable && inputs.keypadDigit >= '0' && inputs.keypadDigit <= '9') {
+    for (uint8_t i = 1; i < DEFUSE_CODE_LENGTH; ++i) {
+      typed[i - 1] = typed[i];
+    }
+    typed[DEFUSE_CODE_LENGTH - 1] = inputs.keypadDigit;
+  }
+}
+
+void Simulator::tick() {
+  // Mostly on cadence, sometimes late by up to three periods.
+  const uint32_t stepMs = config.tickMs + (oneIn(50) ? random() % (config.tickMs * 3) : 0);
+  nowMs += stepMs;
+  results.simulatedMs += stepMs;
+  advanceScript();
+  if (results.matches >= config.matches) {
+    return;
+  }
+
+  inputs.nowMs = nowMs;
+  simulateApi();
+  simulatePlayers();
+
+  FlameState before = engine.get_state();
+  GameOutputs outputs;
+  engine.game_tick(inputs, outputs);
+  if (tickObserver != nullptr) {
+    tickObserver(tickObserverContext, inputs, outputs);
+  }
+  if (outputs.clearIrConfirmation) {
+    irLatched = false;
+  }
+
+  TickView view;
+  view.state = engine.get_state();
+  view.matchStatus = engine.get_match_status();
+  view.bombTimerActive = engine.is_bomb_timer_active();
+  view.bombRemainingMs = engine.get_bomb_timer_remaining_ms();
+  view.bombDurationMs = engine.get_bomb_timer_duration_ms();
+  view.gameTimerValid = engine.is_game_timer_valid();
+  view.gameTimerRemainingMs = engine.get_game_timer_remaining_ms();
+  if (tickFault != nullptr) {
+    tickFault(tickFaultContext, before, outputs, view);
+  }
+  check(outputs, before, view);
+  ++results.ticks;
+}
+
+void Simulator::check(const GameOutputs &outputs, FlameState before, const TickView &view) {
+  const FlameState after = view.state;
+
+  if (outputs.stateChanged != (after != before) ||
+      (outputs.stateChanged && (outputs.previousState != before || outputs.newState != after))) {
+    fail(Invariant::OutputsMismatch, before, after);
+  }
+
+  if (view.bombTimerActive) {
+    if (view.bombRemainingMs > view.bombDurationMs) {
+      fail(Invariant::BombTimerBounds, before, after);
+    }
+    if (after != ARMED) {
+      fail(Invariant::BombTimerOutsideArmed, before, after);
+    }
+  }
+
+  if (after != before) {
+    if ((after == ARMING && before != ACTIVE) || (after == ARMED && before != ARMING)) {
+      fail(Invariant::ArmingPath, before, after);
+    }
+    if (after == ARMING) {
+      armingAtMs = nowMs;
+    }
+    if (after == ARMED) {
+      ++results.armings;
+      armedAtMs = nowMs;
+      armedDurationMs = view.bombDurationMs;
+      codePosition = 0;
+      nextKeyMs = nowMs + randomBetween(300, 25000);
+      // Some players keep holding after arming; that press must not defuse it.
+      if (holding && mode.defuse == game_mode::DefuseMethod::Hold && oneIn(4)) {
+        holdEndsMs = nowMs + mode.defuseHoldMs + randomBetween(0, 2000);
+      }
+    }
+    if (after == ERROR_STATE) {
+      ++results.errors;
+    }
+
+    if (before == ARMED) {
+      switch (after) {
+        case DETONATED:
+          ++results.detonations;
+          if (nowMs - armedAtMs < armedDurationMs) {
+            fail(Invariant::EarlyDetonation, before, after);
+          }
+          break;
+        case DEFUSED:
+        case ACTIVE: {
+          const bool neutral = mode.outcome == game_mode::DefuseOutcome::Neutral;
+          if (neutral != (after == ACTIVE)) {
+            fail(Invariant::ArmedExit, before, after);
+            break;
+          }
+          ++(neutral ? results.neutralizations : results.defuses);
+          if (!defuseEarned()) {
+            fail(Invariant::DefuseWithoutCode, before, after);
+          }
+          break;
+        }
+        case READY:
+          if (view.matchStatus == Running) {
+            fail(Invariant::ArmedExit, before, after);
+          }
+          break;
+        case ERROR_STATE:
+          if (!isWatchdogTripped(inputs)) {
+            fail(Invariant::ArmedExit, before, after);
+          }
+          break;
+        default:
+          fail(Invariant::ArmedExit, before, after);
+          break;
+      }
+    }
+  }
+
+  if (after == ARMED && before == ARMED && nowMs - armedAtMs >= armedDurationMs) {
+    fail(Invariant::BombTimerStalled, before, after);
+  }
+  if (after == ARMING && nowMs - armingAtMs > armingMaxMs + 8 * config.tickMs) {
+    fail(Invariant::ArmingStuck, before, after);
+  }
+  if (isPlayState(after) && isMatchOver(view.matchStatus)) {
+    fail(Invariant::PlayAfterMatchOver, before, after);
+  }
+
+  if (view.gameTimerValid) {
+    const uint32_t remainingMs = view.gameTimerRemainingMs;
+    if (gameTimerTracked && remainingMs > lastGameTimerMs) {
+      fail(Invariant::GameTimerRewound, before, after);
+    }
+    lastGameTimerMs = remainingMs;
+    gameTimerTracked = true;
+  }
+}
+
+// Whether this tick's defuse was earned: the configured code typed last, or, when the
+// mode defuses by holding, a press begun after arming and held for the full hold.
+bool Simulator::defuseEarned() const {
+  if (mode.defuse == game_mode::DefuseMethod::Hold) {
+    return holding && static_cast<int32_t>(holdStartedMs - armedAtMs) > 0 &&
+           nowMs - holdStartedMs >= mode.defuseHoldMs;
+  }
+  for (uint8_t i = 0; i < DEFUSE_CODE_LENGTH; ++i) {
+    if (typed[i] != defuseCode[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void Simulator::fail(Invariant invariant, FlameState from, FlameState to) {
+  if (results.violations == 0) {
+    results.first.invariant = invariant;
+    results.first.match = match;
+    results.first.nowMs = nowMs;
+    results.first.from = from;
+    results.first.to = to;
+  }
+  ++results.violations;
+  ++results.perInvariant[static_cast<size_t>(invariant)];
+}
+
+void writeReport(const Report &report, uint32_t busyUs, LineSink sink) {
+  char line[160];
+  const uint64_t ticksPerSecond = busyUs > 0 ? static_cast<uint64_t>(report.ticks) * 1000000ULL / busyUs : 0;
+  const uint64_t speedup = busyUs > 0 ? report.simulatedMs * 1000ULL / busyUs : 0;
+  snprintf(line, sizeof(line),
+           "[SOAK] matches=%lu ticks=%lu simulated=%llus wall=%lums -> %llu ticks/s (%llux realtime)",
+           static_cast<unsigned long>(report.matches), static_cast<unsigned long>(report.ticks),
+           static_cast<unsigned long long>(report.simulatedMs / 1000), static_cast<unsigned long>(busyUs / 1000),
+           static_cast<unsigned long long>(ticksPerSecond), static_cast<unsigned long long>(speedup));
+  sink(line);
+  snprintf(line, sizeof(line),
+           "[SOAK] armed=%lu defused=%lu detonated=%lu neutralized=%lu errors=%lu violations=%lu",
+           static_cast<unsigned long>(report.armings), static_cast<unsigned long>(report.defuses),
+           static_cast<unsigned long>(report.detonations), static_cast<unsigned long>(report.neutralizations),
+           static_cast<unsigned long>(report.errors), static_cast<unsigned long>(report.violations));
+  sink(line);
+  for (size_t i = 0; i < static_cast<size_t>(Invariant::Count); ++i) {
+    if (report.perInvariant[i] > 0) {
+      snprintf(line, sizeof(line), "[SOAK]   %-22s %lu", invariantName(static_cast<Invariant>(i)),
+               static_cast<unsigned long>(report.perInvariant[i]));
+      sink(line);
+    }
+  }
+  if (report.violations > 0) {
+    snprintf(line, sizeof(line), "[SOAK] first: %s in match %lu at %lums (%s -> %s)",
+             invariantName(report.first.invariant), static_cast<unsigned long>(report.first.match),
+             static_cast<unsigned long>(report.first.nowMs), game_state::flame_state_to_string(report.first.from),
+             game_state::flame_state_to_string(report.first.to));
+    sink(line);
+  }
+}
+}  // namespace soak_sim
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "core/game_mode.h"
+#include "core/game_state.h"
+
+// Accelerated-time soak test of the game logic. A Simulator owns a private GameEngine
+// and drives it from a virtual clock through scripted match timelines (WaitingOnStart
+// -> Countdown -> Running -> Completed/Cancelled, with API outages and WiFi drops) and
+// randomized players pressing buttons, sending IR and typing defuse codes or holding
+// to defuse, under the game mode compiled from Config::rules. Every tick
+// is checked against the invariants below. Only game_state is covered: the effects,
+// UI and network code that consume GameOutputs on the prop are not simulated. Nothing
+// here touches hardware or real time, so the same code soaks thousands of matches on a
+// host or runs in slices on the prop.
+namespace soak_sim {
+struct Config {
+  uint32_t seed = 1;
+  uint32_t matches = 100;
+  uint32_t tickMs = 10;
+  uint32_t minRunningMs = 60000;
+  uint32_t maxRunningMs = 600000;
+  uint32_t startMs = 1000;  // Clock stamp of the first tick; set it near UINT32_MAX to cross the wrap.
+  const char *rules = "";   // Game mode rules string (see game_mode.h); "" is the built-in mode.
+};
+
+enum class Invariant : uint8_t {
+  BombTimerBounds,        // Bomb timer remaining exceeds its duration (i.e. went "negative").
+  BombTimerOutsideArmed,  // Bomb timer active in a state other than ARMED.
+  BombTimerStalled,       // Still ARMED after the bomb duration ran out.
+  EarlyDetonation,        // DETONATED before the bomb duration elapsed.
+  ArmedExit,              // Left ARMED other than to DEFUSED/DETONATED/READY (ACTIVE for a neutral
+                          // outcome), or via the API watchdog.
+  DefuseWithoutCode,      // Defused without the configured code being typed, or without a fresh
+                          // press held for the mode's defuse hold.
+  ArmingPath,             // ARMING not entered from ACTIVE, or ARMED not from ARMING.
+  ArmingStuck,            // ARMING outlasted every step of the mode's arming sequence.
+  PlayAfterMatchOver,     // ACTIVE/ARMING/ARMED while the match is over.
+  OutputsMismatch,        // GameOutputs disagree with the engine's state change.
+  GameTimerRewound,       // Local game timer went up between API syncs.
+  Count
+};
+
+const char *invariantName(Invariant invariant);
+
+struct Violation {
+  Invariant invariant = Invariant::Count;
+  uint32_t match = 0;
+  uint32_t nowMs = 0;
+  FlameState from = ON;
+  FlameState to = ON;
+};
+
+// The engine state the invariant checks read after each tick.
+struct TickView {
+  FlameState state = ON;
+  MatchStatus matchStatus = WaitingOnStart;
+  bool bombTimerActive = false;
+  uint32_t bombRemainingMs = 0;
+  uint32_t bombDurationMs = 0;
+  bool gameTimerValid = false;
+  uint32_t gameTimerRemainingMs = 0;
+};
+
+struct Report {
+  uint32_t matches = 0;  // Completed match timelines.
+  uint32_t ticks = 0;
+  uint64_t simulatedMs = 0;
+  uint32_t armings = 0;
+  uint32_t defuses = 0;
+  uint32_t detonations = 0;
+  uint32_t neutralizations = 0;  // ARMED back to ACTIVE under a neutral outcome.
+  uint32_t errors = 0;
+  uint32_t violations = 0;
+  uint32_t perInvariant[static_cast<size_t>(Invariant::Count)] = {};
+  Violation first;  // Valid when violations > 0.
+};
+
+class Simulator {
+ public:
+  // Sees every simulated tick's inputs and outputs, e.g. to record the run.
+  using TickObserver = void (*)(void *context, const GameInputs &inputs, const GameOutputs &outputs);
+
+  // Runs between a tick and its checks and may rewrite what they see: the state before
+  // the tick, its outputs and the engine after it. Tests use it to break one tick on
+  // purpose and confirm that the matching invariant fires; the engine is untouched.
+  using TickFault = void (*)(void *context, FlameState &before, GameOutputs &outputs, TickView &after);
+
+  Simulator() = default;
+  Simulator(const Simulator &) = delete;
+  Simulator &operator=(const Simulator &) = delete;
+
+  // Starts a new run on a fresh engine and clears the report. Returns false, with no
+  // matches left to step, when config.rules does not compile; `error` (when given)
+  // then points at game_mode::compile()'s description.
+  bool reset(const Config &config, const char **error = nullptr);
+
+  // Simulates up to `maxTicks` ticks. Returns false once every match has been played.
+  bool step(uint32_t maxTicks);
+
+  const Report &report() const { return results; }
+
+  void observeTicks(TickObserver observer, void *context) {
+    tickObserver = observer;
+    tickObserverContext = context;
+  }
+
+  void injectFaults(TickFault fault, void *context) {
+    tickFault = fault;
+    tickFaultContext = context;
+  }
+
+ private:
+  enum class Phase : uint8_t { WaitingOnStart, Countdown, Running, FinalData, Over };
+
+  uint32_t random();
+  uint32_t randomBetween(uint32_t low, uint32_t high);
+  bool oneIn(uint32_t n);
+
+  void startMatch();
+  void advanceScript();
+  void simulateApi();
+  void simulatePlayers();
+  void tick();
+  void check(const GameOutputs &outputs, FlameState before, const TickView &view);
+  void fail(Invariant invariant, FlameState from, FlameState to);
+  bool defuseEarned() const;
+
+  Config config;
+  Report results;
+  TickObserver tickObserver = nullptr;
+  void *tickObserverContext = nullptr;
+  TickFault tickFault = nullptr;
+  void *tickFaultContext = nullptr;
+  game_state::GameEngine engine;
+  game_mode::GameMode mode;
+  GameInputs inputs;
+  uint32_t rngState = 1;
+  uint32_t nowMs = 0;
+  uint32_t match = 0;
+
+  // Match script.
+  Phase phase = Phase::Over;
+  uint32_t phaseEndsMs = 0;
+  MatchStatus remoteStatus = WaitingOnStart;
+  MatchStatus finalStatus = Completed;
+  uint32_t bombDurationMs = DEFAULT_BOMB_DURATION_MS;
+  char defuseCode[DEFUSE_CODE_LENGTH + 1] = {0};
+
+  // Backend link.
+  bool wifiConnected = true;
+  bool apiOutage = false;
+  uint32_t linkRestoresMs = 0;
+  bool apiResponseReceived = false;
+  uint32_t nextApiMs = 0;
+  uint32_t lastSuccessfulApiMs = 0;
+
+  // Players. The arming press spans every step up to the mode's last hold.
+  uint32_t armPressMaxMs = BUTTON_HOLD_MS;
+  uint32_t irWindowMs = IR_CONFIRM_WINDOW_MS;
+  bool holding = false;
+  uint32_t holdStartedMs = 0;
+  uint32_t holdEndsMs = 0;
+  uint32_t irSendMs = 0;
+  bool irScheduled = false;
+  bool irLatched = false;
+  uint32_t nextKeyMs = 0;
+  uint8_t codePosition = 0;
+  bool typingCorrectCode = false;
+  char typed[DEFUSE_CODE_LENGTH] = {0};  // Last digits typed, oldest first.
+
+  // Invariant bookkeeping.
+  uint32_t armedAtMs = 0;
+  uint32_t armedDurationMs = 0;
+  uint32_t armingAtMs = 0;
+  uint32_t armingMaxMs = BUTTON_HOLD_MS + IR_CONFIRM_WINDOW_MS;
+  bool gameTimerTracked = false;
+  uint32_t lastGameTimerMs = 0;
+};
+
+// Receives the report one text line at a time (no trailing newline).
+using LineSink = void (*)(const char *line);
+
+// Formats `report` into lines for `sink`, e.g. Serial on the prop or stdout on a host;
+// `busyUs` is the wall time spent simulating, for throughput.
+void writeReport(const Report &report, uint32_t busyUs, LineSink sink);
+}  // namespace soak_sim
@@ -0,0 +1,199 @@
+#include "core/timer_wheel.h"
+
+namespace {
+bool isBefore(uint32_t a, uint32_t b) { return static_cast<int32_t>(a - b) < 0; }
+
+// Slots from `from` (inclusive) to the first set bit of `mask`, walking upwards and
+// wrapping; 64 when the mask is empty.
+uint32_t slotsToNextSet(uint64_t mask, uint32_t from) {
+  const uint64_t rotated = from == 0 ? mask : (mask >> from) | (mask << (64 - from));
+  return rotated == 0 ? 64 : static_cast<uint32_t>(__builtin_ctzll(rotated));
+}
+}  // namespace
+
+constexpr size_t TimerWheel::kMaxTimers;
+constexpr size_t TimerWheel::kSlots;
+
+TimerWheel::TimerWheel() {
+  for (size_t level = 0; level < kLevels; ++level) {
+    for (size_t slot = 0; slot < kSlots; ++slot) {
+      heads[level][slot] = kNone;
+    }
+  }
+}
+
+TimerHandle TimerWheel::schedule(uint32_t deadlineMs, Callback callback, void *context) {
+  TimerHandle handle;
+  if (callback == nullptr) {
+    return handle;
+  }
+
+  for (size_t i = 0; i < kMaxTimers; ++i) {
+    Node &node = nodes[i];
+    if (node.active) {
+      continue;
+    }
+
+    node.deadlineMs = deadlineMs;
+    node.callback = callback;
+    node.context = context;
+    node.active = true;
+    ++node.generation;
+    ++pending;
+    insert(static_cast<int8_t>(i), currentMs + 1);
+
+    handle.index = static_cast<int8_t>(i);
+    handle.generation = node.generation;
+    return handle;
+  }
+  return handle;
+}
+
+bool TimerWheel::cancel(TimerHandle &handle) {
+  const bool wasPending = isPending(handle);
+  if (wasPending) {
+    unlink(handle.index);
+    nodes[handle.index].active = false;
+    --pending;
+  }
+  handle = TimerHandle{};
+  return wasPending;
+}
+
+bool TimerWheel::isPending(const TimerHandle &handle) const {
+  if (handle.index < 0 || static_cast<size_t>(handle.index) >= kMaxTimers) {
+    return false;
+  }
+  const Node &node = nodes[handle.index];
+  return node.active && node.generation == handle.generation;
+}
+
+void TimerWheel::advance(uint32_t nowMs) {
+  // An empty wheel has nothing to fire in between, so it resynchronises directly. This
+  // also covers a wheel that has not been advanced for more than half the 32-bit range.
+  if (pending == 0) {
+    currentMs = nowMs;
+    return;
+  }
+
+  while (static_cast<int32_t>(nowMs - currentMs) > 0) {
+    // Milliseconds in between have no slot to fire or cascade: skip them.
+    currentMs = nextEventMs(nowMs);
+    // Re-file the coarser levels when their slot boundary is reached, top level first
+    // so timers cascading down two levels land before level 0 fires.
+    if ((currentMs & ((1u << (2 * kSlotBits)) - 1)) == 0) {
+      cascade(2);
+    }
+    if ((currentMs & kSlotMask) == 0) {
+      cascade(1);
+    }
+    fireSlot(currentMs & kSlotMask);
+    if (pending == 0) {
+      currentMs = nowMs;
+      return;
+    }
+  }
+}
+
+uint32_t TimerWheel::nextEventMs(uint32_t limitMs) const {
+  uint32_t step = limitMs - currentMs;
+  const uint32_t next = currentMs + 1;
+  const uint32_t fireStep = slotsToNextSet(occupied[0], next & kSlotMask) + 1;
+  if (fireStep < step) {
+    step = fireStep;
+  }
+  // Level L cascades on multiples of 64^L; the first boundary after currentMs belongs
+  // to the slot after the current one.
+  for (size_t level = 1; level < kLevels; ++level) {
+    const uint32_t shift = static_cast<uint32_t>(level * kSlotBits);
+    const uint32_t slotsAhead = slotsToNextSet(occupied[level], ((currentMs >> shift) + 1) & kSlotMask) + 1;
+    if (slotsAhead > kSlots) {
+      continue;
+    }
+    const uint32_t boundaryMs = ((currentMs >> shift) + slotsAhead) << shift;
+    const uint32_t cascadeStep = boundaryMs - currentMs;
+    if (cascadeStep < step) {
+      step = cascadeStep;
+    }
+  }
+  return currentMs + step;
+}
+
+// `earliestMs` is the first millisecond whose slot has not fired yet: the next one for
+// new timers, the current one while advance() cascades before firing it.
+void TimerWheel::insert(int8_t index, uint32_t earliestMs) {
+  Node &node = nodes[index];
+  uint32_t deadline = node.deadlineMs;
+  if (isBefore(deadline, earliestMs)) {
+    deadline = earliestMs;  // Overdue: fire as soon as possible.
+  }
+
+  const uint32_t delta = deadline - currentMs;
+  size_t level = 0;
+  uint32_t slot = 0;
+  if (delta < kSlots) {
+    slot = deadline & kSlotMask;
+  } else if (delta < (1u << (2 * kSlotBits))) {
+    level = 1;
+    slot = (deadline >> kSlotBits) & kSlotMask;
+  } else {
+    // Beyond the wheel's horizon the timer waits in the farthest top-level slot and is
+    // re-filed with an accurate slot when that slot cascades.
+    level = 2;
+    const uint32_t horizon = (1u << (3 * kSlotBits)) - 1;
+    const uint32_t filed = delta <= horizon ? deadline : currentMs + horizon;
+    slot = (filed >> (2 * kSlotBits)) & kSlotMask;
+  }
+
+  node.level = static_cast<uint8_t>(level);
+  node.slot = static_cast<uint8_t>(slot);
+  node.prev = kNone;
+  node.next = heads[level][slot];
+  if (node.next != kNone) {
+    nodes[node.next].prev = index;
+  }
+  heads[level][slot] = index;
+  occupied[level] |= 1ull << slot;
+}
+
+void TimerWheel::unlink(int8_t index) {
+  Node &node = nodes[index];
+  if (node.prev != kNone) {
+    nodes[node.prev].next = node.next;
+  } else {
+    heads[node.level][node.slot] = node.next;
+    if (node.next == kNone) {
+      occupied[node.level] &= ~(1ull << node.slot);
+    }
+  }
+  if (node.next != kNone) {
+    nodes[node.next].prev = node.prev;
+  }
+  node.next = kNone;
+  node.prev = kNone;
+}
+
+void TimerWheel::cascade(size_t level) {
+  const uint32_t slot = (currentMs >> (level * kSlotBits)) & kSlotMask;
+  int8_t index = heads[level][slot];
+  heads[level][slot] = kNone;
+  occupied[level] &= ~(1ull << slot);
+  while (index != kNone) {
+    const int8_t next = nodes[index].next;
+    insert(index, currentMs);
+    index = next;
+  }
+}
+
+void TimerWheel::fireSlot(size_t slot) {
+  // Detach one node at a time so callbacks can freely schedule or cancel timers,
+  // including re-using the node that just fired.
+  while (heads[0][slot] != kNone) {
+    const int8_t index = heads[0][slot];
+    Node &node = nodes[index];
+    unlink(index);
+    node.active = false;
+    --pending;
+    node.callback(node.context);
+  }
+}
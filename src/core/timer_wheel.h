@@ -0,0 +1,76 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Handle to a scheduled one-shot timer. The generation guards against cancelling a
+// slot that has since fired and been reused by another timer.
+struct TimerHandle {
+  int8_t index = -1;
+  uint8_t generation = 0;
+};
+
+// Hierarchical timing wheel for one-shot millisecond timers. Three levels of 64 slots
+// cover 64 ms, 4 s and 262 s at 1 ms resolution; longer deadlines are parked in the
+// top level and re-filed when it cascades. schedule(), cancel() and firing a timer are
+// O(1). advance() finds the next occupied slot of each level from a per-level bitmap
+// and jumps straight to it, so its cost depends on the timers fired and re-filed, not
+// on the elapsed time. Timer nodes come from a fixed pool, so nothing allocates.
+class TimerWheel {
+ public:
+  using Callback = void (*)(void *context);
+
+  static constexpr size_t kMaxTimers = 16;
+
+  TimerWheel();
+
+  // Schedules `callback(context)` to fire once from the first advance() at or after
+  // `deadlineMs`. Deadlines already in the past fire on the next advance(). Returns an
+  // invalid handle when the pool is exhausted.
+  TimerHandle schedule(uint32_t deadlineMs, Callback callback, void *context = nullptr);
+
+  // Cancels a pending timer and invalidates the handle. Returns false if the timer
+  // already fired or the handle was never valid.
+  bool cancel(TimerHandle &handle);
+
+  bool isPending(const TimerHandle &handle) const;
+
+  // Fires every timer whose deadline is at or before `nowMs`, in deadline order.
+  // Callbacks may schedule or cancel timers on this wheel.
+  void advance(uint32_t nowMs);
+
+  size_t pendingCount() const { return pending; }
+
+ private:
+  static constexpr uint8_t kSlotBits = 6;
+  static constexpr size_t kSlots = 1u << kSlotBits;
+  static constexpr uint32_t kSlotMask = kSlots - 1;
+  static constexpr size_t kLevels = 3;
+  static constexpr int8_t kNone = -1;
+
+  struct Node {
+    uint32_t deadlineMs = 0;
+    Callback callback = nullptr;
+    void *context = nullptr;
+    int8_t next = kNone;
+    int8_t prev = kNone;
+    uint8_t level = 0;
+    uint8_t slot = 0;
+    uint8_t generation = 0;
+    bool active = false;
+  };
+
+  void insert(int8_t index, uint32_t earliestMs);
+  void unlink(int8_t index);
+  void cascade(size_t level);
+  void fireSlot(size_t slot);
+  // The next millisecond after currentMs at which a slot fires or cascades, capped at
+  // `limitMs`.
+  uint32_t nextEventMs(uint32_t limitMs) const;
+
+  Node nodes[kMaxTimers];
+  int8_t heads[kLevels][kSlots];
+  uint64_t occupied[kLevels] = {0, 0, 0};  // Bit per slot with a non-empty list.
+  uint32_t currentMs = 0;
+  size_t pending = 0;
+};
@@ -1,8 +1,14 @@
 #include "effects.h"
 
 #include <Adafruit_NeoPixel.h>
+#include <atomic>
 #include <cmath>
 
+#include "bomb_deadline.h"
+#include "core/clock.h"
+#include "core/coroutine.h"
+#include "core/event_queue.h"
+#include "core/timer_wheel.h"
 #include "game_config.h"
 #include "state_machine.h"
 
@@ -12,6 +18,8 @@ Adafruit_NeoPixel strip(LED_COUNT, LED_PIN, NEO_GRB + NEO_KHZ800);
 float armingProgress01 = 0.0f;
 FlameState lastRenderedState = ON;
 uint32_t lastFrameMs = 0;
+uint32_t frameIntervalMs = EFFECTS_FRAME_INTERVAL_MS;
+bool frameRequested = false;
 uint32_t bootFlashStartMs = 0;
 bool bootFlashActive = false;
 uint32_t defusedStartMs = 0;
@@ -33,20 +41,46 @@ struct ToneState {
 
 ToneState toneState;
 
-struct DoubleBeepState {
-  bool active = false;
-  uint8_t step = 0;
-  uint32_t nextBeepMs = 0;
+// Triggers from the on*() entry points, replayed at the start of update().
+enum class Trigger : uint8_t {
+  Boot,
+  StateChanged,
+  KeypadKey,
+  WrongCode,
+  ArmingConfirmNeeded,
+  ArmingConfirmed,
 };
 
-DoubleBeepState wrongCodeBeep;
+struct PendingTrigger {
+  Trigger trigger;
+  FlameState oldState;
+  FlameState newState;
+};
 
-struct ChimeState {
-  bool active = false;
-  uint8_t step = 0;
-  uint32_t nextBeepMs = 0;
+EventQueue<PendingTrigger, 16> pendingTriggers;
+// Triggers lost because the queue was full: their sound or flash never plays.
+std::atomic<uint32_t> droppedTriggers{0};
+
+void queueTrigger(Trigger trigger, FlameState oldState = ON, FlameState newState = ON) {
+  if (!pendingTriggers.push({trigger, oldState, newState})) {
+    droppedTriggers.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+// One-shot effect timers, advanced at the top of effects::update(). Multi-note
+// sequences re-arm their own timer from the callback for the next note.
+TimerWheel timers;
+TimerHandle defusedEndTimer;
+TimerHandle detonatedEndTimer;
+
+// Multi-note sequences are coroutines hosted on the wheel: each CO_SLEEP_MS re-arms a
+// one-shot timer that resumes the sequence.
+struct SequenceFrame : Coroutine {
+  TimerHandle timer;
 };
-ChimeState defusedChime;
+
+SequenceFrame wrongCodeBeep;
+SequenceFrame defusedChime;
 
 uint32_t colorToPixel(const RgbColor &c, float scale = 1.0f) {
   scale = constrain(scale, 0.0f, 1.0f);
@@ -85,13 +119,13 @@ uint16_t mapRowColToIndex(uint8_t row, uint8_t col) {
 }
 
 void updateTone() {
-  const uint32_t nowMs = millis();
+  const uint32_t nowMs = sys_clock::frameMs();
 
   if (!toneState.active) {
     return;
   }
 
-  if (nowMs >= toneState.endMs) {
+  if (sys_clock::reached(nowMs, toneState.endMs)) {
     ledcWriteTone(AUDIO_CHANNEL, 0);
     ledcWrite(AUDIO_CHANNEL, 0);
     //digitalWrite(AMP_ENABLE_PIN, HIGH);
@@ -167,12 +201,7 @@ void renderDefused(uint32_t now) {
     fillAll(COLOR_DEFUSED, 0.0f);
     return;
   }
-  const uint32_t elapsed = now - defusedStartMs;
-  if (elapsed >= DEFUSED_EFFECT_DURATION_MS) {
-    defusedActive = false;
-    fillAll(COLOR_DEFUSED, 0.0f);
-    return;
-  }
+  const uint32_t elapsed = min<uint32_t>(now - defusedStartMs, DEFUSED_EFFECT_DURATION_MS);
   const float t = 1.0f - (static_cast<float>(elapsed) / static_cast<float>(DEFUSED_EFFECT_DURATION_MS));
   fillAll(COLOR_DEFUSED, t);
 }
@@ -182,12 +211,6 @@ void renderDetonated(uint32_t now) {
     fillAll(COLOR_DETONATED, 0.0f);
     return;
   }
-  const uint32_t elapsed = now - detonatedStartMs;
-  if (elapsed >= DETONATED_EFFECT_DURATION_MS) {
-    detonatedActive = false;
-    fillAll(COLOR_DETONATED, 0.0f);
-    return;
-  }
   const bool on = ((now / 120) % 2) == 0;
   fillAll(COLOR_DETONATED, on ? 1.0f : 0.0f);
 }
@@ -198,13 +221,13 @@ void renderError(uint32_t now) {
   fillAll(COLOR_ERROR, wave);
 }
 
-void handleArmedBeeps(uint32_t now, FlameState state) {
-  if (state != ARMED || !isBombTimerActive()) {
+void handleArmedBeeps(uint32_t now, const GameFrame &frame) {
+  if (frame.state != ARMED || !frame.bombTimerActive) {
     lastArmedBeepMs = now;
     return;
   }
 
-  const uint32_t remaining = getBombTimerRemainingMs();
+  const uint32_t remaining = frame.bombTimerRemainingMs;
   if (remaining == 0) {
     return;
   }
@@ -222,7 +245,7 @@ void handleArmedBeeps(uint32_t now, FlameState state) {
     return;
   }
 
-  if (toneState.active && now < toneState.endMs) {
+  if (toneState.active && !sys_clock::reached(now, toneState.endMs)) {
     return;
   }
 
@@ -235,62 +258,122 @@ void handleArmedBeeps(uint32_t now, FlameState state) {
   effects::playBeep(1500, COUNTDOWN_BEEP_DURATION_MS, COUNTDOWN_BEEP_VOLUME);
 }
 
-void handleWrongCodeBeep(uint32_t now) {
-  if (!wrongCodeBeep.active) {
-    return;
-  }
+uint32_t msUntilToneEnd() {
+  const uint32_t nowMs = sys_clock::frameMs();
+  return (toneState.active && !sys_clock::reached(nowMs, toneState.endMs)) ? toneState.endMs - nowMs : 0;
+}
 
-  if (toneState.active && now < toneState.endMs) {
-    return;
+template <CoStatus (*Body)(SequenceFrame &, uint32_t)>
+void resumeSequence(void *context) {
+  SequenceFrame &frame = *static_cast<SequenceFrame *>(context);
+  const uint32_t nowMs = sys_clock::frameMs();
+  if (Body(frame, nowMs) == CoStatus::Sleeping) {
+    frame.timer = timers.schedule(nowMs + frame.sleepMs, resumeSequence<Body>, &frame);
   }
+}
 
-  if (now < wrongCodeBeep.nextBeepMs) {
-    return;
-  }
+template <CoStatus (*Body)(SequenceFrame &, uint32_t)>
+void startSequence(SequenceFrame &frame) {
+  static_assert(sizeof(SequenceFrame) <= kMaxCoroutineFrameBytes, "Sequence frame exceeds kMaxCoroutineFrameBytes");
+  timers.cancel(frame.timer);
+  frame.restart();
+  resumeSequence<Body>(&frame);
+}
 
-  if (wrongCodeBeep.step == 2) {
-    // Second beep: repeat the low growl.
-    const uint16_t sawFrequencyHz = WRONG_CODE_TONE_FREQ_HZ;
-    const uint16_t sawDurationMs = WRONG_CODE_TONE_MS;
-    const uint8_t sawVolume = 255;
-    effects::playBeep(sawFrequencyHz, sawDurationMs, sawVolume, /*sawtooth=*/true);
-  }
+// Two low sawtooth growls. Like every note below, the second one waits for whatever
+// tone is still playing when it comes due.
+CoStatus runWrongCodeBeep(SequenceFrame &co, uint32_t) {
+  CO_BEGIN(co);
+  effects::playBeep(WRONG_CODE_TONE_FREQ_HZ, WRONG_CODE_TONE_MS, 255, /*sawtooth=*/true);
+  CO_SLEEP_MS(co, msUntilToneEnd() + WRONG_CODE_GAP_MS);
+  while (msUntilToneEnd() > 0) {
+    CO_SLEEP_MS(co, msUntilToneEnd());
+  }
+  effects::playBeep(WRONG_CODE_TONE_FREQ_HZ, WRONG_CODE_TONE_MS, 255, /*sawtooth=*/true);
+  CO_END(co);
+}
 
-  wrongCodeBeep.active = false;
-  wrongCodeBeep.step = 0;
+// Triumphant three-note chime, 50 ms apart.
+CoStatus runDefusedChime(SequenceFrame &co, uint32_t) {
+  CO_BEGIN(co);
+  effects::playBeep(1500, 100, 255);
+  CO_SLEEP_MS(co, msUntilToneEnd() + 50);
+  while (msUntilToneEnd() > 0) {
+    CO_SLEEP_MS(co, msUntilToneEnd());
+  }
+  effects::playBeep(2000, 100, 255);
+  CO_SLEEP_MS(co, msUntilToneEnd() + 50);
+  while (msUntilToneEnd() > 0) {
+    CO_SLEEP_MS(co, msUntilToneEnd());
+  }
+  effects::playBeep(2500, 250, 255);
+  CO_END(co);
 }
 
-void handleDefusedChime(uint32_t now) {
-  if (!defusedChime.active) {
-    return;
-  }
+void startBootEffect() {
+  bootFlashStartMs = sys_clock::frameMs();
+  bootFlashActive = true;
+  effects::playBeep(1500, 120, 160);
+}
 
-  if (toneState.active && now < toneState.endMs) {
-    return;
-  }
+void startStateEffect(FlameState oldState, FlameState newState) {
+  lastRenderedState = newState;
 
-  if (now < defusedChime.nextBeepMs) {
-    return;
+  if (newState == DEFUSED) {
+    defusedActive = true;
+    defusedStartMs = sys_clock::frameMs();
+    timers.cancel(defusedEndTimer);
+    defusedEndTimer =
+        timers.schedule(defusedStartMs + DEFUSED_EFFECT_DURATION_MS, [](void *) { defusedActive = false; });
+    startSequence<runDefusedChime>(defusedChime);
+  } else if (newState == DETONATED) {
+    detonatedActive = true;
+    detonatedStartMs = sys_clock::frameMs();
+    timers.cancel(detonatedEndTimer);
+    detonatedEndTimer =
+        timers.schedule(detonatedStartMs + DETONATED_EFFECT_DURATION_MS, [](void *) { detonatedActive = false; });
+    effects::playBeep(900, DETONATED_EFFECT_DURATION_MS / 2, 255);
+  } else if (newState == ERROR_STATE) {
+    effects::playBeep(500, 400);
+  } else if (newState == READY && oldState == ON) {
+    bootFlashStartMs = sys_clock::frameMs();
+    bootFlashActive = true;
   }
+}
 
-  switch (defusedChime.step) {
-    case 2:
-      // Play the second note of the chime
-      effects::playBeep(2000, 100, 255);
-      defusedChime.step = 3;
-      defusedChime.nextBeepMs = toneState.endMs + 50;
-      break;
-    case 3:
-      // Play the final, higher note
-      effects::playBeep(2500, 250, 255);
-      defusedChime.step = 4;
-      defusedChime.nextBeepMs = toneState.endMs;
-      break;
-    case 4:
-      // Chime is finished
-      defusedChime.active = false;
-      defusedChime.step = 0;
-      break;
+void startKeypadKeyEffect() { effects::playBeep(1200, 140, 255); }
+
+void startWrongCodeEffect() {
+  startSequence<runWrongCodeBeep>(wrongCodeBeep);
+}
+
+void startArmingConfirmNeededEffect() { effects::playBeep(IR_CONFIRM_PROMPT_BEEP_FREQ, IR_CONFIRM_PROMPT_BEEP_MS, 200); }
+
+void startArmingConfirmedEffect() { effects::playBeep(2200, 200); }
+
+void applyPendingTriggers() {
+  PendingTrigger pending;
+  while (pendingTriggers.pop(pending)) {
+    switch (pending.trigger) {
+      case Trigger::Boot:
+        startBootEffect();
+        break;
+      case Trigger::StateChanged:
+        startStateEffect(pending.oldState, pending.newState);
+        break;
+      case Trigger::KeypadKey:
+        startKeypadKeyEffect();
+        break;
+      case Trigger::WrongCode:
+        startWrongCodeEffect();
+        break;
+      case Trigger::ArmingConfirmNeeded:
+        startArmingConfirmNeededEffect();
+        break;
+      case Trigger::ArmingConfirmed:
+        startArmingConfirmedEffect();
+        break;
+    }
   }
 }
 }  // namespace
@@ -308,20 +391,26 @@ void init() {
   ledcAttachPin(AUDIO_PIN, AUDIO_CHANNEL);
   ledcWriteTone(AUDIO_CHANNEL, 0);
   ledcWrite(AUDIO_CHANNEL, 0);
+
+#ifdef APP_DEBUG
+  Serial.printf("[FX] sequence coroutine frame: %uB\n", static_cast<unsigned>(sizeof(SequenceFrame)));
+#endif
 }
 
-void update(uint32_t now) {
+void update(uint32_t now, const GameFrame &frame) {
+  applyPendingTriggers();
+  armingProgress01 = constrain(frame.armingProgress01, 0.0f, 1.0f);
   updateTone();
-  handleWrongCodeBeep(now);
-  handleDefusedChime(now);
-  handleArmedBeeps(now, getState());
+  timers.advance(now);
+  handleArmedBeeps(now, frame);
 
-  if (now - lastFrameMs < EFFECTS_FRAME_INTERVAL_MS) {
+  if (!frameRequested && now - lastFrameMs < frameIntervalMs) {
     return;
   }
+  frameRequested = false;
   lastFrameMs = now;
 
-  const FlameState state = getState();
+  const FlameState state = frame.state;
   switch (state) {
     case ON:
       if (bootFlashActive) {
@@ -355,60 +444,28 @@ void update(uint32_t now) {
 
   lastRenderedState = state;
   strip.show();
+  if (state == DETONATED) {
+    bomb_deadline::noteEffectFrame();
+  }
 }
 
-void onBoot() {
-  bootFlashStartMs = millis();
-  bootFlashActive = true;
-  playBeep(1500, 120, 160);
-}
+void onBoot() { queueTrigger(Trigger::Boot); }
 
 void onStateChanged(FlameState oldState, FlameState newState) {
-  lastRenderedState = newState;
-  if (newState != ARMING) {
-    armingProgress01 = 0.0f;
-  }
-
-  if (newState == DEFUSED) {
-    defusedActive = true;
-    defusedStartMs = millis();
-    // Start the triumphant defuse chime
-    defusedChime.active = true;
-    defusedChime.step = 1;
-    playBeep(1500, 100, 255); // First note
-    defusedChime.nextBeepMs = toneState.endMs + 50;
-    defusedChime.step = 2;
-  } else if (newState == DETONATED) {
-    detonatedActive = true;
-    detonatedStartMs = millis();
-    playBeep(900, DETONATED_EFFECT_DURATION_MS / 2, 255);
-  } else if (newState == ERROR_STATE) {
-    playBeep(500, 400);
-  } else if (newState == READY && oldState == ON) {
-    bootFlashStartMs = millis();
-    bootFlashActive = true;
-  }
+  queueTrigger(Trigger::StateChanged, oldState, newState);
 }
 
-void onKeypadKey() { playBeep(1200, 140, 255); }
+void onKeypadKey() { queueTrigger(Trigger::KeypadKey); }
 
-void onWrongCode() {
-  wrongCodeBeep.active = true;
-  wrongCodeBeep.step = 1;
-  playBeep(WRONG_CODE_TONE_FREQ_HZ, WRONG_CODE_TONE_MS, 255, /*sawtooth=*/true);
-  wrongCodeBeep.step = 2;
-  wrongCodeBeep.nextBeepMs = toneState.endMs + WRONG_CODE_GAP_MS;
-}
+void onWrongCode() { queueTrigger(Trigger::WrongCode); }
 
-void onArmingConfirmNeeded() { playBeep(IR_CONFIRM_PROMPT_BEEP_FREQ, IR_CONFIRM_PROMPT_BEEP_MS, 200); }
+void onArmingConfirmNeeded() { queueTrigger(Trigger::ArmingConfirmNeeded); }
 
-void onArmingConfirmed() { playBeep(2200, 200); }
+void onArmingConfirmed() { queueTrigger(Trigger::ArmingConfirmed); }
 
-void setArmingProgress(float progress01) { armingProgress01 = constrain(progress01, 0.0f, 1.0f); }
+void requestFrame() { frameRequested = true; }
 
-uint16_t getWrongCodeBeepDurationMs() {
-  return (WRONG_CODE_TONE_MS * 2) + WRONG_CODE_GAP_MS;
-}
+void setFrameIntervalMs(uint32_t intervalMs) { frameIntervalMs = intervalMs; }
 
 void playBeep(uint16_t frequencyHz, uint16_t durationMs, uint8_t volume, bool sawtooth) {
   if (frequencyHz == 0 || durationMs == 0) {
@@ -416,9 +473,9 @@ void playBeep(uint16_t frequencyHz, uint16_t durationMs, uint8_t volume, bool sa
   }
   toneState.active = true;
   toneState.frequency = frequencyHz;
-  toneState.endMs = millis() + durationMs;
+  toneState.startMs = sys_clock::frameMs();
+  toneState.endMs = toneState.startMs + durationMs;
   toneState.volume = constrain(volume, static_cast<uint8_t>(0), static_cast<uint8_t>(255));
-  toneState.startMs = millis();
   toneState.sawtooth = sawtooth;
   toneState.periodMs = (frequencyHz == 0) ? 0 : static_cast<uint16_t>(max<uint32_t>(1, 1000UL / frequencyHz));
 
@@ -433,4 +490,11 @@ void playBeep(uint16_t frequencyHz, uint16_t durationMs, uint8_t volume, bool sa
   ledcWrite(AUDIO_CHANNEL, toneState.volume);
   //digitalWrite(AMP_ENABLE_PIN, LOW);
 }
+uint32_t getDroppedTriggerCount() { return droppedTriggers.load(std::memory_order_relaxed); }
+
+void dumpStats() {
+#ifdef APP_DEBUG
+  Serial.printf("[FX] dropped triggers=%lu\n", static_cast<unsigned long>(getDroppedTriggerCount()));
+#endif
+}
 }  // namespace effects
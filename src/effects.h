@@ -5,7 +5,10 @@
 
 namespace effects {
 void init();
-void update(uint32_t now);
+// Advances tones and timers and renders the LEDs for `frame`. The on*() triggers below
+// are queued and only take effect here, so they may be called from the game task while
+// update() runs in another.
+void update(uint32_t now, const GameFrame &frame);
 
 // Optional helpers triggered by events.
 void onBoot();                 // boot beep + flash
@@ -14,8 +17,13 @@ void onKeypadKey();            // short click beep
 void onWrongCode();            // double beep for incorrect code
 void onArmingConfirmNeeded();  // short beep when IR confirmation is requested
 void onArmingConfirmed();      // IR-confirmed arm beep
-void setArmingProgress(float progress01);
-uint16_t getWrongCodeBeepDurationMs();
+void requestFrame();           // render LEDs on the next update() regardless of frame cadence
+void setFrameIntervalMs(uint32_t intervalMs);  // LED frame cadence; defaults to EFFECTS_FRAME_INTERVAL_MS
+
+// Triggers discarded because the queue to update() was full.
+uint32_t getDroppedTriggerCount();
+// Prints the counters above to Serial (APP_DEBUG only).
+void dumpStats();
 
 // Simple tone helper.
 void playBeep(uint16_t frequencyHz, uint16_t durationMs, uint8_t volume = 200, bool sawtooth = false);
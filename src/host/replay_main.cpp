@@ -0,0 +1,169 @@
+// Host replayer for game logs pulled off the prop: re-runs the recorded session through
+// a fresh GameEngine and reports the first tick whose outputs differ from the device's.
+// Takes the binary log or a capture of the 'r'/'R' serial dump (hex between the marker
+// lines; other log lines interleaved with it are skipped).
+//
+//   pio run -e replay && .pio/build/replay/program <log>
+//
+// Exits 0 when every tick matches, 1 on a divergence and 2 when the log is unusable.
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "core/game_recorder.h"
+
+namespace {
+const char kDumpBegin[] = "----- replay log begin";
+const char kDumpEnd[] = "----- replay log end";
+
+bool readFile(const char *path, std::vector<uint8_t> &bytes) {
+  FILE *file = fopen(path, "rb");
+  if (file == nullptr) {
+    return false;
+  }
+  uint8_t buffer[4096];
+  size_t length = 0;
+  while ((length = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    bytes.insert(bytes.end(), buffer, buffer + length);
+  }
+  fclose(file);
+  return true;
+}
+
+int hexValue(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+// Appends the bytes of one dump line; false (and nothing appended) unless the line is
+// nothing but hex pairs.
+bool appendHexLine(const char *line, size_t length, std::vector<uint8_t> &out) {
+  while (length > 0 && (line[length - 1] == '\r' || line[length - 1] == ' ')) {
+    --length;
+  }
+  if (length == 0 || length % 2 != 0) {
+    return false;
+  }
+  const size_t start = out.size();
+  for (size_t i = 0; i < length; i += 2) {
+    const int high = hexValue(line[i]);
+    const int low = hexValue(line[i + 1]);
+    if (high < 0 || low < 0) {
+      out.resize(start);
+      return false;
+    }
+    out.push_back(static_cast<uint8_t>(high << 4 | low));
+  }
+  return true;
+}
+
+// Serial capture -> log bytes. Without marker lines every hex line counts (xxd -p).
+std::vector<uint8_t> decodeDump(const std::vector<uint8_t> &text) {
+  const char *begin = reinterpret_cast<const char *>(text.data());
+  const char *end = begin + text.size();
+  const bool hasMarkers = std::search(begin, end, kDumpBegin, kDumpBegin + sizeof(kDumpBegin) - 1) != end;
+
+  std::vector<uint8_t> log;
+  bool inside = !hasMarkers;
+  for (const char *line = begin; line < end;) {
+    const char *newline = static_cast<const char *>(memchr(line, '\n', end - line));
+    const char *lineEnd = newline != nullptr ? newline : end;
+    const size_t length = static_cast<size_t>(lineEnd - line);
+    if (length >= sizeof(kDumpBegin) - 1 && memcmp(line, kDumpBegin, sizeof(kDumpBegin) - 1) == 0) {
+      log.clear();  // The last dump in the capture wins.
+      inside = true;
+    } else if (length >= sizeof(kDumpEnd) - 1 && memcmp(line, kDumpEnd, sizeof(kDumpEnd) - 1) == 0) {
+      inside = false;
+    } else if (inside) {
+      appendHexLine(line, length, log);
+    }
+    line = lineEnd + 1;
+  }
+  return log;
+}
+
+const char *endName(game_recorder::ReplayEnd end) {
+  switch (end) {
+    case game_recorder::ReplayEnd::Complete:
+      return "complete";
+    case game_recorder::ReplayEnd::BadHeader:
+      return "not a game log (bad header or unknown version)";
+    case game_recorder::ReplayEnd::Truncated:
+      return "truncated inside a record";
+    case game_recorder::ReplayEnd::Corrupt:
+      return "corrupt record";
+    case game_recorder::ReplayEnd::Gap:
+      return "records dropped on the device; stopped at the gap";
+  }
+  return "?";
+}
+
+// Field-by-field view of a packed GameOutputs word (see game_recorder::packOutputs).
+void printOutputs(const char *label, uint16_t word) {
+  static const char *const kFlags[] = {"stateChanged",      "showArmingConfirmPrompt", "armingConfirmNeededEffect",
+                                       "armingConfirmedEffect", "wrongCodeEffect",     "keypadDigitEffect",
+                                       "clearIrConfirmation", "gameOverSet",           "gameOver"};
+  printf("  %-8s 0x%04x", label, static_cast<unsigned>(word));
+  for (size_t i = 0; i < sizeof(kFlags) / sizeof(kFlags[0]); ++i) {
+    if ((word & (1u << i)) != 0) {
+      printf(" %s", kFlags[i]);
+    }
+  }
+  if ((word & 0x001) != 0) {
+    printf(" %s->%s", game_state::flame_state_to_string(static_cast<FlameState>((word >> 9) & 0x7)),
+           game_state::flame_state_to_string(static_cast<FlameState>((word >> 12) & 0x7)));
+  }
+  printf("\n");
+}
+}  // namespace
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    fprintf(stderr, "usage: %s <replay.bin | serial capture of the replay dump>\n", argv[0]);
+    return 2;
+  }
+
+  std::vector<uint8_t> bytes;
+  if (!readFile(argv[1], bytes)) {
+    fprintf(stderr, "cannot read %s\n", argv[1]);
+    return 2;
+  }
+  if (bytes.size() < 4 || memcmp(bytes.data(), "GREC", 4) != 0) {
+    bytes = decodeDump(bytes);
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  game_state::GameEngine engine;
+  const game_recorder::ReplayResult result = game_recorder::replay(bytes.data(), bytes.size(), engine);
+  const double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+  printf("%lu bytes: %lu ticks, %lu overrides, last tick at %lums, replayed in %.1f ms\n",
+         static_cast<unsigned long>(bytes.size()), static_cast<unsigned long>(result.ticks),
+         static_cast<unsigned long>(result.overrides), static_cast<unsigned long>(result.lastNowMs), elapsedMs);
+  printf("end: %s\n", endName(result.end));
+  if (result.end == game_recorder::ReplayEnd::BadHeader) {
+    return 2;
+  }
+
+  if (result.mismatches == 0) {
+    printf("outputs match on every replayed tick; final state %s\n",
+           game_state::flame_state_to_string(engine.get_state()));
+    return 0;
+  }
+  printf("%lu ticks diverge; first at tick %lu (%lums):\n", static_cast<unsigned long>(result.mismatches),
+         static_cast<unsigned long>(result.firstMismatchTick), static_cast<unsigned long>(result.firstMismatchNowMs));
+  printOutputs("device", result.firstMismatchExpected);
+  printOutputs("replay", result.firstMismatchActual);
+  return 1;
+}
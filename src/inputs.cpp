@@ -7,6 +7,8 @@
 #include <Wire.h>
 #include <cstring>
 
+#include "core/clock.h"
+#include "core/scheduler.h"
 #include "game_config.h"
 
 namespace {
@@ -79,7 +81,14 @@ char scanKeypadRaw() {
 
 static bool irConfirmationPending = false;
 
-void initIr() { IrReceiver.begin(IR_PIN, ENABLE_LED_FEEDBACK); }
+// Runs in the IRremote timer ISR once a frame is complete; wakes the inputs task so the
+// frame is decoded in the next scheduler pass instead of on the next 30 ms poll.
+static void IRAM_ATTR handleIrFrameComplete() { scheduler::postFromIsr(scheduler::EventType::IrFrame); }
+
+void initIr() {
+  IrReceiver.begin(IR_PIN, ENABLE_LED_FEEDBACK);
+  IrReceiver.registerReceiveCompleteCallback(handleIrFrameComplete);
+}
 
 void updateIr() {
   if (IrReceiver.decode()) {
@@ -117,7 +126,7 @@ void initInputs() {
 }
 
 InputSnapshot updateInputs() {
-  const uint32_t now = millis();
+  const uint32_t now = sys_clock::frameMs();
 
   updateIr();
 
@@ -1,153 +1,381 @@
 #include <Arduino.h>
 #include <IRremote.hpp>
 
+#include <atomic>
+
+#include "api_session.h"
+#include "bomb_deadline.h"
+#include "core/clock.h"
+#include "core/config_store.h"
+#include "core/load_governor.h"
+#include "core/rtos_stage.h"
 #include "core/scheduler.h"
+#include "core/soak_sim.h"
+#include "core/snapshot_buffer.h"
 #include "effects.h"
 #include "game_config.h"
 #include "inputs.h"
 #include "network.h"
+#include "replay_log.h"
 #include "state_machine.h"
 #include "ui.h"
 #include "util.h"
 #include "wifi_config.h"
 
+// Execution mode. With USE_RTOS_TASKS false every subsystem shares the cooperative
+// scheduler in loop(). With it true the game tick, LEDs and UI run as FreeRTOS tasks
+// with the priorities and core pins below, so a long TFT push is preempted by the tick
+// instead of delaying it. WiFi, the config portal and debug stats stay in loop()
+// (priority 1); the ApiTask keeps core 0.
+static constexpr bool USE_RTOS_TASKS = false;
+
+static constexpr uint32_t INPUTS_INTERVAL_MS = 30;
+static constexpr uint32_t STATE_TICK_INTERVAL_MS = 10;
+static constexpr uint32_t OUTPUT_FRAME_INTERVAL_MS = 42;
+
+static void runGameStage(uint32_t now, bool woken);
+static void runEffectsStage(uint32_t now, bool woken);
+static void runUiStage(uint32_t now, bool woken);
+
+// {name, intervalMs, priority, core, stackBytes}
+static rtos_stage::Stage gameStage = {{"GameTask", STATE_TICK_INTERVAL_MS, 5, 1, 4096}, runGameStage, nullptr};
+static rtos_stage::Stage effectsStage = {{"FxTask", OUTPUT_FRAME_INTERVAL_MS, 3, 1, 4096}, runEffectsStage, nullptr};
+static rtos_stage::Stage uiStage = {{"UiTask", OUTPUT_FRAME_INTERVAL_MS, 2, 1, 8192}, runUiStage, nullptr};
+
 static UiThemeConfig themeConfig = ui::defaultTheme();
 static InputSnapshot lastInputSnapshot{};
-static GameOutputs lastGameOutputs{};
 static uint32_t configuredBombDurationMs = DEFAULT_BOMB_DURATION_MS;
 
-static UiModel buildUiModel() {
-  UiModel model{};
+// The game side publishes a GameFrame after every tick; the UI and effects stages each
+// read their own buffer, so in the threaded mode nothing else crosses task boundaries.
+static SnapshotBuffer<GameFrame> uiFrames;
+static SnapshotBuffer<GameFrame> effectsFrames;
+static GameFrame uiFrame{};
+static GameFrame effectsFrame{};
+
+// Where the UI model's text fields were last filled from. The model persists across
+// frames and text is only rewritten, and its section version bumped, when one of these
+// changes.
+struct UiModelSources {
+  bool primed = false;
+  uint32_t configVersion = 0;
+  bool wifiConnected = false;
+  bool wifiFailed = false;
+  bool portalActive = false;
+  uint32_t portalIp = 0;
+  uint32_t wifiIp = 0;
+  bool hasApiResponse = false;
+  MatchStatus matchStatus = WaitingOnStart;
+};
+
+static UiModel uiModel{};
+static UiModelSources uiSources{};
+
+// `ip` as IPAddress stores it: first octet in the low byte, 0 for none.
+static void formatIp(uint32_t ip, char *buffer, size_t len) {
+  if (ip == 0) {
+    buffer[0] = '\0';
+    return;
+  }
+  snprintf(buffer, len, "%u.%u.%u.%u", static_cast<unsigned>(ip & 0xFF), static_cast<unsigned>((ip >> 8) & 0xFF),
+           static_cast<unsigned>((ip >> 16) & 0xFF), static_cast<unsigned>(ip >> 24));
+}
+
+static void updateUiModel(const GameFrame &frame, UiModel &model) {
   model.theme = themeConfig;
 
-  const FlameState state = getState();
+  const FlameState state = frame.state;
   model.state = state;
   model.bombDurationMs = configuredBombDurationMs;
   model.timerRemainingMs = configuredBombDurationMs;
-  model.armingProgress01 = getArmingProgress(lastInputSnapshot.nowMs);
+  model.bombTimerActive = false;
+  model.bombTimerExpired = false;
+  model.armingProgress01 = frame.armingProgress01;
   model.codeLength = DEFUSE_CODE_LENGTH;
-  model.enteredDigits = getDefuseEnteredDigits();
-  model.defuseBuffer = (state == ARMED) ? String(getDefuseBuffer()) : String("");
-  model.showArmingPrompt = lastGameOutputs.showArmingConfirmPrompt || (state == ARMING && isIrConfirmationWindowActive());
-  model.gameOver = lastGameOutputs.gameOver;
+  model.showArmingPrompt = frame.showArmingConfirmPrompt || (state == ARMING && frame.irConfirmationWindowActive);
+  model.gameOver = frame.gameOver;
+
+  const char *defuseSource = (state == ARMED) ? frame.defuseBuffer : "";
+  if (model.enteredDigits != frame.enteredDigits ||
+      strncmp(model.defuseBuffer, defuseSource, sizeof(model.defuseBuffer)) != 0) {
+    model.enteredDigits = frame.enteredDigits;
+    strlcpy(model.defuseBuffer, defuseSource, sizeof(model.defuseBuffer));
+    ++model.codeVersion;
+  }
 
   if (state == ARMED || state == DEFUSED || state == DETONATED) {
-    model.bombTimerActive = isBombTimerActive();
-    model.timerRemainingMs = getBombTimerRemainingMs();
+    model.bombTimerActive = frame.bombTimerActive;
+    model.timerRemainingMs = frame.bombTimerRemainingMs;
     model.bombTimerExpired = model.timerRemainingMs == 0;
   }
 
-  model.showBootScreen = (state == ON) && !network::isConfigPortalActive();
-  model.wifiSsid = network::getConfiguredWifiSsid();
-  model.wifiConnected = network::isWifiConnected();
-  model.wifiFailed = network::isConfigPortalActive() || network::hasWifiFailedPermanently();
-  model.configApSsid = network::getConfigPortalSsid();
-  model.configApAddress = network::getConfigPortalAddress();
-  model.configApPassword = network::getConfigPortalPassword();
-  model.ipAddress = network::getWifiIpString();
-  model.apiEndpoint = network::getConfiguredApiEndpoint();
-  model.hasApiResponse = network::hasReceivedApiResponse();
-  model.showConfigPortal = network::isConfigPortalActive();
+  const bool portalActive = network::isConfigPortalActive();
+  model.showBootScreen = (state == ON) && !portalActive;
+  model.showConfigPortal = portalActive;
+
+  UiModelSources sources;
+  sources.primed = true;
+  sources.configVersion = config_store::current().version;
+  sources.wifiConnected = network::isWifiConnected();
+  sources.wifiFailed = portalActive || network::hasWifiFailedPermanently();
+  sources.portalActive = portalActive;
+  sources.portalIp = network::getConfigPortalIp();
+  sources.wifiIp = network::getWifiIp();
+  const network::ApiSnapshot api = network::getApiSnapshot();
+  sources.hasApiResponse = api.responseReceived;
+  sources.matchStatus = api.remoteStatus;
+
+  if (!uiSources.primed || sources.configVersion != uiSources.configVersion ||
+      sources.wifiConnected != uiSources.wifiConnected || sources.wifiFailed != uiSources.wifiFailed ||
+      sources.portalActive != uiSources.portalActive || sources.portalIp != uiSources.portalIp ||
+      sources.wifiIp != uiSources.wifiIp || sources.hasApiResponse != uiSources.hasApiResponse) {
+    const ConfigSnapshot &config = config_store::current();
+    strlcpy(model.wifiSsid, config.wifiSsid, sizeof(model.wifiSsid));
+    strlcpy(model.apiEndpoint, config.apiEndpoint, sizeof(model.apiEndpoint));
+    model.wifiConnected = sources.wifiConnected;
+    model.wifiFailed = sources.wifiFailed;
+    strlcpy(model.configApSsid, network::getConfigPortalSsid(), sizeof(model.configApSsid));
+    strlcpy(model.configApPassword, network::getConfigPortalPassword(), sizeof(model.configApPassword));
+    char portalIp[UiModel::kIpTextLength];
+    formatIp(sources.portalIp, portalIp, sizeof(portalIp));
+    snprintf(model.configApAddress, sizeof(model.configApAddress), "%s%s", portalIp[0] ? "http://" : "", portalIp);
+    formatIp(sources.wifiIp, model.ipAddress, sizeof(model.ipAddress));
+    model.hasApiResponse = sources.hasApiResponse;
+    ++model.networkVersion;
+  }
 
 #ifdef APP_DEBUG
-  model.debugIp = network::getWifiIpString();
-  model.debugMatchStatus = String("Match ") + matchStatusToString(network::getRemoteMatchStatus());
-  model.debugTimerValid = isGameTimerValid();
-  model.debugTimerRemainingMs = getGameTimerRemainingMs();
+  if (!uiSources.primed || sources.wifiIp != uiSources.wifiIp || sources.matchStatus != uiSources.matchStatus) {
+    formatIp(sources.wifiIp, model.debugIp, sizeof(model.debugIp));
+    snprintf(model.debugMatchStatus, sizeof(model.debugMatchStatus), "Match %s",
+             matchStatusToString(sources.matchStatus));
+    ++model.debugVersion;
+  }
+  model.debugTimerValid = frame.gameTimerValid;
+  model.debugTimerRemainingMs = frame.gameTimerRemainingMs;
 #endif
 
-  return model;
+  uiSources = sources;
 }
 
 #ifdef APP_DEBUG
-static void handleDebugSerialStateChange() {
-  if (!Serial.available()) {
-    return;
+struct SoakFrame : Coroutine {
+  uint32_t busyUs;
+};
+
+static soak_sim::Simulator soakSimulator;
+static SoakFrame soakFrame;
+static scheduler::TaskId soakTask = scheduler::kInvalidTask;
+
+// Runs the simulator a slice at a time so the real game keeps its cadence meanwhile.
+static CoStatus runSoak(SoakFrame &co, uint32_t) {
+  CO_BEGIN(co);
+  co.busyUs = 0;
+  for (;;) {
+    {
+      const uint64_t startUs = sys_clock::nowUs();
+      const bool more = soakSimulator.step(SOAK_TICKS_PER_SLICE);
+      co.busyUs += static_cast<uint32_t>(sys_clock::nowUs() - startUs);
+      if (!more) {
+        break;
+      }
+    }
+    CO_SLEEP_MS(co, SOAK_SLICE_GAP_MS);
+  }
+  soak_sim::writeReport(soakSimulator.report(), co.busyUs, [](const char *line) { Serial.println(line); });
+  CO_END(co);
+}
+
+struct ReplayDumpFrame : Coroutine {
+  bool previousSession;
+};
+
+static ReplayDumpFrame replayDumpFrame;
+static scheduler::TaskId replayDumpTask = scheduler::kInvalidTask;
+
+// Streams the log a slice at a time, no faster than the Serial TX buffer drains.
+static CoStatus runReplayDump(ReplayDumpFrame &co, uint32_t) {
+  CO_BEGIN(co);
+  if (!replay_log::beginDump(co.previousSession)) {
+    CO_EXIT(co);
   }
+  while (replay_log::dumpChunk(REPLAY_DUMP_BYTES_PER_SLICE)) {
+    CO_SLEEP_MS(co, REPLAY_DUMP_SLICE_GAP_MS);
+  }
+  CO_END(co);
+}
 
-  const int incoming = Serial.read();
-  FlameState requestedState = getState();
-  bool shouldUpdate = true;
+// State digits typed on the console, handed from loop() to the game tick; -1 when none.
+static std::atomic<int> pendingDebugState(-1);
 
-  switch (incoming) {
+// Loop side: reads the debug console. State changes are applied by the game tick.
+static void handleDebugConsoleTask(uint32_t) {
+  while (Serial.available()) {
+    const int incoming = Serial.read();
+    switch (incoming) {
+      case 'r':
+      case 'R':
+        replayDumpFrame.previousSession = incoming == 'R';
+        scheduler::startCoroutine(replayDumpTask);
+        break;
+      case 's': {
+        soak_sim::Config config;
+        config.seed = esp_random();
+        config.matches = SOAK_DEBUG_MATCHES;
+        config.startMs = UINT32_MAX - 600000;  // Crosses the 32-bit ms wrap ten simulated minutes in.
+        soakSimulator.reset(config);
+        scheduler::startCoroutine(soakTask);
+        Serial.printf("[SOAK] seed=%lu matches=%lu\n", static_cast<unsigned long>(config.seed),
+                      static_cast<unsigned long>(config.matches));
+        break;
+      }
+      default:
+        if (incoming >= '0' && incoming <= '7') {
+          pendingDebugState.store(incoming, std::memory_order_relaxed);
+        }
+        break;
+    }
+  }
+}
+
+// Game side.
+static void applyDebugStateChange() {
+  const int command = pendingDebugState.exchange(-1, std::memory_order_relaxed);
+  switch (command) {
     case '0':
-      requestedState = ON;
+      setState(ON);
       break;
     case '1':
-      requestedState = READY;
+      setState(READY);
       break;
     case '2':
-      requestedState = ACTIVE;
       setMatchStatus(Running);
+      setState(ACTIVE);
       break;
     case '3':
-      requestedState = ARMING;
+      setState(ARMING);
       break;
     case '4':
-      requestedState = ARMED;
+      setState(ARMED);
       break;
     case '5':
-      requestedState = DEFUSED;
+      setState(DEFUSED);
       break;
     case '6':
-      requestedState = DETONATED;
+      setState(DETONATED);
       break;
     case '7':
-      requestedState = ERROR_STATE;
+      setState(ERROR_STATE);
       break;
     default:
-      shouldUpdate = false;
       break;
   }
+}
+#endif
 
-  if (shouldUpdate) {
-    setState(requestedState);
-  }
+static bool hasVisibleOutputs(const GameOutputs &outputs) {
+  return outputs.stateChanged || outputs.showArmingConfirmPrompt || outputs.armingConfirmNeededEffect ||
+         outputs.armingConfirmedEffect || outputs.wrongCodeEffect || outputs.keypadDigitEffect;
 }
+
+// Game side. Returns true when the input snapshot changed.
+static bool pollInputs() {
+  const bool buttonsWerePressed = lastInputSnapshot.bothButtonsPressed;
+  lastInputSnapshot = updateInputs();
+  return lastInputSnapshot.keypadDigitAvailable || lastInputSnapshot.irConfirmationReceived ||
+         lastInputSnapshot.bothButtonsPressed != buttonsWerePressed;
+}
+
+// Game side. Runs one game tick, publishes the resulting frame and returns true when the
+// outputs should be redrawn right away.
+static bool tickGame() {
+#ifdef APP_DEBUG
+  applyDebugStateChange();
 #endif
 
-static void handleStateTask(uint32_t) {
-  lastGameOutputs = GameOutputs{};
-  updateState(lastInputSnapshot, lastGameOutputs);
+  GameOutputs outputs{};
+  const FlameState stateBefore = getState();
+  const uint32_t nowMs = sys_clock::frameMs();
+  updateState(lastInputSnapshot, nowMs, outputs);
 
   if (lastInputSnapshot.keypadDigitAvailable) {
     lastInputSnapshot.keypadDigitAvailable = false;
     lastInputSnapshot.keypadDigit = '\0';
   }
 
-  if (getState() == ON) {
-    if (network::hasReceivedApiResponse()) {
-      setState(READY);
-    } else if (network::hasWifiFailedPermanently()) {
+  // ON -> READY on the first backend response is part of the game tick's transition table.
+  if (getState() == ON && network::hasWifiFailedPermanently()) {
 #ifdef APP_DEBUG
-      Serial.println("[ERROR] WiFi retries exhausted without config portal - entering ERROR_STATE.");
-      Serial.print("Configured SSID: ");
-      Serial.println(network::getConfiguredWifiSsid());
-      Serial.println("Ensure WiFi credentials are valid or start the config portal.");
+    Serial.println("[ERROR] WiFi retries exhausted without config portal - entering ERROR_STATE.");
+    Serial.print("Configured SSID: ");
+    Serial.println(network::getConfiguredWifiSsid());
+    Serial.println("Ensure WiFi credentials are valid or start the config portal.");
 #endif
-      setState(ERROR_STATE);
-    }
+    setState(ERROR_STATE);
   }
+
+  GameFrame frame;
+  captureGameFrame(outputs, nowMs, frame);
+  uiFrames.publish(frame);
+  effectsFrames.publish(frame);
+
+  return hasVisibleOutputs(outputs) || getState() != stateBefore;
 }
 
-static void handleEffectsTask(uint32_t now) {
-  effects::setArmingProgress(getArmingProgress(now));
-  effects::update(now);
+static void renderEffects(uint32_t now, bool frameRequested) {
+  effectsFrames.read(effectsFrame);
+  if (frameRequested) {
+    effects::requestFrame();
+  }
+  effects::update(now, effectsFrame);
 }
 
-static void handleUiTask(uint32_t) {
+static void renderUi(bool frameRequested) {
+  uiFrames.read(uiFrame);
   configuredBombDurationMs = network::getConfiguredBombDurationMs();
-  UiModel model = buildUiModel();
-  ui::render(model);
+  updateUiModel(uiFrame, uiModel);
+  if (frameRequested) {
+    ui::requestFrame();
+  }
+  ui::render(uiModel);
+}
 
-#ifdef APP_DEBUG
-  handleDebugSerialStateChange();
-#endif
+static void handleInputsTask(uint32_t) {
+  if (pollInputs()) {
+    scheduler::publish();
+  }
 }
 
-static void handleConfigPortalTask(uint32_t now) { network::updateConfigPortal(now, getState()); }
+static void handleStateTask(uint32_t) {
+  if (tickGame()) {
+    scheduler::publish();
+  }
+}
+
+static void handleEffectsTask(uint32_t now) { renderEffects(now, scheduler::isTriggeredRun()); }
+
+static void handleUiTask(uint32_t) { renderUi(scheduler::isTriggeredRun()); }
+
+static void runGameStage(uint32_t now, bool) {
+  static uint32_t lastInputsMs = 0;
+  if (now - lastInputsMs >= INPUTS_INTERVAL_MS) {
+    lastInputsMs = now;
+    pollInputs();
+  }
+  if (tickGame()) {
+    rtos_stage::wake(effectsStage);
+    rtos_stage::wake(uiStage);
+  }
+}
+
+static void runEffectsStage(uint32_t now, bool woken) { renderEffects(now, woken); }
+
+static void runUiStage(uint32_t, bool woken) { renderUi(woken); }
+
+static void handleConfigPortalTask(uint32_t now) { network::updateConfigPortal(now); }
 
 void setup() {
+  sys_clock::beginFrame();
 #ifdef APP_DEBUG
   Serial.begin(115200);
   while (!Serial) {
@@ -155,22 +383,83 @@ void setup() {
   }
 #endif
 
-  setState(ON);
+  replay_log::begin();
+  if (USE_RTOS_TASKS) {
+    bomb_deadline::begin([]() { rtos_stage::wake(gameStage); });
+  } else {
+    bomb_deadline::begin([]() { scheduler::post(scheduler::EventType::BombDeadline); });
+  }
+  // A round interrupted by a brownout or crash picks up here, before WiFi and the display.
+  const bool resumed = resumeAfterReset();
+  if (!resumed) {
+    setState(ON);
+  }
 
   effects::init();
-  effects::onBoot();
+  if (resumed) {
+    effects::onStateChanged(ON, getState());
+  } else {
+    effects::onBoot();
+  }
 
   initInputs();
   ui::initUI();
   network::beginWifi();
   configuredBombDurationMs = network::getConfiguredBombDurationMs();
 
-  scheduler::addTask([](uint32_t) { lastInputSnapshot = updateInputs(); }, 30);
-  scheduler::addTask([](uint32_t) { network::updateWifi(); }, 200);
-  scheduler::addTask(handleStateTask, 10);
-  scheduler::addTask(handleEffectsTask, 42);
-  scheduler::addTask(handleUiTask, 42);
-  scheduler::addTask(handleConfigPortalTask, 200);
+  if (USE_RTOS_TASKS) {
+    rtos_stage::start(gameStage);
+    rtos_stage::start(effectsStage);
+    rtos_stage::start(uiStage);
+    scheduler::addTask("portal", handleConfigPortalTask, 200, 107);
+  } else {
+    // Phase offsets keep the heavy tasks out of each other's slots: effects and UI share a
+    // 42 ms period but run half a period apart, and the portal is offset from both. The
+    // UI drops stale frames rather than rendering them late.
+    const scheduler::TaskId inputsTask = scheduler::addTask("inputs", handleInputsTask, INPUTS_INTERVAL_MS);
+    const scheduler::TaskId stateTask = scheduler::addTask("state", handleStateTask, STATE_TICK_INTERVAL_MS);
+    const scheduler::TaskId effectsTask = scheduler::addTask("effects", handleEffectsTask, OUTPUT_FRAME_INTERVAL_MS, 3);
+    const scheduler::TaskId uiTask =
+        scheduler::addTask("ui", handleUiTask, OUTPUT_FRAME_INTERVAL_MS, 24, scheduler::CatchUpPolicy::Skip);
+    scheduler::addTask("portal", handleConfigPortalTask, 200, 107);
+
+    // Event wakeups: IR frames, backend responses and the bomb deadline are handled in
+    // the next pass; the periodic cadence above remains as the polling fallback.
+    scheduler::subscribe(inputsTask, scheduler::EventType::IrFrame);
+    scheduler::subscribe(stateTask, scheduler::EventType::ApiResponse);
+    scheduler::subscribe(stateTask, scheduler::EventType::BombDeadline);
+
+    // Fresh input flows through the game tick to the outputs within one pass.
+    scheduler::addDependency(stateTask, inputsTask, PIPELINE_IMMEDIATE_DISPATCH);
+    scheduler::addDependency(effectsTask, stateTask, PIPELINE_IMMEDIATE_DISPATCH);
+    scheduler::addDependency(uiTask, stateTask, PIPELINE_IMMEDIATE_DISPATCH);
+
+    // Render stalls must not delay the game tick: shed UI and LED frames while it runs late.
+    // The threaded mode gets the same guarantee from task priorities instead.
+    load_governor::watch(stateTask);
+    load_governor::addSheddable(UI_FRAME_INTERVAL_MS, ui::setFrameIntervalMs);
+    load_governor::addSheddable(EFFECTS_FRAME_INTERVAL_MS, effects::setFrameIntervalMs);
+    scheduler::addTask("governor", load_governor::update, GOVERNOR_SAMPLE_INTERVAL_MS, 131);
+  }
+  // Flash writes stay in loop() in both modes; the game side only fills the RAM ring.
+  scheduler::addTask("replay", replay_log::flush, REPLAY_LOG_FLUSH_INTERVAL_MS, 173);
+#ifdef APP_DEBUG
+  scheduler::addTask(
+      "stats",
+      [](uint32_t) {
+        scheduler::dumpTaskStats();
+        load_governor::dumpStats();
+        bomb_deadline::dumpStats();
+        api_session::dumpStats();
+        network::dumpReportStats();
+        effects::dumpStats();
+        dumpTickStats();
+      },
+      SCHEDULER_STATS_DUMP_INTERVAL_MS, 55);
+  scheduler::addTask("console", handleDebugConsoleTask, DEBUG_CONSOLE_INTERVAL_MS, 89);
+  soakTask = scheduler::addCoroutine("soak", soakFrame, runSoak);
+  replayDumpTask = scheduler::addCoroutine("dump", replayDumpFrame, runReplayDump);
+#endif
 }
 
 void loop() { scheduler::run(); }
@@ -1,5 +1,13 @@
 #include "network.h"
 
+#include "api_session.h"
+#include "bomb_deadline.h"
+#include "core/clock.h"
+#include "core/config_store.h"
+#include "core/report_cadence.h"
+#include "core/report_selection.h"
+#include "core/scheduler.h"
+#include "core/seqlock.h"
 #include "game_config.h"
 #include "state_machine.h"
 #include "time_sync.h"
@@ -10,6 +18,7 @@
 #include <HTTPClient.h>
 #include <Preferences.h>
 #include <WebServer.h>
+#include <atomic>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 
@@ -24,36 +33,53 @@
 namespace network {
 
 // Internal state cached for network interactions. Variables are file-local via
-// `static` to avoid exposing them outside this translation unit.
-struct RuntimeConfig {
-  String wifiSsid;
-  String wifiPass;
-  String defuseCode;
-  uint32_t bombDurationMs;
-  String apiEndpoint;
-};
-
-static RuntimeConfig runtimeConfig = {String(DEFAULT_WIFI_SSID), String(DEFAULT_WIFI_PASS),
-                                      String(DEFAULT_DEFUSE_CODE), DEFAULT_BOMB_DURATION_MS,
-                                      String(DEFAULT_API_ENDPOINT)};
-
-enum class ApiRequestState { Idle, InFlight };
-
-static uint32_t lastSuccessfulApiMs = 0;
-static MatchStatus remoteStatus = WaitingOnStart;
+// `static` to avoid exposing them outside this translation unit. The configuration
+// itself lives in config_store.
+
+// Backend results are written only by the ApiTask (core 0) into `apiState` and
+// published whole; the game loop and UI on core 1 read the published copy.
+static ApiSnapshot apiState;
+static Seqlock<ApiSnapshot> apiSnapshot;
+// Link keepalive from the WiFi coroutine on core 1; merged into the snapshot on read.
+static std::atomic<uint32_t> linkAliveMs{0};
 static FlameState outboundState = ON;
 static uint32_t outboundTimerMs = DEFAULT_BOMB_DURATION_MS;
-static uint32_t baseRemainingTimeMs = 0;
-static uint32_t baseRemainingTimestampMs = 0;
-static uint32_t lastApiResponseMs = 0;
-static bool apiResponseReceived = false;
 static uint32_t lastApiRequestStartMs = 0;
+
+// Latest state transition, latched by the game side in setOutboundStatus() and sent by
+// the ApiTask on its next pass. Transitions that land before the ApiTask gets to them
+// collapse into the newest one.
+struct OutboundReport {
+  FlameState state;
+  uint32_t timerMs;
+  uint32_t queuedMs;
+};
+static Seqlock<OutboundReport> outboundReport;
+static std::atomic<uint32_t> transitionCount{0};  // Written after each outboundReport write.
+// The report in flight carries a transition queued at transitionQueuedMs.
+static bool transitionInFlight = false;
+static uint32_t transitionQueuedMs = 0;
+
+// The game's current state for heartbeats, published by the state task after every tick
+// so the ApiTask never reads the game engine.
+struct GameStatus {
+  FlameState state = ON;
+  uint32_t timerMs = DEFAULT_BOMB_DURATION_MS;
+};
+static Seqlock<GameStatus> gameStatus;
+
+// Written by the ApiTask, read by the debug dump.
+static std::atomic<uint32_t> deliveredCount{0};
+static std::atomic<uint32_t> totalLatencyMs{0};
+static std::atomic<uint32_t> maxLatencyMs{0};
 static uint32_t lastSuccessfulApiDebugMs = 0;
 
-// Tracks the last POST attempt to maintain the configured cadence.
-static uint32_t lastApiPostMs = 0;
-static ApiRequestState apiRequestState = ApiRequestState::Idle;
-static TaskHandle_t apiTaskHandle = nullptr;
+// Inputs to the heartbeat interval; see core/report_cadence.h.
+static uint8_t consecutiveFailures = 0;
+static uint32_t serverIntervalMs = 0;  // From the latest response; 0 when none was suggested.
+// Set by the game side to send the next report without waiting for the cadence.
+static std::atomic<bool> reportRequested{false};
+static std::atomic<TaskHandle_t> apiTaskHandle{nullptr};
 
 static uint8_t wifiRetryCount = 0;
 static uint32_t wifiAttemptStartMs = 0;
@@ -64,24 +90,51 @@ static bool preferencesInitialized = false;
 
 static WebServer server(80);
 static bool configPortalActive = false;
-static bool configPortalReconnectRequested = false;
-static String configPortalSsid;
+static char configPortalSsid[24] = {0};
 static bool webServerRunning = false;
 static bool webServerRoutesConfigured = false;
 static uint32_t lastWebServerServiceMs = 0;
 
+// Multi-step connection sequences, run as scheduler coroutines.
+struct WifiConnectFrame : Coroutine {};
+struct PortalReconnectFrame : Coroutine {};
+
+static WifiConnectFrame wifiConnect;
+static PortalReconnectFrame portalReconnect;
+static scheduler::TaskId wifiConnectTask = scheduler::kInvalidTask;
+static scheduler::TaskId portalReconnectTask = scheduler::kInvalidTask;
+
 // Forward declarations for config portal route handlers to ensure registration
 // compiles before definitions later in the file.
 static void handleConfigPortalGet();
 static void handleConfigPortalSave();
 
+static void publishApiState() { apiSnapshot.write(apiState); }
+static void handleApiResult(ApiMode mode, uint32_t responseNow);
+
+static void bump(std::atomic<uint32_t> &counter, uint32_t amount = 1) {
+  counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+// Counted from the start of the latest report (see core/report_selection.h).
+static void updateReportInterval() {
+  report_selection::setIntervalMs(report_cadence::nextIntervalMs(outboundState, outboundTimerMs, consecutiveFailures,
+                                                                 serverIntervalMs, esp_random()));
+}
+
 static void apiTaskEntry(void *pvParameters) {
   (void)pvParameters;
-  // Dedicated networking loop pinned to Core 0 to keep blocking HTTP calls off the main UI/effects core.
-  const TickType_t delayTicks = pdMS_TO_TICKS(10);
+  // Dedicated networking loop pinned to Core 0 to keep network work off the main UI/effects core.
+  // While a report is in flight the pause ends as soon as its socket has something;
+  // otherwise the task sleeps until the next heartbeat or until requestReport() wakes it.
+  constexpr uint32_t kPassMs = 10;
   for (;;) {
+    sys_clock::beginFrame();
     updateApi();
-    vTaskDelay(delayTicks);
+    if (!api_session::waitForActivity(kPassMs)) {
+      const uint32_t idleMs = report_selection::msUntilHeartbeat(sys_clock::nowMs());
+      ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(idleMs > kPassMs ? idleMs : kPassMs));
+    }
   }
 }
 
@@ -93,35 +146,46 @@ static Preferences &getPreferences() {
   return preferences;
 }
 
-static void loadRuntimeConfigFromPrefs() {
+// Reads a string setting straight into its snapshot field. Missing, oversized and
+// (unless `allowEmpty`) empty values fall back to `fallback`.
+template <size_t N>
+static void loadStringPref(char (&field)[N], const char *key, const char *fallback, bool allowEmpty = false) {
   Preferences &prefs = getPreferences();
-  runtimeConfig.wifiSsid = prefs.getString("wifi_ssid", DEFAULT_WIFI_SSID);
-  runtimeConfig.wifiPass = prefs.getString("wifi_pass", DEFAULT_WIFI_PASS);
-  runtimeConfig.defuseCode = prefs.getString("defuse_code", DEFAULT_DEFUSE_CODE);
-  runtimeConfig.apiEndpoint = prefs.getString("api_endpoint", DEFAULT_API_ENDPOINT);
-  runtimeConfig.bombDurationMs = prefs.getUInt("bomb_duration_ms", DEFAULT_BOMB_DURATION_MS);
-
-  if (runtimeConfig.wifiSsid.isEmpty()) {
-    runtimeConfig.wifiSsid = DEFAULT_WIFI_SSID;
+  const bool stored = prefs.isKey(key) && prefs.getString(key, field, N) > 0;
+  if (!stored || (!allowEmpty && field[0] == '\0')) {
+    config_store::assign(field, fallback);
   }
-  if (runtimeConfig.apiEndpoint.isEmpty()) {
-    runtimeConfig.apiEndpoint = DEFAULT_API_ENDPOINT;
-  }
-  if (runtimeConfig.defuseCode.isEmpty()) {
-    runtimeConfig.defuseCode = DEFAULT_DEFUSE_CODE;
-  }
-  if (runtimeConfig.bombDurationMs == 0) {
-    runtimeConfig.bombDurationMs = DEFAULT_BOMB_DURATION_MS;
+}
+
+static void loadRuntimeConfigFromPrefs() {
+  ConfigSnapshot config;
+  loadStringPref(config.wifiSsid, "wifi_ssid", DEFAULT_WIFI_SSID);
+  loadStringPref(config.wifiPass, "wifi_pass", DEFAULT_WIFI_PASS, true);
+  loadStringPref(config.defuseCode, "defuse_code", DEFAULT_DEFUSE_CODE);
+  loadStringPref(config.apiEndpoint, "api_endpoint", DEFAULT_API_ENDPOINT);
+  config.bombDurationMs = getPreferences().getUInt("bomb_duration_ms", DEFAULT_BOMB_DURATION_MS);
+  if (config.bombDurationMs == 0) {
+    config.bombDurationMs = DEFAULT_BOMB_DURATION_MS;
+  }
+  char gameModeRules[game_mode::kMaxRulesLength + 1] = {0};
+  loadStringPref(gameModeRules, "game_mode", "", true);
+  const char *error = nullptr;
+  if (!game_mode::compile(gameModeRules, config.gameMode, &error)) {
+#ifdef APP_DEBUG
+    Serial.printf("[CONFIG] Stored game mode \"%s\" rejected (%s); using the built-in mode.\n", gameModeRules, error);
+#endif
   }
+  config_store::publish(config);
 }
 
-static void persistRuntimeConfig() {
+static void persistRuntimeConfig(const ConfigSnapshot &config) {
   Preferences &prefs = getPreferences();
-  prefs.putString("wifi_ssid", runtimeConfig.wifiSsid);
-  prefs.putString("wifi_pass", runtimeConfig.wifiPass);
-  prefs.putString("defuse_code", runtimeConfig.defuseCode);
-  prefs.putUInt("bomb_duration_ms", runtimeConfig.bombDurationMs);
-  prefs.putString("api_endpoint", runtimeConfig.apiEndpoint);
+  prefs.putString("wifi_ssid", config.wifiSsid);
+  prefs.putString("wifi_pass", config.wifiPass);
+  prefs.putString("defuse_code", config.defuseCode);
+  prefs.putUInt("bomb_duration_ms", config.bombDurationMs);
+  prefs.putString("api_endpoint", config.apiEndpoint);
+  prefs.putString("game_mode", config.gameMode.rules);
 }
 
 static void configureWebServerRoutes() {
@@ -147,33 +211,86 @@ static void startWebServerIfNeeded() {
 
 // Starts a single WiFi attempt without blocking the main loop.
 static void startWifiAttempt() {
-  wifiAttemptStartMs = millis();
+  wifiAttemptStartMs = sys_clock::frameMs();
   WiFi.mode(WIFI_STA);
   WiFi.disconnect(true);
-  WiFi.begin(runtimeConfig.wifiSsid.c_str(), runtimeConfig.wifiPass.c_str());
+  const ConfigSnapshot &config = config_store::current();
+  WiFi.begin(config.wifiSsid, config.wifiPass);
 #ifdef APP_DEBUG
   Serial.print("WiFi attempt ");
   Serial.print(static_cast<int>(wifiRetryCount + 1));
   Serial.print("/ ");
   Serial.println(static_cast<int>(MAX_WIFI_RETRIES));
   Serial.print("SSID: ");
-  Serial.println(runtimeConfig.wifiSsid);
+  Serial.println(config.wifiSsid);
+#endif
+}
+
+// Connects with up to MAX_WIFI_RETRIES attempts and then stays resident while the link
+// is up; a dropped connection counts as a failed attempt. Once the retries are
+// exhausted the config portal takes over the radio.
+static CoStatus runWifiConnect(WifiConnectFrame &co, uint32_t now) {
+  CO_BEGIN(co);
+  wifiRetryCount = 0;
+  wifiFailedPermanently = false;
+  for (;;) {
+    startWifiAttempt();
+    while (WiFi.status() != WL_CONNECTED && now - wifiAttemptStartMs < WIFI_CONNECT_TIMEOUT_MS) {
+      CO_SLEEP_MS(co, WIFI_STATUS_POLL_MS);
+    }
+
+    // Keep the timestamp fresh for timeout logic while connected.
+    while (WiFi.status() == WL_CONNECTED) {
+      linkAliveMs.store(sys_clock::frameMs(), std::memory_order_relaxed);
+
+      // Ensure the configuration web server is available on the LAN even when STA connects.
+      startWebServerIfNeeded();
+      CO_SLEEP_MS(co, WIFI_STATUS_POLL_MS);
+    }
+
+    if (++wifiRetryCount >= MAX_WIFI_RETRIES) {
+      break;
+    }
+  }
+
+  wifiFailedPermanently = true;
+#ifdef APP_DEBUG
+  Serial.println("WiFi failed after max retries - starting config portal");
 #endif
+  beginConfigPortal();
+  CO_END(co);
+}
+
+// Tears the SoftAP down after new settings were saved and reconnects as a station.
+static CoStatus runPortalReconnect(PortalReconnectFrame &co, uint32_t) {
+  CO_BEGIN(co);
+  CO_SLEEP_MS(co, CONFIG_PORTAL_RECONNECT_DELAY_MS);
+  server.stop();
+  webServerRunning = false;
+  webServerRoutesConfigured = false;  // Re-register routes after restart to avoid missing handlers.
+  WiFi.softAPdisconnect(true);
+  WiFi.mode(WIFI_STA);
+  configPortalActive = false;
+  scheduler::startCoroutine(wifiConnectTask);
+  CO_END(co);
 }
 
 static void handleConfigPortalGet() {
+  const ConfigSnapshot &config = config_store::current();
   String page;
-  page.reserve(1024);
+  page.reserve(1280);
   page += "<!DOCTYPE html><html><head><meta charset=\"utf-8\"><title>Digital Flame Config</title></head><body>";
   page += "<h2>Digital Flame Configuration</h2>";
   page += "<form action=\"/save\" method=\"POST\">";
-  page += "<label>WiFi SSID: <input type=\"text\" name=\"wifi_ssid\" value=\"" + runtimeConfig.wifiSsid + "\"></label><br><br>";
-  page += "<label>WiFi Password: <input type=\"password\" name=\"wifi_pass\" value=\"" + runtimeConfig.wifiPass + "\"></label><br><br>";
-  page += "<label>Defuse Code: <input type=\"text\" name=\"defuse_code\" value=\"" + runtimeConfig.defuseCode + "\"></label><br><br>";
+  page += "<label>WiFi SSID: <input type=\"text\" name=\"wifi_ssid\" value=\"" + String(config.wifiSsid) + "\"></label><br><br>";
+  page += "<label>WiFi Password: <input type=\"password\" name=\"wifi_pass\" value=\"" + String(config.wifiPass) + "\"></label><br><br>";
+  page += "<label>Defuse Code: <input type=\"text\" name=\"defuse_code\" value=\"" + String(config.defuseCode) + "\"></label><br><br>";
   page += "<label>Bomb Duration (ms): <input type=\"number\" name=\"bomb_duration_ms\" value=\"" +
-          String(runtimeConfig.bombDurationMs) + "\"></label><br><br>";
-  page += "<label>API Endpoint: <input type=\"text\" name=\"api_endpoint\" value=\"" + runtimeConfig.apiEndpoint +
+          String(config.bombDurationMs) + "\"></label><br><br>";
+  page += "<label>API Endpoint: <input type=\"text\" name=\"api_endpoint\" value=\"" + String(config.apiEndpoint) +
           "\"></label><br><br>";
+  page += "<label>Game Mode Rules (empty for the default): <input type=\"text\" name=\"game_mode\" value=\"" +
+          String(config.gameMode.rules) + "\"></label><br><br>";
   page += "<button type=\"submit\">Save</button>";
   page += "</form></body></html>";
 
@@ -185,6 +302,7 @@ static void handleConfigPortalSave() {
   const String pass = server.arg("wifi_pass");
   const String defuse = server.arg("defuse_code");
   const String endpoint = server.arg("api_endpoint");
+  const String gameModeRules = server.arg("game_mode");
   const uint32_t duration = static_cast<uint32_t>(server.arg("bomb_duration_ms").toInt());
 
   if (ssid.isEmpty()) {
@@ -192,79 +310,55 @@ static void handleConfigPortalSave() {
     return;
   }
 
-  runtimeConfig.wifiSsid = ssid;
-  runtimeConfig.wifiPass = pass;
-  runtimeConfig.defuseCode = defuse.isEmpty() ? String(DEFAULT_DEFUSE_CODE) : defuse;
-  runtimeConfig.apiEndpoint = endpoint.isEmpty() ? String(DEFAULT_API_ENDPOINT) : endpoint;
-  runtimeConfig.bombDurationMs = (duration == 0) ? DEFAULT_BOMB_DURATION_MS : duration;
+  ConfigSnapshot config;
+  if (!config_store::assign(config.wifiSsid, ssid.c_str()) || !config_store::assign(config.wifiPass, pass.c_str()) ||
+      !config_store::assign(config.defuseCode, defuse.isEmpty() ? DEFAULT_DEFUSE_CODE : defuse.c_str()) ||
+      !config_store::assign(config.apiEndpoint, endpoint.isEmpty() ? DEFAULT_API_ENDPOINT : endpoint.c_str())) {
+    server.send(400, "text/plain", "A value is too long.");
+    return;
+  }
+  config.bombDurationMs = (duration == 0) ? DEFAULT_BOMB_DURATION_MS : duration;
+  const char *modeError = nullptr;
+  if (!game_mode::compile(gameModeRules.c_str(), config.gameMode, &modeError)) {
+    server.send(400, "text/plain", String("Invalid game mode rules: ") + modeError + ".");
+    return;
+  }
 
-  persistRuntimeConfig();
+  persistRuntimeConfig(config_store::publish(config));
 
   server.send(200, "text/html",
               "<html><body><h3>Settings saved.</h3><p>Device will reconnect using the new settings." \
               "</p></body></html>");
 
-  configPortalReconnectRequested = true;
+  scheduler::startCoroutine(portalReconnectTask);
 }
 
-const String &getConfiguredWifiSsid() { return runtimeConfig.wifiSsid; }
-const String &getConfiguredApiEndpoint() { return runtimeConfig.apiEndpoint; }
-const String &getConfiguredDefuseCode() { return runtimeConfig.defuseCode; }
-uint32_t getConfiguredBombDurationMs() { return runtimeConfig.bombDurationMs; }
+const char *getConfiguredWifiSsid() { return config_store::current().wifiSsid; }
+const char *getConfiguredApiEndpoint() { return config_store::current().apiEndpoint; }
+const char *getConfiguredDefuseCode() { return config_store::current().defuseCode; }
+uint32_t getConfiguredBombDurationMs() { return config_store::current().bombDurationMs; }
 
 void beginWifi() {
   loadRuntimeConfigFromPrefs();
   wifiRetryCount = 0;
   wifiFailedPermanently = false;
   configPortalActive = false;
-  configPortalReconnectRequested = false;
   webServerRunning = false;
   webServerRoutesConfigured = false;
-  lastSuccessfulApiMs = millis();  // Prevent false timeouts before first API call.
-  startWifiAttempt();
-
-  // Start API networking task on Core 0 if not already running.
-  if (apiTaskHandle == nullptr) {
-    xTaskCreatePinnedToCore(apiTaskEntry, "ApiTask", 8192, nullptr, 1, &apiTaskHandle, 0);
-  }
-}
-
-void updateWifi() {
-  if (configPortalActive) {
-    return;  // SoftAP config portal owns the radio while active.
-  }
-
-  if (wifiFailedPermanently) {
-    return;
-  }
-
-  // Successful connection ends the retry loop; keep timestamp fresh for timeout logic.
-  if (WiFi.status() == WL_CONNECTED) {
-    lastSuccessfulApiMs = millis();
-
-    // Ensure the configuration web server is available on the LAN even when STA connects.
-    startWebServerIfNeeded();
-    return;
-  }
+  linkAliveMs.store(sys_clock::nowMs(), std::memory_order_relaxed);  // Prevent false timeouts before first API call.
 
-  const uint32_t now = millis();
-  const bool attemptTimedOut = now - wifiAttemptStartMs >= WIFI_CONNECT_TIMEOUT_MS;
-  if (!attemptTimedOut) {
-    return;
+  if (wifiConnectTask == scheduler::kInvalidTask) {
+    wifiConnectTask = scheduler::addCoroutine("wifi", wifiConnect, runWifiConnect);
+    portalReconnectTask = scheduler::addCoroutine("portalRst", portalReconnect, runPortalReconnect);
   }
+  scheduler::startCoroutine(wifiConnectTask);
 
-  wifiRetryCount++;
-  if (wifiRetryCount >= MAX_WIFI_RETRIES) {
-    wifiFailedPermanently = true;
-#ifdef APP_DEBUG
-    Serial.println("WiFi failed after max retries - starting config portal");
-#endif
-    beginConfigPortal();
-    return;
+  // Start API networking task on Core 0 if not already running.
+  if (apiTaskHandle.load(std::memory_order_acquire) == nullptr) {
+    TaskHandle_t handle = nullptr;
+    xTaskCreatePinnedToCore(apiTaskEntry, "ApiTask", 8192, nullptr, 1, &handle, 0);
+    apiTaskHandle.store(handle, std::memory_order_release);
   }
-
-  // Retry with a new non-blocking attempt.
-  startWifiAttempt();
 }
 
 bool isWifiConnected() { return WiFi.status() == WL_CONNECTED; }
@@ -273,71 +367,137 @@ bool hasWifiFailedPermanently() { return wifiFailedPermanently && !configPortalA
 
 bool isConfigPortalActive() { return configPortalActive; }
 
-String getConfigPortalSsid() { return configPortalSsid; }
+const char *getConfigPortalSsid() { return configPortalSsid; }
 
-String getConfigPortalPassword() { return String(SOFTAP_PASSWORD); }
+const char *getConfigPortalPassword() { return SOFTAP_PASSWORD; }
 
-String getConfigPortalAddress() {
+uint32_t getConfigPortalIp() {
   if (configPortalActive) {
-    return String("http://") + WiFi.softAPIP().toString();
+    return static_cast<uint32_t>(WiFi.softAPIP());
   }
   if (isWifiConnected()) {
-    return String("http://") + WiFi.localIP().toString();
+    return static_cast<uint32_t>(WiFi.localIP());
   }
   // Default SoftAP IP for user guidance when the portal is starting up.
-  return String("http://192.168.4.1");
+  return static_cast<uint32_t>(IPAddress(192, 168, 4, 1));
 }
 
-String getWifiIpString() {
-  if (!isWifiConnected()) {
-    return String("");
+uint32_t getWifiIp() { return isWifiConnected() ? static_cast<uint32_t>(WiFi.localIP()) : 0; }
+
+ApiSnapshot getApiSnapshot() {
+  ApiSnapshot snapshot = apiSnapshot.read();
+  const uint32_t aliveMs = linkAliveMs.load(std::memory_order_relaxed);
+  if (static_cast<int32_t>(aliveMs - snapshot.lastSuccessfulApiMs) > 0) {
+    snapshot.lastSuccessfulApiMs = aliveMs;
   }
-  return WiFi.localIP().toString();
+  return snapshot;
 }
 
-uint64_t getLastSuccessfulApiMs() { return lastSuccessfulApiMs; }
+uint32_t getLastSuccessfulApiMs() { return getApiSnapshot().lastSuccessfulApiMs; }
 
-MatchStatus getRemoteMatchStatus() { return remoteStatus; }
+MatchStatus getRemoteMatchStatus() { return apiSnapshot.read().remoteStatus; }
 
 uint32_t getRemoteRemainingTimeMs() {
-  if (!apiResponseReceived) {
+  const ApiSnapshot snapshot = apiSnapshot.read();
+  if (!snapshot.responseReceived) {
     return 0;
   }
 
-  const uint32_t now = millis();
-  const uint32_t elapsed = now - baseRemainingTimestampMs;
-  if (elapsed >= baseRemainingTimeMs) {
+  const uint32_t now = sys_clock::nowMs();
+  const uint32_t elapsed = now - snapshot.remainingTimestampMs;
+  if (elapsed >= snapshot.remainingTimeMs) {
     return 0;
   }
 
-  return static_cast<uint32_t>(baseRemainingTimeMs - elapsed);
+  return static_cast<uint32_t>(snapshot.remainingTimeMs - elapsed);
 }
 
-bool hasReceivedApiResponse() { return apiResponseReceived; }
+bool hasReceivedApiResponse() { return apiSnapshot.read().responseReceived; }
 
 void setOutboundStatus(FlameState state, uint32_t timerMs) {
-  outboundState = state;
-  outboundTimerMs = timerMs;
+  OutboundReport report;
+  report.state = state;
+  report.timerMs = timerMs;
+  report.queuedMs = sys_clock::nowMs();
+  outboundReport.write(report);
+  transitionCount.fetch_add(1, std::memory_order_release);
+  requestReport();
 }
 
-void updateApi() {
-  const uint32_t now = millis();
-  if (apiRequestState == ApiRequestState::InFlight) {
-    return;
-  }
-  if (now - lastApiPostMs < API_POST_INTERVAL_MS) {
-    return;
+void publishGameStatus(FlameState state, uint32_t timerMs) {
+  GameStatus status;
+  status.state = state;
+  status.timerMs = timerMs;
+  gameStatus.write(status);
+}
+
+void requestReport() {
+  reportRequested.store(true, std::memory_order_release);
+  TaskHandle_t waiter = apiTaskHandle.load(std::memory_order_acquire);
+  if (waiter != nullptr) {
+    xTaskNotifyGive(waiter);
   }
-  if (!isWifiConnected()) {
+}
+
+ReportStats getReportStats() {
+  ReportStats stats;
+  const report_selection::Stats sent = report_selection::getStats();
+  stats.transitions = sent.transitions;
+  stats.coalesced = sent.coalesced;
+  stats.heartbeats = sent.heartbeats;
+  const uint32_t delivered = deliveredCount.load(std::memory_order_relaxed);
+  stats.avgLatencyMs = delivered ? totalLatencyMs.load(std::memory_order_relaxed) / delivered : 0;
+  stats.maxLatencyMs = maxLatencyMs.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void dumpReportStats() {
+#ifdef APP_DEBUG
+  const ReportStats stats = getReportStats();
+  Serial.printf("[API] transitions=%lu coalesced=%lu heartbeats=%lu latency=%lu/%lums\n",
+                static_cast<unsigned long>(stats.transitions), static_cast<unsigned long>(stats.coalesced),
+                static_cast<unsigned long>(stats.heartbeats), static_cast<unsigned long>(stats.avgLatencyMs),
+                static_cast<unsigned long>(stats.maxLatencyMs));
+#endif
+}
+
+void updateApi() {
+  const uint32_t now = sys_clock::frameMs();
+  const ApiMode mode = getApiMode();
+  const api_session::Result result = api_session::poll(now);
+  if (result == api_session::Result::Answered || result == api_session::Result::Failed) {
+    handleApiResult(mode, sys_clock::nowMs());
+  }
+
+  // A report in flight holds the single slot until it completes or times out; only an
+  // urgent one (a state change) cancels it and takes its place.
+  report_selection::Pass pass;
+  pass.nowMs = now;
+  pass.transitions = transitionCount.load(std::memory_order_acquire);
+  pass.requested = reportRequested.load(std::memory_order_acquire);
+  pass.inFlight = api_session::inFlight();
+  pass.linkUp = isWifiConnected();
+  const report_selection::Report next = report_selection::select(pass);
+  if (next == report_selection::Report::None) {
     return;
   }
+  reportRequested.store(false, std::memory_order_release);
 
-  lastApiPostMs = now;
-
-  // Keep outbound state/timer in sync with the current state machine status.
-  outboundState = getState();
+  if (next == report_selection::Report::Transition) {
+    const OutboundReport report = outboundReport.read();
+    outboundState = report.state;
+    outboundTimerMs = report.timerMs;
+    transitionQueuedMs = report.queuedMs;
+  } else {
+    // Heartbeat: the state and timer the game published after its latest tick.
+    const GameStatus status = gameStatus.read();
+    outboundState = status.state;
+    outboundTimerMs = status.timerMs;
+  }
+  transitionInFlight = next == report_selection::Report::Transition;
+  updateReportInterval();
 
-  const uint32_t payloadNowMs = millis();
+  const uint32_t payloadNowMs = sys_clock::nowMs();
   int64_t timestampEpochMs = 0;
   if (time_sync::isValid()) {
     timestampEpochMs = time_sync::getCurrentEpochMs(payloadNowMs);
@@ -345,49 +505,45 @@ void updateApi() {
 
   JsonDocument doc;
   doc["state"] = flameStateToString(outboundState);
-  if (outboundState == ARMED || outboundState == DEFUSED || outboundState == DETONATED) {
-    doc["timer"] = getBombTimerRemainingMs();
-  } else {
-    doc["timer"] = getConfiguredBombDurationMs();
-  }
+  doc["timer"] = outboundTimerMs;
   doc["timestamp"] = timestampEpochMs;
   doc["uptime_ms"] = payloadNowMs;
 
-  String payload;
-  serializeJson(doc, payload);
-
-  const ApiMode mode = getApiMode();
+  char payload[160];
+  const size_t payloadLength = serializeJson(doc, payload, sizeof(payload));
 
   if (mode == ApiMode::Disabled) {
     // Prevent timeout triggers while intentionally offline.
-    lastSuccessfulApiMs = now;
+    apiState.lastSuccessfulApiMs = now;
+    publishApiState();
     return;
   }
 
-  struct ApiRequestGuard {
-    explicit ApiRequestGuard(ApiRequestState &stateRef) : state(stateRef) { state = ApiRequestState::InFlight; }
-    ~ApiRequestGuard() { state = ApiRequestState::Idle; }
-    ApiRequestState &state;
-  } guard(apiRequestState);
-
-  lastApiRequestStartMs = millis();
+  lastApiRequestStartMs = sys_clock::nowMs();
+  if (outboundState == DETONATED) {
+    bomb_deadline::noteReportSent();
+  }
+  api_session::submit(payload, payloadLength, now);
+}
 
-  HTTPClient http;
-  if (!http.begin(runtimeConfig.apiEndpoint)) {
-#if API_DEBUG_ENABLED
-    Serial.println("HTTP begin failed for API endpoint");
-#endif
-    if (mode == ApiMode::TestSendOnly) {
-      lastSuccessfulApiMs = now;
+static void handleApiResult(ApiMode mode, uint32_t responseNow) {
+  const int httpCode = api_session::statusCode();
+  if (httpCode == HTTP_CODE_OK) {
+    consecutiveFailures = 0;
+  } else if (consecutiveFailures < UINT8_MAX) {
+    ++consecutiveFailures;
+  }
+  updateReportInterval();
+  if (transitionInFlight && httpCode > 0) {
+    // State change to backend acknowledgement, including time spent queued.
+    const uint32_t latencyMs = responseNow - transitionQueuedMs;
+    bump(deliveredCount);
+    bump(totalLatencyMs, latencyMs);
+    if (latencyMs > maxLatencyMs.load(std::memory_order_relaxed)) {
+      maxLatencyMs.store(latencyMs, std::memory_order_relaxed);
     }
-    return;
   }
-
-  http.setTimeout(2000);
-  http.addHeader("Content-Type", "application/json");
-  const int httpCode = http.POST(payload);
-  const uint32_t responseNow = millis();
-
+  transitionInFlight = false;
   if (mode == ApiMode::TestSendOnly) {
     if (httpCode != HTTP_CODE_OK) {
 #if API_DEBUG_ENABLED
@@ -396,16 +552,16 @@ void updateApi() {
 #endif
     }
     // Keep timeout logic from firing in this mode regardless of response.
-    lastSuccessfulApiMs = responseNow;
-    http.end();
+    apiState.lastSuccessfulApiMs = responseNow;
+    publishApiState();
     return;
   }
 
   // FullOnline mode: enforce strict success + JSON parsing.
   if (httpCode == HTTP_CODE_OK) {
-    const String response = http.getString();
     JsonDocument respDoc;
-    const DeserializationError err = deserializeJson(respDoc, response);
+    const DeserializationError err =
+        deserializeJson(respDoc, api_session::responseBody(), api_session::responseLength());
     if (!err) {
       const char *statusStr = respDoc["status"];
       MatchStatus parsedStatus;
@@ -420,6 +576,13 @@ void updateApi() {
         time_sync::updateFromServer(serverTimestampMs, lastApiRequestStartMs, responseNow);
       }
 
+      // A suggestion applies until a response without one.
+      const uint32_t suggestedMs = respDoc["poll_interval_ms"] | 0;
+      if (suggestedMs != serverIntervalMs) {
+        serverIntervalMs = suggestedMs;
+        updateReportInterval();
+      }
+
       uint32_t remainingMs = respDoc["remaining_time_ms"] | 0;
       if (hasTimestamp && time_sync::isValid()) {
         const int64_t serverNowEstimate = time_sync::getCurrentEpochMs(responseNow);
@@ -431,25 +594,27 @@ void updateApi() {
         }
       }
 
-      baseRemainingTimeMs = remainingMs;
-      baseRemainingTimestampMs = responseNow;
-      lastApiResponseMs = responseNow;
-      apiResponseReceived = true;
-
-      updateGameTimerFromApi(remainingMs, responseNow);
+      apiState.remainingTimeMs = remainingMs;
+      apiState.remainingTimestampMs = responseNow;
+      apiState.responseReceived = true;
+      ++apiState.responseCount;
 
       if (statusParsed) {
-        remoteStatus = parsedStatus;
+        apiState.remoteStatus = parsedStatus;
       }
 
       // Treat a well-formed JSON body as a successful API interaction for timeout tracking.
-      lastSuccessfulApiMs = responseNow;
+      apiState.lastSuccessfulApiMs = responseNow;
+      publishApiState();
+
+      // Wake the game tick on core 1 so the new match status applies immediately.
+      scheduler::post(scheduler::EventType::ApiResponse);
 
       const uint32_t rttMs = responseNow - lastApiRequestStartMs;
 
       if (lastSuccessfulApiDebugMs != 0) {
         const uint32_t delta = responseNow - lastSuccessfulApiDebugMs;
-        const uint32_t intervals = delta / API_POST_INTERVAL_MS;
+        const uint32_t intervals = delta / report_selection::getIntervalMs();
         if (intervals > 1) {
 #if API_DEBUG_ENABLED
           Serial.printf("[API] Missed approx %lu intervals since last success\n",
@@ -479,8 +644,6 @@ void updateApi() {
     Serial.println(httpCode);
 #endif
   }
-
-  http.end();
 }
 
 void beginConfigPortal() {
@@ -496,13 +659,11 @@ void beginConfigPortal() {
   WiFi.macAddress(mac);
   char suffix[5] = {0};
   snprintf(suffix, sizeof(suffix), "%02X%02X", mac[4], mac[5]);
-  configPortalSsid = String(SOFTAP_SSID_PREFIX) + String(suffix);
+  snprintf(configPortalSsid, sizeof(configPortalSsid), "%s%s", SOFTAP_SSID_PREFIX, suffix);
 
-  WiFi.softAP(configPortalSsid.c_str(), SOFTAP_PASSWORD);
+  WiFi.softAP(configPortalSsid, SOFTAP_PASSWORD);
   startWebServerIfNeeded();
 
-  const String portalAddress = getConfigPortalAddress();
-
   configPortalActive = true;
   wifiFailedPermanently = false;  // Prevent ERROR state while AP is active.
 #ifdef APP_DEBUG
@@ -510,16 +671,19 @@ void beginConfigPortal() {
   Serial.print(configPortalSsid);
   Serial.print(" Password: ");
   Serial.println(SOFTAP_PASSWORD);
-  Serial.print("Browse to ");
-  Serial.println(portalAddress);
+  Serial.print("Browse to http://");
+  Serial.println(WiFi.softAPIP());
 #endif
 }
 
-void updateConfigPortal(uint32_t now, FlameState state) {
+void updateConfigPortal(uint32_t now) {
   if (!webServerRunning) {
     return;
   }
 
+  // The portal runs on the loop task; the state comes from the published copy rather
+  // than the game state owned by the state task.
+  const FlameState state = gameStatus.read().state;
   uint32_t interval = 200;
   if (state == ACTIVE || state == ARMING || state == ARMED) {
     interval = 500;
@@ -531,19 +695,6 @@ void updateConfigPortal(uint32_t now, FlameState state) {
   lastWebServerServiceMs = now;
 
   server.handleClient();
-
-  if (configPortalActive && configPortalReconnectRequested) {
-    configPortalReconnectRequested = false;
-    server.stop();
-    webServerRunning = false;
-    webServerRoutesConfigured = false;  // Re-register routes after restart to avoid missing handlers.
-    WiFi.softAPdisconnect(true);
-    WiFi.mode(WIFI_STA);
-    configPortalActive = false;
-    wifiRetryCount = 0;
-    wifiFailedPermanently = false;
-    startWifiAttempt();
-  }
 }
 
 }  // namespace network
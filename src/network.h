@@ -7,39 +7,80 @@
 
 namespace network {
 
-// Starts the first WiFi connection attempt using credentials from NVS (with
-// defaults from wifi_config.h as a fallback).
-void beginWifi();
+// Latest backend results, published as a whole by the networking task (core 0) so
+// readers on core 1 never see fields from two different responses.
+struct ApiSnapshot {
+  uint32_t responseCount = 0;  // Well-formed responses so far; changes with each new one.
+  uint32_t lastSuccessfulApiMs = 0;
+  uint32_t remainingTimeMs = 0;  // Match time left as of remainingTimestampMs.
+  uint32_t remainingTimestampMs = 0;
+  MatchStatus remoteStatus = WaitingOnStart;
+  bool responseReceived = false;
+};
 
-// Non-blocking WiFi state machine. Call this from loop() to advance retries.
-void updateWifi();
+// Starts connecting using credentials from NVS (with defaults from wifi_config.h as a
+// fallback). Retries run as a scheduler coroutine; after MAX_WIFI_RETRIES failed
+// attempts the config portal takes over.
+void beginWifi();
 
-// Accessors for currently loaded configuration values.
-const String &getConfiguredWifiSsid();
-const String &getConfiguredApiEndpoint();
-const String &getConfiguredDefuseCode();
+// Accessors for currently loaded configuration values (fields of config_store::current()).
+const char *getConfiguredWifiSsid();
+const char *getConfiguredApiEndpoint();
+const char *getConfiguredDefuseCode();
 uint32_t getConfiguredBombDurationMs();
 
 bool isWifiConnected();
 bool hasWifiFailedPermanently();  // True only when config portal is not running.
 bool isConfigPortalActive();
-String getConfigPortalSsid();
-String getConfigPortalPassword();
-String getConfigPortalAddress();
-String getWifiIpString();
-uint64_t getLastSuccessfulApiMs();
+const char *getConfigPortalSsid();
+const char *getConfigPortalPassword();
+// IPv4 addresses as IPAddress stores them (first octet in the low byte); 0 when unknown.
+// The portal address is where the portal can be browsed to, or the default SoftAP
+// address while it is starting up.
+uint32_t getConfigPortalIp();
+uint32_t getWifiIp();
+// Consistent copy of the latest results; safe to call from any task.
+ApiSnapshot getApiSnapshot();
+uint32_t getLastSuccessfulApiMs();
 MatchStatus getRemoteMatchStatus();
 uint32_t getRemoteRemainingTimeMs();
 bool hasReceivedApiResponse();
 
-// Allow state/timer injection for payload construction (set by state machine).
+// Edge-triggered state reports, counted by the networking task.
+struct ReportStats {
+  uint32_t transitions = 0;   // Reports sent for a state transition.
+  uint32_t coalesced = 0;     // Transitions replaced by a newer one before they were sent.
+  uint32_t heartbeats = 0;    // Regular-cadence reports.
+  uint32_t avgLatencyMs = 0;  // Transition queued to backend response, over answered ones.
+  uint32_t maxLatencyMs = 0;
+};
+
+// Queues a report of a state transition and wakes the networking task, which sends it
+// at once (cancelling a report in flight). Transitions queued before it gets to them are
+// coalesced: only the newest is sent. Called by the state machine on every transition.
 void setOutboundStatus(FlameState state, uint32_t timerMs);
 
-// Periodic API POST handler serviced by the networking task.
+// Publishes the game's current state and report timer for the heartbeats. Called by the
+// state task after every tick; the networking task reads only this copy.
+void publishGameStatus(FlameState state, uint32_t timerMs);
+
+// Sends the next report on the networking task's next pass instead of at the regular
+// cadence; safe to call from any task.
+void requestReport();
+
+// Sends a queued transition or, at a cadence set by the game state, failures and the
+// backend's suggestion (see game_config.h), a heartbeat with the current state.
+// Serviced by the networking task.
 void updateApi();
 
-// SoftAP configuration portal used when WiFi station connection fails.
+ReportStats getReportStats();
+
+// Prints the counters above to Serial (APP_DEBUG only).
+void dumpReportStats();
+
+// SoftAP configuration portal used when WiFi station connection fails. The portal
+// services clients less often while a round is running, going by publishGameStatus().
 void beginConfigPortal();
-void updateConfigPortal(uint32_t now, FlameState state);
+void updateConfigPortal(uint32_t now);
 
 }  // namespace network
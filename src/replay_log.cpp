@@ -0,0 +1,249 @@
+#include "replay_log.h"
+
+#include <LittleFS.h>
+
+#include <algorithm>
+#include <atomic>
+
+#include "core/game_recorder.h"
+#include "game_config.h"
+
+namespace replay_log {
+namespace {
+// A segment that finds no quiet tick to close on stops growing here.
+constexpr uint32_t kSegmentHardCapBytes = REPLAY_LOG_SEGMENT_BYTES * 2;
+
+game_recorder::Recorder recorder;
+File logFile;
+bool recording = false;
+uint32_t writtenBytes = 0;  // Into the current segment.
+uint32_t segmentCount = 1;
+// Set by flush() once the segment is full; the recording side then cuts the stream.
+std::atomic<bool> segmentFull{false};
+#ifdef APP_DEBUG
+constexpr size_t kDumpLineBytes = 32;
+
+uint32_t reportedDrops = 0;
+File dumpFile;
+size_t dumpRemaining = 0;
+#endif
+
+size_t writeToLog(const uint8_t *data, size_t length) {
+  if (writtenBytes + length > kSegmentHardCapBytes) {
+    length = kSegmentHardCapBytes - writtenBytes;
+  }
+  const size_t written = length == 0 ? 0 : logFile.write(data, length);
+  writtenBytes += written;
+  return written;
+}
+
+void olderSegmentPath(char (&path)[24], uint8_t age) { snprintf(path, sizeof(path), REPLAY_LOG_OLDER_PATH_FORMAT, age); }
+
+void removeOlderSegments() {
+  char path[24];
+  for (uint8_t age = 1; age < REPLAY_LOG_SEGMENTS; ++age) {
+    olderSegmentPath(path, age);
+    if (LittleFS.exists(path)) {
+      LittleFS.remove(path);
+    }
+  }
+}
+
+// Closes the current segment, ages the older ones (dropping the oldest) and opens a new
+// current segment for the stream startSegment() began.
+void rotateSegments() {
+  logFile.close();
+  char from[24];
+  char to[24];
+  olderSegmentPath(to, REPLAY_LOG_SEGMENTS - 1);
+  if (LittleFS.exists(to)) {
+    LittleFS.remove(to);
+  }
+  for (uint8_t age = REPLAY_LOG_SEGMENTS - 1; age > 1; --age) {
+    olderSegmentPath(from, age - 1);
+    olderSegmentPath(to, age);
+    if (LittleFS.exists(from)) {
+      LittleFS.rename(from, to);
+    }
+  }
+  if (REPLAY_LOG_SEGMENTS > 1) {
+    olderSegmentPath(to, 1);
+    LittleFS.rename(REPLAY_LOG_PATH, to);
+  } else {
+    LittleFS.remove(REPLAY_LOG_PATH);
+  }
+
+  logFile = LittleFS.open(REPLAY_LOG_PATH, FILE_WRITE);
+  writtenBytes = 0;
+  ++segmentCount;
+  segmentFull.store(false, std::memory_order_relaxed);
+#ifdef APP_DEBUG
+  if (!logFile) {
+    Serial.println("[REPLAY] Could not start a new log segment; records are dropped from here on.");
+  }
+#endif
+}
+
+// Between rounds, with the buttons up, the resume record covers everything the engine
+// carries into the next tick, so the new segment replays exactly.
+bool isQuietTick(const GameInputs &inputs, const GameOutputs &outputs, FlameState state) {
+  return !outputs.stateChanged && !inputs.bothButtonsPressed && state != ARMING && state != ARMED;
+}
+}  // namespace
+
+void begin() {
+  if (!REPLAY_LOG_ENABLED) {
+    return;
+  }
+
+  if (!LittleFS.begin(true)) {
+#ifdef APP_DEBUG
+    Serial.println("[REPLAY] LittleFS mount failed; replay log disabled.");
+#endif
+    return;
+  }
+
+  if (LittleFS.exists(REPLAY_LOG_PREVIOUS_PATH)) {
+    LittleFS.remove(REPLAY_LOG_PREVIOUS_PATH);
+  }
+  if (LittleFS.exists(REPLAY_LOG_PATH)) {
+    LittleFS.rename(REPLAY_LOG_PATH, REPLAY_LOG_PREVIOUS_PATH);
+  }
+  removeOlderSegments();
+
+  logFile = LittleFS.open(REPLAY_LOG_PATH, FILE_WRITE);
+  if (!logFile) {
+#ifdef APP_DEBUG
+    Serial.println("[REPLAY] Could not create the replay log; replay log disabled.");
+#endif
+    return;
+  }
+
+  recorder.start();
+  recording = true;
+}
+
+void recordTick(const GameInputs &inputs, const GameOutputs &outputs) {
+  if (!recording) {
+    return;
+  }
+  recorder.recordTick(inputs, outputs);
+  if (segmentFull.load(std::memory_order_relaxed)) {
+    const ResumePoint point = game_state::default_engine().get_resume_point();
+    if (isQuietTick(inputs, outputs, point.state)) {
+      recorder.startSegment(point, inputs.nowMs);
+    }
+  }
+}
+
+void recordSetState(FlameState state, uint32_t nowMs) {
+  if (recording) {
+    recorder.recordSetState(state, nowMs);
+  }
+}
+
+void recordMatchStatus(MatchStatus status) {
+  if (recording) {
+    recorder.recordMatchStatus(status);
+  }
+}
+
+void recordResume(const ResumePoint &point, uint32_t nowMs) {
+  if (recording) {
+    recorder.recordResume(point, nowMs);
+  }
+}
+
+void flush(uint32_t) {
+  if (!recording) {
+    return;
+  }
+
+  size_t drained = recorder.drain(writeToLog);
+  if (recorder.takeSegmentStart()) {
+    rotateSegments();
+    if (!logFile) {
+      return;
+    }
+    drained += recorder.drain(writeToLog);
+  }
+  if (drained > 0) {
+    logFile.flush();
+  }
+  if (writtenBytes >= REPLAY_LOG_SEGMENT_BYTES) {
+    segmentFull.store(true, std::memory_order_relaxed);
+  }
+
+#ifdef APP_DEBUG
+  const uint32_t drops = recorder.droppedRecords();
+  if (drops != reportedDrops) {
+    Serial.printf("[REPLAY] %lu records dropped (segment %lu at %lu/%lu bytes)\n", static_cast<unsigned long>(drops),
+                  static_cast<unsigned long>(segmentCount), static_cast<unsigned long>(writtenBytes),
+                  static_cast<unsigned long>(kSegmentHardCapBytes));
+    reportedDrops = drops;
+  }
+#endif
+}
+
+bool beginDump(bool previousSession) {
+#ifdef APP_DEBUG
+  const char *path = previousSession ? REPLAY_LOG_PREVIOUS_PATH : REPLAY_LOG_PATH;
+  if (dumpFile) {
+    dumpFile.close();
+  }
+
+  dumpFile = LittleFS.open(path, FILE_READ);
+  if (!dumpFile) {
+    Serial.printf("[REPLAY] No log at %s\n", path);
+    return false;
+  }
+
+  // The flush task may append meanwhile; the dump stops at the size announced here.
+  dumpRemaining = dumpFile.size();
+  Serial.printf("----- replay log begin: %s (%lu bytes) -----\n", path, static_cast<unsigned long>(dumpRemaining));
+  return true;
+#else
+  (void)previousSession;
+  return false;
+#endif
+}
+
+bool dumpChunk(size_t maxBytes) {
+#ifdef APP_DEBUG
+  if (!dumpFile) {
+    return false;
+  }
+
+  uint8_t line[kDumpLineBytes];
+  char text[kDumpLineBytes * 2 + 1];
+  size_t budget = maxBytes;
+  while (dumpRemaining > 0 && budget > 0) {
+    const size_t wanted = std::min<size_t>(std::min<size_t>(sizeof(line), dumpRemaining), budget);
+    if (static_cast<size_t>(Serial.availableForWrite()) < wanted * 2 + 2) {
+      return true;
+    }
+    const size_t length = dumpFile.read(line, wanted);
+    if (length == 0) {
+      break;
+    }
+    for (size_t i = 0; i < length; ++i) {
+      snprintf(text + i * 2, 3, "%02x", line[i]);
+    }
+    Serial.println(text);
+    dumpRemaining -= length;
+    budget -= length;
+  }
+  if (dumpRemaining > 0 && budget == 0) {
+    return true;
+  }
+
+  Serial.println("----- replay log end -----");
+  dumpFile.close();
+  dumpRemaining = 0;
+  return false;
+#else
+  (void)maxBytes;
+  return false;
+#endif
+}
+}  // namespace replay_log
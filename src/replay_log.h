@@ -0,0 +1,35 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "core/game_state.h"
+
+// Flight recorder for the game engine: every tick's input changes and outputs (see
+// core/game_recorder.h) are buffered in RAM and flushed to LittleFS. The log is a
+// series of segments that each replay on their own; once the current one passes
+// REPLAY_LOG_SEGMENT_BYTES it is closed between rounds, and only the newest
+// REPLAY_LOG_SEGMENTS are kept. Each boot starts a new log and keeps the previous
+// session's last segment as REPLAY_LOG_PREVIOUS_PATH, so a session that ended in a
+// reset can still be pulled off the device and replayed.
+namespace replay_log {
+// Mounts the filesystem and starts a new log. Call before the first game tick;
+// recording stays off when the filesystem is unavailable.
+void begin();
+
+void recordTick(const GameInputs &inputs, const GameOutputs &outputs);
+void recordSetState(FlameState state, uint32_t nowMs);
+void recordMatchStatus(MatchStatus status);
+void recordResume(const ResumePoint &point, uint32_t nowMs);
+
+// Moves buffered records to flash; run it every REPLAY_LOG_FLUSH_INTERVAL_MS.
+void flush(uint32_t nowMs);
+
+// Streams the current segment (as flushed so far) or the previous session's last one to
+// Serial as hex between marker lines (APP_DEBUG only); `xxd -r -p` or the host replayer
+// turns the lines back into the log. beginDump() opens the file and prints the begin
+// marker, returning false when there is no log. Each dumpChunk() then prints at most
+// `maxBytes` of it, only as much as the Serial TX buffer takes without blocking, and
+// returns false once the end marker is out.
+bool beginDump(bool previousSession);
+bool dumpChunk(size_t maxBytes);
+}  // namespace replay_log
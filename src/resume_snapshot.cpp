@@ -0,0 +1,46 @@
+#include "resume_snapshot.h"
+
+#include <esp32/rtc.h>
+#include <esp_system.h>
+
+#include "core/resume_codec.h"
+
+namespace resume_snapshot {
+namespace {
+// Not zeroed at boot; the checksum tells a valid snapshot from power-on garbage.
+RTC_NOINIT_ATTR resume_codec::Snapshot snapshot;
+
+resume_codec::ResetReason resetReason() {
+  using resume_codec::ResetReason;
+  switch (esp_reset_reason()) {
+    case ESP_RST_POWERON:
+      return ResetReason::PowerOn;
+    case ESP_RST_EXT:
+      return ResetReason::External;
+    case ESP_RST_SW:
+      return ResetReason::Software;
+    case ESP_RST_DEEPSLEEP:
+      return ResetReason::DeepSleep;
+    case ESP_RST_BROWNOUT:
+      return ResetReason::Brownout;
+    case ESP_RST_PANIC:
+      return ResetReason::Panic;
+    case ESP_RST_INT_WDT:
+      return ResetReason::InterruptWatchdog;
+    case ESP_RST_TASK_WDT:
+      return ResetReason::TaskWatchdog;
+    case ESP_RST_WDT:
+      return ResetReason::OtherWatchdog;
+    default:
+      return ResetReason::Unknown;
+  }
+}
+}  // namespace
+
+void save(const ResumePoint &point) { snapshot = resume_codec::encode(point, esp_rtc_get_time_us()); }
+
+bool load(ResumePoint &point) {
+  const resume_codec::Snapshot saved = snapshot;
+  return resume_codec::decode(saved, resetReason(), esp_rtc_get_time_us(), point);
+}
+}  // namespace resume_snapshot
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "core/game_state.h"
+
+// Game state kept in RTC slow memory so a round survives a warm reset (brownout when
+// the amp and LEDs peak, panic, watchdog). The snapshot is rewritten whenever the
+// state, match status or defuse progress changes. The bomb deadline is stored as an
+// absolute time on the RTC timer, which keeps counting through those resets while
+// esp_timer starts over from zero.
+//
+// A power-on or reset-button boot ignores the snapshot, as does one that fails its
+// checksum. Only ARMED, DEFUSED and DETONATED are resumed: every other state needs the
+// backend to move on anyway, so it starts from ON. Those rules and the snapshot layout
+// live in core/resume_codec.h; this module holds the RTC copy.
+namespace resume_snapshot {
+// Stores `point`; for ARMED, the deadline is now plus `point.bombRemainingMs`.
+void save(const ResumePoint &point);
+
+// Fills `point` from the snapshot after a warm reset. An ARMED round whose deadline
+// passed during the reset comes back as DETONATED. Returns false when there is nothing
+// to resume.
+bool load(ResumePoint &point);
+}  // namespace resume_snapshot
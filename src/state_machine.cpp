@@ -1,26 +1,88 @@
 #include "state_machine.h"
 
+#include <atomic>
+
+#include "bomb_deadline.h"
+#include "core/clock.h"
+#include "core/config_store.h"
 #include "core/game_state.h"
 #include "effects.h"
 #include "game_config.h"
 #include "inputs.h"
 #include "network.h"
+#include "replay_log.h"
+#include "resume_snapshot.h"
 #include "util.h"
 
 namespace {
-GameInputs buildGameInputs(const InputSnapshot &inputSnapshot) {
+// game_tick() cost, written by the game task and read by the debug dump.
+std::atomic<uint32_t> tickCount{0};
+std::atomic<uint32_t> tickMaxUs{0};
+std::atomic<uint32_t> ticksOverBudget{0};
+
+// What the RTC snapshot currently holds; it is rewritten only when one of these changes.
+bool resumeSaved = false;
+FlameState savedState = ON;
+MatchStatus savedMatchStatus = WaitingOnStart;
+uint8_t savedDigits = 0;
+
+void saveResumePointIfChanged() {
+  const ResumePoint point = game_state::default_engine().get_resume_point();
+  if (resumeSaved && point.state == savedState && point.matchStatus == savedMatchStatus &&
+      point.enteredDigits == savedDigits) {
+    return;
+  }
+  resume_snapshot::save(point);
+  resumeSaved = true;
+  savedState = point.state;
+  savedMatchStatus = point.matchStatus;
+  savedDigits = point.enteredDigits;
+}
+
+void noteTickCost(uint32_t costUs) {
+  tickCount.store(tickCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  if (costUs > tickMaxUs.load(std::memory_order_relaxed)) {
+    tickMaxUs.store(costUs, std::memory_order_relaxed);
+  }
+  if (costUs > GAME_TICK_BUDGET_US) {
+    ticksOverBudget.store(ticksOverBudget.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+}
+
+// Timer sent with a report: the bomb countdown once armed, else the configured duration.
+uint32_t reportTimerMs(FlameState state) {
+  if (state == ARMED || state == DEFUSED || state == DETONATED) {
+    return game_state::get_bomb_timer_remaining_ms();
+  }
+  return config_store::current().bombDurationMs;
+}
+
+// Hands the current state to the networking task for its heartbeats.
+void publishGameStatus() {
+  const FlameState state = game_state::get_state();
+  network::publishGameStatus(state, reportTimerMs(state));
+}
+
+// responseCount of the last backend response applied to the game timer.
+uint32_t appliedResponseCount = 0;
+
+GameInputs buildGameInputs(const InputSnapshot &inputSnapshot, const network::ApiSnapshot &api, uint32_t nowMs) {
   GameInputs inputs{};
-  inputs.nowMs = inputSnapshot.nowMs;
+  inputs.nowMs = nowMs;
   inputs.wifiConnected = network::isWifiConnected();
-  inputs.lastSuccessfulApiMs = network::getLastSuccessfulApiMs();
-  inputs.apiResponseReceived = network::hasReceivedApiResponse();
-  inputs.remoteMatchStatus = network::getRemoteMatchStatus();
-  inputs.configuredBombDurationMs = network::getConfiguredBombDurationMs();
-  inputs.configuredDefuseCode = network::getConfiguredDefuseCode();
+  inputs.lastSuccessfulApiMs = api.lastSuccessfulApiMs;
+  inputs.apiResponseReceived = api.responseReceived;
+  inputs.remoteMatchStatus = api.remoteStatus;
+  // One snapshot per tick: a portal save lands between ticks, never half-way through one.
+  const ConfigSnapshot &config = config_store::current();
+  inputs.configuredBombDurationMs = config.bombDurationMs;
+  inputs.configuredDefuseCode = config.defuseCode;
+  inputs.gameMode = &config.gameMode;
   inputs.bothButtonsPressed = inputSnapshot.bothButtonsPressed;
   inputs.keypadDigitAvailable = inputSnapshot.keypadDigitAvailable;
   inputs.keypadDigit = inputSnapshot.keypadDigit;
   inputs.irConfirmationReceived = inputSnapshot.irConfirmationReceived;
+  inputs.bombDeadlineElapsed = bomb_deadline::takeExpired();
   return inputs;
 }
 
@@ -53,6 +115,17 @@ void applyOutputs(const GameOutputs &outputs) {
     Serial.println(flameStateToString(outputs.newState));
 #endif
     effects::onStateChanged(outputs.previousState, outputs.newState);
+
+    if (outputs.newState == ARMED) {
+      bomb_deadline::arm(game_state::get_bomb_timer_duration_ms());
+    } else if (outputs.newState == DETONATED) {
+      bomb_deadline::noteDetonation();
+    } else if (outputs.previousState == ARMED) {
+      bomb_deadline::cancel();
+    }
+
+    // Tell the backend now rather than at the next heartbeat.
+    network::setOutboundStatus(outputs.newState, reportTimerMs(outputs.newState));
   }
 }
 }  // namespace
@@ -61,17 +134,79 @@ FlameState getState() { return game_state::get_state(); }
 
 void setState(FlameState newState) {
   GameOutputs outputs{};
-  game_state::set_state(newState, &outputs);
+  const uint32_t nowMs = sys_clock::frameMs();
+  game_state::default_engine().set_state(newState, nowMs, &outputs);
+  replay_log::recordSetState(newState, nowMs);
   applyOutputs(outputs);
+  publishGameStatus();
+  saveResumePointIfChanged();
+}
+
+bool resumeAfterReset() {
+  ResumePoint point;
+  if (!resume_snapshot::load(point)) {
+    return false;
+  }
+  const uint32_t nowMs = sys_clock::frameMs();
+  game_state::default_engine().resume(point, nowMs);
+  replay_log::recordResume(point, nowMs);
+  publishGameStatus();
+  if (point.state == ARMED) {
+    bomb_deadline::arm(point.bombRemainingMs);
+  } else if (point.state == DETONATED) {
+    network::requestReport();
+  }
+  saveResumePointIfChanged();
+#ifdef APP_DEBUG
+  Serial.printf("RESUME: %s, %lu ms left\n", flameStateToString(point.state),
+                static_cast<unsigned long>(point.bombRemainingMs));
+#endif
+  return true;
 }
 
-void updateState(const InputSnapshot &inputSnapshot, GameOutputs &outputs) {
-  GameInputs inputs = buildGameInputs(inputSnapshot);
+void updateState(const InputSnapshot &inputSnapshot, uint32_t nowMs, GameOutputs &outputs) {
+  // One consistent copy of the backend results per tick.
+  const network::ApiSnapshot api = network::getApiSnapshot();
+  if (api.responseCount != appliedResponseCount) {
+    appliedResponseCount = api.responseCount;
+    // The response may be stamped after this tick's frame time; never count backwards.
+    const int32_t ageMs = static_cast<int32_t>(nowMs - api.remainingTimestampMs);
+    uint32_t remainingMs = api.remainingTimeMs;
+    if (ageMs > 0) {
+      remainingMs = static_cast<uint32_t>(ageMs) >= remainingMs ? 0 : remainingMs - static_cast<uint32_t>(ageMs);
+    }
+    updateGameTimerFromApi(remainingMs, nowMs);
+  }
+  GameInputs inputs = buildGameInputs(inputSnapshot, api, nowMs);
+  const uint64_t startUs = sys_clock::nowUs();
   game_state::game_tick(inputs, outputs);
+  noteTickCost(static_cast<uint32_t>(sys_clock::nowUs() - startUs));
+  replay_log::recordTick(inputs, outputs);
   applyOutputs(outputs);
+  publishGameStatus();
+  saveResumePointIfChanged();
 }
 
-void setMatchStatus(MatchStatus status) { game_state::set_match_status(status); }
+void captureGameFrame(const GameOutputs &outputs, uint32_t nowMs, GameFrame &frame) {
+  frame.nowMs = nowMs;
+  frame.state = game_state::get_state();
+  frame.armingProgress01 = game_state::get_arming_progress(nowMs);
+  frame.showArmingConfirmPrompt = outputs.showArmingConfirmPrompt;
+  frame.irConfirmationWindowActive = game_state::is_ir_confirmation_window_active();
+  frame.gameOver = outputs.gameOver;
+  frame.enteredDigits = game_state::get_defuse_entered_digits();
+  strlcpy(frame.defuseBuffer, game_state::get_defuse_buffer(), sizeof(frame.defuseBuffer));
+  frame.bombTimerActive = game_state::is_bomb_timer_active();
+  frame.bombTimerRemainingMs = game_state::get_bomb_timer_remaining_ms();
+  frame.gameTimerValid = game_state::is_game_timer_valid();
+  frame.gameTimerRemainingMs = game_state::get_game_timer_remaining_ms();
+}
+
+void setMatchStatus(MatchStatus status) {
+  game_state::set_match_status(status);
+  replay_log::recordMatchStatus(status);
+  saveResumePointIfChanged();
+}
 
 MatchStatus getMatchStatus() { return game_state::get_match_status(); }
 
@@ -101,6 +236,16 @@ const char *getDefuseBuffer() { return game_state::get_defuse_buffer(); }
 
 float getArmingProgress(uint32_t nowMs) { return game_state::get_arming_progress(nowMs); }
 
+void dumpTickStats() {
+#ifdef APP_DEBUG
+  Serial.printf("[TICK] mode=\"%s\" ticks=%lu max=%luus over%luus=%lu\n", config_store::current().gameMode.rules,
+                static_cast<unsigned long>(tickCount.load(std::memory_order_relaxed)),
+                static_cast<unsigned long>(tickMaxUs.load(std::memory_order_relaxed)),
+                static_cast<unsigned long>(GAME_TICK_BUDGET_US),
+                static_cast<unsigned long>(ticksOverBudget.load(std::memory_order_relaxed)));
+#endif
+}
+
 const char *flameStateToString(FlameState state) { return game_state::flame_state_to_string(state); }
 
 const char *matchStatusToString(MatchStatus status) { return game_state::match_status_to_string(status); }
@@ -5,10 +5,33 @@
 #include "core/game_state.h"
 #include "inputs.h"
 
+// Game-side view handed to the UI and effects stages after every game tick. It is
+// copied through snapshot buffers so those stages never read game state directly.
+struct GameFrame {
+  uint32_t nowMs = 0;
+  FlameState state = ON;
+  float armingProgress01 = 0.0f;
+  bool showArmingConfirmPrompt = false;
+  bool irConfirmationWindowActive = false;
+  bool gameOver = false;
+  uint8_t enteredDigits = 0;
+  char defuseBuffer[DEFUSE_CODE_LENGTH + 1] = {0};
+  bool bombTimerActive = false;
+  uint32_t bombTimerRemainingMs = 0;
+  bool gameTimerValid = false;
+  uint32_t gameTimerRemainingMs = 0;
+};
+
 // Accessors and update routine
 FlameState getState();
 void setState(FlameState newState);
-void updateState(const InputSnapshot &inputSnapshot, GameOutputs &outputs);
+// Restores a round saved in RTC memory before a warm reset (see resume_snapshot.h) and
+// re-arms the bomb deadline. Returns false when there was nothing to resume.
+bool resumeAfterReset();
+// `nowMs` is the tick's frame time, not the (up to one input period old) snapshot
+// time, so a tick woken by the bomb deadline sees the deadline as reached.
+void updateState(const InputSnapshot &inputSnapshot, uint32_t nowMs, GameOutputs &outputs);
+void captureGameFrame(const GameOutputs &outputs, uint32_t nowMs, GameFrame &frame);
 
 // Match status helpers (populated by the networking layer)
 void setMatchStatus(MatchStatus status);
@@ -33,6 +56,9 @@ uint8_t getDefuseEnteredDigits();
 const char *getDefuseBuffer();
 float getArmingProgress(uint32_t nowMs);
 
+// Debug serial dump of game_tick() cost against GAME_TICK_BUDGET_US.
+void dumpTickStats();
+
 // Utility conversion helpers
 const char *flameStateToString(FlameState state);
 const char *matchStatusToString(MatchStatus status);
@@ -3,6 +3,7 @@
 #include <TFT_eSPI.h>
 #include <algorithm>
 #include <cstring>
+#include "core/clock.h"
 #include "game_config.h"
 
 namespace {
@@ -24,6 +25,8 @@ struct RenderState {
   bool hasLastScreen = false;
   ScreenMode lastScreen = ScreenMode::Boot;
   uint32_t lastRenderMs = 0;
+  uint32_t frameIntervalMs = UI_FRAME_INTERVAL_MS;
+  bool frameRequested = false;
   bool themeInitialized = false;
   UiThemeConfig theme{};
 } renderState;
@@ -33,12 +36,12 @@ struct BootCache {
   char wifiLine[96] = {0};
   char statusLine[96] = {0};
   char endpointLine[96] = {0};
+  uint32_t networkVersion = 0;
 } bootCache;
 
 struct ConfigCache {
   bool layoutDrawn = false;
-  String ssid;
-  String password;
+  uint32_t networkVersion = 0;
 } configCache;
 
 struct MainCache {
@@ -50,13 +53,12 @@ struct MainCache {
   uint16_t statusColor = TFT_BLACK;
   float armingProgress = -1.0f;
   uint16_t armingColor = TFT_BLACK;
-  char codeDisplay[32] = {0};
+  uint32_t codeVersion = 0;
   bool codeVisible = false;
   bool showArmingPrompt = false;
 #ifdef APP_DEBUG
-  char debugMatchStatus[32] = {0};
-  char debugIp[32] = {0};
-  char debugTimer[16] = {0};
+  bool debugDrawn = false;
+  uint32_t debugVersion = 0;
   int32_t debugTimerSeconds = -1;
 #endif
 } mainCache;
@@ -119,13 +121,9 @@ void markAllLayoutsDirty() {
   mainCache.statusText[0] = '\0';
   mainCache.armingProgress = -1.0f;
   mainCache.codeVisible = false;
-  mainCache.codeDisplay[0] = '\0';
   mainCache.showArmingPrompt = false;
 #ifdef APP_DEBUG
-  mainCache.debugMatchStatus[0] = '\0';
-  mainCache.debugIp[0] = '\0';
-  mainCache.debugTimer[0] = '\0';
-  mainCache.debugTimerSeconds = -1;
+  mainCache.debugDrawn = false;
 #endif
 }
 
@@ -234,6 +232,9 @@ void drawStaticLayout() {
   }
 
   mainCache.layoutDrawn = true;
+#ifdef APP_DEBUG
+  mainCache.debugDrawn = false;
+#endif
 }
 
 void formatTimeSSMM(uint32_t ms, char *buffer, size_t len) {
@@ -258,22 +259,26 @@ void formatTimeMMSS(uint32_t ms, char *buffer, size_t len) {
 }
 
 void renderBootScreen(const UiModel &model) {
+  const bool layoutWasDrawn = bootCache.layoutDrawn;
   drawBootLayout();
+  if (layoutWasDrawn && model.networkVersion == bootCache.networkVersion) {
+    return;
+  }
 
   char wifiLine[96] = {0};
   if (model.wifiFailed) {
-    const char *apName = model.configApSsid.isEmpty() ? "config AP" : model.configApSsid.c_str();
+    const char *apName = model.configApSsid[0] == '\0' ? "config AP" : model.configApSsid;
     snprintf(wifiLine, sizeof(wifiLine), "failed → AP %s", apName);
   } else if (model.wifiConnected) {
-    const char *ipValue = model.ipAddress.isEmpty() ? "IP pending" : model.ipAddress.c_str();
+    const char *ipValue = model.ipAddress[0] == '\0' ? "IP pending" : model.ipAddress;
     snprintf(wifiLine, sizeof(wifiLine), "connected (%s)", ipValue);
   } else {
-    snprintf(wifiLine, sizeof(wifiLine), "connecting to %s", model.wifiSsid.c_str());
+    snprintf(wifiLine, sizeof(wifiLine), "connecting to %s", model.wifiSsid);
   }
 
   char apiStatusValue[96] = {0};
   if (model.wifiFailed) {
-    const char *address = model.configApAddress.isEmpty() ? "http://192.168.4.1" : model.configApAddress.c_str();
+    const char *address = model.configApAddress[0] == '\0' ? "http://192.168.4.1" : model.configApAddress;
     snprintf(apiStatusValue, sizeof(apiStatusValue), "Open %s to configure", address);
   } else if (model.hasApiResponse) {
     strlcpy(apiStatusValue, "API response received", sizeof(apiStatusValue));
@@ -283,8 +288,8 @@ void renderBootScreen(const UiModel &model) {
 
   drawBootBlock("WiFi:", wifiLine, 60, STATUS_TEXT_SIZE, BOOT_DETAIL_TEXT_SIZE, bootCache.wifiLine);
   drawBootBlock("Status:", apiStatusValue, 95, STATUS_TEXT_SIZE, BOOT_DETAIL_TEXT_SIZE, bootCache.statusLine);
-  drawBootBlock("Endpoint:", model.apiEndpoint.c_str(), 150, STATUS_TEXT_SIZE, BOOT_DETAIL_TEXT_SIZE,
-                bootCache.endpointLine);
+  drawBootBlock("Endpoint:", model.apiEndpoint, 150, STATUS_TEXT_SIZE, BOOT_DETAIL_TEXT_SIZE, bootCache.endpointLine);
+  bootCache.networkVersion = model.networkVersion;
 }
 
 void renderConfigPortalScreen(const UiModel &model) {
@@ -296,32 +301,20 @@ void renderConfigPortalScreen(const UiModel &model) {
 
     tft.setTextSize(STATUS_TEXT_SIZE);
     tft.drawString("Connect to:", 10, 50);
-    tft.drawString(model.configApSsid, 10, 70);
-
     tft.drawString("Password:", 10, 100);
-    tft.drawString(model.configApPassword, 10, 120);
 
     configCache.layoutDrawn = true;
-    configCache.ssid = model.configApSsid;
-    configCache.password = model.configApPassword;
+  } else if (model.networkVersion == configCache.networkVersion) {
     return;
   }
 
-  if (model.configApSsid != configCache.ssid) {
-    tft.fillRect(0, 70, tft.width(), STATUS_TEXT_SIZE * 10, activeTheme.backgroundColor);
-    tft.setTextDatum(TL_DATUM);
-    tft.setTextSize(STATUS_TEXT_SIZE);
-    tft.drawString(model.configApSsid, 10, 70);
-    configCache.ssid = model.configApSsid;
-  }
-
-  if (model.configApPassword != configCache.password) {
-    tft.fillRect(0, 120, tft.width(), STATUS_TEXT_SIZE * 10, activeTheme.backgroundColor);
-    tft.setTextDatum(TL_DATUM);
-    tft.setTextSize(STATUS_TEXT_SIZE);
-    tft.drawString(model.configApPassword, 10, 120);
-    configCache.password = model.configApPassword;
-  }
+  tft.fillRect(0, 70, tft.width(), STATUS_TEXT_SIZE * 10, activeTheme.backgroundColor);
+  tft.fillRect(0, 120, tft.width(), STATUS_TEXT_SIZE * 10, activeTheme.backgroundColor);
+  tft.setTextDatum(TL_DATUM);
+  tft.setTextSize(STATUS_TEXT_SIZE);
+  tft.drawString(model.configApSsid, 10, 70);
+  tft.drawString(model.configApPassword, 10, 120);
+  configCache.networkVersion = model.networkVersion;
 }
 
 void renderMainUi(const UiModel &model) {
@@ -410,12 +403,13 @@ void renderMainUi(const UiModel &model) {
     mainCache.armingColor = armingColor;
   }
 
-  if (model.state == ARMED) {
+  if (model.state == ARMED && (!mainCache.codeVisible || model.codeVersion != mainCache.codeVersion)) {
     char codeDisplay[32] = {0};
+    const size_t bufferLength = strnlen(model.defuseBuffer, sizeof(model.defuseBuffer));
     size_t idx = 0;
     for (uint8_t i = 0; i < model.codeLength && idx + 1 < sizeof(codeDisplay); ++i) {
       char toWrite = '_';
-      if (i < model.defuseBuffer.length()) {
+      if (i < bufferLength) {
         toWrite = model.defuseBuffer[i];
       } else if (i < model.enteredDigits) {
         toWrite = '_';
@@ -427,15 +421,12 @@ void renderMainUi(const UiModel &model) {
     }
     codeDisplay[idx] = '\0';
 
-    if (!mainCache.codeVisible || strncmp(codeDisplay, mainCache.codeDisplay, sizeof(mainCache.codeDisplay)) != 0) {
-      drawCenteredText(codeDisplay, CODE_Y, CODE_TEXT_SIZE, 24, activeTheme.foregroundColor);
-      strlcpy(mainCache.codeDisplay, codeDisplay, sizeof(mainCache.codeDisplay));
-      mainCache.codeVisible = true;
-    }
-  } else if (mainCache.codeVisible) {
+    drawCenteredText(codeDisplay, CODE_Y, CODE_TEXT_SIZE, 24, activeTheme.foregroundColor);
+    mainCache.codeVersion = model.codeVersion;
+    mainCache.codeVisible = true;
+  } else if (model.state != ARMED && mainCache.codeVisible) {
     tft.fillRect(0, CODE_Y - 16, tft.width(), 32, activeTheme.backgroundColor);
     mainCache.codeVisible = false;
-    mainCache.codeDisplay[0] = '\0';
   }
 
 #ifdef APP_DEBUG
@@ -452,8 +443,7 @@ void renderMainUi(const UiModel &model) {
     strlcpy(debugTimerValue, "--:--", sizeof(debugTimerValue));
   }
 
-  if (strncmp(model.debugMatchStatus.c_str(), mainCache.debugMatchStatus, sizeof(mainCache.debugMatchStatus)) != 0 ||
-      strncmp(model.debugIp.c_str(), mainCache.debugIp, sizeof(mainCache.debugIp)) != 0 ||
+  if (!mainCache.debugDrawn || model.debugVersion != mainCache.debugVersion ||
       debugTimerSeconds != mainCache.debugTimerSeconds) {
     tft.fillRect(0, debugY, tft.width(), debugHeight, activeTheme.backgroundColor);
     tft.setTextSize(1);
@@ -466,9 +456,8 @@ void renderMainUi(const UiModel &model) {
     char timerLine[16] = {0};
     snprintf(timerLine, sizeof(timerLine), "T %s", debugTimerValue);
     tft.drawString(timerLine, tft.width() - 2, tft.height() - 2);
-    strlcpy(mainCache.debugMatchStatus, model.debugMatchStatus.c_str(), sizeof(mainCache.debugMatchStatus));
-    strlcpy(mainCache.debugIp, model.debugIp.c_str(), sizeof(mainCache.debugIp));
-    strlcpy(mainCache.debugTimer, debugTimerValue, sizeof(mainCache.debugTimer));
+    mainCache.debugDrawn = true;
+    mainCache.debugVersion = model.debugVersion;
     mainCache.debugTimerSeconds = debugTimerSeconds;
   }
 #endif
@@ -505,9 +494,9 @@ void render(const UiModel &model) {
   }
 
   const bool screenChanged = !renderState.hasLastScreen || renderState.lastScreen != currentScreen;
-  const uint32_t now = millis();
-  if (!screenChanged && !themeChanged && renderState.hasLastScreen &&
-      (now - renderState.lastRenderMs) < UI_FRAME_INTERVAL_MS) {
+  const uint32_t now = sys_clock::frameMs();
+  if (!screenChanged && !themeChanged && !renderState.frameRequested && renderState.hasLastScreen &&
+      (now - renderState.lastRenderMs) < renderState.frameIntervalMs) {
     return;
   }
 
@@ -530,6 +519,11 @@ void render(const UiModel &model) {
   renderState.lastScreen = currentScreen;
   renderState.hasLastScreen = true;
   renderState.lastRenderMs = now;
+  renderState.frameRequested = false;
 }
 
+void requestFrame() { renderState.frameRequested = true; }
+
+void setFrameIntervalMs(uint32_t intervalMs) { renderState.frameIntervalMs = intervalMs; }
+
 }  // namespace ui
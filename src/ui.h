@@ -2,6 +2,7 @@
 
 #include <Arduino.h>
 
+#include "core/config_store.h"
 #include "state_machine.h"
 
 struct UiThemeConfig {
@@ -14,7 +15,14 @@ struct UiThemeConfig {
   uint16_t armingBarRed;
 };
 
+// Text lives in fixed buffers owned by the model, which the UI task keeps and refills
+// only when a source changes. Each group of text fields carries a version that is
+// bumped whenever any field in the group is rewritten; render() redraws a section only
+// when the version differs from the one it last drew.
 struct UiModel {
+  static constexpr size_t kIpTextLength = 16;                      // "255.255.255.255"
+  static constexpr size_t kAddressTextLength = 7 + kIpTextLength;  // "http://" + IP
+
   bool showBootScreen = false;
   bool showConfigPortal = false;
   bool showArmingPrompt = false;
@@ -28,20 +36,23 @@ struct UiModel {
   float armingProgress01 = 0.0f;
   uint8_t codeLength = DEFUSE_CODE_LENGTH;
   uint8_t enteredDigits = 0;
-  String defuseBuffer;
+  char defuseBuffer[DEFUSE_CODE_LENGTH + 1] = {0};
+  uint32_t codeVersion = 0;  // defuseBuffer, enteredDigits
 
-  String wifiSsid;
+  char wifiSsid[ConfigSnapshot::kMaxSsidLength + 1] = {0};
   bool wifiConnected = false;
   bool wifiFailed = false;
-  String configApSsid;
-  String configApAddress;
-  String configApPassword;
-  String ipAddress;
-  String apiEndpoint;
+  char configApSsid[ConfigSnapshot::kMaxSsidLength + 1] = {0};
+  char configApAddress[kAddressTextLength] = {0};
+  char configApPassword[ConfigSnapshot::kMaxPasswordLength + 1] = {0};
+  char ipAddress[kIpTextLength] = {0};
+  char apiEndpoint[ConfigSnapshot::kMaxEndpointLength + 1] = {0};
   bool hasApiResponse = false;
+  uint32_t networkVersion = 0;  // Everything from wifiSsid to hasApiResponse.
 
-  String debugIp;
-  String debugMatchStatus;
+  char debugIp[kIpTextLength] = {0};
+  char debugMatchStatus[32] = {0};
+  uint32_t debugVersion = 0;  // debugIp, debugMatchStatus
   bool debugTimerValid = false;
   uint32_t debugTimerRemainingMs = 0;
 
@@ -53,4 +64,10 @@ UiThemeConfig defaultTheme();
 
 void initUI();
 void render(const UiModel &model);
+
+// Bypasses the frame interval throttle for the next render() call.
+void requestFrame();
+
+// Minimum time between unrequested frames; defaults to UI_FRAME_INTERVAL_MS.
+void setFrameIntervalMs(uint32_t intervalMs);
 }  // namespace ui
@@ -0,0 +1,22 @@
+#pragma once
+
+// Host stand-in for the parts of Arduino.h that the portable core/ modules and
+// api_session.cpp see in the native test build. Anything that needs more than this is
+// not portable.
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define IRAM_ATTR
+
+// Provided by newlib on the prop; glibc before 2.38 lacks it.
+inline size_t host_strlcpy(char *destination, const char *source, size_t size) {
+  const size_t length = strlen(source);
+  if (size > 0) {
+    const size_t copied = length < size - 1 ? length : size - 1;
+    memcpy(destination, source, copied);
+    destination[copied] = '\0';
+  }
+  return length;
+}
+#define strlcpy host_strlcpy
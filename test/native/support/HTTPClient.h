@@ -0,0 +1,30 @@
+#pragma once
+
+// Host stand-in for the blocking HTTPClient that api_session.cpp falls back to for
+// https:// endpoints. There is no TLS on the host: begin() always fails, so the
+// fallback reports a refused connection.
+#include <stdint.h>
+
+#include <string>
+
+#define HTTP_CODE_OK 200
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+
+class String {
+ public:
+  String(const char *text = "") : value(text) {}
+  const char *c_str() const { return value.c_str(); }
+
+ private:
+  std::string value;
+};
+
+class HTTPClient {
+ public:
+  bool begin(const char *) { return false; }
+  void setTimeout(uint32_t) {}
+  void addHeader(const char *, const char *) {}
+  int POST(const String &) { return HTTPC_ERROR_CONNECTION_REFUSED; }
+  String getString() { return String(); }
+  void end() {}
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+// Host stand-in for the WiFi calls api_session.cpp makes: IPAddress and a name lookup
+// that resolves every host to 127.0.0.1 (where LoopbackServer listens) and counts the
+// lookups, so a test can check that a session resolves its host once.
+#include <arpa/inet.h>
+#include <stdint.h>
+
+class IPAddress {
+ public:
+  IPAddress() = default;
+  explicit IPAddress(uint32_t address) : raw(address) {}
+
+  // Dotted quad only, as on the prop.
+  bool fromString(const char *text) {
+    in_addr parsed;
+    if (inet_pton(AF_INET, text, &parsed) != 1) {
+      return false;
+    }
+    raw = parsed.s_addr;
+    return true;
+  }
+
+  // Network byte order, as a sockaddr_in wants it.
+  operator uint32_t() const { return raw; }
+
+ private:
+  uint32_t raw = 0;
+};
+
+namespace host_wifi {
+struct State {
+  uint32_t lookups = 0;
+  bool resolves = true;
+};
+
+inline State &state() {
+  static State instance;
+  return instance;
+}
+}  // namespace host_wifi
+
+class HostWiFi {
+ public:
+  int hostByName(const char *, IPAddress &result) {
+    ++host_wifi::state().lookups;
+    if (!host_wifi::state().resolves) {
+      return 0;
+    }
+    result = IPAddress(inet_addr("127.0.0.1"));
+    return 1;
+  }
+};
+
+namespace host_wifi {
+inline HostWiFi &wifi() {
+  static HostWiFi instance;
+  return instance;
+}
+}  // namespace host_wifi
+
+#define WiFi (host_wifi::wifi())
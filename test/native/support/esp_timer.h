@@ -0,0 +1,86 @@
+#pragma once
+
+// Host stand-in for the one-shot esp_timer calls used by bomb_deadline.cpp. Nothing
+// fires on its own: a test calls host_esp_timer::fire() to run the callback of the
+// started timer as the esp_timer task would, at a moment of its choosing.
+#include <stdint.h>
+
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+
+typedef void (*esp_timer_cb_t)(void *arg);
+
+typedef enum { ESP_TIMER_TASK } esp_timer_dispatch_t;
+
+typedef struct {
+  esp_timer_cb_t callback;
+  void *arg;
+  esp_timer_dispatch_t dispatch_method;
+  const char *name;
+  bool skip_unhandled_events;
+} esp_timer_create_args_t;
+
+namespace host_esp_timer {
+struct Timer {
+  esp_timer_cb_t callback = nullptr;
+  void *arg = nullptr;
+  bool running = false;
+  uint64_t timeoutUs = 0;
+  uint32_t starts = 0;
+  uint32_t stops = 0;
+};
+
+inline Timer &timer() {
+  static Timer instance;
+  return instance;
+}
+
+// Runs the callback if the timer is started, as its expiry would; false otherwise.
+inline bool fire() {
+  Timer &t = timer();
+  if (!t.running) {
+    return false;
+  }
+  t.running = false;
+  t.callback(t.arg);
+  return true;
+}
+
+// Runs the callback whatever the timer's state, as when the esp_timer task had already
+// taken the expiry before esp_timer_stop() got to it.
+inline void dispatchLate() {
+  Timer &t = timer();
+  t.running = false;
+  t.callback(t.arg);
+}
+}  // namespace host_esp_timer
+
+typedef host_esp_timer::Timer *esp_timer_handle_t;
+
+inline esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *handle) {
+  host_esp_timer::Timer &t = host_esp_timer::timer();
+  t.callback = args->callback;
+  t.arg = args->arg;
+  *handle = &t;
+  return ESP_OK;
+}
+
+inline esp_err_t esp_timer_start_once(esp_timer_handle_t handle, uint64_t timeoutUs) {
+  if (handle->running) {
+    return ESP_FAIL;  // The IDF rejects starting a running timer too.
+  }
+  handle->running = true;
+  handle->timeoutUs = timeoutUs;
+  ++handle->starts;
+  return ESP_OK;
+}
+
+inline esp_err_t esp_timer_stop(esp_timer_handle_t handle) {
+  if (!handle->running) {
+    return ESP_FAIL;
+  }
+  handle->running = false;
+  ++handle->stops;
+  return ESP_OK;
+}
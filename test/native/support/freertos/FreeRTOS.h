@@ -0,0 +1,15 @@
+#pragma once
+
+// Host stand-in for the FreeRTOS types and macros used by core/scheduler.cpp. The tick
+// rate matches the ESP32 build (1 kHz), so ticks and milliseconds are the same.
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef void *TaskHandle_t;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define portYIELD_FROM_ISR()
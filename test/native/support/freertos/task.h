@@ -0,0 +1,48 @@
+#pragma once
+
+// Host stand-in for FreeRTOS task notifications with a single simulated task. A take
+// that would block calls the test's onBlock hook with the requested wait instead of
+// sleeping, which is where a virtual clock advances.
+#include <atomic>
+
+#include "freertos/FreeRTOS.h"
+
+namespace host_rtos {
+struct State {
+  std::atomic<uint32_t> notifications{0};
+  uint32_t takes = 0;
+  TickType_t lastWaitTicks = 0;
+  void (*onBlock)(TickType_t waitTicks) = nullptr;
+};
+
+inline State &state() {
+  static State instance;
+  return instance;
+}
+}  // namespace host_rtos
+
+inline TaskHandle_t xTaskGetCurrentTaskHandle() { return &host_rtos::state(); }
+
+inline BaseType_t xTaskNotifyGive(TaskHandle_t) {
+  host_rtos::state().notifications.fetch_add(1);
+  return pdTRUE;
+}
+
+inline void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *higherPriorityTaskWoken) {
+  xTaskNotifyGive(task);
+  if (higherPriorityTaskWoken != nullptr) {
+    *higherPriorityTaskWoken = pdFALSE;
+  }
+}
+
+inline uint32_t ulTaskNotifyTake(BaseType_t clearCountOnExit, TickType_t waitTicks) {
+  host_rtos::State &state = host_rtos::state();
+  ++state.takes;
+  state.lastWaitTicks = waitTicks;
+  if (state.notifications.load() == 0 && state.onBlock != nullptr) {
+    state.onBlock(waitTicks);
+  }
+  const uint32_t value = state.notifications.load();
+  state.notifications.store(clearCountOnExit == pdTRUE || value == 0 ? 0 : value - 1);
+  return value;
+}
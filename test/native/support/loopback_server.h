@@ -0,0 +1,170 @@
+#pragma once
+
+// Scripted stand-in for the backend in native tests: an HTTP/1.1 server on 127.0.0.1
+// with an ephemeral port, run on its own thread. It reads each request (headers and a
+// Content-Length body) and hands it to the test's responder, which writes whatever
+// bytes it likes back, in pieces and with pauses if it wants, and decides whether the
+// connection stays open.
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <thread>
+
+class LoopbackServer {
+ public:
+  struct Request {
+    uint32_t connection;  // 1 for the first accepted connection.
+    uint32_t index;       // 1 for the first request overall.
+    std::string head;     // Request line and headers.
+    std::string body;
+  };
+
+  enum class After : uint8_t { KeepOpen, Close };
+
+  // Writes the response to `fd` (see sendText()); returning Close ends the connection.
+  using Responder = std::function<After(int fd, const Request &request)>;
+
+  explicit LoopbackServer(Responder responder) : respond(std::move(responder)) {
+    listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    const int reuse = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = inet_addr("127.0.0.1");
+    address.sin_port = 0;
+    bind(listenFd, reinterpret_cast<const sockaddr *>(&address), sizeof(address));
+    listen(listenFd, 8);
+    socklen_t length = sizeof(address);
+    getsockname(listenFd, reinterpret_cast<sockaddr *>(&address), &length);
+    listenPort = ntohs(address.sin_port);
+    worker = std::thread([this]() { serve(); });
+  }
+
+  ~LoopbackServer() {
+    stopping.store(true);
+    worker.join();
+    close(listenFd);
+  }
+
+  LoopbackServer(const LoopbackServer &) = delete;
+  LoopbackServer &operator=(const LoopbackServer &) = delete;
+
+  uint16_t port() const { return listenPort; }
+  uint32_t connections() const { return accepted.load(); }
+  uint32_t requests() const { return served.load(); }
+
+  static void sendText(int fd, const char *text) { sendBytes(fd, text, strlen(text)); }
+
+  static void sendBytes(int fd, const char *data, size_t length) {
+    while (length > 0) {
+      const ssize_t sent = send(fd, data, length, MSG_NOSIGNAL);
+      if (sent <= 0) {
+        return;
+      }
+      data += sent;
+      length -= static_cast<size_t>(sent);
+    }
+  }
+
+  // Sends `text` in `pieces` writes with `gapMs` between them, so the client sees split reads.
+  static void trickle(int fd, const char *text, size_t pieces, uint32_t gapMs) {
+    const size_t length = strlen(text);
+    const size_t step = (length + pieces - 1) / pieces;
+    for (size_t offset = 0; offset < length; offset += step) {
+      sendBytes(fd, text + offset, offset + step < length ? step : length - offset);
+      std::this_thread::sleep_for(std::chrono::milliseconds(gapMs));
+    }
+  }
+
+ private:
+  // Waits up to 10 ms for `fd` to become readable; false while the server is stopping.
+  bool waitReadable(int fd) {
+    pollfd entry = {fd, POLLIN, 0};
+    while (!stopping.load()) {
+      if (::poll(&entry, 1, 10) > 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void serve() {
+    while (waitReadable(listenFd)) {
+      const int fd = accept(listenFd, nullptr, nullptr);
+      if (fd < 0) {
+        continue;
+      }
+      const int noDelay = 1;
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+      const uint32_t connection = ++accepted;
+      handleConnection(fd, connection);
+      close(fd);
+    }
+  }
+
+  // One connection at a time is enough for a client with a single in-flight slot.
+  void handleConnection(int fd, uint32_t connection) {
+    std::string pending;
+    for (;;) {
+      Request request;
+      request.connection = connection;
+      size_t headEnd;
+      while ((headEnd = pending.find("\r\n\r\n")) == std::string::npos) {
+        if (!readMore(fd, pending)) {
+          return;
+        }
+      }
+      request.head = pending.substr(0, headEnd + 4);
+      size_t bodyLength = 0;
+      const char *lengthHeader = strcasestr(request.head.c_str(), "\r\nContent-Length:");
+      if (lengthHeader != nullptr) {
+        bodyLength = strtoul(lengthHeader + 17, nullptr, 10);
+      }
+      while (pending.size() < headEnd + 4 + bodyLength) {
+        if (!readMore(fd, pending)) {
+          return;
+        }
+      }
+      request.body = pending.substr(headEnd + 4, bodyLength);
+      pending.erase(0, headEnd + 4 + bodyLength);
+      request.index = ++served;
+      if (respond(fd, request) == After::Close) {
+        return;
+      }
+    }
+  }
+
+  bool readMore(int fd, std::string &pending) {
+    if (!waitReadable(fd)) {
+      return false;
+    }
+    char buffer[512];
+    const ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+    if (received <= 0) {
+      return false;
+    }
+    pending.append(buffer, static_cast<size_t>(received));
+    return true;
+  }
+
+  Responder respond;
+  int listenFd = -1;
+  uint16_t listenPort = 0;
+  std::atomic<bool> stopping{false};
+  std::atomic<uint32_t> accepted{0};
+  std::atomic<uint32_t> served{0};
+  std::thread worker;
+};
@@ -0,0 +1,147 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unity.h>
+
+#include <atomic>
+#include <new>
+#include <vector>
+
+#include "core/config_store.h"
+#include "core/game_recorder.h"
+#include "core/soak_sim.h"
+
+// Counts heap allocations made through operator new, and through malloc() where the C
+// library lets the test wrap it (glibc), to show the per-tick game path allocates nothing.
+namespace {
+std::atomic<uint32_t> allocations(0);
+}  // namespace
+
+#ifdef __GLIBC__
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *pointer, size_t size);
+
+void *malloc(size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  return __libc_calloc(count, size);
+}
+
+void *realloc(void *pointer, size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  return __libc_realloc(pointer, size);
+}
+}
+#endif
+
+// Out of line so GCC does not pair the inlined malloc() with a delete and warn.
+__attribute__((noinline)) void *operator new(size_t size) {
+#ifndef __GLIBC__
+  allocations.fetch_add(1, std::memory_order_relaxed);  // Otherwise malloc() counts it.
+#endif
+  void *pointer = malloc(size == 0 ? 1 : size);
+  if (pointer == nullptr) {
+    throw std::bad_alloc();
+  }
+  return pointer;
+}
+
+void *operator new[](size_t size) { return operator new(size); }
+
+__attribute__((noinline)) void operator delete(void *pointer) noexcept { free(pointer); }
+
+void operator delete[](void *pointer) noexcept { operator delete(pointer); }
+
+void operator delete(void *pointer, size_t) noexcept { operator delete(pointer); }
+
+void operator delete[](void *pointer, size_t) noexcept { operator delete(pointer); }
+
+namespace {
+game_recorder::Recorder recorder;
+soak_sim::Simulator simulator;
+uint8_t sinkBuffer[game_recorder::Recorder::kRingBytes];
+size_t codeLengths = 0;
+
+size_t discardLog(const uint8_t *data, size_t length) {
+  memcpy(sinkBuffer, data, length < sizeof(sinkBuffer) ? length : sizeof(sinkBuffer));
+  return length;
+}
+
+// What the prop does around each tick: one config snapshot read (buildGameInputs), the
+// recorder, and a drain every so often (the flush task).
+void recordTick(void *, const GameInputs &inputs, const GameOutputs &outputs) {
+  const ConfigSnapshot &config = config_store::current();
+  codeLengths += strlen(config.defuseCode);
+  recorder.recordTick(inputs, outputs);
+  if (recorder.pendingBytes() > game_recorder::Recorder::kRingBytes / 2) {
+    recorder.drain(discardLog);
+  }
+}
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_counter_sees_allocations() {
+  const uint32_t before = allocations.load();
+  {
+    std::vector<uint32_t> values(16);
+    TEST_ASSERT_EQUAL_UINT32(before + 1, allocations.load());
+  }
+}
+
+void test_config_snapshot_reads_and_publishes_do_not_allocate() {
+  ConfigSnapshot next;
+  TEST_ASSERT_TRUE(config_store::assign(next.defuseCode, "4711"));
+  TEST_ASSERT_TRUE(config_store::assign(next.apiEndpoint, "http://192.168.4.2:8080/api/prop"));
+
+  const uint32_t before = allocations.load();
+  for (uint32_t i = 0; i < 1000; ++i) {
+    next.bombDurationMs = i;
+    const ConfigSnapshot &published = config_store::publish(next);
+    TEST_ASSERT_EQUAL_UINT32(i, config_store::current().bombDurationMs);
+    TEST_ASSERT_EQUAL_STRING("4711", published.defuseCode);
+  }
+  TEST_ASSERT_EQUAL_UINT32(before, allocations.load());
+}
+
+void test_game_tick_and_recorder_do_not_allocate() {
+  ConfigSnapshot next;
+  config_store::assign(next.defuseCode, "4711");
+  config_store::publish(next);
+
+  soak_sim::Config config;
+  config.seed = 5;
+  config.matches = 20;
+  config.minRunningMs = 30000;
+  config.maxRunningMs = 120000;
+  recorder.start();
+  simulator.observeTicks(recordTick, nullptr);
+  simulator.reset(config);
+  simulator.step(1000);  // Warm-up: the first ticks record the session header.
+
+  const uint32_t before = allocations.load();
+  while (simulator.step(10000)) {
+  }
+  recorder.drain(discardLog);
+  TEST_ASSERT_EQUAL_UINT32(before, allocations.load());
+
+  TEST_ASSERT_TRUE(simulator.report().ticks > 100000);
+  TEST_ASSERT_EQUAL_UINT32(0, simulator.report().violations);
+  TEST_ASSERT_EQUAL_UINT32(0, recorder.droppedRecords());
+  TEST_ASSERT_TRUE(codeLengths > 0);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_counter_sees_allocations);
+  RUN_TEST(test_config_snapshot_reads_and_publishes_do_not_allocate);
+  RUN_TEST(test_game_tick_and_recorder_do_not_allocate);
+  return UNITY_END();
+}
@@ -0,0 +1,129 @@
+#include <WiFi.h>
+#include <stdio.h>
+#include <unity.h>
+
+#include <chrono>
+#include <thread>
+
+#include "api_session.h"
+#include "core/clock.h"
+#include "core/config_store.h"
+#include "loopback_server.h"
+
+// api_session against LoopbackServer, driven as the ApiTask drives it: submit, then
+// poll and wait on the socket until the report completes. The module keeps its
+// counters across tests, so each test compares against the stats it starts from.
+namespace {
+constexpr uint32_t kReports = 50;
+constexpr uint32_t kServerDelayMs = 2;
+const char kReport[] = "{\"state\":\"ARMED\",\"timer\":31000}";
+const char kOk[] = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: 11\r\n\r\n{\"ok\":true}";
+const char kOkThenClose[] =
+    "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: 11\r\nConnection: close\r\n\r\n"
+    "{\"ok\":true}";
+
+// Publishes `url` as the backend endpoint.
+void useEndpoint(const char *urlFormat, uint16_t port) {
+  ConfigSnapshot next = config_store::current();
+  snprintf(next.apiEndpoint, sizeof(next.apiEndpoint), urlFormat, static_cast<unsigned>(port));
+  config_store::publish(next);
+}
+
+api_session::Result report() {
+  api_session::submit(kReport, sizeof(kReport) - 1, sys_clock::nowMs());
+  api_session::Result result;
+  while ((result = api_session::poll(sys_clock::nowMs())) == api_session::Result::Pending) {
+    api_session::waitForActivity(5);
+  }
+  return result;
+}
+
+// Answers every request after kServerDelayMs, keeping the connection open or saying
+// that it closes.
+LoopbackServer::Responder replyAfterDelay(LoopbackServer::After after) {
+  return [after](int fd, const LoopbackServer::Request &) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(kServerDelayMs));
+    LoopbackServer::sendText(fd, after == LoopbackServer::After::Close ? kOkThenClose : kOk);
+    return after;
+  };
+}
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_session_keeps_one_connection_and_one_lookup() {
+  LoopbackServer server(replyAfterDelay(LoopbackServer::After::KeepOpen));
+  useEndpoint("http://backend.test:%u/api/prop", server.port());
+  const api_session::Stats before = api_session::getStats();
+  const uint32_t lookups = host_wifi::state().lookups;
+
+  for (uint32_t i = 0; i < kReports; ++i) {
+    TEST_ASSERT_EQUAL(api_session::Result::Answered, report());
+    TEST_ASSERT_EQUAL_INT(200, api_session::statusCode());
+    TEST_ASSERT_EQUAL_STRING("{\"ok\":true}", api_session::responseBody());
+  }
+
+  const api_session::Stats after = api_session::getStats();
+  TEST_ASSERT_EQUAL_UINT32(kReports, server.requests());
+  TEST_ASSERT_EQUAL_UINT32(1, server.connections());
+  TEST_ASSERT_EQUAL_UINT32(before.requests + kReports, after.requests);
+  TEST_ASSERT_EQUAL_UINT32(before.reused + kReports - 1, after.reused);
+  TEST_ASSERT_EQUAL_UINT32(before.connects + 1, after.connects);
+  TEST_ASSERT_EQUAL_UINT32(before.dnsLookups + 1, after.dnsLookups);
+  TEST_ASSERT_EQUAL_UINT32(lookups + 1, host_wifi::state().lookups);
+  TEST_ASSERT_EQUAL_UINT32(before.failures, after.failures);
+
+  // Every round trip includes the server's delay; none comes near the deadline.
+  TEST_ASSERT_TRUE(after.avgRttMs >= kServerDelayMs);
+  TEST_ASSERT_TRUE(after.maxRttMs >= after.avgRttMs);
+  TEST_ASSERT_TRUE(after.maxRttMs < API_HTTP_TIMEOUT_MS);
+
+  char message[96];
+  snprintf(message, sizeof(message), "%lu reports, rtt avg %lu ms, max %lu ms",
+           static_cast<unsigned long>(kReports), static_cast<unsigned long>(after.avgRttMs),
+           static_cast<unsigned long>(after.maxRttMs));
+  TEST_MESSAGE(message);
+}
+
+// A server that closes after each response costs a connect per report, but the
+// address is still looked up only once per endpoint.
+void test_closed_connections_reconnect_without_a_new_lookup() {
+  LoopbackServer server(replyAfterDelay(LoopbackServer::After::Close));
+  useEndpoint("http://backend.test:%u/api/prop", server.port());
+  const api_session::Stats before = api_session::getStats();
+
+  for (uint32_t i = 0; i < kReports; ++i) {
+    TEST_ASSERT_EQUAL(api_session::Result::Answered, report());
+  }
+
+  const api_session::Stats after = api_session::getStats();
+  TEST_ASSERT_EQUAL_UINT32(kReports, server.connections());
+  TEST_ASSERT_EQUAL_UINT32(before.reused, after.reused);
+  TEST_ASSERT_EQUAL_UINT32(before.connects + kReports, after.connects);
+  TEST_ASSERT_EQUAL_UINT32(before.dnsLookups + 1, after.dnsLookups);
+  TEST_ASSERT_EQUAL_UINT32(before.failures, after.failures);
+}
+
+void test_literal_address_needs_no_lookup() {
+  LoopbackServer server(replyAfterDelay(LoopbackServer::After::KeepOpen));
+  useEndpoint("http://127.0.0.1:%u/api/prop", server.port());
+  const api_session::Stats before = api_session::getStats();
+
+  TEST_ASSERT_EQUAL(api_session::Result::Answered, report());
+  TEST_ASSERT_EQUAL(api_session::Result::Answered, report());
+
+  const api_session::Stats after = api_session::getStats();
+  TEST_ASSERT_EQUAL_UINT32(before.dnsLookups, after.dnsLookups);
+  TEST_ASSERT_EQUAL_UINT32(before.reused + 1, after.reused);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_session_keeps_one_connection_and_one_lookup);
+  RUN_TEST(test_closed_connections_reconnect_without_a_new_lookup);
+  RUN_TEST(test_literal_address_needs_no_lookup);
+  api_session::reset();
+  return UNITY_END();
+}
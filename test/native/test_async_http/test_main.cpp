@@ -0,0 +1,295 @@
+#include <arpa/inet.h>
+#include <stdio.h>
+#include <unity.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "core/async_http.h"
+#include "core/clock.h"
+#include "loopback_server.h"
+
+// AsyncHttpClient against LoopbackServer: the client is driven the way api_session
+// drives it from the ApiTask, polling and waiting on the socket between polls.
+namespace {
+constexpr uint32_t kTimeoutMs = 2000;
+const char kReport[] = "{\"state\":\"ARMED\",\"remaining\":31000}";
+const char kOk[] = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: 11\r\n\r\n{\"ok\":true}";
+
+AsyncHttpClient::Target targetFor(const LoopbackServer &server) {
+  AsyncHttpClient::Target target;
+  target.address = inet_addr("127.0.0.1");
+  target.port = server.port();
+  target.host = "127.0.0.1";
+  target.path = "/api/prop";
+  return target;
+}
+
+// Runs one POST to completion (or failure) and returns its final phase.
+AsyncHttpClient::Phase post(AsyncHttpClient &client, const AsyncHttpClient::Target &target,
+                            uint32_t timeoutMs = kTimeoutMs) {
+  if (!client.startPost(target, kReport, sizeof(kReport) - 1, sys_clock::nowMs(), timeoutMs)) {
+    return client.phase();
+  }
+  while (client.poll(sys_clock::nowMs()) != AsyncHttpClient::Phase::Done &&
+         client.phase() != AsyncHttpClient::Phase::Failed) {
+    client.waitForActivity(5);
+  }
+  return client.phase();
+}
+
+// A server that answers every request with `response`, written in `pieces` parts.
+LoopbackServer::Responder replyWith(const char *response, size_t pieces = 1) {
+  return [response, pieces](int fd, const LoopbackServer::Request &) {
+    LoopbackServer::trickle(fd, response, pieces, pieces > 1 ? 1 : 0);
+    return LoopbackServer::After::KeepOpen;
+  };
+}
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+// The session keeps one connection across polls; report the round trip it buys.
+void test_keep_alive_reuses_one_connection() {
+  constexpr uint32_t kPolls = 200;
+  LoopbackServer server([](int fd, const LoopbackServer::Request &) {
+    LoopbackServer::sendText(fd, kOk);
+    return LoopbackServer::After::KeepOpen;
+  });
+  AsyncHttpClient client;
+  const AsyncHttpClient::Target target = targetFor(server);
+
+  uint64_t totalUs = 0;
+  uint64_t maxUs = 0;
+  uint32_t reused = 0;
+  for (uint32_t i = 0; i < kPolls; ++i) {
+    const uint64_t startUs = sys_clock::nowUs();
+    TEST_ASSERT_EQUAL(AsyncHttpClient::Phase::Done, post(client, target));
+    const uint64_t rttUs = sys_clock::nowUs() - startUs;
+    totalUs += rttUs;
+    maxUs = rttUs > maxUs ? rttUs : maxUs;
+    TEST_ASSERT_EQUAL_INT(200, client.status());
+    TEST_ASSERT_EQUAL_STRING("{\"ok\":true}", client.body());
+    reused += client.reusedConnection() ? 1 : 0;
+  }
+
+  TEST_ASSERT_EQUAL_UINT32(1, client.connectCount());
+  TEST_ASSERT_EQUAL_UINT32(1, server.connections());
+  TEST_ASSERT_EQUAL_UINT32(kPolls, server.requests());
+  TEST_ASSERT_EQUAL_UINT32(kPolls - 1, reused);
+
+  char message[96];
+  snprintf(message, sizeof(message), "%lu keep-alive polls: RTT avg %lu us, max %lu us",
+           static_cast<unsigned long>(kPolls), static_cast<unsigned long>(totalUs / kPolls),
+           static_cast<unsigned long>(maxUs));
+  TEST_MESSAGE(message);
+}
+
+// A server that closes the connection now and then costs one reconnect each time, and
+// no failed report.
+void test_reconnects_after_server_close() {
+  constexpr uint32_t kPolls = 50;
+  LoopbackServer server([](int fd, const LoopbackServer::Request &request) {
+    if (request.index % 7 == 0) {
+      LoopbackServer::sendText(fd,
+                               "HTTP/1.1 200 OK\r\nConnection: close\r\nContent-Length: 11\r\n\r\n{\"ok\":true}");
+      return LoopbackServer::After::Close;
+    }
+    LoopbackServer::sendText(fd, kOk);
+    return LoopbackServer::After::KeepOpen;
+  });
+  AsyncHttpClient client;
+  const AsyncHttpClient::Target target = targetFor(server);
+  for (uint32_t i = 0; i < kPolls; ++i) {
+    TEST_ASSERT_EQUAL(AsyncHttpClient::Phase::Done, post(client, target));
+  }
+  TEST_ASSERT_EQUAL_UINT32(1 + kPolls / 7, client.connectCount());
+  TEST_ASSERT_EQUAL_UINT32(1 + kPolls / 7, server.connections());
+}
+
+void test_request_is_well_formed() {
+  std::string head;
+  std::string body;
+  LoopbackServer server([&head, &body](int fd, const LoopbackServer::Request &request) {
+    head = request.head;
+    body = request.body;
+    LoopbackServer::sendText(fd, kOk);
+    return LoopbackServer::After::KeepOpen;
+  });
+  AsyncHttpClient client;
+  TEST_ASSERT_EQUAL(AsyncHttpClient::Phase::Done, post(client, targetFor(server)));
+
+  char host[48];
+  snprintf(host, sizeof(host), "\r\nHost: 127.0.0.1:%u\r\n", static_cast<unsigned>(server.port()));
+  char length[40];
+  snprintf(length, sizeof(length), "\r\nContent-Length: %u\r\n", static_cast<unsigned>(sizeof(kReport) - 1));
+  TEST_ASSERT_EQUAL_INT(0, head.find("POST /api/prop HTTP/1.1\r\n"));
+  TEST_ASSERT_TRUE(head.find(host) != std::string::npos);
+  TEST_ASSERT_TRUE(head.find(length) != std::string::npos);
+  TEST_ASSERT_EQUAL_STRING(kReport, body.c_str());
+}
+
+// Status line, headers and body arrive a few bytes at a time.
+void test_split_reads() {
+  LoopbackServer server(replyWith(kOk, 40));
+  AsyncHttpClient client;
+  TEST_ASSERT_EQUAL(AsyncHttpClient::Phase::Done, post(client, targetFor(server)));
+  TEST_ASSERT_EQUAL_INT(200, client.status());
+  TEST_ASSERT_EQUAL_STRING("{\"ok\":true}", client.body());
+  TEST_ASSERT_EQUAL_UINT32(11, client.bodyLength());
+}
+
+// Chunk extensions are ignored and trailers skipped; chunk boundaries fall mid-read.
+void test_chunked_body_with_extensions_and_trailers() {
+  LoopbackServer server(replyWith("HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+                                  "6;name=value\r\n{\"ok\":\r\n"
+                                  "5\r\ntrue}\r\n"
+                                  "0\r\nX-Checksum: 1234\r\n\r\n",
+                                  17));
+  AsyncHttpClient client;
+  const AsyncHttpClient::Target target = targetFor(server);
+  TEST_ASSERT_EQUAL(AsyncHttpClient::Phase::Done, post(client, target));
+  TEST_ASSERT_EQUAL_STRING("{\"ok\":true}", client.body());
+  TEST_ASSERT_EQUAL_UINT32(11, client.bodyLength());
+
+  // The connection is still usable for the next exchange.
+  TEST_ASSERT_EQUAL(AsyncHttpClient::Phase::Done, post(client, target));
+  TEST_ASSERT_TRUE(client.reusedConnection());
+  TEST_ASSERT_EQUAL_UINT32(1, client.connectCount());
+}
+
+// Without a length the body runs until the server closes; the next POST reconnects.
+void test_connection_close_body_reads_until_close() {
+  LoopbackServer server([](int fd, const LoopbackServer::Request &) {
+    LoopbackServer::trickle(fd, "HTTP/1.1 200 OK\r\nConnection: close\r\n\r\n{\"ok\":true}", 4, 2);
+    return LoopbackServer::After::Close;
+  });
+  AsyncHttpClient client;
+  const AsyncHttpClient::Target target = targetFor(server);
+  TEST_ASSERT_EQUAL(AsyncHttpClient::Phase::Done, post(client, target));
+  TEST_ASSERT_EQUAL_STRING("{\"ok\":true}", client.body());
+
+  TEST_ASSERT_EQUAL(AsyncHttpClient::Phase::Done, post(client, target));
+  TEST_ASSERT_FALSE(client.reusedConnection());
+  TEST_ASSERT_EQUAL_UINT32(2, client.connectCount());
+}
+
+// The server dropped the idle connection without saying so, and the next request on it
+// goes unanswered: the client resends it once on a fresh connection.
+void test_stale_keep_alive_connection_is_retried() {
+  LoopbackServer server([](int fd, const LoopbackServer::Request &request) {
+    if (request.index == 2) {
+      return LoopbackServer::After::Close;
+    }
+    LoopbackServer::sendText(fd, kOk);
+    return LoopbackServer::After::KeepOpen;
+  });
+  AsyncHttpClient client;
+  const AsyncHttpClient::Target target = targetFor(server);
+  TEST_ASSERT_EQUAL(AsyncHttpClient::Phase::Done, post(client, target));
+  TEST_ASSERT_EQUAL(AsyncHttpClient::Phase::Done, post(client, target));
+  TEST_ASSERT_EQUAL_INT(200, client.status());
+  TEST_ASSERT_EQUAL_UINT32(2, client.connectCount());
+  TEST_ASSERT_EQUAL_UINT32(2, server.connections());
+  TEST_ASSERT_EQUAL_UINT32(3, server.requests());
+}
+
+// An idle connection the server has already closed is noticed before sending.
+void test_closed_idle_connection_is_replaced() {
+  LoopbackServer server([](int fd, const LoopbackServer::Request &) {
+    LoopbackServer::sendText(fd, kOk);
+    return LoopbackServer::After::Close;
+  });
+  AsyncHttpClient client;
+  const AsyncHttpClient::Target target = targetFor(server);
+  TEST_ASSERT_EQUAL(AsyncHttpClient::Phase::Done, post(client, target));
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  TEST_ASSERT_EQUAL(AsyncHttpClient::Phase::Done, post(client, target));
+  TEST_ASSERT_FALSE(client.reusedConnection());
+  TEST_ASSERT_EQUAL_UINT32(2, client.connectCount());
+  TEST_ASSERT_EQUAL_UINT32(2, server.requests());
+}
+
+void test_slow_server_times_out() {
+  LoopbackServer server([](int, const LoopbackServer::Request &) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    return LoopbackServer::After::Close;
+  });
+  AsyncHttpClient client;
+  const uint32_t startMs = sys_clock::nowMs();
+  TEST_ASSERT_EQUAL(AsyncHttpClient::Phase::Failed, post(client, targetFor(server), 100));
+  TEST_ASSERT_EQUAL(AsyncHttpClient::Error::Timeout, client.error());
+  TEST_ASSERT_UINT32_WITHIN(90, 190, sys_clock::nowMs() - startMs);  // At the deadline, before the reply.
+}
+
+// A newer report cancels the pending one (latest wins) and completes on its own.
+void test_newer_report_supersedes_pending_one() {
+  LoopbackServer server([](int fd, const LoopbackServer::Request &request) {
+    if (request.index == 1) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    LoopbackServer::sendText(fd, kOk);
+    return LoopbackServer::After::KeepOpen;
+  });
+  AsyncHttpClient client;
+  const AsyncHttpClient::Target target = targetFor(server);
+  TEST_ASSERT_TRUE(client.startPost(target, kReport, sizeof(kReport) - 1, sys_clock::nowMs(), kTimeoutMs));
+  while (server.requests() == 0) {
+    client.poll(sys_clock::nowMs());
+    client.waitForActivity(5);
+  }
+  TEST_ASSERT_TRUE(client.inFlight());
+  TEST_ASSERT_EQUAL(AsyncHttpClient::Phase::Done, post(client, target));
+  TEST_ASSERT_EQUAL_INT(200, client.status());
+  TEST_ASSERT_EQUAL_UINT32(2, client.connectCount());
+}
+
+void test_oversized_responses_fail_too_large() {
+  LoopbackServer lengthServer(replyWith("HTTP/1.1 200 OK\r\nContent-Length: 5000\r\n\r\n{"));
+  AsyncHttpClient client;
+  TEST_ASSERT_EQUAL(AsyncHttpClient::Phase::Failed, post(client, targetFor(lengthServer)));
+  TEST_ASSERT_EQUAL(AsyncHttpClient::Error::TooLarge, client.error());
+
+  static std::string endlessHeaders = "HTTP/1.1 200 OK\r\n";
+  while (endlessHeaders.size() < 2 * AsyncHttpClient::kResponseCapacity) {
+    endlessHeaders += "X-Padding: 0123456789abcdef\r\n";
+  }
+  LoopbackServer headerServer(replyWith(endlessHeaders.c_str()));
+  TEST_ASSERT_EQUAL(AsyncHttpClient::Phase::Failed, post(client, targetFor(headerServer)));
+  TEST_ASSERT_EQUAL(AsyncHttpClient::Error::TooLarge, client.error());
+}
+
+void test_malformed_responses_fail_protocol() {
+  const char *const responses[] = {
+      "ICY 200 OK\r\n\r\n",
+      "HTTP/1.1 abc\r\nContent-Length: 0\r\n\r\n",
+      "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\nzz\r\n{}\r\n0\r\n\r\n",
+      "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n2\r\n{}xx0\r\n\r\n",
+  };
+  for (const char *response : responses) {
+    LoopbackServer server(replyWith(response));
+    AsyncHttpClient client;
+    TEST_ASSERT_EQUAL_MESSAGE(AsyncHttpClient::Phase::Failed, post(client, targetFor(server)), response);
+    TEST_ASSERT_EQUAL_MESSAGE(AsyncHttpClient::Error::Protocol, client.error(), response);
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_keep_alive_reuses_one_connection);
+  RUN_TEST(test_reconnects_after_server_close);
+  RUN_TEST(test_request_is_well_formed);
+  RUN_TEST(test_split_reads);
+  RUN_TEST(test_chunked_body_with_extensions_and_trailers);
+  RUN_TEST(test_connection_close_body_reads_until_close);
+  RUN_TEST(test_stale_keep_alive_connection_is_retried);
+  RUN_TEST(test_closed_idle_connection_is_replaced);
+  RUN_TEST(test_slow_server_times_out);
+  RUN_TEST(test_newer_report_supersedes_pending_one);
+  RUN_TEST(test_oversized_responses_fail_too_large);
+  RUN_TEST(test_malformed_responses_fail_protocol);
+  return UNITY_END();
+}
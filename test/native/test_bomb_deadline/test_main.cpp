@@ -0,0 +1,137 @@
+#include <esp_timer.h>
+#include <unity.h>
+
+#include "bomb_deadline.h"
+#include "core/clock.h"
+
+// Drives the deadline through the esp_timer stand-in on a virtual clock. The module
+// keeps its counters across deadlines, so each test compares against the stats it
+// starts from.
+namespace {
+constexpr uint32_t kDurationMs = 30000;
+
+uint64_t virtualUs = 5000000;
+uint32_t notifications = 0;
+
+uint64_t readVirtualClock() { return virtualUs; }
+
+void countNotification() { ++notifications; }
+
+uint32_t samples(const bomb_deadline::Stats &stats, bomb_deadline::Stage stage) {
+  return stats.stages[static_cast<size_t>(stage)].samples;
+}
+}  // namespace
+
+void setUp() { notifications = 0; }
+
+void tearDown() {}
+
+void test_cancel_beats_a_callback_already_dispatched() {
+  const bomb_deadline::Stats before = bomb_deadline::getStats();
+  bomb_deadline::arm(kDurationMs);
+  TEST_ASSERT_TRUE(host_esp_timer::timer().running);
+
+  // Defused just as the timer expired: the callback runs after cancel().
+  bomb_deadline::cancel();
+  TEST_ASSERT_FALSE(host_esp_timer::timer().running);
+  host_esp_timer::dispatchLate();
+
+  TEST_ASSERT_EQUAL_UINT32(0, notifications);
+  TEST_ASSERT_FALSE(bomb_deadline::takeExpired());
+  const bomb_deadline::Stats after = bomb_deadline::getStats();
+  TEST_ASSERT_EQUAL_UINT32(before.armed + 1, after.armed);
+  TEST_ASSERT_EQUAL_UINT32(before.cancelled + 1, after.cancelled);
+  TEST_ASSERT_EQUAL_UINT32(samples(before, bomb_deadline::Stage::Dispatch),
+                           samples(after, bomb_deadline::Stage::Dispatch));
+}
+
+void test_cancel_drops_a_fired_deadline_not_yet_taken() {
+  const bomb_deadline::Stats before = bomb_deadline::getStats();
+  bomb_deadline::arm(kDurationMs);
+  virtualUs += sys_clock::msToUs(kDurationMs);
+  TEST_ASSERT_TRUE(host_esp_timer::fire());
+  TEST_ASSERT_EQUAL_UINT32(1, notifications);
+
+  // The game tick applies a defuse before it gets to the expiry.
+  bomb_deadline::cancel();
+  TEST_ASSERT_FALSE(bomb_deadline::takeExpired());
+
+  const bomb_deadline::Stats after = bomb_deadline::getStats();
+  TEST_ASSERT_EQUAL_UINT32(before.cancelled + 1, after.cancelled);
+  TEST_ASSERT_EQUAL_UINT32(samples(before, bomb_deadline::Stage::Dispatch) + 1,
+                           samples(after, bomb_deadline::Stage::Dispatch));
+  // Nothing is left to measure for the dropped deadline.
+  bomb_deadline::noteDetonation();
+  bomb_deadline::noteEffectFrame();
+  bomb_deadline::noteReportSent();
+  const bomb_deadline::Stats later = bomb_deadline::getStats();
+  TEST_ASSERT_EQUAL_UINT32(samples(before, bomb_deadline::Stage::Tick), samples(later, bomb_deadline::Stage::Tick));
+  TEST_ASSERT_EQUAL_UINT32(samples(before, bomb_deadline::Stage::Frame), samples(later, bomb_deadline::Stage::Frame));
+  TEST_ASSERT_EQUAL_UINT32(samples(before, bomb_deadline::Stage::Report), samples(later, bomb_deadline::Stage::Report));
+  TEST_ASSERT_EQUAL_UINT32(before.countdownFallbacks, later.countdownFallbacks);
+}
+
+void test_countdown_detonation_before_the_timer_counts_a_fallback() {
+  const bomb_deadline::Stats before = bomb_deadline::getStats();
+  const uint32_t stops = host_esp_timer::timer().stops;
+  bomb_deadline::arm(kDurationMs);
+  virtualUs += sys_clock::msToUs(kDurationMs) - 400;
+
+  bomb_deadline::noteDetonation();
+  TEST_ASSERT_FALSE(host_esp_timer::timer().running);
+  TEST_ASSERT_EQUAL_UINT32(stops + 1, host_esp_timer::timer().stops);
+  TEST_ASSERT_FALSE(host_esp_timer::fire());
+  TEST_ASSERT_FALSE(bomb_deadline::takeExpired());
+
+  const bomb_deadline::Stats after = bomb_deadline::getStats();
+  TEST_ASSERT_EQUAL_UINT32(before.countdownFallbacks + 1, after.countdownFallbacks);
+  TEST_ASSERT_EQUAL_UINT32(before.cancelled, after.cancelled);
+  TEST_ASSERT_EQUAL_UINT32(samples(before, bomb_deadline::Stage::Tick) + 1, samples(after, bomb_deadline::Stage::Tick));
+  // Early by 400 us counts as on time.
+  TEST_ASSERT_EQUAL_UINT32(before.stages[static_cast<size_t>(bomb_deadline::Stage::Tick)].maxUs,
+                           after.stages[static_cast<size_t>(bomb_deadline::Stage::Tick)].maxUs);
+}
+
+void test_each_stage_is_marked_once_per_deadline() {
+  const bomb_deadline::Stats before = bomb_deadline::getStats();
+  bomb_deadline::arm(kDurationMs);
+  const uint64_t deadlineUs = virtualUs + sys_clock::msToUs(kDurationMs);
+
+  virtualUs = deadlineUs + 100;
+  TEST_ASSERT_TRUE(host_esp_timer::fire());
+  TEST_ASSERT_TRUE(bomb_deadline::takeExpired());
+  TEST_ASSERT_FALSE(bomb_deadline::takeExpired());
+  virtualUs = deadlineUs + 2000;
+  bomb_deadline::noteDetonation();
+  virtualUs = deadlineUs + 15000;
+  bomb_deadline::noteEffectFrame();
+  virtualUs = deadlineUs + 80000;
+  bomb_deadline::noteReportSent();
+
+  // Later frames and reports of the same detonation are not new samples.
+  virtualUs = deadlineUs + 900000;
+  bomb_deadline::noteDetonation();
+  bomb_deadline::noteEffectFrame();
+  bomb_deadline::noteReportSent();
+
+  const bomb_deadline::Stats after = bomb_deadline::getStats();
+  const uint32_t expectedUs[] = {100, 2000, 15000, 80000};
+  for (size_t i = 0; i < static_cast<size_t>(bomb_deadline::Stage::Count); ++i) {
+    TEST_ASSERT_EQUAL_UINT32(before.stages[i].samples + 1, after.stages[i].samples);
+    TEST_ASSERT_EQUAL_UINT32(expectedUs[i], after.stages[i].maxUs);
+  }
+  TEST_ASSERT_EQUAL_UINT32(before.countdownFallbacks, after.countdownFallbacks);
+  TEST_ASSERT_EQUAL_UINT32(before.cancelled, after.cancelled);
+}
+
+int main() {
+  sys_clock::setHostTimeSource(readVirtualClock);
+  bomb_deadline::begin(countNotification);
+
+  UNITY_BEGIN();
+  RUN_TEST(test_cancel_beats_a_callback_already_dispatched);
+  RUN_TEST(test_cancel_drops_a_fired_deadline_not_yet_taken);
+  RUN_TEST(test_countdown_detonation_before_the_timer_counts_a_fallback);
+  RUN_TEST(test_each_stage_is_marked_once_per_deadline);
+  return UNITY_END();
+}
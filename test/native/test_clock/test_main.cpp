@@ -0,0 +1,90 @@
+#include <unity.h>
+
+#include <thread>
+
+#include "core/clock.h"
+
+// sys_clock on a virtual time source: millisecond stamps across the 32-bit wrap, and
+// the per-task frame time that stays put between beginFrame() calls.
+namespace {
+constexpr uint64_t kWrapUs = (static_cast<uint64_t>(UINT32_MAX) + 1) * 1000;
+
+uint64_t virtualUs = 0;
+
+uint64_t readVirtualClock() { return virtualUs; }
+}  // namespace
+
+void setUp() { virtualUs = 1000000; }
+
+void tearDown() {}
+
+void test_reached_holds_across_the_wrap() {
+  TEST_ASSERT_TRUE(sys_clock::reached(100, 100));
+  TEST_ASSERT_TRUE(sys_clock::reached(101, 100));
+  TEST_ASSERT_FALSE(sys_clock::reached(99, 100));
+
+  // A deadline set just before the wrap lands just after it.
+  const uint32_t startMs = UINT32_MAX - 50;
+  const uint32_t deadlineMs = startMs + 100;
+  TEST_ASSERT_EQUAL_UINT32(49, deadlineMs);
+  TEST_ASSERT_FALSE(sys_clock::reached(startMs, deadlineMs));
+  TEST_ASSERT_FALSE(sys_clock::reached(UINT32_MAX, deadlineMs));
+  TEST_ASSERT_FALSE(sys_clock::reached(48, deadlineMs));
+  TEST_ASSERT_TRUE(sys_clock::reached(49, deadlineMs));
+  TEST_ASSERT_TRUE(sys_clock::reached(startMs + 1000, deadlineMs));
+  // A deadline already passed before the wrap stays reached after it.
+  TEST_ASSERT_TRUE(sys_clock::reached(10, UINT32_MAX - 10));
+}
+
+void test_millisecond_stamps_wrap_with_the_microsecond_clock() {
+  sys_clock::setHostTimeSource(readVirtualClock);
+  virtualUs = kWrapUs - 1500;
+  const uint32_t beforeMs = sys_clock::nowMs();
+  TEST_ASSERT_EQUAL_UINT32(UINT32_MAX - 1, beforeMs);
+  const uint32_t deadlineMs = beforeMs + 5;
+
+  virtualUs = kWrapUs + 2000;
+  const uint32_t afterMs = sys_clock::nowMs();
+  TEST_ASSERT_EQUAL_UINT32(2, afterMs);
+  TEST_ASSERT_EQUAL_UINT32(4, afterMs - beforeMs);
+  TEST_ASSERT_FALSE(sys_clock::reached(afterMs, deadlineMs));
+  virtualUs += 1000;
+  TEST_ASSERT_TRUE(sys_clock::reached(sys_clock::nowMs(), deadlineMs));
+  sys_clock::setHostTimeSource(nullptr);
+}
+
+void test_frame_time_is_cached_until_the_next_frame() {
+  sys_clock::setHostTimeSource(readVirtualClock);
+  virtualUs = 7000250;
+  sys_clock::beginFrame();
+  TEST_ASSERT_TRUE(sys_clock::frameUs() == 7000250);
+  TEST_ASSERT_EQUAL_UINT32(7000, sys_clock::frameMs());
+
+  // Time moves on inside the frame; only now*() sees it.
+  virtualUs += 3400;
+  TEST_ASSERT_TRUE(sys_clock::frameUs() == 7000250);
+  TEST_ASSERT_EQUAL_UINT32(7003, sys_clock::nowMs());
+
+  // Another task's frame does not touch this one.
+  uint64_t otherFrameUs = 0;
+  std::thread other([&otherFrameUs]() {
+    sys_clock::beginFrame();
+    otherFrameUs = sys_clock::frameUs();
+  });
+  other.join();
+  TEST_ASSERT_TRUE(otherFrameUs == 7003650);
+  TEST_ASSERT_TRUE(sys_clock::frameUs() == 7000250);
+
+  sys_clock::beginFrame();
+  TEST_ASSERT_TRUE(sys_clock::frameUs() == 7003650);
+  TEST_ASSERT_EQUAL_UINT32(7003, sys_clock::frameMs());
+  sys_clock::setHostTimeSource(nullptr);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_reached_holds_across_the_wrap);
+  RUN_TEST(test_millisecond_stamps_wrap_with_the_microsecond_clock);
+  RUN_TEST(test_frame_time_is_cached_until_the_next_frame);
+  return UNITY_END();
+}
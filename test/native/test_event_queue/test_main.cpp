@@ -0,0 +1,103 @@
+#include <unity.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "core/event_queue.h"
+
+namespace {
+struct Item {
+  uint32_t producer;
+  uint32_t sequence;
+};
+
+constexpr uint32_t kProducers = 4;
+constexpr uint32_t kItemsPerProducer = 50000;
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_fifo_and_full() {
+  EventQueue<uint32_t, 4> queue;
+  uint32_t value = 0;
+  TEST_ASSERT_FALSE(queue.pop(value));
+
+  // Several laps around the ring.
+  for (uint32_t lap = 0; lap < 3; ++lap) {
+    for (uint32_t i = 0; i < 4; ++i) {
+      TEST_ASSERT_TRUE(queue.push(lap * 10 + i));
+    }
+    TEST_ASSERT_FALSE(queue.push(99));
+    for (uint32_t i = 0; i < 4; ++i) {
+      TEST_ASSERT_TRUE(queue.pop(value));
+      TEST_ASSERT_EQUAL_UINT32(lap * 10 + i, value);
+    }
+    TEST_ASSERT_FALSE(queue.pop(value));
+  }
+}
+
+// Producers on several threads race for a small ring that is full most of the time.
+// Every item must arrive exactly once, and each producer's items in the order pushed.
+void test_concurrent_producers() {
+  EventQueue<Item, 8> queue;
+  std::atomic<bool> go{false};
+  std::atomic<uint32_t> rejectedPushes{0};
+
+  std::vector<std::thread> producers;
+  for (uint32_t p = 0; p < kProducers; ++p) {
+    producers.emplace_back([&queue, &go, &rejectedPushes, p]() {
+      while (!go.load()) {
+        std::this_thread::yield();
+      }
+      for (uint32_t i = 0; i < kItemsPerProducer; ++i) {
+        while (!queue.push(Item{p, i})) {
+          rejectedPushes.fetch_add(1, std::memory_order_relaxed);
+          std::this_thread::sleep_for(std::chrono::microseconds(10));
+        }
+      }
+    });
+  }
+
+  uint32_t nextSequence[kProducers] = {};
+  uint32_t received = 0;
+  uint32_t outOfOrder = 0;
+  uint32_t badProducer = 0;
+  go.store(true);
+  Item item;
+  while (received < kProducers * kItemsPerProducer) {
+    if (!queue.pop(item)) {
+      continue;
+    }
+    ++received;
+    if (item.producer >= kProducers) {
+      ++badProducer;
+      continue;
+    }
+    if (item.sequence != nextSequence[item.producer]) {
+      ++outOfOrder;
+    }
+    nextSequence[item.producer] = item.sequence + 1;
+  }
+  for (std::thread &producer : producers) {
+    producer.join();
+  }
+
+  TEST_ASSERT_EQUAL_UINT32(0, badProducer);
+  TEST_ASSERT_EQUAL_UINT32(0, outOfOrder);
+  for (uint32_t p = 0; p < kProducers; ++p) {
+    TEST_ASSERT_EQUAL_UINT32(kItemsPerProducer, nextSequence[p]);
+  }
+  TEST_ASSERT_FALSE(queue.pop(item));
+  TEST_ASSERT_GREATER_THAN(0, rejectedPushes.load());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_fifo_and_full);
+  RUN_TEST(test_concurrent_producers);
+  return UNITY_END();
+}
@@ -0,0 +1,257 @@
+#include <string.h>
+#include <unity.h>
+
+#include "core/game_mode.h"
+#include "core/game_state.h"
+
+using game_mode::ArmStep;
+using game_mode::DefuseMethod;
+using game_mode::DefuseOutcome;
+using game_mode::GameMode;
+
+// Rules strings through game_mode::compile(), then the three example modes from
+// game_mode.h played through a GameEngine tick by tick.
+namespace {
+constexpr uint32_t kStartMs = 100000;
+constexpr uint32_t kTickMs = 10;
+constexpr uint32_t kBombMs = 60000;
+const char kCode[] = "1234";
+
+// Compiles `rules` expecting success.
+GameMode compiled(const char *rules) {
+  GameMode mode;
+  const char *error = nullptr;
+  TEST_ASSERT_TRUE_MESSAGE(game_mode::compile(rules, mode, &error), error != nullptr ? error : rules);
+  return mode;
+}
+
+// Compiles `rules` over a known mode, expecting `expectedError`, and checks that the mode
+// was left as it was.
+void rejects(const char *rules, const char *expectedError) {
+  GameMode mode = compiled("arm=hold:2000,ir:4000;defuse=hold:7000");
+  const uint32_t id = mode.id;
+  const char *error = nullptr;
+  TEST_ASSERT_FALSE_MESSAGE(game_mode::compile(rules, mode, &error), rules);
+  TEST_ASSERT_EQUAL_STRING(expectedError, error);
+  TEST_ASSERT_EQUAL_UINT32(id, mode.id);
+  TEST_ASSERT_EQUAL_STRING("arm=hold:2000,ir:4000;defuse=hold:7000", mode.rules);
+  TEST_ASSERT_EQUAL_UINT8(2, mode.armStepCount);
+  TEST_ASSERT_EQUAL_UINT32(2000, mode.armSteps[0].durationMs);
+  TEST_ASSERT_EQUAL_UINT32(4000, mode.armSteps[1].durationMs);
+  TEST_ASSERT_EQUAL(DefuseMethod::Hold, mode.defuse);
+  TEST_ASSERT_EQUAL_UINT32(7000, mode.defuseHoldMs);
+  TEST_ASSERT_EQUAL(DefuseOutcome::Defused, mode.outcome);
+}
+
+// One round on a fresh engine, played in kTickMs ticks with the match Running.
+struct Round {
+  GameMode mode;
+  game_state::GameEngine engine;
+  uint32_t nowMs = kStartMs;
+  GameOutputs outputs;
+
+  // Takes `rules` on an idle tick in ON, as the prop does at boot, then enters ACTIVE.
+  explicit Round(const char *rules) : mode(compiled(rules)) {
+    tick(false);
+    engine.set_state(ACTIVE, nowMs);
+    engine.set_match_status(Running);
+  }
+
+  FlameState tick(bool pressed, bool ir = false, char digit = '\0') {
+    nowMs += kTickMs;
+    GameInputs inputs;
+    inputs.nowMs = nowMs;
+    inputs.wifiConnected = true;
+    inputs.lastSuccessfulApiMs = nowMs;
+    inputs.remoteMatchStatus = Running;
+    inputs.configuredBombDurationMs = kBombMs;
+    inputs.configuredDefuseCode = kCode;
+    inputs.bothButtonsPressed = pressed;
+    inputs.irConfirmationReceived = ir;
+    inputs.keypadDigitAvailable = digit != '\0';
+    inputs.keypadDigit = digit;
+    inputs.gameMode = &mode;
+    outputs = GameOutputs();
+    engine.game_tick(inputs, outputs);
+    return engine.get_state();
+  }
+
+  // Holds (or leaves) the buttons for `ms`; returns the state after the last tick.
+  FlameState hold(uint32_t ms, bool pressed = true) {
+    FlameState state = engine.get_state();
+    for (uint32_t elapsed = 0; elapsed < ms; elapsed += kTickMs) {
+      state = tick(pressed);
+    }
+    return state;
+  }
+
+  void typeCode() {
+    for (size_t i = 0; i < DEFUSE_CODE_LENGTH; ++i) {
+      tick(false, false, kCode[i]);
+    }
+  }
+};
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_accepts_the_documented_forms_with_their_defaults() {
+  const GameMode builtIn = compiled("");
+  TEST_ASSERT_EQUAL_UINT32(0, builtIn.id);
+  TEST_ASSERT_EQUAL_UINT8(2, builtIn.armStepCount);
+  TEST_ASSERT_EQUAL(ArmStep::Hold, builtIn.armSteps[0].kind);
+  TEST_ASSERT_EQUAL_UINT32(BUTTON_HOLD_MS, builtIn.armSteps[0].durationMs);
+  TEST_ASSERT_EQUAL(ArmStep::IrConfirm, builtIn.armSteps[1].kind);
+  TEST_ASSERT_EQUAL_UINT32(IR_CONFIRM_WINDOW_MS, builtIn.armSteps[1].durationMs);
+  TEST_ASSERT_EQUAL(DefuseMethod::Code, builtIn.defuse);
+  TEST_ASSERT_EQUAL(DefuseOutcome::Defused, builtIn.outcome);
+
+  // Spelling the built-in rules out compiles to the same behaviour.
+  const GameMode spelled = compiled("arm=hold,ir;defuse=code;outcome=defused");
+  TEST_ASSERT_NOT_EQUAL(0, spelled.id);
+  TEST_ASSERT_EQUAL_UINT8(2, spelled.armStepCount);
+  TEST_ASSERT_EQUAL_UINT32(BUTTON_HOLD_MS, spelled.armSteps[0].durationMs);
+  TEST_ASSERT_EQUAL_UINT32(IR_CONFIRM_WINDOW_MS, spelled.armSteps[1].durationMs);
+  TEST_ASSERT_EQUAL(DefuseMethod::Code, spelled.defuse);
+
+  const GameMode holdDefuse = compiled("defuse=hold");
+  TEST_ASSERT_EQUAL(DefuseMethod::Hold, holdDefuse.defuse);
+  TEST_ASSERT_EQUAL_UINT32(BUTTON_HOLD_MS, holdDefuse.defuseHoldMs);
+  TEST_ASSERT_EQUAL_UINT8(2, holdDefuse.armStepCount);
+  TEST_ASSERT_EQUAL_UINT32(8000, compiled("defuse=hold:8000").defuseHoldMs);
+
+  const GameMode multiStage = compiled("arm=hold,ir,hold:5000");
+  TEST_ASSERT_EQUAL_UINT8(3, multiStage.armStepCount);
+  TEST_ASSERT_EQUAL_UINT32(BUTTON_HOLD_MS, multiStage.armSteps[0].durationMs);
+  TEST_ASSERT_EQUAL(ArmStep::IrConfirm, multiStage.armSteps[1].kind);
+  TEST_ASSERT_EQUAL_UINT32(IR_CONFIRM_WINDOW_MS, multiStage.armSteps[1].durationMs);
+  TEST_ASSERT_EQUAL(ArmStep::Hold, multiStage.armSteps[2].kind);
+  TEST_ASSERT_EQUAL_UINT32(5000, multiStage.armSteps[2].durationMs);
+  TEST_ASSERT_EQUAL(DefuseMethod::Code, multiStage.defuse);
+
+  const GameMode capture = compiled("arm=hold:10000;defuse=hold:10000;outcome=neutral");
+  TEST_ASSERT_EQUAL_UINT8(1, capture.armStepCount);
+  TEST_ASSERT_EQUAL_UINT32(10000, capture.armSteps[0].durationMs);
+  TEST_ASSERT_EQUAL(DefuseMethod::Hold, capture.defuse);
+  TEST_ASSERT_EQUAL_UINT32(10000, capture.defuseHoldMs);
+  TEST_ASSERT_EQUAL(DefuseOutcome::Neutral, capture.outcome);
+  TEST_ASSERT_EQUAL_STRING("arm=hold:10000;defuse=hold:10000;outcome=neutral", capture.rules);
+
+  // Any clause order, spaces around the separators, four steps, the longest step.
+  const GameMode loose = compiled(" outcome = neutral ; arm = hold:600000 , ir:1 , hold , ir ;");
+  TEST_ASSERT_EQUAL_UINT8(game_mode::kMaxArmSteps, loose.armStepCount);
+  TEST_ASSERT_EQUAL_UINT32(game_mode::kMaxStepMs, loose.armSteps[0].durationMs);
+  TEST_ASSERT_EQUAL_UINT32(1, loose.armSteps[1].durationMs);
+  TEST_ASSERT_EQUAL(DefuseOutcome::Neutral, loose.outcome);
+
+  // The id names the rules string.
+  TEST_ASSERT_EQUAL_UINT32(multiStage.id, compiled("arm=hold,ir,hold:5000").id);
+  TEST_ASSERT_NOT_EQUAL(multiStage.id, capture.id);
+}
+
+void test_rejects_bad_rules_and_keeps_the_mode() {
+  rejects("arm=hold:0", "bad arming step duration");
+  rejects("arm=hold:600001", "bad arming step duration");
+  rejects("arm=hold,ir:x", "bad arming step duration");
+  rejects("arm=hold,ir,hold,ir,hold", "too many arming steps");
+  rejects("arm=ir,hold", "arming must start with a hold");
+  rejects("arm=", "arming must start with a hold");
+  rejects("arm=hold,beep", "unknown arming step");
+  rejects("defuse=code:5", "unknown defuse method");
+  rejects("defuse=hold:0", "bad defuse hold duration");
+  rejects("outcome=exploded", "unknown outcome");
+  rejects("defuse=hold;colour=red", "unknown rule");
+
+  char tooLong[game_mode::kMaxRulesLength + 2];
+  memset(tooLong, ' ', sizeof(tooLong) - 1);
+  memcpy(tooLong, "defuse=hold", 11);
+  tooLong[sizeof(tooLong) - 1] = '\0';
+  rejects(tooLong, "rules too long");
+  // One character shorter fits.
+  tooLong[game_mode::kMaxRulesLength] = '\0';
+  TEST_ASSERT_EQUAL(DefuseMethod::Hold, compiled(tooLong).defuse);
+}
+
+// Hold, IR confirmation, then a second 5 s hold on the same press.
+void test_multi_stage_arming_needs_every_step() {
+  Round round("arm=hold,ir,hold:5000");
+  TEST_ASSERT_EQUAL(ARMING, round.tick(true));
+  TEST_ASSERT_EQUAL(ARMING, round.hold(BUTTON_HOLD_MS));
+  TEST_ASSERT_TRUE(round.engine.is_ir_confirmation_window_active());
+
+  TEST_ASSERT_EQUAL(ARMING, round.tick(true, true));
+  TEST_ASSERT_TRUE(round.outputs.clearIrConfirmation);
+  TEST_ASSERT_FALSE(round.engine.is_ir_confirmation_window_active());
+  TEST_ASSERT_TRUE(round.engine.is_button_hold_active());
+
+  TEST_ASSERT_EQUAL(ARMING, round.hold(5000 - kTickMs));
+  TEST_ASSERT_EQUAL(ARMED, round.tick(true));
+  TEST_ASSERT_TRUE(round.outputs.armingConfirmedEffect);
+  TEST_ASSERT_EQUAL_UINT32(kBombMs, round.engine.get_bomb_timer_remaining_ms());
+
+  // Letting go during the last hold starts arming over.
+  Round released("arm=hold,ir,hold:5000");
+  released.hold(BUTTON_HOLD_MS + kTickMs);
+  released.tick(true, true);
+  released.hold(2000);
+  TEST_ASSERT_EQUAL(ACTIVE, released.tick(false));
+}
+
+// The press that armed the device must be let go before a defusing hold counts.
+void test_hold_defuse_needs_a_fresh_press() {
+  Round round("defuse=hold");
+  round.hold(BUTTON_HOLD_MS + kTickMs);
+  TEST_ASSERT_EQUAL(ARMED, round.tick(true, true));
+
+  TEST_ASSERT_EQUAL(ARMED, round.hold(BUTTON_HOLD_MS * 2));
+  TEST_ASSERT_FALSE(round.engine.is_button_hold_active());
+
+  round.tick(false);
+  TEST_ASSERT_EQUAL(ARMED, round.hold(BUTTON_HOLD_MS));
+  TEST_ASSERT_TRUE(round.engine.is_button_hold_active());
+  TEST_ASSERT_EQUAL(DEFUSED, round.tick(true));
+  TEST_ASSERT_TRUE(round.engine.get_bomb_timer_remaining_ms() > 0);
+
+  // Typing the code does nothing in this mode.
+  Round typed("defuse=hold");
+  typed.hold(BUTTON_HOLD_MS + kTickMs);
+  typed.tick(true, true);
+  typed.tick(false);
+  typed.typeCode();
+  TEST_ASSERT_EQUAL(ARMED, typed.engine.get_state());
+}
+
+// A defusing hold hands the point back to ACTIVE, and it can be captured again.
+void test_neutral_outcome_allows_recapture() {
+  Round round("arm=hold:10000;defuse=hold:10000;outcome=neutral");
+  TEST_ASSERT_EQUAL(ARMING, round.hold(10000));
+  TEST_ASSERT_EQUAL(ARMED, round.tick(true));
+  round.tick(false);
+
+  TEST_ASSERT_EQUAL(ARMED, round.hold(10000));
+  TEST_ASSERT_EQUAL(ACTIVE, round.tick(true));
+  TEST_ASSERT_TRUE(round.outputs.stateChanged);
+  TEST_ASSERT_EQUAL(ARMED, round.outputs.previousState);
+  TEST_ASSERT_FALSE(round.engine.is_bomb_timer_active());
+
+  // The neutralising press does not start the next capture.
+  TEST_ASSERT_EQUAL(ACTIVE, round.hold(1000));
+  TEST_ASSERT_FALSE(round.engine.is_button_hold_active());
+
+  round.tick(false);
+  TEST_ASSERT_EQUAL(ARMING, round.hold(10000));
+  TEST_ASSERT_EQUAL(ARMED, round.tick(true));
+  TEST_ASSERT_EQUAL_UINT32(kBombMs, round.engine.get_bomb_timer_remaining_ms());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_accepts_the_documented_forms_with_their_defaults);
+  RUN_TEST(test_rejects_bad_rules_and_keeps_the_mode);
+  RUN_TEST(test_multi_stage_arming_needs_every_step);
+  RUN_TEST(test_hold_defuse_needs_a_fresh_press);
+  RUN_TEST(test_neutral_outcome_allows_recapture);
+  return UNITY_END();
+}
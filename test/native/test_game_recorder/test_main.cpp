@@ -0,0 +1,224 @@
+#include <stdio.h>
+#include <unity.h>
+
+#include <chrono>
+#include <vector>
+
+#include "core/game_recorder.h"
+
+// Records scripted matches tick by tick, drains the log as the prop's flush task would,
+// and replays it through a fresh engine.
+namespace {
+constexpr uint32_t kMatchMs = 30u * 60u * 1000u;
+constexpr uint32_t kTickMs = 10;
+
+std::vector<uint8_t> logBytes;
+game_recorder::Recorder recorder;
+uint32_t simulatedMs = 0;
+
+// This tick is recorded with one output bit flipped, as if the firmware had diverged.
+uint32_t tamperTick = UINT32_MAX;
+uint32_t recordedTicks = 0;
+
+// From this tick on, the first quiet tick starts a new segment, as replay_log does once
+// a file is full; the new segment's header lands at segmentOffset in the log.
+uint32_t segmentTick = UINT32_MAX;
+size_t segmentOffset = 0;
+
+size_t appendToLog(const uint8_t *data, size_t length) {
+  logBytes.insert(logBytes.end(), data, data + length);
+  return length;
+}
+
+void drainLog() {
+  recorder.drain(appendToLog);
+  if (recorder.takeSegmentStart()) {
+    segmentOffset = logBytes.size();
+    recorder.drain(appendToLog);
+  }
+}
+
+void recordTick(const GameInputs &inputs, const GameOutputs &outputs) {
+  if (recordedTicks++ == tamperTick) {
+    GameOutputs tampered = outputs;
+    tampered.keypadDigitEffect = !tampered.keypadDigitEffect;
+    recorder.recordTick(inputs, tampered);
+  } else {
+    recorder.recordTick(inputs, outputs);
+  }
+  // Well before the ring could fill; the prop drains every REPLAY_LOG_FLUSH_INTERVAL_MS.
+  if (recorder.pendingBytes() > game_recorder::Recorder::kRingBytes / 2) {
+    drainLog();
+  }
+}
+
+uint32_t rngState = 1;
+
+uint32_t nextRandom(uint32_t bound) {
+  rngState = rngState * 1664525u + 1013904223u;
+  return (rngState >> 8) % bound;
+}
+
+// Runs `ms` of ticks in one match phase. While Running, a randomized player holds the
+// buttons, sends IR confirmations and types digits, sometimes the right code.
+void play(game_state::GameEngine &engine, GameInputs &inputs, MatchStatus status, uint32_t ms) {
+  static const char kDigits[] = "0123456789";
+  inputs.remoteMatchStatus = status;
+  uint32_t holdUntilMs = 0;
+  for (uint32_t elapsed = 0; elapsed < ms; elapsed += kTickMs) {
+    inputs.nowMs += kTickMs;
+    simulatedMs += kTickMs;
+    inputs.lastSuccessfulApiMs = inputs.nowMs - inputs.nowMs % 1000;
+    inputs.keypadDigitAvailable = false;
+    inputs.keypadDigit = '\0';
+    if (status == Running) {
+      if (holdUntilMs == 0 && nextRandom(400) == 0) {
+        holdUntilMs = inputs.nowMs + BUTTON_HOLD_MS / 2 + nextRandom(BUTTON_HOLD_MS);
+      }
+      inputs.bothButtonsPressed = holdUntilMs != 0 && inputs.nowMs < holdUntilMs;
+      if (!inputs.bothButtonsPressed) {
+        holdUntilMs = 0;
+      }
+      if (nextRandom(300) == 0) {
+        inputs.irConfirmationReceived = true;
+      }
+      if (nextRandom(50) == 0) {
+        inputs.keypadDigitAvailable = true;
+        inputs.keypadDigit = nextRandom(2) == 0 ? DEFAULT_DEFUSE_CODE[engine.get_defuse_entered_digits() % DEFUSE_CODE_LENGTH]
+                                                : kDigits[nextRandom(10)];
+      }
+    } else {
+      inputs.bothButtonsPressed = false;
+    }
+
+    GameOutputs outputs;
+    engine.game_tick(inputs, outputs);
+    recordTick(inputs, outputs);
+    if (recordedTicks >= segmentTick && !outputs.stateChanged && !inputs.bothButtonsPressed &&
+        engine.get_state() != ARMING && engine.get_state() != ARMED &&
+        recorder.startSegment(engine.get_resume_point(), inputs.nowMs)) {
+      segmentTick = UINT32_MAX;
+    }
+    if (outputs.clearIrConfirmation) {
+      inputs.irConfirmationReceived = false;
+    }
+  }
+}
+
+// `matches` scripted matches whose Running phase lasts `runningMs`.
+void recordSession(uint32_t seed, uint32_t runningMs, uint32_t matches) {
+  logBytes.clear();
+  recordedTicks = 0;
+  simulatedMs = 0;
+  rngState = seed;
+  segmentOffset = 0;
+  recorder.start();
+
+  game_state::GameEngine engine;
+  GameInputs inputs;
+  inputs.wifiConnected = true;
+  inputs.apiResponseReceived = true;
+  inputs.configuredDefuseCode = DEFAULT_DEFUSE_CODE;
+  for (uint32_t match = 0; match < matches; ++match) {
+    play(engine, inputs, WaitingOnStart, 1000);
+    play(engine, inputs, Countdown, 1000);
+    play(engine, inputs, Running, runningMs);
+    play(engine, inputs, WaitingOnFinalData, 1000);
+    play(engine, inputs, Completed, 2000);
+  }
+  drainLog();
+}
+}  // namespace
+
+void setUp() {
+  tamperTick = UINT32_MAX;
+  segmentTick = UINT32_MAX;
+}
+
+void tearDown() {}
+
+void test_round_trip_replays_every_tick() {
+  recordSession(7, 120000, 5);
+  TEST_ASSERT_EQUAL_UINT32(0, recorder.droppedRecords());
+
+  game_state::GameEngine engine;
+  const game_recorder::ReplayResult result = game_recorder::replay(logBytes.data(), logBytes.size(), engine);
+  TEST_ASSERT_EQUAL(game_recorder::ReplayEnd::Complete, result.end);
+  TEST_ASSERT_EQUAL_UINT32(recordedTicks, result.ticks);
+  TEST_ASSERT_EQUAL_UINT32(0, result.mismatches);
+}
+
+void test_reports_first_divergence() {
+  tamperTick = 5000;
+  recordSession(7, 120000, 1);
+
+  game_state::GameEngine engine;
+  const game_recorder::ReplayResult result = game_recorder::replay(logBytes.data(), logBytes.size(), engine);
+  TEST_ASSERT_EQUAL(game_recorder::ReplayEnd::Complete, result.end);
+  TEST_ASSERT_EQUAL_UINT32(1, result.mismatches);
+  TEST_ASSERT_EQUAL_UINT32(tamperTick, result.firstMismatchTick);
+  TEST_ASSERT_EQUAL_UINT32(0x020, result.firstMismatchExpected ^ result.firstMismatchActual);
+}
+
+void test_cut_log_is_truncated() {
+  recordSession(3, 60000, 1);
+  game_state::GameEngine engine;
+  const game_recorder::ReplayResult result = game_recorder::replay(logBytes.data(), logBytes.size() - 1, engine);
+  TEST_ASSERT_EQUAL(game_recorder::ReplayEnd::Truncated, result.end);
+  TEST_ASSERT_EQUAL_UINT32(0, result.mismatches);
+}
+
+// Cut mid-match, each segment replays on its own: the second from its resume record.
+void test_each_segment_replays_on_its_own() {
+  segmentTick = 30000;
+  recordSession(7, 120000, 3);
+  TEST_ASSERT_EQUAL_UINT32(0, recorder.droppedRecords());
+  TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, segmentTick);
+  TEST_ASSERT_GREATER_THAN(0, segmentOffset);
+
+  game_state::GameEngine first;
+  const game_recorder::ReplayResult head = game_recorder::replay(logBytes.data(), segmentOffset, first);
+  TEST_ASSERT_EQUAL(game_recorder::ReplayEnd::Complete, head.end);
+  TEST_ASSERT_EQUAL_UINT32(0, head.mismatches);
+
+  game_state::GameEngine second;
+  const game_recorder::ReplayResult tail =
+      game_recorder::replay(logBytes.data() + segmentOffset, logBytes.size() - segmentOffset, second);
+  TEST_ASSERT_EQUAL(game_recorder::ReplayEnd::Complete, tail.end);
+  TEST_ASSERT_EQUAL_UINT32(0, tail.mismatches);
+  TEST_ASSERT_EQUAL_UINT32(1, tail.overrides);
+  TEST_ASSERT_GREATER_THAN(0, tail.ticks);
+  TEST_ASSERT_EQUAL_UINT32(recordedTicks, head.ticks + tail.ticks);
+}
+
+void test_thirty_minute_match_replays_within_a_second() {
+  recordSession(11, kMatchMs, 1);
+  TEST_ASSERT_EQUAL_UINT32(0, recorder.droppedRecords());
+  TEST_ASSERT_TRUE(simulatedMs >= kMatchMs);
+
+  const auto start = std::chrono::steady_clock::now();
+  game_state::GameEngine engine;
+  const game_recorder::ReplayResult result = game_recorder::replay(logBytes.data(), logBytes.size(), engine);
+  const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  TEST_ASSERT_EQUAL(game_recorder::ReplayEnd::Complete, result.end);
+  TEST_ASSERT_EQUAL_UINT32(0, result.mismatches);
+  TEST_ASSERT_EQUAL_UINT32(recordedTicks, result.ticks);
+  TEST_ASSERT_TRUE(seconds < 1.0);
+
+  char message[112];
+  snprintf(message, sizeof(message), "%lu ticks (%lu s of play, %lu log bytes) replayed in %.1f ms",
+           static_cast<unsigned long>(result.ticks), static_cast<unsigned long>(simulatedMs / 1000),
+           static_cast<unsigned long>(logBytes.size()), seconds * 1000.0);
+  TEST_MESSAGE(message);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_round_trip_replays_every_tick);
+  RUN_TEST(test_reports_first_divergence);
+  RUN_TEST(test_cut_log_is_truncated);
+  RUN_TEST(test_each_segment_replays_on_its_own);
+  RUN_TEST(test_thirty_minute_match_replays_within_a_second);
+  return UNITY_END();
+}
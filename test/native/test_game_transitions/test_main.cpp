@@ -0,0 +1,397 @@
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+#include <chrono>
+
+#include "core/game_state.h"
+
+using game_state::GameEngine;
+using game_state::GameEvent;
+
+// Walks every (FlameState x MatchStatus x GameEvent) cell through game_tick(): each
+// cell puts a fresh engine in the state, sets the match status and feeds inputs that
+// raise the event, then checks the resulting state and the entry/exit actions against
+// the rules below. Those are written out from the specification, independently of
+// kTransitions, so a wrong table cell and a wrong event priority both show up.
+namespace {
+constexpr size_t kStates = ERROR_STATE + 1;
+constexpr size_t kStatuses = Cancelled + 1;
+constexpr size_t kEvents = static_cast<size_t>(GameEvent::Count);
+constexpr uint32_t kStartMs = 100000;
+constexpr uint32_t kBombMs = 30000;
+const char kCode[] = "1234";
+
+constexpr uint8_t bit(MatchStatus status) { return static_cast<uint8_t>(1u << status); }
+constexpr uint16_t eventBit(GameEvent event) { return static_cast<uint16_t>(1u << static_cast<uint8_t>(event)); }
+
+constexpr uint8_t kAny = static_cast<uint8_t>((1u << kStatuses) - 1);
+constexpr uint8_t kPreMatch = bit(WaitingOnStart) | bit(Countdown);
+constexpr uint8_t kHalted = kPreMatch | bit(WaitingOnFinalData);
+
+struct Rule {
+  FlameState from;
+  GameEvent event;
+  uint8_t statuses;
+  FlameState to;
+};
+
+const Rule kRules[] = {
+    {ON, GameEvent::ApiTimeout, kAny, ERROR_STATE},
+    {READY, GameEvent::ApiTimeout, kAny, ERROR_STATE},
+    {ACTIVE, GameEvent::ApiTimeout, kAny, ERROR_STATE},
+    {ARMING, GameEvent::ApiTimeout, kAny, ERROR_STATE},
+    {ARMED, GameEvent::ApiTimeout, kAny, ERROR_STATE},
+    {DEFUSED, GameEvent::ApiTimeout, kAny, ERROR_STATE},
+    {DETONATED, GameEvent::ApiTimeout, kAny, ERROR_STATE},
+    {ACTIVE, GameEvent::MatchOver, kAny, READY},
+    {ARMING, GameEvent::MatchOver, kAny, READY},
+    {ARMED, GameEvent::MatchOver, kAny, READY},
+    {ARMED, GameEvent::BombExpired, kAny, DETONATED},
+    {ARMED, GameEvent::DefuseCompleted, kAny, DEFUSED},
+    {ARMED, GameEvent::Neutralized, kAny, ACTIVE},
+    {READY, GameEvent::StatusUpdate, bit(Running), ACTIVE},
+    {ACTIVE, GameEvent::StatusUpdate, kHalted, READY},
+    {ARMING, GameEvent::StatusUpdate, kHalted, READY},
+    {ARMED, GameEvent::StatusUpdate, kPreMatch, READY},
+    {DEFUSED, GameEvent::StatusUpdate, kPreMatch, READY},
+    {DETONATED, GameEvent::StatusUpdate, kPreMatch, READY},
+    {ON, GameEvent::ApiOnline, kAny, READY},
+    {ACTIVE, GameEvent::HoldActive, kAny, ARMING},
+    {ARMING, GameEvent::HoldReleased, kAny, ACTIVE},
+    {ERROR_STATE, GameEvent::HoldCompleted, kAny, ON},
+    {ARMING, GameEvent::ArmingCompleted, kAny, ARMED},
+    {ARMING, GameEvent::IrWindowExpired, kAny, ACTIVE},
+};
+
+game_mode::GameMode neutralMode;
+
+const Rule *ruleFor(FlameState from, GameEvent event, MatchStatus status) {
+  for (const Rule &rule : kRules) {
+    if (rule.from == from && rule.event == event && (rule.statuses & bit(status)) != 0) {
+      return &rule;
+    }
+  }
+  return nullptr;
+}
+
+bool isMatchOver(MatchStatus status) {
+  return status == WaitingOnFinalData || status == Completed || status == Cancelled;
+}
+
+struct Cell {
+  FlameState state;
+  MatchStatus status;
+  GameEvent event;
+
+  // Both buttons are down on the final tick.
+  bool pressed() const {
+    return event == GameEvent::HoldActive || event == GameEvent::HoldCompleted ||
+           event == GameEvent::ArmingCompleted || event == GameEvent::IrWindowExpired;
+  }
+
+  // A hold is started (and, for the arming events, the IR window opened) on priming
+  // ticks before the final one. Not in ACTIVE: the hold itself would start ARMING.
+  bool primed() const {
+    if (state == ACTIVE) {
+      return false;
+    }
+    return event == GameEvent::HoldCompleted ||
+           (state == ARMING && (event == GameEvent::ArmingCompleted || event == GameEvent::IrWindowExpired));
+  }
+
+  // The match is over as far as game_tick() is concerned: it raises MatchOver and
+  // clears the hold and the bomb timer.
+  bool gameOver() const { return isMatchOver(status) && state != DEFUSED && state != DETONATED; }
+
+  // Every event game_tick() raises on the final tick, whether or not a rule takes it.
+  uint16_t raised() const {
+    uint16_t events = eventBit(GameEvent::StatusUpdate);
+    if (event == GameEvent::ApiTimeout || event == GameEvent::ApiOnline) {
+      events |= eventBit(event);
+    }
+    if (gameOver()) {
+      events |= eventBit(GameEvent::MatchOver);
+    }
+    if (state == ARMED && event == GameEvent::BombExpired && !gameOver()) {
+      events |= eventBit(event);
+    }
+    // A WaitingOnStart tick clears the defuse buffer before the last digit is checked.
+    if (state == ARMED && (event == GameEvent::DefuseCompleted || event == GameEvent::Neutralized) &&
+        status != WaitingOnStart) {
+      events |= eventBit(event);
+    }
+    const bool holding = pressed() && !gameOver();
+    events |= eventBit(holding ? GameEvent::HoldActive : GameEvent::HoldReleased);
+    if (holding && primed()) {
+      events |= eventBit(GameEvent::HoldCompleted);
+      if (state == ARMING && event != GameEvent::HoldCompleted) {
+        events |= eventBit(event);
+      }
+    }
+    return events;
+  }
+};
+
+struct Outcome {
+  FlameState state;
+  GameEvent decidedBy;  // GameEvent::Count when no rule applied.
+};
+
+// The first raised event, in priority order, with a rule for the state and status.
+Outcome expectedOutcome(const Cell &cell) {
+  const uint16_t raised = cell.raised();
+  for (size_t e = 0; e < kEvents; ++e) {
+    const GameEvent event = static_cast<GameEvent>(e);
+    if ((raised & eventBit(event)) == 0) {
+      continue;
+    }
+    const Rule *rule = ruleFor(cell.state, event, cell.status);
+    if (rule != nullptr) {
+      return Outcome{rule->to, event};
+    }
+  }
+  return Outcome{cell.state, GameEvent::Count};
+}
+
+GameInputs inputsAt(uint32_t nowMs, MatchStatus status, const Cell &cell) {
+  GameInputs inputs;
+  inputs.nowMs = nowMs;
+  inputs.wifiConnected = true;
+  inputs.lastSuccessfulApiMs = nowMs;
+  inputs.remoteMatchStatus = status;
+  inputs.configuredBombDurationMs = kBombMs;
+  inputs.configuredDefuseCode = kCode;
+  inputs.bothButtonsPressed = cell.pressed();
+  inputs.gameMode = cell.event == GameEvent::Neutralized ? &neutralMode : nullptr;
+  return inputs;
+}
+
+// Puts a fresh engine into `state` at `nowMs`. One idle tick in ON takes the
+// configuration and `mode`; ARMED is then entered with set_state() and all but the last
+// code digit typed.
+void place(GameEngine &engine, FlameState state, uint32_t nowMs, const game_mode::GameMode *mode = nullptr) {
+  const Cell idle = {ON, Running, GameEvent::StatusUpdate};
+  GameOutputs ignored;
+  GameInputs configure = inputsAt(nowMs, WaitingOnStart, idle);
+  configure.gameMode = mode;
+  engine.game_tick(configure, ignored);
+  engine.set_state(state, nowMs);
+  if (state != ARMED) {
+    return;
+  }
+  engine.set_match_status(Running);
+  for (size_t i = 0; i + 1 < DEFUSE_CODE_LENGTH; ++i) {
+    GameInputs inputs = inputsAt(nowMs, Running, idle);
+    inputs.keypadDigitAvailable = true;
+    inputs.keypadDigit = kCode[i];
+    engine.game_tick(inputs, ignored);
+  }
+}
+
+// Runs the cell's scenario and returns the outputs of its final tick.
+GameOutputs runCell(GameEngine &engine, const Cell &cell, const char *label) {
+  uint32_t nowMs = kStartMs;
+  place(engine, cell.state, nowMs, inputsAt(nowMs, cell.status, cell).gameMode);
+
+  if (cell.primed()) {
+    // Priming runs under a status the state has no rule for.
+    const MatchStatus quiet = cell.state == READY ? WaitingOnStart : Running;
+    engine.set_match_status(quiet);
+    GameOutputs ignored;
+    engine.game_tick(inputsAt(nowMs, quiet, cell), ignored);
+    nowMs += BUTTON_HOLD_MS;
+    if (cell.event != GameEvent::HoldCompleted) {
+      // The hold completes and the IR confirmation window opens.
+      engine.game_tick(inputsAt(nowMs, quiet, cell), ignored);
+      TEST_ASSERT_TRUE_MESSAGE(engine.is_ir_confirmation_window_active(), label);
+      nowMs += cell.event == GameEvent::ArmingCompleted ? 10 : IR_CONFIRM_WINDOW_MS;
+    }
+    TEST_ASSERT_EQUAL_MESSAGE(cell.state, engine.get_state(), label);
+  }
+
+  engine.set_match_status(cell.status);
+  GameInputs inputs = inputsAt(nowMs, cell.status, cell);
+  switch (cell.event) {
+    case GameEvent::ApiTimeout:
+      inputs.lastSuccessfulApiMs = nowMs - API_TIMEOUT_MS;
+      break;
+    case GameEvent::BombExpired:
+      inputs.bombDeadlineElapsed = true;
+      break;
+    case GameEvent::DefuseCompleted:
+    case GameEvent::Neutralized:
+      inputs.keypadDigitAvailable = true;
+      inputs.keypadDigit = kCode[DEFUSE_CODE_LENGTH - 1];
+      break;
+    case GameEvent::ApiOnline:
+      inputs.apiResponseReceived = true;
+      break;
+    case GameEvent::ArmingCompleted:
+      inputs.irConfirmationReceived = true;
+      break;
+    default:
+      break;
+  }
+  GameOutputs outputs;
+  engine.game_tick(inputs, outputs);
+  return outputs;
+}
+
+void checkActions(const GameEngine &engine, const GameOutputs &outputs, const Cell &cell, const Outcome &expected,
+                  const char *label) {
+  const FlameState from = cell.state;
+  const FlameState to = expected.state;
+  TEST_ASSERT_EQUAL_MESSAGE(to != from, outputs.stateChanged, label);
+  if (to == from) {
+    return;
+  }
+  TEST_ASSERT_EQUAL_MESSAGE(from, outputs.previousState, label);
+  TEST_ASSERT_EQUAL_MESSAGE(to, outputs.newState, label);
+
+  // ARMED entry starts the bomb countdown; ARMED exit stops it and clears the keypad.
+  if (to == ARMED) {
+    TEST_ASSERT_TRUE_MESSAGE(engine.is_bomb_timer_active(), label);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(kBombMs, engine.get_bomb_timer_duration_ms(), label);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(kBombMs, engine.get_bomb_timer_remaining_ms(), label);
+    TEST_ASSERT_TRUE_MESSAGE(outputs.armingConfirmedEffect, label);
+  }
+  if (from == ARMED) {
+    TEST_ASSERT_FALSE_MESSAGE(engine.is_bomb_timer_active(), label);
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(0, engine.get_defuse_entered_digits(), label);
+    if (to == DEFUSED) {
+      TEST_ASSERT_NOT_EQUAL_MESSAGE(0, engine.get_bomb_timer_remaining_ms(), label);
+    } else {
+      TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, engine.get_bomb_timer_remaining_ms(), label);
+    }
+  }
+  // ARMING exit drops the hold and the confirmation window.
+  if (from == ARMING) {
+    TEST_ASSERT_FALSE_MESSAGE(engine.is_button_hold_active(), label);
+    TEST_ASSERT_FALSE_MESSAGE(engine.is_ir_confirmation_window_active(), label);
+    TEST_ASSERT_TRUE_MESSAGE(outputs.clearIrConfirmation, label);
+  }
+  if (expected.decidedBy == GameEvent::IrWindowExpired) {
+    TEST_ASSERT_TRUE_MESSAGE(outputs.wrongCodeEffect, label);
+  }
+  if (expected.decidedBy == GameEvent::HoldCompleted || expected.decidedBy == GameEvent::Neutralized) {
+    TEST_ASSERT_FALSE_MESSAGE(engine.is_button_hold_active(), label);
+  }
+}
+
+double nsPerTick(std::chrono::steady_clock::duration elapsed, uint32_t ticks) {
+  return std::chrono::duration<double, std::nano>(elapsed).count() / ticks;
+}
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_every_cell() {
+  TEST_ASSERT_EQUAL(game_mode::DefuseOutcome::Neutral, neutralMode.outcome);
+  bool decided[kStates][kEvents] = {};
+  uint32_t cells = 0;
+  for (size_t s = 0; s < kStates; ++s) {
+    for (size_t m = 0; m < kStatuses; ++m) {
+      for (size_t e = 0; e < kEvents; ++e) {
+        const Cell cell = {static_cast<FlameState>(s), static_cast<MatchStatus>(m), static_cast<GameEvent>(e)};
+        char label[64];
+        snprintf(label, sizeof(label), "%s / %s / event %u", game_state::flame_state_to_string(cell.state),
+                 game_state::match_status_to_string(cell.status), static_cast<unsigned>(e));
+
+        GameEngine engine;
+        const GameOutputs outputs = runCell(engine, cell, label);
+        const Outcome expected = expectedOutcome(cell);
+        TEST_ASSERT_EQUAL_MESSAGE(expected.state, engine.get_state(), label);
+        checkActions(engine, outputs, cell, expected, label);
+        if (expected.decidedBy != GameEvent::Count) {
+          decided[s][static_cast<size_t>(expected.decidedBy)] = true;
+        }
+        ++cells;
+      }
+    }
+  }
+  TEST_ASSERT_EQUAL_UINT32(kStates * kStatuses * kEvents, cells);
+
+  // Every rule decided the outcome of at least one cell.
+  for (const Rule &rule : kRules) {
+    char label[48];
+    snprintf(label, sizeof(label), "rule %s / event %u never taken", game_state::flame_state_to_string(rule.from),
+             static_cast<unsigned>(rule.event));
+    TEST_ASSERT_TRUE_MESSAGE(decided[rule.from][static_cast<size_t>(rule.event)], label);
+  }
+}
+
+// The API watchdog counts from the last success with wrapping arithmetic, so it fires
+// on time when the millisecond clock rolls over in between.
+void test_api_timeout_fires_just_past_the_wrap() {
+  const Cell idle = {ACTIVE, Running, GameEvent::StatusUpdate};
+  const uint32_t lastSuccessMs = UINT32_MAX - API_TIMEOUT_MS / 2;
+  GameEngine engine;
+  place(engine, ACTIVE, lastSuccessMs);
+  engine.set_match_status(Running);
+
+  GameOutputs outputs;
+  GameInputs inputs = inputsAt(lastSuccessMs + API_TIMEOUT_MS - 10, Running, idle);
+  inputs.lastSuccessfulApiMs = lastSuccessMs;
+  TEST_ASSERT_TRUE(inputs.nowMs < lastSuccessMs);
+  engine.game_tick(inputs, outputs);
+  TEST_ASSERT_EQUAL(ACTIVE, engine.get_state());
+
+  inputs.nowMs = lastSuccessMs + API_TIMEOUT_MS;
+  engine.game_tick(inputs, outputs);
+  TEST_ASSERT_EQUAL(ERROR_STATE, engine.get_state());
+  TEST_ASSERT_TRUE(outputs.stateChanged);
+}
+
+// game_tick() cost on the two paths a round spends its time in: ACTIVE with nothing
+// happening, and an ARMED countdown (re-armed whenever it detonates).
+void test_tick_throughput() {
+  constexpr uint32_t kTicks = 2000000;
+  const Cell idle = {ACTIVE, Running, GameEvent::StatusUpdate};
+
+  GameEngine active;
+  place(active, ACTIVE, kStartMs);
+  active.set_match_status(Running);
+  uint32_t nowMs = kStartMs;
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < kTicks; ++i) {
+    nowMs += 10;
+    GameOutputs outputs;
+    active.game_tick(inputsAt(nowMs, Running, idle), outputs);
+  }
+  const double activeNs = nsPerTick(std::chrono::steady_clock::now() - start, kTicks);
+  TEST_ASSERT_EQUAL(ACTIVE, active.get_state());
+
+  GameEngine armed;
+  place(armed, ARMED, kStartMs);
+  nowMs = kStartMs;
+  uint32_t detonations = 0;
+  start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < kTicks; ++i) {
+    nowMs += 10;
+    GameOutputs outputs;
+    armed.game_tick(inputsAt(nowMs, Running, idle), outputs);
+    if (outputs.stateChanged) {
+      ++detonations;
+      place(armed, ARMED, nowMs);
+    }
+  }
+  const double armedNs = nsPerTick(std::chrono::steady_clock::now() - start, kTicks);
+  TEST_ASSERT_EQUAL_UINT32(kTicks * 10 / kBombMs, detonations);
+
+  char message[96];
+  snprintf(message, sizeof(message), "game_tick ns/tick: ACTIVE %.1f, ARMED countdown %.1f", activeNs, armedNs);
+  TEST_MESSAGE(message);
+}
+
+int main() {
+  game_mode::compile("outcome=neutral", neutralMode);
+
+  UNITY_BEGIN();
+  RUN_TEST(test_every_cell);
+  RUN_TEST(test_api_timeout_fires_just_past_the_wrap);
+  RUN_TEST(test_tick_throughput);
+  return UNITY_END();
+}
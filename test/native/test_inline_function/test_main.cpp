@@ -0,0 +1,135 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unity.h>
+
+#include <chrono>
+#include <functional>
+#include <new>
+
+#include "core/inline_function.h"
+
+// Counts heap allocations made by this test program.
+namespace {
+size_t allocations = 0;
+}  // namespace
+
+void *operator new(size_t size) {
+  ++allocations;
+  void *block = malloc(size != 0 ? size : 1);
+  if (block == nullptr) {
+    throw std::bad_alloc();
+  }
+  return block;
+}
+
+void operator delete(void *block) noexcept { free(block); }
+
+void operator delete(void *block, size_t) noexcept { free(block); }
+
+namespace {
+using Callback = InlineFunction<void(uint32_t)>;
+
+constexpr size_t kTableSize = 16;  // scheduler::kMaxTasks
+constexpr uint32_t kPasses = 1000000;
+
+volatile uint32_t sink = 0;
+
+void addToSink(uint32_t value) { sink = sink + value; }
+
+// Runs every entry of `table` kPasses times, as the dispatcher does, and returns ns per call.
+template <typename Table>
+double dispatchNs(const Table &table) {
+  const auto start = std::chrono::steady_clock::now();
+  for (uint32_t pass = 0; pass < kPasses; ++pass) {
+    for (size_t i = 0; i < kTableSize; ++i) {
+      table[i](pass);
+    }
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::nano>(elapsed).count() / (static_cast<double>(kPasses) * kTableSize);
+}
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_empty_and_invocation() {
+  Callback empty;
+  TEST_ASSERT_FALSE(static_cast<bool>(empty));
+
+  uint32_t total = 0;
+  uint32_t calls = 0;
+  uint32_t *totalPtr = &total;
+  uint32_t *callsPtr = &calls;
+  Callback callback = [totalPtr, callsPtr](uint32_t value) {
+    *totalPtr += value;
+    ++*callsPtr;
+  };
+  TEST_ASSERT_TRUE(static_cast<bool>(callback));
+  Callback copy = callback;
+  callback(40);
+  copy(2);
+  TEST_ASSERT_EQUAL_UINT32(42, total);
+  TEST_ASSERT_EQUAL_UINT32(2, calls);
+
+  Callback plain = addToSink;
+  sink = 0;
+  plain(7);
+  TEST_ASSERT_EQUAL_UINT32(7, sink);
+}
+
+void test_never_allocates() {
+  uint32_t counter = 0;
+  uint32_t *target = &counter;
+  const size_t before = allocations;
+  Callback table[kTableSize];
+  for (size_t i = 0; i < kTableSize; ++i) {
+    table[i] = [target, i](uint32_t) { *target += static_cast<uint32_t>(i); };
+  }
+  Callback copies[kTableSize];
+  for (size_t i = 0; i < kTableSize; ++i) {
+    copies[i] = table[i];
+    copies[i](0);
+  }
+  TEST_ASSERT_EQUAL_UINT32(before, allocations);
+  TEST_ASSERT_EQUAL_UINT32(120, counter);
+
+  // For comparison: std::function moves a capture of three pointers to the heap.
+  uint32_t *a = &counter;
+  uint32_t *b = &counter;
+  uint32_t *c = &counter;
+  std::function<void(uint32_t)> heapy = [a, b, c](uint32_t value) { *a += value + *b + *c; };
+  heapy(0);
+  TEST_ASSERT_GREATER_THAN(before, allocations);
+}
+
+void test_dispatch_cost_against_std_function() {
+  Callback inlineTable[kTableSize];
+  std::function<void(uint32_t)> stdTable[kTableSize];
+  uint32_t counters[kTableSize] = {};
+  for (size_t i = 0; i < kTableSize; ++i) {
+    uint32_t *counter = &counters[i];
+    inlineTable[i] = [counter](uint32_t value) { *counter += value; };
+    stdTable[i] = [counter](uint32_t value) { *counter += value; };
+  }
+
+  const double inlineNs = dispatchNs(inlineTable);
+  const double stdNs = dispatchNs(stdTable);
+  const uint32_t expected = static_cast<uint32_t>(2ull * (static_cast<uint64_t>(kPasses) * (kPasses - 1) / 2));
+  for (size_t i = 0; i < kTableSize; ++i) {
+    TEST_ASSERT_EQUAL_UINT32(expected, counters[i]);
+  }
+
+  char message[96];
+  snprintf(message, sizeof(message), "dispatch ns/call: InlineFunction %.2f, std::function %.2f", inlineNs, stdNs);
+  TEST_MESSAGE(message);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_empty_and_invocation);
+  RUN_TEST(test_never_allocates);
+  RUN_TEST(test_dispatch_cost_against_std_function);
+  return UNITY_END();
+}
@@ -0,0 +1,129 @@
+#include <freertos/task.h>
+#include <unity.h>
+
+#include "core/clock.h"
+#include "core/load_governor.h"
+#include "core/scheduler.h"
+#include "game_config.h"
+
+// A render task registered ahead of the state tick burns virtual time in each pass, so
+// the state tick starts late by exactly that much. Each sample window runs the
+// scheduler for GOVERNOR_SAMPLE_INTERVAL_MS and then closes it with update(). The
+// governor keeps static state, so the tests below build on each other and run in order.
+namespace {
+constexpr uint32_t kTickMs = 10;
+constexpr uint32_t kNominalFrameMs = 40;
+constexpr uint32_t kStallUs = GOVERNOR_SHED_LATENESS_US + 2000;
+constexpr uint32_t kUnsettledUs = (GOVERNOR_RESTORE_LATENESS_US + GOVERNOR_SHED_LATENESS_US) / 2;
+
+uint64_t virtualUs = 1000000;
+uint32_t renderCostUs = 0;
+uint32_t frameIntervalMs = 0;
+uint32_t lastUpdateMs = 0;
+uint32_t expectedDegradedMs = 0;
+
+uint64_t readVirtualClock() { return virtualUs; }
+
+void sleepVirtually(TickType_t waitTicks) { virtualUs += static_cast<uint64_t>(waitTicks) * 1000; }
+
+void setFrameInterval(uint32_t intervalMs) { frameIntervalMs = intervalMs; }
+
+// Runs one sample window with the given render cost and closes it.
+void runWindow(uint32_t costUs) {
+  renderCostUs = costUs;
+  const uint32_t startMs = sys_clock::nowMs();
+  while (sys_clock::nowMs() - startMs < GOVERNOR_SAMPLE_INTERVAL_MS) {
+    scheduler::run();
+  }
+  const uint32_t nowMs = sys_clock::nowMs();
+  if (load_governor::getLevel() > 0) {
+    expectedDegradedMs += nowMs - lastUpdateMs;
+  }
+  lastUpdateMs = nowMs;
+  load_governor::update(nowMs);
+}
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_sheds_one_level_per_late_window_up_to_the_cap() {
+  TEST_ASSERT_NOT_EQUAL(scheduler::kInvalidTask,
+                        scheduler::addTask("render", [](uint32_t) { virtualUs += renderCostUs; }, kTickMs));
+  const scheduler::TaskId state = scheduler::addTask("state", [](uint32_t) {}, kTickMs);
+  TEST_ASSERT_NOT_EQUAL(scheduler::kInvalidTask, state);
+  load_governor::watch(state);
+  TEST_ASSERT_TRUE(load_governor::addSheddable(kNominalFrameMs, setFrameInterval));
+  TEST_ASSERT_EQUAL_UINT32(kNominalFrameMs, frameIntervalMs);
+
+  // A calm start changes nothing.
+  lastUpdateMs = sys_clock::nowMs();
+  runWindow(0);
+  TEST_ASSERT_EQUAL(0, load_governor::getLevel());
+
+  for (uint8_t level = 1; level <= GOVERNOR_MAX_LEVEL; ++level) {
+    runWindow(kStallUs);
+    TEST_ASSERT_EQUAL(level, load_governor::getLevel());
+    TEST_ASSERT_EQUAL_UINT32(kNominalFrameMs << level, frameIntervalMs);
+    TEST_ASSERT_EQUAL_UINT32(lastUpdateMs, load_governor::getStats().lastEscalationMs);
+  }
+
+  // Still late at the cap: no further level, no further escalation.
+  runWindow(kStallUs);
+  runWindow(kStallUs);
+  const load_governor::Stats stats = load_governor::getStats();
+  TEST_ASSERT_EQUAL(GOVERNOR_MAX_LEVEL, stats.level);
+  TEST_ASSERT_EQUAL_UINT32(GOVERNOR_MAX_LEVEL, stats.escalations);
+  TEST_ASSERT_EQUAL_UINT32(kNominalFrameMs << GOVERNOR_MAX_LEVEL, frameIntervalMs);
+  TEST_ASSERT_EQUAL_UINT32(kStallUs, stats.peakLatenessUs);
+}
+
+void test_restores_only_after_enough_calm_windows_in_a_row() {
+  for (uint8_t i = 0; i + 1 < GOVERNOR_RESTORE_WINDOWS; ++i) {
+    runWindow(0);
+  }
+  TEST_ASSERT_EQUAL(GOVERNOR_MAX_LEVEL, load_governor::getLevel());
+
+  // Lateness between the two thresholds neither sheds nor counts as calm: the run of
+  // calm windows starts over.
+  runWindow(kUnsettledUs);
+  TEST_ASSERT_EQUAL(GOVERNOR_MAX_LEVEL, load_governor::getLevel());
+  for (uint8_t i = 0; i + 1 < GOVERNOR_RESTORE_WINDOWS; ++i) {
+    runWindow(0);
+  }
+  TEST_ASSERT_EQUAL(GOVERNOR_MAX_LEVEL, load_governor::getLevel());
+
+  runWindow(0);
+  TEST_ASSERT_EQUAL(GOVERNOR_MAX_LEVEL - 1, load_governor::getLevel());
+  TEST_ASSERT_EQUAL_UINT32(kNominalFrameMs << (GOVERNOR_MAX_LEVEL - 1), frameIntervalMs);
+  TEST_ASSERT_EQUAL_UINT32(1, load_governor::getStats().restorations);
+}
+
+void test_counts_degraded_time_and_peak_level() {
+  while (load_governor::getLevel() > 0) {
+    runWindow(0);
+  }
+  TEST_ASSERT_EQUAL_UINT32(kNominalFrameMs, frameIntervalMs);
+
+  // Back at level 0, further windows add no degraded time.
+  runWindow(0);
+  runWindow(0);
+  const load_governor::Stats stats = load_governor::getStats();
+  TEST_ASSERT_EQUAL_UINT32(expectedDegradedMs, stats.degradedMs);
+  TEST_ASSERT_GREATER_THAN(0, stats.degradedMs);
+  TEST_ASSERT_EQUAL(GOVERNOR_MAX_LEVEL, stats.peakLevel);
+  TEST_ASSERT_EQUAL_UINT32(GOVERNOR_MAX_LEVEL, stats.restorations);
+  TEST_ASSERT_EQUAL_UINT32(GOVERNOR_MAX_LEVEL, stats.escalations);
+}
+
+int main() {
+  sys_clock::setHostTimeSource(readVirtualClock);
+  host_rtos::state().onBlock = sleepVirtually;
+
+  UNITY_BEGIN();
+  RUN_TEST(test_sheds_one_level_per_late_window_up_to_the_cap);
+  RUN_TEST(test_restores_only_after_enough_calm_windows_in_a_row);
+  RUN_TEST(test_counts_degraded_time_and_peak_level);
+  return UNITY_END();
+}
@@ -0,0 +1,97 @@
+#include <unity.h>
+
+#include "core/report_cadence.h"
+
+using report_cadence::nextIntervalMs;
+
+namespace {
+constexpr uint32_t kLongTimerMs = API_FINAL_COUNTDOWN_MS + 20000;
+
+uint32_t backoffWindowMs(uint8_t failures) {
+  uint32_t windowMs = API_BACKOFF_BASE_MS;
+  for (uint8_t i = 1; i < failures && windowMs < API_MAX_POST_INTERVAL_MS; ++i) {
+    windowMs *= 2;
+  }
+  return windowMs < API_MAX_POST_INTERVAL_MS ? windowMs : API_MAX_POST_INTERVAL_MS;
+}
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_per_state_intervals() {
+  TEST_ASSERT_EQUAL_UINT32(API_IDLE_POST_INTERVAL_MS, nextIntervalMs(ON, kLongTimerMs, 0, 0, 0));
+  TEST_ASSERT_EQUAL_UINT32(API_IDLE_POST_INTERVAL_MS, nextIntervalMs(READY, kLongTimerMs, 0, 0, 0));
+  TEST_ASSERT_EQUAL_UINT32(API_ACTIVE_POST_INTERVAL_MS, nextIntervalMs(ACTIVE, kLongTimerMs, 0, 0, 0));
+  TEST_ASSERT_EQUAL_UINT32(API_POST_INTERVAL_MS, nextIntervalMs(ARMING, kLongTimerMs, 0, 0, 0));
+  TEST_ASSERT_EQUAL_UINT32(API_POST_INTERVAL_MS, nextIntervalMs(ARMED, kLongTimerMs, 0, 0, 0));
+  TEST_ASSERT_EQUAL_UINT32(API_ACTIVE_POST_INTERVAL_MS, nextIntervalMs(DEFUSED, 0, 0, 0, 0));
+  TEST_ASSERT_EQUAL_UINT32(API_ACTIVE_POST_INTERVAL_MS, nextIntervalMs(DETONATED, 0, 0, 0, 0));
+  TEST_ASSERT_EQUAL_UINT32(API_POST_INTERVAL_MS, nextIntervalMs(ERROR_STATE, kLongTimerMs, 0, 0, 0));
+  // Idle states ignore the timer they carry (the configured bomb duration).
+  TEST_ASSERT_EQUAL_UINT32(API_IDLE_POST_INTERVAL_MS, nextIntervalMs(READY, 1000, 0, 0, 0));
+}
+
+void test_server_interval_replaces_the_state_interval_within_bounds() {
+  TEST_ASSERT_EQUAL_UINT32(1500, nextIntervalMs(READY, kLongTimerMs, 0, 1500, 0));
+  TEST_ASSERT_EQUAL_UINT32(1500, nextIntervalMs(ACTIVE, kLongTimerMs, 0, 1500, 0));
+  TEST_ASSERT_EQUAL_UINT32(API_MIN_POST_INTERVAL_MS, nextIntervalMs(READY, kLongTimerMs, 0, 1, 0));
+  TEST_ASSERT_EQUAL_UINT32(API_MAX_POST_INTERVAL_MS, nextIntervalMs(READY, kLongTimerMs, 0, 60000, 0));
+}
+
+void test_final_countdown_clamps_armed_reports() {
+  TEST_ASSERT_EQUAL_UINT32(API_POST_INTERVAL_MS, nextIntervalMs(ARMED, API_FINAL_COUNTDOWN_MS + 1, 0, 0, 0));
+  TEST_ASSERT_EQUAL_UINT32(API_FINAL_POST_INTERVAL_MS, nextIntervalMs(ARMED, API_FINAL_COUNTDOWN_MS, 0, 0, 0));
+  TEST_ASSERT_EQUAL_UINT32(API_FINAL_POST_INTERVAL_MS, nextIntervalMs(ARMED, 0, 0, 0, 0));
+  // A slower server suggestion does not slow the end of a countdown; a faster one stands.
+  TEST_ASSERT_EQUAL_UINT32(API_FINAL_POST_INTERVAL_MS, nextIntervalMs(ARMED, 5000, 0, 2000, 0));
+  TEST_ASSERT_EQUAL_UINT32(API_MIN_POST_INTERVAL_MS, nextIntervalMs(ARMED, 5000, 0, API_MIN_POST_INTERVAL_MS, 0));
+  // Only ARMED has a countdown to clamp for.
+  TEST_ASSERT_EQUAL_UINT32(API_ACTIVE_POST_INTERVAL_MS, nextIntervalMs(DEFUSED, 5000, 0, 0, 0));
+}
+
+void test_failures_back_off_exponentially_with_jitter() {
+  uint32_t previousWindowMs = 0;
+  for (uint8_t failures = 1; failures <= 6; ++failures) {
+    const uint32_t windowMs = backoffWindowMs(failures);
+    TEST_ASSERT_TRUE(windowMs >= previousWindowMs);
+    previousWindowMs = windowMs;
+
+    // The jitter spans the upper half of the window, both ends included.
+    TEST_ASSERT_EQUAL_UINT32(windowMs / 2, nextIntervalMs(ACTIVE, kLongTimerMs, failures, 0, 0));
+    TEST_ASSERT_EQUAL_UINT32(windowMs, nextIntervalMs(ACTIVE, kLongTimerMs, failures, 0, windowMs / 2));
+    for (uint32_t random = 0; random < 5000; random += 7) {
+      const uint32_t intervalMs = nextIntervalMs(ACTIVE, kLongTimerMs, failures, 0, random * 2654435761u);
+      TEST_ASSERT_TRUE(intervalMs >= windowMs / 2 && intervalMs <= windowMs);
+    }
+  }
+  TEST_ASSERT_EQUAL_UINT32(API_BACKOFF_BASE_MS, nextIntervalMs(ACTIVE, kLongTimerMs, 1, 0, API_BACKOFF_BASE_MS / 2));
+  TEST_ASSERT_EQUAL_UINT32(2 * API_BACKOFF_BASE_MS,
+                           nextIntervalMs(ACTIVE, kLongTimerMs, 2, 0, API_BACKOFF_BASE_MS));
+}
+
+void test_backoff_is_capped_and_overrides_server_and_countdown() {
+  for (uint32_t failures = 1; failures <= 255; ++failures) {
+    TEST_ASSERT_TRUE(nextIntervalMs(READY, kLongTimerMs, static_cast<uint8_t>(failures), 0, 0xFFFFFFFFu) <=
+                     API_MAX_POST_INTERVAL_MS);
+  }
+  TEST_ASSERT_EQUAL_UINT32(API_MAX_POST_INTERVAL_MS,
+                           nextIntervalMs(READY, kLongTimerMs, 255, 0, API_MAX_POST_INTERVAL_MS / 2));
+
+  // While the backend fails, neither its last suggestion nor the final countdown rate
+  // brings the retries back to full speed.
+  TEST_ASSERT_EQUAL_UINT32(API_BACKOFF_BASE_MS / 2,
+                           nextIntervalMs(ACTIVE, kLongTimerMs, 1, API_MIN_POST_INTERVAL_MS, 0));
+  TEST_ASSERT_EQUAL_UINT32(API_BACKOFF_BASE_MS / 2, nextIntervalMs(ARMED, 1000, 1, 0, 0));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_per_state_intervals);
+  RUN_TEST(test_server_interval_replaces_the_state_interval_within_bounds);
+  RUN_TEST(test_final_countdown_clamps_armed_reports);
+  RUN_TEST(test_failures_back_off_exponentially_with_jitter);
+  RUN_TEST(test_backoff_is_capped_and_overrides_server_and_countdown);
+  return UNITY_END();
+}
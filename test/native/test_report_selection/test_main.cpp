@@ -0,0 +1,108 @@
+#include <unity.h>
+
+#include "core/report_selection.h"
+
+using report_selection::Report;
+
+// Drives report_selection the way the ApiTask does, one pass at a time. The module
+// keeps its counters and queue position across tests, so each test compares against
+// the stats it starts from and keeps queueing onto the same running count.
+namespace {
+constexpr uint32_t kIntervalMs = 5000;
+
+report_selection::Pass pass;
+
+Report runPass(uint32_t advanceMs) {
+  pass.nowMs += advanceMs;
+  const Report report = report_selection::select(pass);
+  if (report != Report::None) {
+    pass.requested = false;
+    pass.inFlight = true;
+  }
+  return report;
+}
+
+// Sends whatever is left over and then a heartbeat, each completing at once, so a test
+// begins with nothing queued and nothing in flight.
+void settle() {
+  pass.linkUp = true;
+  Report report = Report::None;
+  for (int i = 0; i < 3 && report != Report::Heartbeat; ++i) {
+    pass.inFlight = false;
+    report = runPass(kIntervalMs);
+  }
+  pass.inFlight = false;
+  TEST_ASSERT_EQUAL(Report::Heartbeat, report);
+}
+}  // namespace
+
+void setUp() {
+  report_selection::setIntervalMs(kIntervalMs);
+  settle();
+}
+
+void tearDown() {}
+
+void test_transitions_queued_between_passes_go_out_as_one() {
+  const report_selection::Stats before = report_selection::getStats();
+  pass.transitions += 3;  // ACTIVE -> ARMING -> ARMED -> DEFUSED within one pass.
+
+  TEST_ASSERT_EQUAL(Report::Transition, runPass(10));
+  pass.inFlight = false;
+  TEST_ASSERT_EQUAL(Report::None, runPass(10));
+
+  const report_selection::Stats after = report_selection::getStats();
+  TEST_ASSERT_EQUAL_UINT32(before.transitions + 1, after.transitions);
+  TEST_ASSERT_EQUAL_UINT32(before.coalesced + 2, after.coalesced);
+  TEST_ASSERT_EQUAL_UINT32(before.heartbeats, after.heartbeats);
+
+  // A single transition is not coalesced with anything.
+  ++pass.transitions;
+  TEST_ASSERT_EQUAL(Report::Transition, runPass(10));
+  TEST_ASSERT_EQUAL_UINT32(after.coalesced, report_selection::getStats().coalesced);
+}
+
+void test_urgent_report_replaces_a_heartbeat_in_flight() {
+  TEST_ASSERT_EQUAL(Report::None, runPass(kIntervalMs - 20));
+  TEST_ASSERT_EQUAL(Report::Heartbeat, runPass(20));
+  TEST_ASSERT_EQUAL_UINT32(kIntervalMs, report_selection::msUntilHeartbeat(pass.nowMs));
+
+  // While the heartbeat is in flight, a due heartbeat waits for it...
+  TEST_ASSERT_EQUAL(Report::None, runPass(kIntervalMs));
+  TEST_ASSERT_EQUAL_UINT32(0, report_selection::msUntilHeartbeat(pass.nowMs));
+  // ...but a transition, or an explicit request, takes its slot.
+  ++pass.transitions;
+  TEST_ASSERT_EQUAL(Report::Transition, runPass(10));
+  TEST_ASSERT_EQUAL_UINT32(kIntervalMs, report_selection::msUntilHeartbeat(pass.nowMs));
+  pass.requested = true;
+  TEST_ASSERT_EQUAL(Report::Heartbeat, runPass(10));
+  TEST_ASSERT_EQUAL(Report::None, runPass(10));
+}
+
+void test_transition_waits_for_the_link() {
+  const report_selection::Stats before = report_selection::getStats();
+  pass.linkUp = false;
+  ++pass.transitions;
+  for (int i = 0; i < 5; ++i) {
+    TEST_ASSERT_EQUAL(Report::None, runPass(kIntervalMs));
+  }
+  // A second transition while the link is down replaces the first.
+  ++pass.transitions;
+  TEST_ASSERT_EQUAL(Report::None, runPass(10));
+
+  pass.linkUp = true;
+  TEST_ASSERT_EQUAL(Report::Transition, runPass(10));
+  const report_selection::Stats after = report_selection::getStats();
+  TEST_ASSERT_EQUAL_UINT32(before.transitions + 1, after.transitions);
+  TEST_ASSERT_EQUAL_UINT32(before.coalesced + 1, after.coalesced);
+  TEST_ASSERT_EQUAL_UINT32(before.heartbeats, after.heartbeats);
+}
+
+int main() {
+  pass.nowMs = 1000;
+  UNITY_BEGIN();
+  RUN_TEST(test_transitions_queued_between_passes_go_out_as_one);
+  RUN_TEST(test_urgent_report_replaces_a_heartbeat_in_flight);
+  RUN_TEST(test_transition_waits_for_the_link);
+  return UNITY_END();
+}
@@ -0,0 +1,149 @@
+#include <string.h>
+#include <unity.h>
+
+#include "core/resume_codec.h"
+
+using resume_codec::ResetReason;
+
+// Snapshots saved before a reset and decoded after it, on a made-up RTC clock.
+namespace {
+constexpr uint64_t kSavedAtUs = 5000000000ULL;
+constexpr uint32_t kBombMs = 45000;
+
+ResumePoint armedPoint(uint32_t remainingMs) {
+  ResumePoint point;
+  point.state = ARMED;
+  point.matchStatus = Running;
+  point.bombDurationMs = kBombMs;
+  point.bombRemainingMs = remainingMs;
+  point.enteredDigits = 2;
+  memcpy(point.defuseBuffer, "73", 3);
+  return point;
+}
+
+// A point that decoding must not touch.
+ResumePoint untouched() {
+  ResumePoint point;
+  point.state = READY;
+  point.bombRemainingMs = 1;
+  return point;
+}
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_only_warm_resets_resume() {
+  const resume_codec::Snapshot saved = resume_codec::encode(armedPoint(30000), kSavedAtUs);
+  const ResetReason warm[] = {ResetReason::Brownout, ResetReason::Panic, ResetReason::InterruptWatchdog,
+                              ResetReason::TaskWatchdog, ResetReason::OtherWatchdog};
+  const ResetReason cold[] = {ResetReason::PowerOn, ResetReason::External, ResetReason::Software,
+                              ResetReason::DeepSleep, ResetReason::Unknown};
+  for (ResetReason reason : warm) {
+    ResumePoint point;
+    TEST_ASSERT_TRUE(resume_codec::decode(saved, reason, kSavedAtUs, point));
+    TEST_ASSERT_EQUAL(ARMED, point.state);
+  }
+  for (ResetReason reason : cold) {
+    ResumePoint point = untouched();
+    TEST_ASSERT_FALSE(resume_codec::decode(saved, reason, kSavedAtUs, point));
+    TEST_ASSERT_EQUAL(READY, point.state);
+  }
+}
+
+void test_rejects_a_bad_magic_or_checksum() {
+  const resume_codec::Snapshot good = resume_codec::encode(armedPoint(30000), kSavedAtUs);
+
+  resume_codec::Snapshot badMagic = good;
+  badMagic.magic ^= 1;
+  // Every other field changed by one bit, as RTC garbage or a half-written save would.
+  resume_codec::Snapshot flipped[] = {good, good, good, good, good};
+  flipped[0].state ^= 1;
+  flipped[1].enteredDigits ^= 1;
+  flipped[2].defuseBuffer[0] ^= 1;
+  flipped[3].deadlineRtcUs ^= 1ULL << 40;
+  flipped[4].checksum ^= 1;
+
+  ResumePoint point = untouched();
+  TEST_ASSERT_FALSE(resume_codec::decode(badMagic, ResetReason::Brownout, kSavedAtUs, point));
+  for (const resume_codec::Snapshot &saved : flipped) {
+    TEST_ASSERT_FALSE(resume_codec::decode(saved, ResetReason::Brownout, kSavedAtUs, point));
+  }
+  TEST_ASSERT_EQUAL(READY, point.state);
+  TEST_ASSERT_EQUAL_UINT32(1, point.bombRemainingMs);
+
+  // All zeroes, as after a power-on that happened to pass the reason check.
+  resume_codec::Snapshot zeroes;
+  memset(&zeroes, 0, sizeof(zeroes));
+  TEST_ASSERT_FALSE(resume_codec::decode(zeroes, ResetReason::Panic, kSavedAtUs, point));
+}
+
+void test_only_armed_defused_and_detonated_resume() {
+  const FlameState states[] = {ON, READY, ACTIVE, ARMING, ARMED, DEFUSED, DETONATED, ERROR_STATE};
+  for (FlameState state : states) {
+    ResumePoint saved = armedPoint(30000);
+    saved.state = state;
+    ResumePoint point = untouched();
+    const bool resumed =
+        resume_codec::decode(resume_codec::encode(saved, kSavedAtUs), ResetReason::Brownout, kSavedAtUs, point);
+    const bool expected = state == ARMED || state == DEFUSED || state == DETONATED;
+    TEST_ASSERT_EQUAL_MESSAGE(expected, resumed, game_state::flame_state_to_string(state));
+    TEST_ASSERT_EQUAL(expected ? state : READY, point.state);
+  }
+
+  // DEFUSED keeps its frozen time.
+  ResumePoint defused = armedPoint(12345);
+  defused.state = DEFUSED;
+  ResumePoint point;
+  TEST_ASSERT_TRUE(resume_codec::decode(resume_codec::encode(defused, kSavedAtUs), ResetReason::Panic,
+                                        kSavedAtUs + 60000000ULL, point));
+  TEST_ASSERT_EQUAL_UINT32(12345, point.bombRemainingMs);
+  TEST_ASSERT_EQUAL(Running, point.matchStatus);
+  TEST_ASSERT_EQUAL_UINT32(kBombMs, point.bombDurationMs);
+  TEST_ASSERT_EQUAL_UINT8(0, point.enteredDigits);
+}
+
+void test_armed_past_its_deadline_comes_back_detonated() {
+  const resume_codec::Snapshot saved = resume_codec::encode(armedPoint(2000), kSavedAtUs);
+
+  ResumePoint point;
+  TEST_ASSERT_TRUE(resume_codec::decode(saved, ResetReason::Brownout, kSavedAtUs + 2000000ULL, point));
+  TEST_ASSERT_EQUAL(DETONATED, point.state);
+  TEST_ASSERT_EQUAL_UINT32(0, point.bombRemainingMs);
+  TEST_ASSERT_EQUAL_UINT8(0, point.enteredDigits);
+  TEST_ASSERT_EQUAL_STRING("", point.defuseBuffer);
+
+  TEST_ASSERT_TRUE(resume_codec::decode(saved, ResetReason::Brownout, kSavedAtUs + 90000000ULL, point));
+  TEST_ASSERT_EQUAL(DETONATED, point.state);
+}
+
+void test_remaining_time_rounds_up_to_whole_ms() {
+  const resume_codec::Snapshot saved = resume_codec::encode(armedPoint(30000), kSavedAtUs);
+
+  ResumePoint point;
+  TEST_ASSERT_TRUE(resume_codec::decode(saved, ResetReason::TaskWatchdog, kSavedAtUs + 1500, point));
+  TEST_ASSERT_EQUAL(ARMED, point.state);
+  TEST_ASSERT_EQUAL_UINT32(29999, point.bombRemainingMs);
+  TEST_ASSERT_EQUAL_UINT32(kBombMs, point.bombDurationMs);
+  TEST_ASSERT_EQUAL_UINT8(2, point.enteredDigits);
+  TEST_ASSERT_EQUAL_STRING("73", point.defuseBuffer);
+
+  TEST_ASSERT_TRUE(resume_codec::decode(saved, ResetReason::TaskWatchdog, kSavedAtUs + 2000, point));
+  TEST_ASSERT_EQUAL_UINT32(29998, point.bombRemainingMs);
+
+  // One microsecond before the deadline is still a millisecond to go, not a detonation.
+  TEST_ASSERT_TRUE(resume_codec::decode(saved, ResetReason::TaskWatchdog, kSavedAtUs + 30000000ULL - 1, point));
+  TEST_ASSERT_EQUAL(ARMED, point.state);
+  TEST_ASSERT_EQUAL_UINT32(1, point.bombRemainingMs);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_only_warm_resets_resume);
+  RUN_TEST(test_rejects_a_bad_magic_or_checksum);
+  RUN_TEST(test_only_armed_defused_and_detonated_resume);
+  RUN_TEST(test_armed_past_its_deadline_comes_back_detonated);
+  RUN_TEST(test_remaining_time_rounds_up_to_whole_ms);
+  return UNITY_END();
+}
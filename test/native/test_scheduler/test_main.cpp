@@ -0,0 +1,177 @@
+#include <freertos/task.h>
+#include <stdio.h>
+#include <unity.h>
+
+#include <set>
+
+#include "core/clock.h"
+#include "core/scheduler.h"
+
+// The scheduler keeps one static task table, so the tests below build on each other
+// and run in order. Time is virtual: it only moves while run() would block.
+namespace {
+constexpr uint32_t kEpochMs = 5000;  // Virtual time when the first task is registered.
+constexpr uint32_t kSpanMs = 10000;
+
+uint64_t virtualUs = static_cast<uint64_t>(kEpochMs) * 1000;
+uint32_t foreverWaits = 0;
+
+uint64_t readVirtualClock() { return virtualUs; }
+
+void sleepVirtually(TickType_t waitTicks) {
+  if (waitTicks == portMAX_DELAY) {
+    ++foreverWaits;
+    return;
+  }
+  virtualUs += static_cast<uint64_t>(waitTicks) * 1000;
+}
+
+struct Probe {
+  uint32_t intervalMs;
+  uint32_t phaseMs;
+  uint32_t runs;
+  uint32_t offGrid;  // Dispatches that did not land exactly on the task's next deadline.
+
+  void record(uint32_t nowMs) {
+    if (nowMs != kEpochMs + phaseMs + runs * intervalMs || sys_clock::nowMs() != nowMs) {
+      ++offGrid;
+    }
+    ++runs;
+  }
+};
+
+// The cadences registered in setup(): inputs, state, effects, UI and portal.
+Probe probes[] = {{30, 0, 0, 0}, {10, 0, 0, 0}, {42, 3, 0, 0}, {42, 24, 0, 0}, {200, 107, 0, 0}};
+
+struct IdleFrame : Coroutine {};
+IdleFrame idleFrame;
+
+CoStatus runIdle(IdleFrame &co, uint32_t) {
+  CO_BEGIN(co);
+  CO_END(co);
+}
+
+// Each step burns kStepCostMs of virtual time, longer than the 1 ms a coroutine task is
+// registered with but well inside its sleeps.
+constexpr uint32_t kStepCostMs = 5;
+constexpr uint32_t kStepSleepMs = 50;
+
+struct StepsFrame : Coroutine {
+  uint8_t step;
+};
+StepsFrame stepsFrame;
+uint32_t stepsRun = 0;
+
+CoStatus runSteps(StepsFrame &co, uint32_t) {
+  CO_BEGIN(co);
+  for (co.step = 0; co.step < 3; ++co.step) {
+    ++stepsRun;
+    virtualUs += kStepCostMs * 1000;
+    CO_SLEEP_MS(co, kStepSleepMs);
+  }
+  ++stepsRun;
+  CO_END(co);
+}
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_blocks_indefinitely_without_runnable_tasks() {
+  TEST_ASSERT_EQUAL_UINT32(scheduler::kNoDeadline, scheduler::msUntilNextDeadline(sys_clock::nowMs()));
+  scheduler::run();
+  TEST_ASSERT_EQUAL_UINT32(portMAX_DELAY, host_rtos::state().lastWaitTicks);
+  TEST_ASSERT_EQUAL_UINT32(1, foreverWaits);
+
+  // A parked coroutine is not runnable either.
+  TEST_ASSERT_NOT_EQUAL(scheduler::kInvalidTask, scheduler::addCoroutine("idle", idleFrame, runIdle));
+  TEST_ASSERT_EQUAL_UINT32(scheduler::kNoDeadline, scheduler::msUntilNextDeadline(sys_clock::nowMs()));
+  scheduler::run();
+  TEST_ASSERT_EQUAL_UINT32(portMAX_DELAY, host_rtos::state().lastWaitTicks);
+  TEST_ASSERT_EQUAL_UINT32(2, foreverWaits);
+  TEST_ASSERT_EQUAL_UINT32(kEpochMs, sys_clock::nowMs());
+}
+
+void test_event_ends_an_indefinite_wait() {
+  const uint32_t wakeupsBefore = scheduler::getIdleStats().eventWakeups;
+  scheduler::post(scheduler::EventType::ApiResponse);
+  scheduler::run();
+  TEST_ASSERT_EQUAL_UINT32(wakeupsBefore + 1, scheduler::getIdleStats().eventWakeups);
+  TEST_ASSERT_EQUAL_UINT32(2, foreverWaits);
+}
+
+void test_cadences_hit_every_deadline() {
+  for (Probe &probe : probes) {
+    Probe *target = &probe;
+    TEST_ASSERT_NOT_EQUAL(scheduler::kInvalidTask,
+                          scheduler::addTask(
+                              "probe", [target](uint32_t nowMs) { target->record(nowMs); }, probe.intervalMs,
+                              probe.phaseMs));
+  }
+
+  const scheduler::IdleStats before = scheduler::getIdleStats();
+  while (sys_clock::nowMs() - kEpochMs < kSpanMs) {
+    scheduler::run();
+  }
+  const scheduler::IdleStats after = scheduler::getIdleStats();
+
+  std::set<uint32_t> deadlines;
+  for (const Probe &probe : probes) {
+    TEST_ASSERT_EQUAL_UINT32((kSpanMs - probe.phaseMs + probe.intervalMs - 1) / probe.intervalMs, probe.runs);
+    TEST_ASSERT_EQUAL_UINT32(0, probe.offGrid);
+    for (uint32_t offset = probe.phaseMs; offset < kSpanMs; offset += probe.intervalMs) {
+      deadlines.insert(offset);
+    }
+  }
+  for (size_t i = 1; i < scheduler::getTaskCount(); ++i) {
+    scheduler::TaskStats stats;
+    TEST_ASSERT_TRUE(scheduler::getTaskStats(i, stats));
+    TEST_ASSERT_EQUAL_UINT32(0, stats.missedDeadlines);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.maxJitterUs);
+  }
+
+  // One pass per distinct deadline, each followed by one sleep, where a polling loop
+  // checking every millisecond would have made kSpanMs passes.
+  const uint32_t passes = after.passes - before.passes;
+  TEST_ASSERT_EQUAL_UINT32(deadlines.size(), passes);
+  TEST_ASSERT_EQUAL_UINT32(passes, after.sleeps - before.sleeps);
+  TEST_ASSERT_EQUAL_UINT32(kSpanMs, after.sleptMs - before.sleptMs);
+  char message[96];
+  snprintf(message, sizeof(message), "%lu passes in %lu ms; %lu wakeups saved over 1 ms polling",
+           static_cast<unsigned long>(passes), static_cast<unsigned long>(kSpanMs),
+           static_cast<unsigned long>(kSpanMs - passes));
+  TEST_MESSAGE(message);
+}
+
+void test_coroutine_steps_are_not_missed_deadlines() {
+  const scheduler::TaskId task = scheduler::addCoroutine("steps", stepsFrame, runSteps);
+  TEST_ASSERT_NOT_EQUAL(scheduler::kInvalidTask, task);
+  TEST_ASSERT_TRUE(scheduler::startCoroutine(task));
+  // The first resume comes a few ms after the start, as when loop() was busy.
+  virtualUs += kStepCostMs * 1000;
+  for (uint32_t i = 0; i < 1000 && stepsRun < 4; ++i) {
+    scheduler::run();
+  }
+  TEST_ASSERT_EQUAL_UINT32(4, stepsRun);
+
+  scheduler::TaskStats stats;
+  TEST_ASSERT_TRUE(scheduler::getTaskStats(static_cast<size_t>(task), stats));
+  TEST_ASSERT_TRUE(stats.parked);
+  TEST_ASSERT_EQUAL_UINT32(4, stats.runs);
+  TEST_ASSERT_EQUAL_UINT32(kStepSleepMs, stats.intervalMs);
+  TEST_ASSERT_EQUAL_UINT32(0, stats.missedDeadlines);
+  TEST_ASSERT_EQUAL_UINT32(0, stats.overruns);
+}
+
+int main() {
+  sys_clock::setHostTimeSource(readVirtualClock);
+  host_rtos::state().onBlock = sleepVirtually;
+
+  UNITY_BEGIN();
+  RUN_TEST(test_blocks_indefinitely_without_runnable_tasks);
+  RUN_TEST(test_event_ends_an_indefinite_wait);
+  RUN_TEST(test_cadences_hit_every_deadline);
+  RUN_TEST(test_coroutine_steps_are_not_missed_deadlines);
+  return UNITY_END();
+}
@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <unity.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "core/seqlock.h"
+
+namespace {
+// Shaped like network::ApiSnapshot; every field derives from `count`, so a value mixing
+// two writes fails check().
+struct Sample {
+  uint32_t count;
+  int32_t status;
+  uint32_t remainingMs;
+  uint32_t stampMs;
+  bool received;
+  uint64_t checksum;
+};
+
+constexpr uint32_t kWrites = 100000;
+constexpr uint32_t kReaders = 2;
+
+Sample makeSample(uint32_t count) {
+  Sample sample;
+  sample.count = count;
+  sample.status = static_cast<int32_t>(count % 5);
+  sample.remainingMs = ~count;
+  sample.stampMs = count * 7u;
+  sample.received = (count & 1u) != 0;
+  sample.checksum = (static_cast<uint64_t>(count) << 32) | (count ^ 0xA5A5A5A5u);
+  return sample;
+}
+
+bool check(const Sample &sample) {
+  const Sample expected = makeSample(sample.count);
+  return sample.status == expected.status && sample.remainingMs == expected.remainingMs &&
+         sample.stampMs == expected.stampMs && sample.received == expected.received &&
+         sample.checksum == expected.checksum;
+}
+
+struct ReaderStats {
+  uint32_t reads = 0;
+  uint32_t torn = 0;
+  uint32_t backwards = 0;
+  uint32_t distinct = 0;
+};
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_read_returns_latest_write() {
+  Seqlock<Sample> lock;
+  TEST_ASSERT_EQUAL_UINT32(0, lock.read().count);
+  const uint32_t sequence = lock.sequence();
+  lock.write(makeSample(42));
+  const Sample sample = lock.read();
+  TEST_ASSERT_EQUAL_UINT32(42, sample.count);
+  TEST_ASSERT_TRUE(check(sample));
+  TEST_ASSERT_EQUAL_UINT32(sequence + 2, lock.sequence());
+}
+
+// One writer thread (the ApiTask) publishes as fast as it can while reader threads (game
+// tick, UI) read: no reader may ever see a mix of two writes or an older value than before.
+void test_concurrent_reads_are_never_torn() {
+  Seqlock<Sample> lock;
+  lock.write(makeSample(1));
+  std::atomic<bool> writing{true};
+  std::vector<ReaderStats> stats(kReaders);
+
+  std::vector<std::thread> readers;
+  for (uint32_t r = 0; r < kReaders; ++r) {
+    readers.emplace_back([&lock, &writing, &stats, r]() {
+      ReaderStats &own = stats[r];
+      uint32_t last = 0;
+      do {
+        const Sample sample = lock.read();
+        ++own.reads;
+        if (!check(sample)) {
+          ++own.torn;
+        } else if (sample.count < last) {
+          ++own.backwards;
+        } else if (sample.count != last) {
+          ++own.distinct;
+          last = sample.count;
+        }
+      } while (writing.load(std::memory_order_relaxed));
+    });
+  }
+
+  for (uint32_t count = 2; count <= kWrites; ++count) {
+    lock.write(makeSample(count));
+    // A writer that never pauses starves the readers; the real one posts every few ms.
+    if (count % 64 == 0) {
+      std::this_thread::yield();
+    }
+  }
+  writing.store(false);
+  for (std::thread &reader : readers) {
+    reader.join();
+  }
+
+  TEST_ASSERT_EQUAL_UINT32(kWrites, lock.read().count);
+  for (const ReaderStats &own : stats) {
+    TEST_ASSERT_EQUAL_UINT32(0, own.torn);
+    TEST_ASSERT_EQUAL_UINT32(0, own.backwards);
+    TEST_ASSERT_GREATER_THAN(1, own.distinct);
+  }
+  char message[96];
+  snprintf(message, sizeof(message), "%lu reads seeing %lu distinct values (reader 0)",
+           static_cast<unsigned long>(stats[0].reads), static_cast<unsigned long>(stats[0].distinct));
+  TEST_MESSAGE(message);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_read_returns_latest_write);
+  RUN_TEST(test_concurrent_reads_are_never_torn);
+  return UNITY_END();
+}
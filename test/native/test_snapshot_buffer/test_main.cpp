@@ -0,0 +1,126 @@
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+#include <atomic>
+#include <thread>
+
+#include "core/snapshot_buffer.h"
+
+namespace {
+// Shaped like GameFrame (a few scalars and a text buffer); every field derives from
+// `count`, so a frame mixing two publishes fails check().
+struct Frame {
+  uint32_t count;
+  uint32_t nowMs;
+  int32_t state;
+  float progress;
+  bool flag;
+  char buffer[12];
+  uint32_t remainingMs;
+};
+
+constexpr uint32_t kPublishes = 200000;
+
+Frame makeFrame(uint32_t count) {
+  Frame frame;
+  frame.count = count;
+  frame.nowMs = count * 10u;
+  frame.state = static_cast<int32_t>(count % 8);
+  frame.progress = static_cast<float>(count % 100) / 100.0f;
+  frame.flag = (count & 1u) != 0;
+  snprintf(frame.buffer, sizeof(frame.buffer), "%lu", static_cast<unsigned long>(count));
+  frame.remainingMs = ~count;
+  return frame;
+}
+
+bool check(const Frame &frame) {
+  const Frame expected = makeFrame(frame.count);
+  return frame.nowMs == expected.nowMs && frame.state == expected.state && frame.progress == expected.progress &&
+         frame.flag == expected.flag && strcmp(frame.buffer, expected.buffer) == 0 &&
+         frame.remainingMs == expected.remainingMs;
+}
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_read_takes_only_the_latest_publish() {
+  SnapshotBuffer<Frame> buffer;
+  Frame frame = makeFrame(0);
+  TEST_ASSERT_FALSE(buffer.read(frame));
+
+  buffer.publish(makeFrame(1));
+  buffer.publish(makeFrame(2));
+  buffer.publish(makeFrame(3));
+  TEST_ASSERT_TRUE(buffer.read(frame));
+  TEST_ASSERT_EQUAL_UINT32(3, frame.count);
+  TEST_ASSERT_TRUE(check(frame));
+
+  // Nothing new: `out` is left alone.
+  frame = makeFrame(99);
+  TEST_ASSERT_FALSE(buffer.read(frame));
+  TEST_ASSERT_EQUAL_UINT32(99, frame.count);
+
+  buffer.publish(makeFrame(4));
+  TEST_ASSERT_TRUE(buffer.read(frame));
+  TEST_ASSERT_EQUAL_UINT32(4, frame.count);
+}
+
+// The game side publishes a frame per tick while the UI (or effects) task reads: the
+// reader must never see a mix of two frames, an older frame than before, or miss the
+// last one.
+void test_concurrent_reads_are_never_torn() {
+  SnapshotBuffer<Frame> buffer;
+  std::atomic<bool> publishing{true};
+  uint32_t reads = 0;
+  uint32_t torn = 0;
+  uint32_t backwards = 0;
+  uint32_t last = 0;
+
+  std::thread reader([&]() {
+    Frame frame;
+    for (;;) {
+      const bool done = !publishing.load(std::memory_order_acquire);
+      while (buffer.read(frame)) {
+        ++reads;
+        if (!check(frame)) {
+          ++torn;
+        } else if (frame.count <= last) {
+          ++backwards;
+        } else {
+          last = frame.count;
+        }
+      }
+      if (done) {
+        break;
+      }
+    }
+  });
+
+  for (uint32_t count = 1; count <= kPublishes; ++count) {
+    buffer.publish(makeFrame(count));
+    if (count % 64 == 0) {
+      std::this_thread::yield();
+    }
+  }
+  publishing.store(false, std::memory_order_release);
+  reader.join();
+
+  TEST_ASSERT_EQUAL_UINT32(0, torn);
+  TEST_ASSERT_EQUAL_UINT32(0, backwards);
+  TEST_ASSERT_EQUAL_UINT32(kPublishes, last);
+  TEST_ASSERT_GREATER_THAN(1, reads);
+  char message[96];
+  snprintf(message, sizeof(message), "%lu reads over %lu publishes", static_cast<unsigned long>(reads),
+           static_cast<unsigned long>(kPublishes));
+  TEST_MESSAGE(message);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_read_takes_only_the_latest_publish);
+  RUN_TEST(test_concurrent_reads_are_never_torn);
+  return UNITY_END();
+}
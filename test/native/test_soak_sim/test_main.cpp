@@ -0,0 +1,227 @@
+#include <stdio.h>
+#include <unity.h>
+
+#include "core/soak_sim.h"
+
+// Plays scripted matches through soak_sim::Simulator. The checks must stay silent on
+// the real engine, and each invariant must fire when a tick is broken on purpose.
+namespace {
+using soak_sim::Invariant;
+
+constexpr uint32_t kSeed = 5;
+constexpr uint32_t kMatches = 40;
+
+soak_sim::Simulator simulator;
+
+soak_sim::Config makeConfig(uint32_t seed) {
+  soak_sim::Config config;
+  config.seed = seed;
+  config.matches = kMatches;
+  return config;
+}
+
+const soak_sim::Report &run(const soak_sim::Config &config) {
+  simulator.reset(config);
+  while (simulator.step(10000)) {
+  }
+  return simulator.report();
+}
+
+// Breaks the first tick that suits `target`, leaving the engine itself alone.
+struct Fault {
+  Invariant target = Invariant::Count;
+  bool injected = false;
+  uint32_t faultyTicks = 0;
+};
+
+// A stuck ARMING must outlast the hold and the IR window before it counts.
+constexpr uint32_t kStuckArmingTicks = (BUTTON_HOLD_MS + IR_CONFIRM_WINDOW_MS) / 10 + 20;
+
+void fakeTransition(FlameState before, FlameState to, GameOutputs &outputs, soak_sim::TickView &after) {
+  outputs.stateChanged = true;
+  outputs.previousState = before;
+  outputs.newState = to;
+  after.state = to;
+  after.bombTimerActive = to == ARMED;
+}
+
+void injectFault(void *context, FlameState &before, GameOutputs &outputs, soak_sim::TickView &after) {
+  Fault &fault = *static_cast<Fault *>(context);
+  if (fault.injected) {
+    return;
+  }
+  const bool steady = !outputs.stateChanged;
+  switch (fault.target) {
+    case Invariant::BombTimerBounds:
+      if (steady && after.state == ARMED) {
+        after.bombRemainingMs = after.bombDurationMs + 1;
+        fault.injected = true;
+      }
+      break;
+    case Invariant::BombTimerOutsideArmed:
+      if (steady && after.state == ACTIVE) {
+        after.bombTimerActive = true;
+        fault.injected = true;
+      }
+      break;
+    case Invariant::BombTimerStalled:
+      // The countdown ran out, but the engine stays ARMED.
+      if (before == ARMED && after.state == DETONATED) {
+        outputs.stateChanged = false;
+        after.state = ARMED;
+        fault.injected = true;
+      }
+      break;
+    case Invariant::EarlyDetonation:
+    case Invariant::ArmedExit:
+    case Invariant::DefuseWithoutCode:
+      // Straight after arming: too early, by the wrong route, or before any code.
+      if (steady && after.state == ARMED) {
+        const FlameState to = fault.target == Invariant::EarlyDetonation ? DETONATED
+                              : fault.target == Invariant::ArmedExit     ? ACTIVE
+                                                                         : DEFUSED;
+        fakeTransition(ARMED, to, outputs, after);
+        fault.injected = true;
+      }
+      break;
+    case Invariant::ArmingPath:
+      if (steady && after.state == ACTIVE) {
+        fakeTransition(ACTIVE, ARMED, outputs, after);
+        fault.injected = true;
+      }
+      break;
+    case Invariant::ArmingStuck:
+      // The engine enters ARMING and never leaves it.
+      if (fault.faultyTicks > 0 || (steady && after.state == ACTIVE)) {
+        if (fault.faultyTicks == 0) {
+          fakeTransition(ACTIVE, ARMING, outputs, after);
+        } else {
+          before = ARMING;
+          outputs.stateChanged = false;
+          after.state = ARMING;
+          after.bombTimerActive = false;
+        }
+        after.matchStatus = Running;
+        fault.injected = ++fault.faultyTicks >= kStuckArmingTicks;
+      }
+      break;
+    case Invariant::PlayAfterMatchOver:
+      if (steady && after.state == ACTIVE) {
+        after.matchStatus = Completed;
+        fault.injected = true;
+      }
+      break;
+    case Invariant::OutputsMismatch:
+      if (steady) {
+        outputs.stateChanged = true;
+        outputs.previousState = before;
+        outputs.newState = after.state;
+        fault.injected = true;
+      }
+      break;
+    case Invariant::GameTimerRewound:
+      // Two ticks in a row, the second with more time left than the first.
+      if (steady) {
+        after.gameTimerValid = true;
+        after.gameTimerRemainingMs = fault.faultyTicks;
+        fault.injected = ++fault.faultyTicks == 2;
+      }
+      break;
+    default:
+      break;
+  }
+}
+}  // namespace
+
+void setUp() { simulator.injectFaults(nullptr, nullptr); }
+
+void tearDown() {}
+
+void test_same_seed_reproduces_the_report() {
+  const soak_sim::Report first = run(makeConfig(kSeed));
+  const soak_sim::Report second = run(makeConfig(kSeed));
+
+  TEST_ASSERT_EQUAL_UINT32(kMatches, first.matches);
+  TEST_ASSERT_EQUAL_UINT32(first.matches, second.matches);
+  TEST_ASSERT_EQUAL_UINT32(first.ticks, second.ticks);
+  TEST_ASSERT_TRUE(first.simulatedMs == second.simulatedMs);
+  TEST_ASSERT_EQUAL_UINT32(first.armings, second.armings);
+  TEST_ASSERT_EQUAL_UINT32(first.defuses, second.defuses);
+  TEST_ASSERT_EQUAL_UINT32(first.detonations, second.detonations);
+  TEST_ASSERT_EQUAL_UINT32(first.errors, second.errors);
+  TEST_ASSERT_EQUAL_UINT32(first.violations, second.violations);
+
+  // A different seed plays different matches.
+  const soak_sim::Report other = run(makeConfig(kSeed + 1));
+  TEST_ASSERT_NOT_EQUAL(first.ticks, other.ticks);
+}
+
+void test_matches_reach_every_outcome_without_violations() {
+  const soak_sim::Report &report = run(makeConfig(kSeed));
+  TEST_ASSERT_EQUAL_UINT32(0, report.violations);
+  TEST_ASSERT_GREATER_THAN(0, report.armings);
+  TEST_ASSERT_GREATER_THAN(0, report.defuses);
+  TEST_ASSERT_GREATER_THAN(0, report.detonations);
+  TEST_ASSERT_GREATER_THAN(0, report.errors);
+
+  char message[96];
+  snprintf(message, sizeof(message), "armed=%lu defused=%lu detonated=%lu errors=%lu",
+           static_cast<unsigned long>(report.armings), static_cast<unsigned long>(report.defuses),
+           static_cast<unsigned long>(report.detonations), static_cast<unsigned long>(report.errors));
+  TEST_MESSAGE(message);
+}
+
+// The example modes from game_mode.h, each soaked with the invariants in force.
+void test_game_modes_soak_without_violations() {
+  const char *const modes[] = {"defuse=hold:8000", "arm=hold,ir,hold:5000",
+                               "arm=hold:10000;defuse=hold:10000;outcome=neutral"};
+  for (const char *rules : modes) {
+    soak_sim::Config config = makeConfig(kSeed);
+    config.rules = rules;
+    const soak_sim::Report &report = run(config);
+
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(kMatches, report.matches, rules);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, report.violations, soak_sim::invariantName(report.first.invariant));
+    TEST_ASSERT_GREATER_THAN(0, report.armings);
+    TEST_ASSERT_GREATER_THAN(0, report.detonations);
+    if (rules == modes[2]) {
+      TEST_ASSERT_GREATER_THAN(0, report.neutralizations);
+      TEST_ASSERT_EQUAL_UINT32(0, report.defuses);
+      // Recaptured after being neutralised.
+      TEST_ASSERT_GREATER_THAN(report.neutralizations, report.armings);
+    } else {
+      TEST_ASSERT_GREATER_THAN(0, report.defuses);
+      TEST_ASSERT_EQUAL_UINT32(0, report.neutralizations);
+    }
+  }
+
+  soak_sim::Config bad = makeConfig(kSeed);
+  bad.rules = "defuse=code:5";
+  const char *error = nullptr;
+  TEST_ASSERT_FALSE(simulator.reset(bad, &error));
+  TEST_ASSERT_EQUAL_STRING("unknown defuse method", error);
+  TEST_ASSERT_FALSE(simulator.step(10000));
+  TEST_ASSERT_EQUAL_UINT32(0, simulator.report().ticks);
+}
+
+void test_each_invariant_fires_on_a_faulty_tick() {
+  for (size_t i = 0; i < static_cast<size_t>(Invariant::Count); ++i) {
+    Fault fault;
+    fault.target = static_cast<Invariant>(i);
+    simulator.injectFaults(injectFault, &fault);
+    const soak_sim::Report &report = run(makeConfig(kSeed));
+
+    TEST_ASSERT_TRUE_MESSAGE(fault.injected, soak_sim::invariantName(fault.target));
+    TEST_ASSERT_EQUAL_STRING(soak_sim::invariantName(fault.target), soak_sim::invariantName(report.first.invariant));
+    TEST_ASSERT_GREATER_THAN(0, report.perInvariant[i]);
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_same_seed_reproduces_the_report);
+  RUN_TEST(test_matches_reach_every_outcome_without_violations);
+  RUN_TEST(test_game_modes_soak_without_violations);
+  RUN_TEST(test_each_invariant_fires_on_a_faulty_tick);
+  return UNITY_END();
+}
@@ -0,0 +1,272 @@
+#include <unity.h>
+
+#include "core/timer_wheel.h"
+
+// The wheel is driven by a virtual clock: `clockMs` is what the last advance() was
+// given, so a callback can record the millisecond it fired in.
+namespace {
+struct Probe {
+  uint32_t deadlineMs;
+  uint32_t fired;
+  uint32_t firedAtMs;
+};
+
+uint32_t clockMs = 0;
+uint32_t fireOrder[64];
+size_t fireCount = 0;
+
+void record(void *context) {
+  Probe &probe = *static_cast<Probe *>(context);
+  ++probe.fired;
+  probe.firedAtMs = clockMs;
+  if (fireCount < sizeof(fireOrder) / sizeof(fireOrder[0])) {
+    fireOrder[fireCount++] = probe.deadlineMs;
+  }
+}
+
+void advanceTo(TimerWheel &wheel, uint32_t nowMs) {
+  clockMs = nowMs;
+  wheel.advance(nowMs);
+}
+
+void stepTo(TimerWheel &wheel, uint32_t nowMs) {
+  while (clockMs != nowMs) {
+    advanceTo(wheel, clockMs + 1);
+  }
+}
+
+uint32_t rngState = 0x2545F491;
+
+uint32_t nextRandom() {
+  rngState ^= rngState << 13;
+  rngState ^= rngState >> 17;
+  rngState ^= rngState << 5;
+  return rngState;
+}
+
+// A wheel whose clock is at `baseMs`, as after running for that long.
+void startAt(TimerWheel &wheel, uint32_t baseMs) {
+  clockMs = baseMs;
+  wheel.advance(baseMs);
+  fireCount = 0;
+}
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_fires_exactly_once() {
+  TimerWheel wheel;
+  startAt(wheel, 1000);
+  Probe probe = {1100, 0, 0};
+  const TimerHandle handle = wheel.schedule(probe.deadlineMs, record, &probe);
+  TEST_ASSERT_TRUE(wheel.isPending(handle));
+
+  stepTo(wheel, 1099);
+  TEST_ASSERT_EQUAL_UINT32(0, probe.fired);
+  advanceTo(wheel, 1100);
+  TEST_ASSERT_EQUAL_UINT32(1, probe.fired);
+  TEST_ASSERT_EQUAL_UINT32(1100, probe.firedAtMs);
+  TEST_ASSERT_FALSE(wheel.isPending(handle));
+
+  advanceTo(wheel, 90000);
+  TEST_ASSERT_EQUAL_UINT32(1, probe.fired);
+  TEST_ASSERT_EQUAL_UINT32(0, wheel.pendingCount());
+}
+
+void test_overdue_deadline_fires_on_next_advance() {
+  TimerWheel wheel;
+  startAt(wheel, 5000);
+  Probe probe = {4000, 0, 0};
+  wheel.schedule(probe.deadlineMs, record, &probe);
+  advanceTo(wheel, 5001);
+  TEST_ASSERT_EQUAL_UINT32(1, probe.fired);
+}
+
+void test_cancel_before_fire() {
+  TimerWheel wheel;
+  startAt(wheel, 0);
+  Probe probe = {50, 0, 0};
+  TimerHandle handle = wheel.schedule(probe.deadlineMs, record, &probe);
+  TEST_ASSERT_TRUE(wheel.cancel(handle));
+  TEST_ASSERT_EQUAL_INT8(-1, handle.index);
+  TEST_ASSERT_EQUAL_UINT32(0, wheel.pendingCount());
+
+  advanceTo(wheel, 1000);
+  TEST_ASSERT_EQUAL_UINT32(0, probe.fired);
+  TEST_ASSERT_FALSE(wheel.cancel(handle));
+}
+
+void test_stale_handle_leaves_reused_node_alone() {
+  TimerWheel wheel;
+  startAt(wheel, 0);
+  Probe first = {10, 0, 0};
+  Probe second = {30, 0, 0};
+  TimerHandle stale = wheel.schedule(first.deadlineMs, record, &first);
+  advanceTo(wheel, 10);
+  TEST_ASSERT_EQUAL_UINT32(1, first.fired);
+
+  const TimerHandle fresh = wheel.schedule(second.deadlineMs, record, &second);
+  TEST_ASSERT_EQUAL_INT8(stale.index, fresh.index);
+  TEST_ASSERT_FALSE(wheel.cancel(stale));
+  TEST_ASSERT_TRUE(wheel.isPending(fresh));
+  advanceTo(wheel, 30);
+  TEST_ASSERT_EQUAL_UINT32(1, second.fired);
+}
+
+// Deadlines on both sides of the level boundaries (64 ms, 4096 ms) and the horizon
+// (262144 ms), from aligned and unaligned starting points.
+void test_cascade_boundaries() {
+  const uint32_t offsets[] = {1, 63, 64, 65, 127, 128, 4031, 4095, 4096, 4097, 8192, 262143, 262144, 262145, 600000};
+  const uint32_t bases[] = {0, 1, 63, 4095, 4096, 123457};
+  for (uint32_t base : bases) {
+    for (uint32_t offset : offsets) {
+      // Stepping one millisecond at a time pins down the exact firing millisecond.
+      TimerWheel stepped;
+      startAt(stepped, base);
+      Probe steppedProbe = {base + offset, 0, 0};
+      stepped.schedule(steppedProbe.deadlineMs, record, &steppedProbe);
+      stepTo(stepped, base + offset + 1);
+      TEST_ASSERT_EQUAL_UINT32(1, steppedProbe.fired);
+      TEST_ASSERT_EQUAL_UINT32(base + offset, steppedProbe.firedAtMs);
+
+      // Jumping must agree: nothing just before the deadline, then exactly once.
+      TimerWheel jumped;
+      startAt(jumped, base);
+      Probe jumpedProbe = {base + offset, 0, 0};
+      jumped.schedule(jumpedProbe.deadlineMs, record, &jumpedProbe);
+      advanceTo(jumped, base + offset - 1);
+      TEST_ASSERT_EQUAL_UINT32(0, jumpedProbe.fired);
+      advanceTo(jumped, base + offset);
+      TEST_ASSERT_EQUAL_UINT32(1, jumpedProbe.fired);
+    }
+  }
+}
+
+void test_wraps_at_32_bits() {
+  TimerWheel wheel;
+  const uint32_t base = UINT32_MAX - 100;
+  startAt(wheel, base);
+  Probe probes[] = {{base + 50, 0, 0}, {base + 101, 0, 0}, {base + 150, 0, 0}, {base + 5000, 0, 0}};
+  for (Probe &probe : probes) {
+    wheel.schedule(probe.deadlineMs, record, &probe);
+  }
+  stepTo(wheel, base + 6000);
+  for (const Probe &probe : probes) {
+    TEST_ASSERT_EQUAL_UINT32(1, probe.fired);
+    TEST_ASSERT_EQUAL_UINT32(probe.deadlineMs, probe.firedAtMs);
+  }
+  TEST_ASSERT_EQUAL_UINT32(4, fireCount);
+  TEST_ASSERT_EQUAL_UINT32(0, fireOrder[1]);  // base + 101
+}
+
+void test_pool_exhaustion() {
+  TimerWheel wheel;
+  startAt(wheel, 0);
+  Probe probes[TimerWheel::kMaxTimers + 1];
+  TimerHandle handles[TimerWheel::kMaxTimers];
+  for (size_t i = 0; i < TimerWheel::kMaxTimers; ++i) {
+    probes[i] = {static_cast<uint32_t>(100 + i), 0, 0};
+    handles[i] = wheel.schedule(probes[i].deadlineMs, record, &probes[i]);
+    TEST_ASSERT_TRUE(wheel.isPending(handles[i]));
+  }
+  probes[TimerWheel::kMaxTimers] = {500, 0, 0};
+  const TimerHandle rejected = wheel.schedule(500, record, &probes[TimerWheel::kMaxTimers]);
+  TEST_ASSERT_EQUAL_INT8(-1, rejected.index);
+  TEST_ASSERT_FALSE(wheel.isPending(rejected));
+  TEST_ASSERT_EQUAL_UINT32(TimerWheel::kMaxTimers, wheel.pendingCount());
+
+  TEST_ASSERT_TRUE(wheel.cancel(handles[3]));
+  const TimerHandle accepted = wheel.schedule(500, record, &probes[TimerWheel::kMaxTimers]);
+  TEST_ASSERT_TRUE(wheel.isPending(accepted));
+
+  advanceTo(wheel, 1000);
+  TEST_ASSERT_EQUAL_UINT32(0, probes[3].fired);
+  TEST_ASSERT_EQUAL_UINT32(1, probes[TimerWheel::kMaxTimers].fired);
+  TEST_ASSERT_EQUAL_UINT32(TimerWheel::kMaxTimers, fireCount);
+}
+
+namespace {
+struct Chain {
+  TimerWheel *wheel;
+  uint32_t periodMs;
+  uint32_t remaining;
+  uint32_t deadlineMs;
+  uint32_t firedAt[4];
+  uint32_t fired;
+};
+
+void rearm(void *context) {
+  Chain &chain = *static_cast<Chain *>(context);
+  chain.firedAt[chain.fired++] = chain.deadlineMs;
+  if (--chain.remaining > 0) {
+    chain.deadlineMs += chain.periodMs;
+    chain.wheel->schedule(chain.deadlineMs, rearm, &chain);
+  }
+}
+}  // namespace
+
+// A callback re-arming its own timer within one long advance(); each re-armed timer is
+// due inside the advanced range and still fires, in order.
+void test_callback_reschedules_during_advance() {
+  TimerWheel wheel;
+  startAt(wheel, 0);
+  Chain chain = {&wheel, 100, 4, 100, {0, 0, 0, 0}, 0};
+  wheel.schedule(100, rearm, &chain);
+  advanceTo(wheel, 1000);
+  TEST_ASSERT_EQUAL_UINT32(4, chain.fired);
+  for (uint32_t i = 0; i < 4; ++i) {
+    TEST_ASSERT_EQUAL_UINT32((i + 1) * 100, chain.firedAt[i]);
+  }
+  TEST_ASSERT_EQUAL_UINT32(0, wheel.pendingCount());
+}
+
+// Random deadlines and random advance() jumps, some across the wrap: every timer fires
+// exactly once, in the advance() whose range holds its deadline, in deadline order.
+void test_random_jumps_match_deadlines() {
+  for (uint32_t round = 0; round < 500; ++round) {
+    TimerWheel wheel;
+    const uint32_t base = (round % 4 == 0) ? UINT32_MAX - (nextRandom() % 300000) : nextRandom();
+    startAt(wheel, base);
+
+    Probe probes[TimerWheel::kMaxTimers];
+    for (Probe &probe : probes) {
+      const uint32_t span = (nextRandom() % 3 == 0) ? 300000 : 5000;
+      probe = {base + 1 + nextRandom() % span, 0, 0};
+      wheel.schedule(probe.deadlineMs, record, &probe);
+    }
+
+    uint32_t previousMs = base;
+    while (wheel.pendingCount() > 0) {
+      const uint32_t jump = (nextRandom() % 4 == 0) ? nextRandom() % 70000 : nextRandom() % 300;
+      const size_t firedBefore = fireCount;
+      advanceTo(wheel, previousMs + jump);
+      for (size_t i = firedBefore; i < fireCount; ++i) {
+        const uint32_t deadline = fireOrder[i];
+        TEST_ASSERT_TRUE(deadline - previousMs >= 1 && deadline - previousMs <= jump);
+        if (i > firedBefore) {
+          TEST_ASSERT_TRUE(static_cast<int32_t>(deadline - fireOrder[i - 1]) >= 0);
+        }
+      }
+      previousMs += jump;
+    }
+    for (const Probe &probe : probes) {
+      TEST_ASSERT_EQUAL_UINT32(1, probe.fired);
+    }
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_fires_exactly_once);
+  RUN_TEST(test_overdue_deadline_fires_on_next_advance);
+  RUN_TEST(test_cancel_before_fire);
+  RUN_TEST(test_stale_handle_leaves_reused_node_alone);
+  RUN_TEST(test_cascade_boundaries);
+  RUN_TEST(test_wraps_at_32_bits);
+  RUN_TEST(test_pool_exhaustion);
+  RUN_TEST(test_callback_reschedules_during_advance);
+  RUN_TEST(test_random_jumps_match_deadlines);
+  return UNITY_END();
+}